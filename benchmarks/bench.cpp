@@ -1,239 +1,227 @@
-#include "../client/client.h"
+#include "load_generator.h"
 #include <iostream>
-#include <chrono>
+#include <fstream>
 #include <iomanip>
-#include <vector>
-#include <thread>
-#include <numeric>
+#include <string>
+#include <cstring>
+#include <cstdlib>
 
 using namespace distkv;
 
-class Benchmark {
-public:
-    void run_all() {
-        std::cout << "\n========================================\n";
-        std::cout << "     DistKV Performance Benchmark\n";
-        std::cout << "========================================\n\n";
-
-        // Connect to server
-        if (!client_.connect("127.0.0.1", 6379)) {
-            std::cerr << "Failed to connect to server. Is it running?\n";
-            std::cerr << "Start server with: ./distkv-server\n";
-            return;
-        }
-
-        std::cout << "Connected to server at 127.0.0.1:6379\n\n";
-
-        // Run benchmarks
-        benchmark_set();
-        benchmark_get();
-        benchmark_mixed();
-        benchmark_list_operations();
-        benchmark_set_operations();
-        benchmark_concurrent();
-
-        std::cout << "\n========================================\n";
-        std::cout << "     Benchmark Complete\n";
-        std::cout << "========================================\n\n";
-
-        client_.disconnect();
+// Parse "SET:GET" into a two-command mix
+bool parse_ratio(const std::string& spec, std::vector<MixEntry>& mix) {
+    size_t colon = spec.find(':');
+    if (colon == std::string::npos) {
+        return false;
     }
+    return parse_mix("set:" + spec.substr(0, colon) + ",get:" + spec.substr(colon + 1), mix);
+}
 
-private:
-    Client client_;
-
-    void benchmark_set() {
-        std::cout << "Benchmarking SET operations...\n";
-
-        const int iterations = 10000;
-        auto start = std::chrono::high_resolution_clock::now();
+bool write_file(const std::string& path, const std::string& contents) {
+    std::ofstream file(path);
+    file << contents;
+    return static_cast<bool>(file);
+}
 
-        for (int i = 0; i < iterations; ++i) {
-            std::string key = "bench_key_" + std::to_string(i);
-            client_.set(key, "value_" + std::to_string(i));
+int main(int argc, char* argv[]) {
+    LoadConfig config;
+    std::string hdr_file;
+    std::string json_file;
+    std::string label;
+    int server_pid = 0;
+
+    // Parse command line arguments
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--host") == 0 && i + 1 < argc) {
+            config.host = argv[i + 1];
+            ++i;
+        } else if (std::strcmp(argv[i], "--port") == 0 && i + 1 < argc) {
+            config.port = std::atoi(argv[i + 1]);
+            ++i;
+        } else if (std::strcmp(argv[i], "--unix-socket") == 0 && i + 1 < argc) {
+            config.unix_socket = argv[i + 1];
+            ++i;
+        } else if (std::strcmp(argv[i], "--protocol") == 0 && i + 1 < argc) {
+            if (std::strcmp(argv[i + 1], "binary") != 0 && std::strcmp(argv[i + 1], "text") != 0) {
+                std::cerr << "Invalid --protocol, expected text or binary\n";
+                return 1;
+            }
+            config.binary = std::strcmp(argv[i + 1], "binary") == 0;
+            ++i;
+        } else if (std::strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+            config.threads = static_cast<size_t>(std::atoi(argv[i + 1]));
+            ++i;
+        } else if (std::strcmp(argv[i], "--clients") == 0 && i + 1 < argc) {
+            config.clients = static_cast<size_t>(std::atoi(argv[i + 1]));
+            ++i;
+        } else if (std::strcmp(argv[i], "--pipeline") == 0 && i + 1 < argc) {
+            config.pipeline = static_cast<size_t>(std::atoi(argv[i + 1]));
+            ++i;
+        } else if (std::strcmp(argv[i], "--requests") == 0 && i + 1 < argc) {
+            config.requests = static_cast<size_t>(std::atoll(argv[i + 1]));
+            ++i;
+        } else if (std::strcmp(argv[i], "--test-time") == 0 && i + 1 < argc) {
+            config.duration_s = std::atof(argv[i + 1]);
+            ++i;
+        } else if (std::strcmp(argv[i], "--rate") == 0 && i + 1 < argc) {
+            config.rate = std::atof(argv[i + 1]);
+            ++i;
+        } else if (std::strcmp(argv[i], "--key-space") == 0 && i + 1 < argc) {
+            config.key_space = static_cast<size_t>(std::atoll(argv[i + 1]));
+            ++i;
+        } else if (std::strcmp(argv[i], "--key-distribution") == 0 && i + 1 < argc) {
+            if (!config.key_distribution.parse(argv[i + 1])) {
+                std::cerr << "Invalid --key-distribution " << argv[i + 1] << ", see --help\n";
+                return 1;
+            }
+            ++i;
+        } else if (std::strcmp(argv[i], "--key-prefix") == 0 && i + 1 < argc) {
+            config.key_prefix = argv[i + 1];
+            ++i;
+        } else if (std::strcmp(argv[i], "--data-size") == 0 && i + 1 < argc) {
+            if (!config.value_size.parse(argv[i + 1])) {
+                std::cerr << "Invalid --data-size " << argv[i + 1] << ", see --help\n";
+                return 1;
+            }
+            ++i;
+        } else if (std::strcmp(argv[i], "--ratio") == 0 && i + 1 < argc) {
+            if (!parse_ratio(argv[i + 1], config.mix)) {
+                std::cerr << "Invalid --ratio " << argv[i + 1] << ", expected SET:GET\n";
+                return 1;
+            }
+            ++i;
+        } else if (std::strcmp(argv[i], "--command-mix") == 0 && i + 1 < argc) {
+            if (!parse_mix(argv[i + 1], config.mix)) {
+                std::cerr << "Invalid --command-mix " << argv[i + 1] << ", see --help\n";
+                return 1;
+            }
+            ++i;
+        } else if (std::strcmp(argv[i], "--range") == 0 && i + 1 < argc) {
+            config.range = std::atoi(argv[i + 1]);
+            ++i;
+        } else if (std::strcmp(argv[i], "--preload") == 0) {
+            config.preload = true;
+        } else if (std::strcmp(argv[i], "--seed") == 0 && i + 1 < argc) {
+            config.seed = static_cast<uint64_t>(std::strtoull(argv[i + 1], nullptr, 10));
+            ++i;
+        } else if (std::strcmp(argv[i], "--hdr-file") == 0 && i + 1 < argc) {
+            hdr_file = argv[i + 1];
+            ++i;
+        } else if (std::strcmp(argv[i], "--json-out-file") == 0 && i + 1 < argc) {
+            json_file = argv[i + 1];
+            ++i;
+        } else if (std::strcmp(argv[i], "--label") == 0 && i + 1 < argc) {
+            label = argv[i + 1];
+            ++i;
+        } else if (std::strcmp(argv[i], "--server-pid") == 0 && i + 1 < argc) {
+            server_pid = std::atoi(argv[i + 1]);
+            ++i;
+        } else if (std::strcmp(argv[i], "--help") == 0) {
+            std::cout << "DistKV Benchmark - load generator\n\n";
+            std::cout << "Usage: " << argv[0] << " [options]\n\n";
+            std::cout << "Options:\n";
+            std::cout << "  --host <host>            Server host (default: 127.0.0.1)\n";
+            std::cout << "  --port <port>            Server port (default: 6379)\n";
+            std::cout << "  --unix-socket <path>     Connect through a Unix domain socket instead\n";
+            std::cout << "  --protocol <p>           text or binary (default: text)\n";
+            std::cout << "  --threads <n>            Worker threads (default: 4)\n";
+            std::cout << "  --clients <n>            Connections per thread (default: 10)\n";
+            std::cout << "  --pipeline <n>           Requests in flight per connection (default: 1)\n";
+            std::cout << "  --requests <n>           Requests per connection (default: 10000)\n";
+            std::cout << "  --test-time <secs>       Run for this long instead of --requests\n";
+            std::cout << "  --rate <n>               Open loop: requests/sec over all connections,\n";
+            std::cout << "                           latency measured from scheduled send times\n";
+            std::cout << "                           (default: closed loop)\n";
+            std::cout << "  --key-space <n>          Distinct keys per type (default: 100000)\n";
+            std::cout << "  --key-distribution <d>   How keys are picked (default: uniform):\n";
+            std::cout << "                             uniform\n";
+            std::cout << "                             zipfian[:theta]      skewed, theta in (0, 1),\n";
+            std::cout << "                                                  default 0.99\n";
+            std::cout << "                             hotspot[:keys:ops]   ops fraction of requests to\n";
+            std::cout << "                                                  keys fraction of keys,\n";
+            std::cout << "                                                  default 0.2:0.8\n";
+            std::cout << "                             latest[:theta]       writes add new keys, reads\n";
+            std::cout << "                                                  are zipfian by age\n";
+            std::cout << "  --key-prefix <prefix>    Prefix for every key (default: none)\n";
+            std::cout << "  --data-size <spec>       Value sizes for SET/LPUSH/RPUSH (default: 32):\n";
+            std::cout << "                             <bytes>, <min>-<max> (uniform),\n";
+            std::cout << "                             zipf:<min>-<max> (mostly small, long tail), or\n";
+            std::cout << "                             <bytes>:<weight>,... (e.g. 32:80,1024:20)\n";
+            std::cout << "  --ratio <set>:<get>      SET to GET ratio (default: 1:10)\n";
+            std::cout << "  --command-mix <spec>     Weighted commands, e.g. get:10,set:2,lpush:1\n";
+            std::cout << "                           from set get del exists expire ttl lpush rpush\n";
+            std::cout << "                           lpop rpop lrange llen sadd srem sismember\n";
+            std::cout << "                           smembers scard\n";
+            std::cout << "  --range <n>              Elements per LRANGE (default: 10)\n";
+            std::cout << "  --preload                SET every key before the run\n";
+            std::cout << "  --seed <n>               Random seed (default: from the clock)\n";
+            std::cout << "  --hdr-file <path>        Write percentile distributions (.hgrm layout)\n";
+            std::cout << "  --json-out-file <path>   Write results as JSON, for bench-compare\n";
+            std::cout << "  --label <text>           Name for this run in the JSON (e.g. a version)\n";
+            std::cout << "  --server-pid <pid>       Report the server's memory use (Linux)\n";
+            std::cout << "  --help                   Show this help message\n";
+            return 0;
+        } else {
+            std::cerr << "Unknown option " << argv[i] << ", see --help\n";
+            return 1;
         }
-
-        auto end = std::chrono::high_resolution_clock::now();
-        auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(
-            end - start).count();
-
-        double ops_per_sec = (iterations * 1000.0) / duration;
-        double latency_ms = static_cast<double>(duration) / iterations;
-
-        std::cout << "  Operations: " << iterations << "\n";
-        std::cout << "  Duration: " << duration << " ms\n";
-        std::cout << "  Throughput: " << std::fixed << std::setprecision(2)
-                  << ops_per_sec << " ops/sec\n";
-        std::cout << "  Avg Latency: " << std::fixed << std::setprecision(3)
-                  << latency_ms << " ms\n\n";
     }
 
-    void benchmark_get() {
-        std::cout << "Benchmarking GET operations...\n";
-
-        const int iterations = 10000;
-        auto start = std::chrono::high_resolution_clock::now();
-
-        for (int i = 0; i < iterations; ++i) {
-            std::string key = "bench_key_" + std::to_string(i % 1000);
-            client_.get(key);
-        }
-
-        auto end = std::chrono::high_resolution_clock::now();
-        auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(
-            end - start).count();
-
-        double ops_per_sec = (iterations * 1000.0) / duration;
-        double latency_ms = static_cast<double>(duration) / iterations;
-
-        std::cout << "  Operations: " << iterations << "\n";
-        std::cout << "  Duration: " << duration << " ms\n";
-        std::cout << "  Throughput: " << std::fixed << std::setprecision(2)
-                  << ops_per_sec << " ops/sec\n";
-        std::cout << "  Avg Latency: " << std::fixed << std::setprecision(3)
-                  << latency_ms << " ms\n\n";
+    std::cout << "\n========================================\n";
+    std::cout << "     DistKV Performance Benchmark\n";
+    std::cout << "========================================\n\n";
+    std::cout << "Server:     "
+              << (config.unix_socket.empty() ? config.host + ":" + std::to_string(config.port) : config.unix_socket)
+              << (config.binary ? " (binary protocol)" : "") << "\n";
+    std::cout << "Load:       " << config.threads << " threads x " << config.clients
+              << " connections, pipeline " << config.pipeline << ", ";
+    if (config.duration_s > 0) {
+        std::cout << config.duration_s << "s";
+    } else {
+        std::cout << config.requests << " requests per connection";
     }
-
-    void benchmark_mixed() {
-        std::cout << "Benchmarking mixed operations (50% SET, 50% GET)...\n";
-
-        const int iterations = 10000;
-        auto start = std::chrono::high_resolution_clock::now();
-
-        for (int i = 0; i < iterations; ++i) {
-            std::string key = "mixed_key_" + std::to_string(i % 1000);
-
-            if (i % 2 == 0) {
-                client_.set(key, "value");
-            } else {
-                client_.get(key);
-            }
-        }
-
-        auto end = std::chrono::high_resolution_clock::now();
-        auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(
-            end - start).count();
-
-        double ops_per_sec = (iterations * 1000.0) / duration;
-
-        std::cout << "  Operations: " << iterations << "\n";
-        std::cout << "  Duration: " << duration << " ms\n";
-        std::cout << "  Throughput: " << std::fixed << std::setprecision(2)
-                  << ops_per_sec << " ops/sec\n\n";
+    if (config.rate > 0) {
+        std::cout << ", open loop at " << config.rate << " requests/sec";
     }
-
-    void benchmark_list_operations() {
-        std::cout << "Benchmarking list operations (LPUSH/RPOP)...\n";
-
-        const int iterations = 5000;
-        const std::string list_key = "bench_list";
-
-        auto start = std::chrono::high_resolution_clock::now();
-
-        for (int i = 0; i < iterations; ++i) {
-            client_.lpush(list_key, "item_" + std::to_string(i));
-        }
-
-        for (int i = 0; i < iterations; ++i) {
-            client_.rpop(list_key);
-        }
-
-        auto end = std::chrono::high_resolution_clock::now();
-        auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(
-            end - start).count();
-
-        double ops_per_sec = (iterations * 2 * 1000.0) / duration;
-
-        std::cout << "  Operations: " << (iterations * 2) << "\n";
-        std::cout << "  Duration: " << duration << " ms\n";
-        std::cout << "  Throughput: " << std::fixed << std::setprecision(2)
-                  << ops_per_sec << " ops/sec\n\n";
+    std::cout << "\n";
+    std::cout << "Keys:       " << config.key_space << (config.preload ? " (preloaded)" : "") << ", "
+              << config.key_distribution.describe() << "\n";
+    std::cout << "Values:     " << config.value_size.describe() << "\n";
+    std::cout << "Mix:        " << describe_mix(config.mix) << "\n\n";
+
+    LoadGenerator generator(config);
+    LoadResult result = generator.run([](double seconds, uint64_t answered) {
+        std::cerr << "[" << std::fixed << std::setprecision(0) << seconds << "s] " << answered
+                  << " requests, " << answered / seconds << " ops/sec\n";
+    });
+    if (result.totals.ops == 0) {
+        std::cerr << "Benchmark failed: " << result.error << "\n";
+        std::cerr << "Start server with: ./distkv-server\n";
+        return 1;
     }
 
-    void benchmark_set_operations() {
-        std::cout << "Benchmarking set operations (SADD)...\n";
-
-        const int iterations = 5000;
-        const std::string set_key = "bench_set";
-
-        auto start = std::chrono::high_resolution_clock::now();
-
-        for (int i = 0; i < iterations; ++i) {
-            client_.sadd(set_key, "member_" + std::to_string(i));
-        }
-
-        auto end = std::chrono::high_resolution_clock::now();
-        auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(
-            end - start).count();
-
-        double ops_per_sec = (iterations * 1000.0) / duration;
-
-        std::cout << "  Operations: " << iterations << "\n";
-        std::cout << "  Duration: " << duration << " ms\n";
-        std::cout << "  Throughput: " << std::fixed << std::setprecision(2)
-                  << ops_per_sec << " ops/sec\n\n";
-
-        // Cleanup
-        client_.del(set_key);
+    ResultDocument doc = result.document(generator.config());
+    doc.set_label(label);
+    std::cout << "\n" << result.report();
+    uint64_t rss = 0;
+    uint64_t peak = 0;
+    if (server_pid > 0 && process_rss(server_pid, rss, peak)) {
+        std::cout << std::fixed << std::setprecision(1) << "Server RSS " << rss / 1048576.0 << " MB, peak "
+                  << peak / 1048576.0 << " MB\n";
+        doc.set_resource("server_rss_bytes", static_cast<double>(rss));
+        doc.set_resource("server_peak_rss_bytes", static_cast<double>(peak));
+    } else if (server_pid > 0) {
+        std::cerr << "Cannot read memory use of process " << server_pid << "\n";
     }
-
-    void benchmark_concurrent() {
-        std::cout << "Benchmarking concurrent access (4 threads)...\n";
-
-        const int num_threads = 4;
-        const int ops_per_thread = 2500;
-        std::vector<std::thread> threads;
-        std::vector<double> thread_times(num_threads);
-
-        auto start = std::chrono::high_resolution_clock::now();
-
-        for (int t = 0; t < num_threads; ++t) {
-            threads.emplace_back([this, t, ops_per_thread, &thread_times]() {
-                Client client;
-                client.connect("127.0.0.1", 6379);
-
-                auto thread_start = std::chrono::high_resolution_clock::now();
-
-                for (int i = 0; i < ops_per_thread; ++i) {
-                    std::string key = "thread_" + std::to_string(t) +
-                                     "_key_" + std::to_string(i);
-                    client.set(key, "value");
-                }
-
-                auto thread_end = std::chrono::high_resolution_clock::now();
-                thread_times[t] = std::chrono::duration_cast<std::chrono::milliseconds>(
-                    thread_end - thread_start).count();
-
-                client.disconnect();
-            });
-        }
-
-        for (auto& t : threads) {
-            t.join();
-        }
-
-        auto end = std::chrono::high_resolution_clock::now();
-        auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(
-            end - start).count();
-
-        int total_ops = num_threads * ops_per_thread;
-        double ops_per_sec = (total_ops * 1000.0) / duration;
-        double avg_thread_time = std::accumulate(thread_times.begin(),
-                                                   thread_times.end(), 0.0) /
-                                 num_threads;
-
-        std::cout << "  Threads: " << num_threads << "\n";
-        std::cout << "  Total operations: " << total_ops << "\n";
-        std::cout << "  Wall time: " << duration << " ms\n";
-        std::cout << "  Avg thread time: " << std::fixed << std::setprecision(2)
-                  << avg_thread_time << " ms\n";
-        std::cout << "  Throughput: " << std::fixed << std::setprecision(2)
-                  << ops_per_sec << " ops/sec\n\n";
+    if (!hdr_file.empty() && !write_file(hdr_file, result.histograms())) {
+        std::cerr << "Failed to write " << hdr_file << "\n";
+    }
+    if (!json_file.empty() && !write_file(json_file, doc.to_json())) {
+        std::cerr << "Failed to write " << json_file << "\n";
+    }
+    if (!result.ok) {
+        std::cerr << "Stopped early: " << result.error << "\n";
+        return 1;
     }
-};
-
-int main() {
-    Benchmark bench;
-    bench.run_all();
     return 0;
 }
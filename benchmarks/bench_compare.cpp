@@ -0,0 +1,182 @@
+#include "bench_results.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <string>
+
+using namespace distkv;
+
+bool read_results(const std::string& path, ResultSet& results) {
+    std::ifstream file(path);
+    if (!file) {
+        std::cerr << "Cannot read " << path << "\n";
+        return false;
+    }
+    std::string text((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    std::string error;
+    if (!results.load(text, error)) {
+        std::cerr << path << ": " << error << "\n";
+        return false;
+    }
+    return true;
+}
+
+// "p99_us=20" into a metric threshold override
+bool parse_metric_threshold(const std::string& spec, CompareOptions& options) {
+    size_t eq = spec.find('=');
+    if (eq == std::string::npos || eq == 0) {
+        return false;
+    }
+    char* end = nullptr;
+    double percent = std::strtod(spec.c_str() + eq + 1, &end);
+    if (*end != '\0' || percent < 0) {
+        return false;
+    }
+    options.metric_thresholds.emplace_back(spec.substr(0, eq), percent / 100);
+    return true;
+}
+
+const char* verdict_name(Verdict verdict) {
+    switch (verdict) {
+        case Verdict::UNCHANGED: return "";
+        case Verdict::IMPROVED: return "improved";
+        case Verdict::REGRESSED: return "REGRESSED";
+        case Verdict::ADDED: return "added";
+        case Verdict::REMOVED: return "removed";
+    }
+    return "";
+}
+
+// Plain digits up to millions, then exponents
+void format_value(char* out, size_t size, double value) {
+    std::snprintf(out, size, std::fabs(value) >= 1e6 && std::fabs(value) < 1e12 ? "%.0f" : "%.6g", value);
+}
+
+std::string describe(const std::string& path, const ResultSet& results) {
+    return path + " (" + (results.label.empty() ? results.suite : results.label) + ")";
+}
+
+int main(int argc, char* argv[]) {
+    CompareOptions options;
+    bool show_all = false;
+    std::vector<std::string> files;
+
+    // Parse command line arguments
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--threshold") == 0 && i + 1 < argc) {
+            options.threshold = std::atof(argv[i + 1]) / 100;
+            ++i;
+        } else if (std::strcmp(argv[i], "--metric-threshold") == 0 && i + 1 < argc) {
+            if (!parse_metric_threshold(argv[i + 1], options)) {
+                std::cerr << "Invalid --metric-threshold " << argv[i + 1] << ", expected <metric>=<percent>\n";
+                return 2;
+            }
+            ++i;
+        } else if (std::strcmp(argv[i], "--all") == 0) {
+            show_all = true;
+        } else if (std::strcmp(argv[i], "--help") == 0) {
+            std::cout << "DistKV Benchmark Compare - diff two bench or microbench result files\n\n";
+            std::cout << "Usage: " << argv[0] << " [options] <baseline.json> <current.json>\n\n";
+            std::cout << "Options:\n";
+            std::cout << "  --threshold <percent>    Noise allowance for throughput and ns/op\n";
+            std::cout << "                           (default: 5)\n";
+            std::cout << "  --metric-threshold <m>=<percent>\n";
+            std::cout << "                           Noise allowance for one metric, e.g. p99_us=20;\n";
+            std::cout << "                           repeatable. Defaults: mean/p50/p90 10,\n";
+            std::cout << "                           p99 15, p99.9/p99.99/max 25, memory 10,\n";
+            std::cout << "                           allocs/op 2, errors 0\n";
+            std::cout << "  --all                    Also list metrics within their threshold\n";
+            std::cout << "  --help                   Show this help message\n";
+            std::cout << "\nExits 1 if any metric regressed beyond its threshold, 2 on bad input.\n";
+            return 0;
+        } else if (argv[i][0] == '-' && argv[i][1] != '\0') {
+            std::cerr << "Unknown option " << argv[i] << ", see --help\n";
+            return 2;
+        } else {
+            files.push_back(argv[i]);
+        }
+    }
+    if (files.size() != 2) {
+        std::cerr << "Expected a baseline and a current result file, see --help\n";
+        return 2;
+    }
+
+    ResultSet baseline;
+    ResultSet current;
+    if (!read_results(files[0], baseline) || !read_results(files[1], current)) {
+        return 2;
+    }
+    if (baseline.suite != current.suite) {
+        std::cerr << "Cannot compare " << baseline.suite << " results with " << current.suite << " results\n";
+        return 2;
+    }
+
+    std::cout << "Baseline: " << describe(files[0], baseline) << "\n";
+    std::cout << "Current:  " << describe(files[1], current) << "\n";
+
+    // Numbers from different machines or builds are not comparable
+    for (const auto& field : baseline.environment) {
+        if (field.first == "timestamp") {
+            continue;
+        }
+        for (const auto& other : current.environment) {
+            if (other.first == field.first && other.second != field.second) {
+                std::cout << "Warning: " << field.first << " differs: \"" << field.second << "\" vs \""
+                          << other.second << "\"\n";
+            }
+        }
+    }
+
+    std::vector<MetricChange> changes = compare_results(baseline, current, options);
+    size_t width = 9;
+    for (const auto& change : changes) {
+        width = std::max(width, change.benchmark.size());
+    }
+
+    size_t counts[5] = {0, 0, 0, 0, 0};
+    bool header = false;
+    for (const auto& change : changes) {
+        ++counts[static_cast<int>(change.verdict)];
+        if (change.verdict == Verdict::UNCHANGED && !show_all) {
+            continue;
+        }
+        if (!header) {
+            std::printf("\n%-*s  %-22s %14s %14s %9s %9s\n", static_cast<int>(width), "Benchmark", "Metric",
+                        "Baseline", "Current", "Change", "Noise");
+            std::printf("%s\n", std::string(width + 75, '-').c_str());
+            header = true;
+        }
+        char baseline_text[32] = "-";
+        char current_text[32] = "-";
+        char change_text[32] = "";
+        char noise_text[32] = "";
+        if (change.verdict != Verdict::ADDED) {
+            format_value(baseline_text, sizeof(baseline_text), change.baseline);
+        }
+        if (change.verdict != Verdict::REMOVED) {
+            format_value(current_text, sizeof(current_text), change.current);
+        }
+        if (change.verdict != Verdict::ADDED && change.verdict != Verdict::REMOVED) {
+            if (std::isinf(change.change)) {
+                std::snprintf(change_text, sizeof(change_text), "from 0");
+            } else {
+                std::snprintf(change_text, sizeof(change_text), "%+.1f%%", change.change * 100);
+            }
+            std::snprintf(noise_text, sizeof(noise_text), "%.3g%%", change.threshold * 100);
+        }
+        std::printf("%-*s  %-22s %14s %14s %9s %9s  %s\n", static_cast<int>(width), change.benchmark.c_str(),
+                    change.metric.c_str(), baseline_text, current_text, change_text, noise_text,
+                    verdict_name(change.verdict));
+    }
+
+    std::printf("\n%zu regressed, %zu improved, %zu within noise, %zu added, %zu removed\n",
+                counts[static_cast<int>(Verdict::REGRESSED)], counts[static_cast<int>(Verdict::IMPROVED)],
+                counts[static_cast<int>(Verdict::UNCHANGED)], counts[static_cast<int>(Verdict::ADDED)],
+                counts[static_cast<int>(Verdict::REMOVED)]);
+    return counts[static_cast<int>(Verdict::REGRESSED)] > 0 ? 1 : 0;
+}
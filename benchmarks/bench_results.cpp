@@ -0,0 +1,551 @@
+#include "bench_results.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <fstream>
+#include <iterator>
+#include <thread>
+
+#ifndef _WIN32
+    #include <sys/resource.h>
+    #include <sys/utsname.h>
+    #include <unistd.h>
+#endif
+
+namespace distkv {
+
+namespace {
+
+// Shortest text that reads back as the same double
+std::string json_number(double value) {
+    if (!std::isfinite(value)) {
+        return "null";
+    }
+    char text[32];
+    std::snprintf(text, sizeof(text), "%.17g", value);
+    for (int precision = 6; precision < 17; ++precision) {
+        char shorter[32];
+        std::snprintf(shorter, sizeof(shorter), "%.*g", precision, value);
+        if (std::strtod(shorter, nullptr) == value) {
+            return shorter;
+        }
+    }
+    return text;
+}
+
+std::string metrics_json(const Metrics& metrics) {
+    std::string out = "{";
+    for (size_t i = 0; i < metrics.size(); ++i) {
+        out += (i ? ",\"" : "\"") + json_escape(metrics[i].first) + "\":" + json_number(metrics[i].second);
+    }
+    return out + "}";
+}
+
+std::string trim(const std::string& s) {
+    size_t start = s.find_first_not_of(" \t");
+    size_t end = s.find_last_not_of(" \t\r\n");
+    return start == std::string::npos ? "" : s.substr(start, end - start + 1);
+}
+
+// "VmRSS:     1234 kB" style field of a /proc status file, in bytes
+bool status_field(const std::string& status, const char* name, uint64_t& bytes) {
+    size_t at = status.find(name);
+    if (at == std::string::npos) {
+        return false;
+    }
+    bytes = std::strtoull(status.c_str() + at + std::strlen(name), nullptr, 10) * 1024;
+    return true;
+}
+
+bool ends_with(const std::string& s, const std::string& suffix) {
+    return s.size() >= suffix.size() && s.compare(s.size() - suffix.size(), suffix.size(), suffix) == 0;
+}
+
+} // namespace
+
+std::string json_escape(const std::string& s) {
+    std::string out;
+    for (char c : s) {
+        if (c == '"' || c == '\\') {
+            out += '\\';
+            out += c;
+        } else if (static_cast<unsigned char>(c) < 0x20) {
+            char escaped[8];
+            std::snprintf(escaped, sizeof(escaped), "\\u%04x", static_cast<unsigned char>(c));
+            out += escaped;
+        } else {
+            out += c;
+        }
+    }
+    return out;
+}
+
+Environment Environment::current() {
+    Environment env;
+    env.cores = std::thread::hardware_concurrency();
+#ifndef _WIN32
+    char host[256] = "";
+    if (gethostname(host, sizeof(host) - 1) == 0) {
+        env.hostname = host;
+    }
+    struct utsname names;
+    if (uname(&names) == 0) {
+        env.os = std::string(names.sysname) + " " + names.release + " " + names.machine;
+    }
+#else
+    env.os = "Windows";
+#endif
+
+    std::ifstream cpuinfo("/proc/cpuinfo");
+    std::string line;
+    while (std::getline(cpuinfo, line)) {
+        if (line.compare(0, 10, "model name") == 0 && line.find(':') != std::string::npos) {
+            env.cpu = trim(line.substr(line.find(':') + 1));
+            break;
+        }
+    }
+
+#if defined(__clang__)
+    env.compiler = "clang " __clang_version__;
+#elif defined(__GNUC__)
+    env.compiler = "gcc " __VERSION__;
+#elif defined(_MSC_VER)
+    env.compiler = "msvc " + std::to_string(_MSC_VER);
+#endif
+#if defined(__OPTIMIZE__) || (defined(_MSC_VER) && !defined(_DEBUG))
+    env.optimized = true;
+#endif
+
+    std::time_t now = std::time(nullptr);
+    std::tm utc{};
+#ifdef _WIN32
+    gmtime_s(&utc, &now);
+#else
+    gmtime_r(&now, &utc);
+#endif
+    char stamp[32];
+    std::strftime(stamp, sizeof(stamp), "%Y-%m-%dT%H:%M:%SZ", &utc);
+    env.timestamp = stamp;
+    return env;
+}
+
+std::string Environment::to_json() const {
+    return "{\"hostname\":\"" + json_escape(hostname) + "\",\"os\":\"" + json_escape(os) + "\",\"cpu\":\"" +
+           json_escape(cpu) + "\",\"cores\":" + std::to_string(cores) + ",\"compiler\":\"" +
+           json_escape(compiler) + "\",\"optimized\":" + (optimized ? "true" : "false") +
+           ",\"timestamp\":\"" + timestamp + "\"}";
+}
+
+uint64_t peak_rss_bytes() {
+#ifndef _WIN32
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) == 0) {
+#ifdef __APPLE__
+        return static_cast<uint64_t>(usage.ru_maxrss);         // bytes
+#else
+        return static_cast<uint64_t>(usage.ru_maxrss) * 1024;  // kilobytes
+#endif
+    }
+#endif
+    return 0;
+}
+
+bool process_rss(int pid, uint64_t& rss, uint64_t& peak) {
+    std::ifstream file("/proc/" + std::to_string(pid) + "/status");
+    if (!file) {
+        return false;
+    }
+    std::string status((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    return status_field(status, "VmRSS:", rss) && status_field(status, "VmHWM:", peak);
+}
+
+ResultDocument::ResultDocument(const std::string& suite) : suite_(suite) {}
+
+void ResultDocument::set_config(const std::string& key, const std::string& value) {
+    config_.emplace_back(key, "\"" + json_escape(value) + "\"");
+}
+
+void ResultDocument::set_config(const std::string& key, double value) {
+    config_.emplace_back(key, json_number(value));
+}
+
+void ResultDocument::set_config(const std::string& key, bool value) {
+    config_.emplace_back(key, value ? "true" : "false");
+}
+
+void ResultDocument::add_benchmark(const std::string& name, const Metrics& metrics) {
+    benchmarks_.emplace_back(name, metrics);
+}
+
+void ResultDocument::set_resource(const std::string& key, double value) {
+    resources_.emplace_back(key, value);
+}
+
+std::string ResultDocument::to_json() const {
+    std::string out = "{\"schema\":1,\"suite\":\"" + json_escape(suite_) + "\",\"label\":\"" +
+                      json_escape(label_) + "\",\"ok\":" + (error_.empty() ? "true" : "false") +
+                      ",\"error\":\"" + json_escape(error_) + "\",\n\"environment\":" +
+                      Environment::current().to_json() + ",\n\"config\":{";
+    for (size_t i = 0; i < config_.size(); ++i) {
+        out += (i ? ",\"" : "\"") + json_escape(config_[i].first) + "\":" + config_[i].second;
+    }
+    out += "},\n\"benchmarks\":[";
+    for (size_t i = 0; i < benchmarks_.size(); ++i) {
+        out += std::string(i ? ",\n" : "\n") + "{\"name\":\"" + json_escape(benchmarks_[i].first) +
+               "\",\"metrics\":" + metrics_json(benchmarks_[i].second) + "}";
+    }
+    return out + "],\n\"resources\":" + metrics_json(resources_) + "}\n";
+}
+
+// Recursive descent over the text; nesting is limited so a hostile file
+// cannot exhaust the stack
+class JsonParser {
+public:
+    explicit JsonParser(const std::string& text) : text_(text) {}
+
+    bool parse(JsonValue& value, std::string& error) {
+        if (!parse_value(value, 0) || (skip_space(), pos_ != text_.size())) {
+            error = error_.empty() ? "unexpected character" : error_;
+            error += " at offset " + std::to_string(pos_);
+            return false;
+        }
+        return true;
+    }
+
+private:
+    static constexpr int MAX_DEPTH = 64;
+
+    bool fail(const char* message) {
+        if (error_.empty()) {
+            error_ = message;
+        }
+        return false;
+    }
+
+    void skip_space() {
+        while (pos_ < text_.size() &&
+               (text_[pos_] == ' ' || text_[pos_] == '\t' || text_[pos_] == '\r' || text_[pos_] == '\n')) {
+            ++pos_;
+        }
+    }
+
+    bool literal(const char* word) {
+        size_t len = std::strlen(word);
+        if (text_.compare(pos_, len, word) != 0) {
+            return false;
+        }
+        pos_ += len;
+        return true;
+    }
+
+    bool parse_value(JsonValue& value, int depth) {
+        if (depth > MAX_DEPTH) {
+            return fail("nesting too deep");
+        }
+        skip_space();
+        if (pos_ >= text_.size()) {
+            return fail("unexpected end");
+        }
+        char c = text_[pos_];
+        if (c == '{') {
+            return parse_object(value, depth);
+        }
+        if (c == '[') {
+            return parse_array(value, depth);
+        }
+        if (c == '"') {
+            value.type_ = JsonValue::Type::STRING;
+            return parse_string(value.string_);
+        }
+        if (literal("true") || literal("false")) {
+            value.type_ = JsonValue::Type::BOOLEAN;
+            value.boolean_ = c == 't';
+            return true;
+        }
+        if (literal("null")) {
+            value.type_ = JsonValue::Type::NUL;
+            return true;
+        }
+        const char* start = text_.c_str() + pos_;
+        char* end = nullptr;
+        value.number_ = std::strtod(start, &end);
+        if (end == start || (c != '-' && (c < '0' || c > '9'))) {
+            return fail("unexpected character");
+        }
+        value.type_ = JsonValue::Type::NUMBER;
+        pos_ += static_cast<size_t>(end - start);
+        return true;
+    }
+
+    bool parse_object(JsonValue& value, int depth) {
+        value.type_ = JsonValue::Type::OBJECT;
+        ++pos_;
+        skip_space();
+        if (pos_ < text_.size() && text_[pos_] == '}') {
+            ++pos_;
+            return true;
+        }
+        while (true) {
+            skip_space();
+            std::string key;
+            if (pos_ >= text_.size() || text_[pos_] != '"' || !parse_string(key)) {
+                return fail("expected member name");
+            }
+            skip_space();
+            if (pos_ >= text_.size() || text_[pos_] != ':') {
+                return fail("expected ':'");
+            }
+            ++pos_;
+            value.keys_.push_back(key);
+            value.items_.emplace_back();
+            if (!parse_value(value.items_.back(), depth + 1)) {
+                return false;
+            }
+            skip_space();
+            if (pos_ < text_.size() && text_[pos_] == ',') {
+                ++pos_;
+            } else if (pos_ < text_.size() && text_[pos_] == '}') {
+                ++pos_;
+                return true;
+            } else {
+                return fail("expected ',' or '}'");
+            }
+        }
+    }
+
+    bool parse_array(JsonValue& value, int depth) {
+        value.type_ = JsonValue::Type::ARRAY;
+        ++pos_;
+        skip_space();
+        if (pos_ < text_.size() && text_[pos_] == ']') {
+            ++pos_;
+            return true;
+        }
+        while (true) {
+            value.items_.emplace_back();
+            if (!parse_value(value.items_.back(), depth + 1)) {
+                return false;
+            }
+            skip_space();
+            if (pos_ < text_.size() && text_[pos_] == ',') {
+                ++pos_;
+            } else if (pos_ < text_.size() && text_[pos_] == ']') {
+                ++pos_;
+                return true;
+            } else {
+                return fail("expected ',' or ']'");
+            }
+        }
+    }
+
+    // From the opening quote; \u escapes become UTF-8
+    bool parse_string(std::string& out) {
+        ++pos_;
+        while (pos_ < text_.size() && text_[pos_] != '"') {
+            char c = text_[pos_++];
+            if (c != '\\') {
+                out += c;
+                continue;
+            }
+            if (pos_ >= text_.size()) {
+                break;
+            }
+            char e = text_[pos_++];
+            switch (e) {
+                case 'b': out += '\b'; break;
+                case 'f': out += '\f'; break;
+                case 'n': out += '\n'; break;
+                case 'r': out += '\r'; break;
+                case 't': out += '\t'; break;
+                case 'u': {
+                    if (pos_ + 4 > text_.size()) {
+                        return fail("bad \\u escape");
+                    }
+                    unsigned code = static_cast<unsigned>(std::strtoul(text_.substr(pos_, 4).c_str(), nullptr, 16));
+                    pos_ += 4;
+                    if (code < 0x80) {
+                        out += static_cast<char>(code);
+                    } else if (code < 0x800) {
+                        out += static_cast<char>(0xC0 | (code >> 6));
+                        out += static_cast<char>(0x80 | (code & 0x3F));
+                    } else {
+                        out += static_cast<char>(0xE0 | (code >> 12));
+                        out += static_cast<char>(0x80 | ((code >> 6) & 0x3F));
+                        out += static_cast<char>(0x80 | (code & 0x3F));
+                    }
+                    break;
+                }
+                default: out += e; break;
+            }
+        }
+        if (pos_ >= text_.size()) {
+            return fail("unterminated string");
+        }
+        ++pos_;
+        return true;
+    }
+
+    const std::string& text_;
+    size_t pos_ = 0;
+    std::string error_;
+};
+
+bool JsonValue::parse(const std::string& text, JsonValue& value, std::string& error) {
+    value = JsonValue();
+    JsonParser parser(text);
+    return parser.parse(value, error);
+}
+
+const JsonValue* JsonValue::find(const std::string& key) const {
+    for (size_t i = 0; i < keys_.size(); ++i) {
+        if (keys_[i] == key) {
+            return &items_[i];
+        }
+    }
+    return nullptr;
+}
+
+bool ResultSet::load(const std::string& text, std::string& error) {
+    JsonValue doc;
+    if (!JsonValue::parse(text, doc, error)) {
+        return false;
+    }
+    const JsonValue* benchmarks_json = doc.find("benchmarks");
+    if (doc.type() != JsonValue::Type::OBJECT || !benchmarks_json ||
+        benchmarks_json->type() != JsonValue::Type::ARRAY) {
+        error = "not a benchmark result file (no benchmarks array)";
+        return false;
+    }
+
+    auto text_of = [](const JsonValue* value) { return value ? value->string() : std::string(); };
+    auto numbers = [](const JsonValue* object) {
+        Metrics metrics;
+        if (object && object->type() == JsonValue::Type::OBJECT) {
+            for (size_t i = 0; i < object->keys().size(); ++i) {
+                if (object->items()[i].type() == JsonValue::Type::NUMBER) {
+                    metrics.emplace_back(object->keys()[i], object->items()[i].number());
+                }
+            }
+        }
+        return metrics;
+    };
+
+    suite = text_of(doc.find("suite"));
+    label = text_of(doc.find("label"));
+    environment.clear();
+    if (const JsonValue* env = doc.find("environment")) {
+        for (size_t i = 0; i < env->keys().size(); ++i) {
+            const JsonValue& field = env->items()[i];
+            std::string value = field.type() == JsonValue::Type::STRING  ? field.string()
+                                : field.type() == JsonValue::Type::NUMBER ? json_number(field.number())
+                                : field.type() == JsonValue::Type::BOOLEAN ? (field.boolean() ? "true" : "false")
+                                                                           : "";
+            environment.emplace_back(env->keys()[i], value);
+        }
+    }
+    benchmarks.clear();
+    for (const auto& entry : benchmarks_json->items()) {
+        benchmarks.emplace_back(text_of(entry.find("name")), numbers(entry.find("metrics")));
+    }
+    Metrics resources = numbers(doc.find("resources"));
+    if (!resources.empty()) {
+        benchmarks.emplace_back("resources", resources);
+    }
+    return true;
+}
+
+bool higher_is_better(const std::string& metric) {
+    return ends_with(metric, "_per_sec");
+}
+
+double CompareOptions::threshold_for(const std::string& metric) const {
+    for (const auto& entry : metric_thresholds) {
+        if (entry.first == metric) {
+            return entry.second;
+        }
+    }
+    if (metric == "errors") {
+        return 0;
+    }
+    if (metric == "allocs_per_op") {
+        return 0.02;
+    }
+    if (metric == "p99_9_us" || metric == "p99_99_us" || metric == "max_us") {
+        return 0.25;
+    }
+    if (metric == "p99_us") {
+        return 0.15;
+    }
+    if (ends_with(metric, "_us") || ends_with(metric, "_bytes")) {
+        return 0.10;
+    }
+    return threshold;
+}
+
+std::vector<MetricChange> compare_results(const ResultSet& baseline, const ResultSet& current,
+                                          const CompareOptions& options) {
+    auto find = [](const ResultSet& set, const std::string& benchmark, const std::string& metric,
+                   double& value) {
+        for (const auto& entry : set.benchmarks) {
+            if (entry.first != benchmark) {
+                continue;
+            }
+            for (const auto& m : entry.second) {
+                if (m.first == metric) {
+                    value = m.second;
+                    return true;
+                }
+            }
+        }
+        return false;
+    };
+
+    std::vector<MetricChange> changes;
+    for (const auto& entry : baseline.benchmarks) {
+        for (const auto& metric : entry.second) {
+            MetricChange change;
+            change.benchmark = entry.first;
+            change.metric = metric.first;
+            change.baseline = metric.second;
+            change.threshold = options.threshold_for(metric.first);
+            if (!find(current, entry.first, metric.first, change.current)) {
+                change.verdict = Verdict::REMOVED;
+                changes.push_back(change);
+                continue;
+            }
+            double delta = change.current - change.baseline;
+            if (delta == 0) {
+                change.verdict = Verdict::UNCHANGED;
+            } else {
+                change.change = change.baseline != 0 ? delta / std::fabs(change.baseline)
+                                                     : (delta > 0 ? HUGE_VAL : -HUGE_VAL);
+                bool better = higher_is_better(metric.first) ? delta > 0 : delta < 0;
+                if (std::fabs(change.change) <= change.threshold) {
+                    change.verdict = Verdict::UNCHANGED;
+                } else {
+                    change.verdict = better ? Verdict::IMPROVED : Verdict::REGRESSED;
+                }
+            }
+            changes.push_back(change);
+        }
+    }
+    for (const auto& entry : current.benchmarks) {
+        for (const auto& metric : entry.second) {
+            double unused;
+            if (!find(baseline, entry.first, metric.first, unused)) {
+                MetricChange change;
+                change.benchmark = entry.first;
+                change.metric = metric.first;
+                change.current = metric.second;
+                change.verdict = Verdict::ADDED;
+                changes.push_back(change);
+            }
+        }
+    }
+    return changes;
+}
+
+} // namespace distkv
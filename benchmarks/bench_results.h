@@ -0,0 +1,141 @@
+#ifndef DISTKV_BENCH_RESULTS_H
+#define DISTKV_BENCH_RESULTS_H
+
+#include <string>
+#include <vector>
+#include <utility>
+#include <cstdint>
+
+namespace distkv {
+
+// Escape a string for use between JSON quotes
+std::string json_escape(const std::string& s);
+
+// Where a run happened. Written into every result file so a comparison
+// can tell when two runs came from different machines or builds.
+struct Environment {
+    std::string hostname;
+    std::string os;                  // "Linux 6.8.0 x86_64"
+    std::string cpu;                 // model name, when the OS reports one
+    unsigned cores = 0;
+    std::string compiler;
+    bool optimized = false;          // built with -O1 or higher
+    std::string timestamp;           // UTC, ISO 8601
+
+    static Environment current();
+    std::string to_json() const;
+};
+
+// Peak resident set size of this process in bytes; 0 if unknown
+uint64_t peak_rss_bytes();
+
+// Current and peak resident set size of another process in bytes, read
+// from /proc/<pid>/status; false where that is unavailable
+bool process_rss(int pid, uint64_t& rss, uint64_t& peak);
+
+using Metrics = std::vector<std::pair<std::string, double>>;
+
+// A benchmark result file:
+//
+//   {"schema":1,"suite":"bench","label":"...","ok":true,"error":"",
+//    "environment":{...},"config":{...},
+//    "benchmarks":[{"name":"GET","metrics":{"ops_per_sec":...}},...],
+//    "resources":{"peak_rss_bytes":...}}
+//
+// Metric names carry their unit and direction: *_per_sec is better
+// higher, everything else (ns_per_op, p99_us, allocs_per_op, *_bytes,
+// errors) better lower. bench-compare relies on that.
+class ResultDocument {
+public:
+    explicit ResultDocument(const std::string& suite);
+
+    void set_label(const std::string& label) { label_ = label; }
+    void set_error(const std::string& error) { error_ = error; }
+    void set_config(const std::string& key, const std::string& value);
+    void set_config(const std::string& key, double value);
+    void set_config(const std::string& key, bool value);
+    void add_benchmark(const std::string& name, const Metrics& metrics);
+    void set_resource(const std::string& key, double value);
+
+    // The document with Environment::current()
+    std::string to_json() const;
+
+private:
+    std::string suite_;
+    std::string label_;
+    std::string error_;
+    std::vector<std::pair<std::string, std::string>> config_;  // key, JSON value
+    std::vector<std::pair<std::string, Metrics>> benchmarks_;
+    Metrics resources_;
+};
+
+// A parsed JSON value; enough of JSON to read result files back
+class JsonValue {
+public:
+    enum class Type { NUL, BOOLEAN, NUMBER, STRING, ARRAY, OBJECT };
+
+    static bool parse(const std::string& text, JsonValue& value, std::string& error);
+
+    Type type() const { return type_; }
+    bool boolean() const { return boolean_; }
+    double number() const { return number_; }
+    const std::string& string() const { return string_; }
+    const std::vector<JsonValue>& items() const { return items_; }
+    const std::vector<std::string>& keys() const { return keys_; }
+
+    // Member of an object, nullptr if missing
+    const JsonValue* find(const std::string& key) const;
+
+private:
+    friend class JsonParser;
+
+    Type type_ = Type::NUL;
+    bool boolean_ = false;
+    double number_ = 0;
+    std::string string_;
+    std::vector<JsonValue> items_;   // array items, or object member values
+    std::vector<std::string> keys_;  // object member names, parallel to items_
+};
+
+// The parts of a result file a comparison needs
+struct ResultSet {
+    std::string suite;
+    std::string label;
+    std::vector<std::pair<std::string, std::string>> environment;  // scalar fields, as text
+    std::vector<std::pair<std::string, Metrics>> benchmarks;       // "resources" last
+
+    bool load(const std::string& text, std::string& error);
+};
+
+enum class Verdict { UNCHANGED, IMPROVED, REGRESSED, ADDED, REMOVED };
+
+struct MetricChange {
+    std::string benchmark;
+    std::string metric;
+    double baseline = 0;
+    double current = 0;
+    double change = 0;               // (current - baseline) / baseline
+    double threshold = 0;            // noise allowance applied
+    Verdict verdict = Verdict::UNCHANGED;
+};
+
+// Relative changes below a metric's threshold count as noise. Tail
+// latencies move more run to run than throughput, so their defaults are
+// wider.
+struct CompareOptions {
+    double threshold = 0.05;         // throughput and ns/op
+    std::vector<std::pair<std::string, double>> metric_thresholds;  // exact metric name overrides
+
+    double threshold_for(const std::string& metric) const;
+};
+
+// *_per_sec metrics are better higher; all others better lower
+bool higher_is_better(const std::string& metric);
+
+// Every metric of both sets, in baseline order with additions last
+std::vector<MetricChange> compare_results(const ResultSet& baseline, const ResultSet& current,
+                                          const CompareOptions& options);
+
+} // namespace distkv
+
+#endif // DISTKV_BENCH_RESULTS_H
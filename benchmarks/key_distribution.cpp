@@ -0,0 +1,157 @@
+#include "key_distribution.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <sstream>
+#include <vector>
+
+namespace distkv {
+
+namespace {
+
+// Terms of the zeta sum computed exactly before switching to the integral
+constexpr uint64_t EXACT_ZETA_TERMS = 1000000;
+
+double uniform01(std::mt19937_64& rng) {
+    return static_cast<double>(rng() >> 11) * (1.0 / 9007199254740992.0);
+}
+
+// "name[:a[:b]]" into its parts
+std::vector<std::string> split(const std::string& spec) {
+    std::vector<std::string> parts;
+    std::istringstream iss(spec);
+    std::string part;
+    while (std::getline(iss, part, ':')) {
+        parts.push_back(part);
+    }
+    return parts;
+}
+
+bool parse_fraction(const std::string& s, double& value) {
+    char* end = nullptr;
+    value = std::strtod(s.c_str(), &end);
+    return !s.empty() && *end == '\0';
+}
+
+} // namespace
+
+ZipfianGenerator::ZipfianGenerator(uint64_t n, double theta)
+    : n_(std::max<uint64_t>(n, 1)), theta_(theta) {
+    zetan_ = zeta(n_, theta_);
+    alpha_ = 1.0 / (1.0 - theta_);
+    half_pow_theta_ = std::pow(0.5, theta_);
+    // Unused below three items, where the first two cases cover every draw
+    eta_ = n_ > 2 ? (1.0 - std::pow(2.0 / n_, 1.0 - theta_)) / (1.0 - zeta(2, theta_) / zetan_) : 0;
+}
+
+double ZipfianGenerator::zeta(uint64_t n, double theta) {
+    uint64_t exact = std::min(n, EXACT_ZETA_TERMS);
+    double sum = 0;
+    for (uint64_t k = 1; k <= exact; ++k) {
+        sum += 1.0 / std::pow(static_cast<double>(k), theta);
+    }
+    if (n > exact) {
+        // Midpoint rule: the remaining terms are the integral over
+        // [exact + 0.5, n + 0.5] to well under a part per million
+        sum += (std::pow(n + 0.5, 1.0 - theta) - std::pow(exact + 0.5, 1.0 - theta)) / (1.0 - theta);
+    }
+    return sum;
+}
+
+uint64_t ZipfianGenerator::next(std::mt19937_64& rng) const {
+    double u = uniform01(rng);
+    double uz = u * zetan_;
+    if (uz < 1.0) {
+        return 0;
+    }
+    if (uz < 1.0 + half_pow_theta_) {
+        return std::min<uint64_t>(1, n_ - 1);
+    }
+    auto k = static_cast<uint64_t>(n_ * std::pow(eta_ * u - eta_ + 1.0, alpha_));
+    return std::min(k, n_ - 1);
+}
+
+bool KeyDistribution::parse(const std::string& spec) {
+    std::vector<std::string> parts = split(spec);
+    if (parts.empty()) {
+        return false;
+    }
+    const std::string& name = parts[0];
+    if (name == "uniform") {
+        kind = Kind::UNIFORM;
+        return parts.size() == 1;
+    }
+    if (name == "zipfian" || name == "latest") {
+        kind = name == "zipfian" ? Kind::ZIPFIAN : Kind::LATEST;
+        if (parts.size() == 1) {
+            return true;
+        }
+        return parts.size() == 2 && parse_fraction(parts[1], theta) && theta > 0 && theta < 1;
+    }
+    if (name == "hotspot") {
+        kind = Kind::HOTSPOT;
+        if (parts.size() == 1) {
+            return true;
+        }
+        return parts.size() == 3 && parse_fraction(parts[1], hot_keys) && parse_fraction(parts[2], hot_ops) &&
+               hot_keys > 0 && hot_keys <= 1 && hot_ops >= 0 && hot_ops <= 1;
+    }
+    return false;
+}
+
+std::string KeyDistribution::describe() const {
+    std::ostringstream out;
+    switch (kind) {
+        case Kind::UNIFORM:
+            out << "uniform";
+            break;
+        case Kind::ZIPFIAN:
+            out << "zipfian (theta " << theta << ")";
+            break;
+        case Kind::HOTSPOT:
+            out << "hotspot (" << hot_ops * 100 << "% of requests to " << hot_keys * 100 << "% of keys)";
+            break;
+        case Kind::LATEST:
+            out << "latest (theta " << theta << ")";
+            break;
+    }
+    return out.str();
+}
+
+KeyChooser::KeyChooser(const KeyDistribution& distribution, uint64_t key_space, std::atomic<uint64_t>* newest)
+    : distribution_(distribution),
+      key_space_(std::max<uint64_t>(key_space, 1)),
+      hot_count_(0),
+      newest_(newest) {
+    if (distribution_.kind == KeyDistribution::Kind::ZIPFIAN || distribution_.kind == KeyDistribution::Kind::LATEST) {
+        zipfian_ = ZipfianGenerator(key_space_, distribution_.theta);
+    }
+    hot_count_ = static_cast<uint64_t>(key_space_ * distribution_.hot_keys);
+    hot_count_ = std::min(std::max<uint64_t>(hot_count_, 1), key_space_);
+}
+
+uint64_t KeyChooser::next(std::mt19937_64& rng, bool write) {
+    switch (distribution_.kind) {
+        case KeyDistribution::Kind::UNIFORM:
+            break;
+        case KeyDistribution::Kind::ZIPFIAN:
+            return zipfian_.next(rng);
+        case KeyDistribution::Kind::HOTSPOT:
+            if (hot_count_ == key_space_ || uniform01(rng) < distribution_.hot_ops) {
+                return rng() % hot_count_;
+            }
+            return hot_count_ + rng() % (key_space_ - hot_count_);
+        case KeyDistribution::Kind::LATEST:
+            if (newest_ == nullptr) {
+                break;
+            }
+            if (write) {
+                return newest_->fetch_add(1, std::memory_order_relaxed);
+            }
+            // Zipfian by age over the newest key_space keys
+            return newest_->load(std::memory_order_relaxed) - 1 - zipfian_.next(rng);
+    }
+    return rng() % key_space_;
+}
+
+} // namespace distkv
@@ -0,0 +1,84 @@
+#ifndef DISTKV_KEY_DISTRIBUTION_H
+#define DISTKV_KEY_DISTRIBUTION_H
+
+#include <atomic>
+#include <random>
+#include <string>
+#include <cstdint>
+
+namespace distkv {
+
+// Zipfian numbers in [0, n): item k is drawn with probability proportional
+// to 1 / (k + 1)^theta, so 0 is the most popular. Gray et al.'s method
+// ("Quickly Generating Billion-Record Synthetic Databases", as used by
+// YCSB): constant time per draw after computing zeta(n, theta) once.
+// Copies share nothing and are cheap, one per thread.
+class ZipfianGenerator {
+public:
+    // theta in (0, 1); YCSB's default 0.99 sends about 13% of draws over
+    // 1000 items to the first one
+    ZipfianGenerator(uint64_t n = 1, double theta = 0.99);
+
+    uint64_t next(std::mt19937_64& rng) const;
+
+    uint64_t items() const { return n_; }
+    double theta() const { return theta_; }
+
+    // sum over k = 1..n of 1 / k^theta; exact for the first million terms,
+    // the integral of the rest beyond, so large key spaces start quickly
+    static double zeta(uint64_t n, double theta);
+
+private:
+    uint64_t n_;
+    double theta_;
+    double zetan_;
+    double alpha_;
+    double eta_;
+    double half_pow_theta_;
+};
+
+// How the load generator picks key numbers in [0, key_space)
+struct KeyDistribution {
+    enum class Kind {
+        UNIFORM,   // every key equally likely
+        ZIPFIAN,   // a few keys take most requests (theta)
+        HOTSPOT,   // hot_ops of requests go to the first hot_keys of keys
+        LATEST     // writes add new keys; reads favor the newest (theta)
+    };
+
+    Kind kind = Kind::UNIFORM;
+    double theta = 0.99;
+    double hot_keys = 0.2;
+    double hot_ops = 0.8;
+
+    // "uniform", "zipfian[:theta]", "hotspot[:keys:ops]" (fractions, e.g.
+    // hotspot:0.01:0.9) or "latest[:theta]"
+    bool parse(const std::string& spec);
+    std::string describe() const;
+};
+
+// Draws keys from a KeyDistribution. Build one per run and copy it into
+// each thread; the zeta sum is computed once and copies draw
+// independently. LATEST copies share the count of keys written through
+// the newest pointer.
+class KeyChooser {
+public:
+    // newest counts keys in existence for LATEST, starting from key_space
+    // (the preloaded keys); unused by other kinds
+    KeyChooser(const KeyDistribution& distribution, uint64_t key_space, std::atomic<uint64_t>* newest);
+
+    // Key for a request; write is true for commands that store a value,
+    // which under LATEST create the next new key instead
+    uint64_t next(std::mt19937_64& rng, bool write);
+
+private:
+    KeyDistribution distribution_;
+    uint64_t key_space_;
+    uint64_t hot_count_;
+    ZipfianGenerator zipfian_;
+    std::atomic<uint64_t>* newest_;
+};
+
+} // namespace distkv
+
+#endif // DISTKV_KEY_DISTRIBUTION_H
@@ -0,0 +1,145 @@
+#include "latency_histogram.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+
+namespace distkv {
+
+namespace {
+
+int highest_bit(uint64_t value) {
+    int bit = 0;
+    while (value >>= 1) {
+        ++bit;
+    }
+    return bit;
+}
+
+std::string format(const char* fmt, double a, double b, unsigned long long c, double d) {
+    char line[128];
+    std::snprintf(line, sizeof(line), fmt, a, b, c, d);
+    return line;
+}
+
+} // namespace
+
+size_t LatencyHistogram::index_of(uint64_t value) {
+    if (value < 2 * SUB_BUCKETS) {
+        return static_cast<size_t>(value);
+    }
+    int shift = highest_bit(value) - SUB_BUCKET_BITS;
+    return static_cast<size_t>(SUB_BUCKETS * (shift + 1) + ((value >> shift) - SUB_BUCKETS));
+}
+
+uint64_t LatencyHistogram::highest_in(size_t index) {
+    if (index < 2 * SUB_BUCKETS) {
+        return index;
+    }
+    int shift = static_cast<int>(index / SUB_BUCKETS) - 1;
+    uint64_t sub = index % SUB_BUCKETS + SUB_BUCKETS;
+    return ((sub + 1) << shift) - 1;
+}
+
+void LatencyHistogram::record(uint64_t value, uint64_t count) {
+    if (count == 0) {
+        return;
+    }
+    size_t index = index_of(value);
+    if (index >= counts_.size()) {
+        counts_.resize(index + 1, 0);
+    }
+    counts_[index] += count;
+    total_ += count;
+    sum_ += static_cast<long double>(value) * count;
+    min_ = std::min(min_, value);
+    max_ = std::max(max_, value);
+}
+
+void LatencyHistogram::merge(const LatencyHistogram& other) {
+    if (other.counts_.size() > counts_.size()) {
+        counts_.resize(other.counts_.size(), 0);
+    }
+    for (size_t i = 0; i < other.counts_.size(); ++i) {
+        counts_[i] += other.counts_[i];
+    }
+    total_ += other.total_;
+    sum_ += other.sum_;
+    min_ = std::min(min_, other.min_);
+    max_ = std::max(max_, other.max_);
+}
+
+double LatencyHistogram::mean() const {
+    return total_ ? static_cast<double>(sum_ / total_) : 0;
+}
+
+uint64_t LatencyHistogram::value_at(double q) const {
+    if (total_ == 0) {
+        return 0;
+    }
+    uint64_t target = static_cast<uint64_t>(std::ceil(std::min(std::max(q, 0.0), 1.0) * total_));
+    target = std::max<uint64_t>(target, 1);
+    uint64_t seen = 0;
+    for (size_t i = 0; i < counts_.size(); ++i) {
+        seen += counts_[i];
+        if (seen >= target) {
+            return std::max(std::min(highest_in(i), max_), min_);
+        }
+    }
+    return max_;
+}
+
+std::string LatencyHistogram::percentile_distribution(int ticks_per_half_distance) const {
+    std::string out = "       Value     Percentile TotalCount 1/(1-Percentile)\n\n";
+    ticks_per_half_distance = std::max(ticks_per_half_distance, 1);
+
+    // One row each time the cumulative count passes the next tick; ticks
+    // get denser as the remaining tail halves
+    double next = 0;
+    uint64_t seen = 0;
+    double variance = 0;
+    for (size_t i = 0; i < counts_.size(); ++i) {
+        if (counts_[i] == 0) {
+            continue;
+        }
+        seen += counts_[i];
+        uint64_t value = std::max(std::min(highest_in(i), max_), min_);
+        variance += (value - mean()) * (value - mean()) * counts_[i];
+        double percentile = 100.0 * seen / total_;
+        if (seen == total_) {
+            out += format("%12.3f %14.12f %10llu\n", value / 1e6, 1.0, static_cast<unsigned long long>(seen), 0);
+            break;
+        }
+        if (percentile < next) {
+            continue;
+        }
+        out += format("%12.3f %14.12f %10llu %14.2f\n", value / 1e6, percentile / 100,
+                      static_cast<unsigned long long>(seen), 100 / (100 - percentile));
+        while (next <= percentile) {
+            int half_distance = static_cast<int>(std::floor(std::log2(100 / (100 - next)))) + 1;
+            next += 100.0 / (ticks_per_half_distance * std::pow(2.0, half_distance));
+        }
+    }
+
+    char footer[256];
+    std::snprintf(footer, sizeof(footer),
+                  "#[Mean    = %12.3f, StdDeviation   = %12.3f]\n"
+                  "#[Max     = %12.3f, Total count    = %12llu]\n"
+                  "#[Buckets = %12zu, SubBuckets     = %12llu]\n",
+                  mean() / 1e6, total_ ? std::sqrt(variance / total_) / 1e6 : 0, max_ / 1e6,
+                  static_cast<unsigned long long>(total_),
+                  counts_.size() / SUB_BUCKETS, static_cast<unsigned long long>(SUB_BUCKETS));
+    return out + footer;
+}
+
+std::string LatencyHistogram::to_json() const {
+    char json[512];
+    std::snprintf(json, sizeof(json),
+                  "{\"count\":%llu,\"min_us\":%.3f,\"mean_us\":%.3f,\"p50_us\":%.3f,\"p90_us\":%.3f,"
+                  "\"p99_us\":%.3f,\"p99_9_us\":%.3f,\"p99_99_us\":%.3f,\"max_us\":%.3f}",
+                  static_cast<unsigned long long>(total_), min() / 1e3, mean() / 1e3,
+                  value_at(0.5) / 1e3, value_at(0.9) / 1e3, value_at(0.99) / 1e3,
+                  value_at(0.999) / 1e3, value_at(0.9999) / 1e3, max_ / 1e3);
+    return json;
+}
+
+} // namespace distkv
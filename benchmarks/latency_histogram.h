@@ -0,0 +1,59 @@
+#ifndef DISTKV_LATENCY_HISTOGRAM_H
+#define DISTKV_LATENCY_HISTOGRAM_H
+
+#include <string>
+#include <vector>
+#include <cstdint>
+
+namespace distkv {
+
+// HDR-style latency histogram: fixed relative precision over any range,
+// in constant time per sample and memory that grows with the logarithm of
+// the largest value.
+//
+// Values (nanoseconds) below 2 * SUB_BUCKETS are counted exactly; above
+// that, each power of two is split into SUB_BUCKETS equal steps, so any
+// recorded value is reported within 1 / SUB_BUCKETS (about 0.1%) of its
+// true value. Counts merge by adding, so per-thread histograms combine
+// without losing the tail the way averaged percentiles would.
+class LatencyHistogram {
+public:
+    static constexpr int SUB_BUCKET_BITS = 10;
+    static constexpr uint64_t SUB_BUCKETS = 1ULL << SUB_BUCKET_BITS;
+
+    void record(uint64_t value, uint64_t count = 1);
+    void merge(const LatencyHistogram& other);
+
+    uint64_t count() const { return total_; }
+    uint64_t min() const { return total_ ? min_ : 0; }
+    uint64_t max() const { return max_; }
+    double mean() const;
+
+    // Smallest recorded value (to the histogram's precision) that at
+    // least fraction q (0..1) of the samples do not exceed; 0 when empty
+    uint64_t value_at(double q) const;
+
+    // Percentile distribution in HdrHistogram's .hgrm text layout, values
+    // in milliseconds, with ticks_per_half_distance rows per halving of
+    // the remaining tail
+    std::string percentile_distribution(int ticks_per_half_distance = 5) const;
+
+    // {"count":..,"min_us":..,"mean_us":..,"p50_us":..,"p90_us":..,
+    //  "p99_us":..,"p99_9_us":..,"p99_99_us":..,"max_us":..}
+    std::string to_json() const;
+
+private:
+    std::vector<uint64_t> counts_;  // grown to the largest index recorded
+    uint64_t total_ = 0;
+    uint64_t min_ = UINT64_MAX;
+    uint64_t max_ = 0;
+    long double sum_ = 0;
+
+    static size_t index_of(uint64_t value);
+    // Largest value counted in the slot at index
+    static uint64_t highest_in(size_t index);
+};
+
+} // namespace distkv
+
+#endif // DISTKV_LATENCY_HISTOGRAM_H
@@ -0,0 +1,915 @@
+#include "load_generator.h"
+#include "../client/client.h"
+#include "../client/resp_parser.h"
+#include "binary_protocol.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cctype>
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <iomanip>
+#include <memory>
+#include <random>
+#include <sstream>
+#include <thread>
+
+// Platform-specific includes
+#ifndef _WIN32
+    #include <sys/socket.h>
+    #include <sys/un.h>
+    #include <netinet/in.h>
+    #include <netinet/tcp.h>
+    #include <arpa/inet.h>
+    #include <fcntl.h>
+    #include <poll.h>
+    #include <unistd.h>
+#endif
+
+namespace distkv {
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+// Keys SET per preload pipeline
+constexpr size_t PRELOAD_BATCH = 1000;
+
+// Bytes received per recv() call
+constexpr size_t READ_CHUNK = 65536;
+
+// Values are slices of one random buffer, starting anywhere in its first
+// VALUE_OFFSETS bytes
+constexpr size_t VALUE_OFFSETS = 4096;
+
+std::string upper(std::string s) {
+    std::transform(s.begin(), s.end(), s.begin(), [](unsigned char c) { return std::toupper(c); });
+    return s;
+}
+
+bool parse_count(const std::string& s, size_t& value) {
+    if (s.empty() || s.size() > 12 || s.find_first_not_of("0123456789") != std::string::npos) {
+        return false;
+    }
+    value = static_cast<size_t>(std::strtoull(s.c_str(), nullptr, 10));
+    return true;
+}
+
+// Key prefixes of strings, lists and sets
+const char* const FAMILIES[] = {"key:", "list:", "set:"};
+constexpr int FAMILY_COUNT = 3;
+
+// FAMILIES index of each command the mix may hold; -1 for the rest
+int key_family(CommandType command) {
+    switch (command) {
+        case CommandType::SET:
+        case CommandType::GET:
+        case CommandType::DEL:
+        case CommandType::EXISTS:
+        case CommandType::EXPIRE:
+        case CommandType::TTL:
+            return 0;
+        case CommandType::LPUSH:
+        case CommandType::RPUSH:
+        case CommandType::LPOP:
+        case CommandType::RPOP:
+        case CommandType::LRANGE:
+        case CommandType::LLEN:
+            return 1;
+        case CommandType::SADD:
+        case CommandType::SREM:
+        case CommandType::SISMEMBER:
+        case CommandType::SMEMBERS:
+        case CommandType::SCARD:
+            return 2;
+        default:
+            return -1;
+    }
+}
+
+// Commands whose reply says whether the key held a value
+bool is_read(CommandType command) {
+    return command == CommandType::GET || command == CommandType::LPOP || command == CommandType::RPOP;
+}
+
+// Commands that store a value, creating their key if needed
+bool is_write(CommandType command) {
+    return command == CommandType::SET || command == CommandType::LPUSH || command == CommandType::RPUSH ||
+           command == CommandType::SADD;
+}
+
+// Weighted choice over a cumulative weight table
+size_t pick(const std::vector<uint64_t>& cumulative, std::mt19937_64& rng) {
+    uint64_t r = rng() % cumulative.back();
+    return static_cast<size_t>(std::upper_bound(cumulative.begin(), cumulative.end(), r) - cumulative.begin());
+}
+
+// Draws value sizes from a SizeSpec
+class SizeChooser {
+public:
+    explicit SizeChooser(const SizeSpec& spec)
+        : spec_(spec), zipfian_(spec.zipfian ? spec.max - spec.min + 1 : 1) {
+        uint64_t total = 0;
+        for (const auto& size : spec_.weighted) {
+            total += size.second;
+            weights_.push_back(total);
+        }
+    }
+
+    size_t next(std::mt19937_64& rng) const {
+        if (!spec_.weighted.empty()) {
+            return spec_.weighted[pick(weights_, rng)].first;
+        }
+        if (spec_.zipfian) {
+            return spec_.min + static_cast<size_t>(zipfian_.next(rng));
+        }
+        return spec_.min + (spec_.max > spec_.min ? rng() % (spec_.max - spec_.min + 1) : 0);
+    }
+
+private:
+    SizeSpec spec_;
+    std::vector<uint64_t> weights_;
+    ZipfianGenerator zipfian_;
+};
+
+std::string random_values(size_t size, uint64_t seed) {
+    static const char alphabet[] = "abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ0123456789";
+    std::mt19937_64 rng(seed);
+    std::string values(size, 'x');
+    for (auto& c : values) {
+        c = alphabet[rng() % (sizeof(alphabet) - 1)];
+    }
+    return values;
+}
+
+#ifndef _WIN32
+
+#ifdef MSG_NOSIGNAL
+constexpr int SEND_FLAGS = MSG_NOSIGNAL;
+#else
+constexpr int SEND_FLAGS = 0;
+#endif
+
+bool would_block() {
+    return errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR;
+}
+
+// Blocking connect to the configured server; -1 and error on failure
+int open_connection(const LoadConfig& config, std::string& error) {
+    int fd;
+    if (!config.unix_socket.empty()) {
+        struct sockaddr_un addr;
+        std::memset(&addr, 0, sizeof(addr));
+        addr.sun_family = AF_UNIX;
+        if (config.unix_socket.size() >= sizeof(addr.sun_path)) {
+            error = "Socket path too long";
+            return -1;
+        }
+        std::memcpy(addr.sun_path, config.unix_socket.c_str(), config.unix_socket.size());
+        fd = socket(AF_UNIX, SOCK_STREAM, 0);
+        if (fd >= 0 && ::connect(fd, (struct sockaddr*)&addr, sizeof(addr)) < 0) {
+            close(fd);
+            fd = -1;
+        }
+    } else {
+        struct sockaddr_in addr;
+        std::memset(&addr, 0, sizeof(addr));
+        addr.sin_family = AF_INET;
+        addr.sin_port = htons(config.port);
+        std::string ip = (config.host == "localhost") ? "127.0.0.1" : config.host;
+        if (inet_pton(AF_INET, ip.c_str(), &addr.sin_addr) <= 0) {
+            error = "Invalid address " + config.host;
+            return -1;
+        }
+        fd = socket(AF_INET, SOCK_STREAM, 0);
+        if (fd >= 0) {
+            int opt = 1;
+            setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &opt, sizeof(opt));
+            if (::connect(fd, (struct sockaddr*)&addr, sizeof(addr)) < 0) {
+                close(fd);
+                fd = -1;
+            }
+        }
+    }
+    if (fd < 0) {
+        error = "Connection failed";
+    }
+    return fd;
+}
+
+// Switch a fresh connection to binary frames; the +OK comes back as text
+bool negotiate_binary(int fd, std::string& error) {
+    const char request[] = "PROTOCOL BINARY\n";
+    if (send(fd, request, sizeof(request) - 1, SEND_FLAGS) != static_cast<ssize_t>(sizeof(request) - 1)) {
+        error = "Failed to send PROTOCOL BINARY";
+        return false;
+    }
+    std::string reply;
+    char c;
+    while (reply.find('\n') == std::string::npos && reply.size() < 256) {
+        if (recv(fd, &c, 1, 0) != 1) {
+            error = "Connection closed during PROTOCOL BINARY";
+            return false;
+        }
+        reply.push_back(c);
+    }
+    if (reply != "+OK\r\n") {
+        error = "Server refused PROTOCOL BINARY";
+        return false;
+    }
+    return true;
+}
+
+// One request written and not yet answered
+struct Pending {
+    size_t command;       // index into the mix
+    uint16_t id;          // binary frames only
+    Clock::time_point started;  // written, or due (open loop)
+};
+
+struct Connection {
+    int fd = -1;
+    std::string out;      // encoded requests not yet written
+    size_t out_pos = 0;
+    std::string in;       // received bytes not yet decoded
+    size_t in_pos = 0;
+    RespParser parser;
+    BinaryProtocol::Frame frame;
+    std::deque<Pending> pending;
+    size_t issued = 0;
+    uint16_t next_id = 0;
+    Clock::time_point next_send;  // open loop only
+    bool closed = false;
+};
+
+// One thread's share of the load, and what it measured
+class Worker {
+public:
+    // keys holds a chooser per key family
+    Worker(const LoadConfig& config, const std::string& values, const std::vector<KeyChooser>& keys,
+           uint64_t seed, std::atomic<uint64_t>& answered)
+        : config_(config), values_(values), keys_(keys), sizes_(config.value_size), rng_(seed),
+          answered_(answered) {
+        uint64_t total = 0;
+        for (const auto& entry : config_.mix) {
+            total += entry.weight;
+            mix_weights_.push_back(total);
+            families_.push_back(key_family(entry.command));
+            results_.emplace_back();
+            results_.back().name = Protocol::command_to_string(entry.command);
+        }
+    }
+
+    ~Worker() {
+        for (auto& conn : connections_) {
+            if (conn.fd >= 0) {
+                close(conn.fd);
+            }
+        }
+    }
+
+    bool connect(std::string& error) {
+        connections_.resize(config_.clients);
+        for (auto& conn : connections_) {
+            conn.fd = open_connection(config_, error);
+            if (conn.fd < 0 || (config_.binary && !negotiate_binary(conn.fd, error))) {
+                return false;
+            }
+            fcntl(conn.fd, F_SETFL, fcntl(conn.fd, F_GETFL, 0) | O_NONBLOCK);
+        }
+        return true;
+    }
+
+    // Open loop: this thread's connections are numbered from first out of
+    // total, and each sends every `interval`, staggered across the first
+    // interval so the load arrives evenly
+    void schedule(Clock::time_point start, Clock::duration interval, size_t first, size_t total) {
+        interval_ = interval;
+        for (size_t i = 0; i < connections_.size(); ++i) {
+            connections_[i].next_send = start + interval * static_cast<Clock::rep>(first + i) / total;
+        }
+    }
+
+    void run(Clock::time_point deadline) {
+        deadline_ = deadline;
+        std::vector<pollfd> fds(connections_.size());
+        std::vector<char> chunk(READ_CHUNK);
+        size_t open = connections_.size();
+
+        while (open > 0) {
+            Clock::time_point wake = Clock::time_point::max();
+            for (size_t i = 0; i < connections_.size(); ++i) {
+                Connection& conn = connections_[i];
+                fds[i].fd = conn.closed ? -1 : conn.fd;
+                fds[i].events = 0;
+                fds[i].revents = 0;
+                if (conn.closed) {
+                    continue;
+                }
+                fill(conn);
+                if (!flush(conn)) {
+                    drop(conn);
+                    --open;
+                    continue;
+                }
+                bool more = more_to_send(conn);
+                if (conn.pending.empty() && !more) {
+                    // Nothing left to send or wait for
+                    conn.closed = true;
+                    fds[i].fd = -1;
+                    --open;
+                    continue;
+                }
+                if (open_loop() && more && conn.pending.size() < config_.pipeline) {
+                    wake = std::min(wake, conn.next_send);
+                }
+                fds[i].events = static_cast<short>(POLLIN | (conn.out_pos < conn.out.size() ? POLLOUT : 0));
+            }
+            if (open == 0 || wait(fds, wake) <= 0) {
+                continue;
+            }
+
+            for (size_t i = 0; i < connections_.size(); ++i) {
+                Connection& conn = connections_[i];
+                if (conn.closed || (fds[i].revents & (POLLIN | POLLERR | POLLHUP)) == 0) {
+                    continue;
+                }
+                ssize_t n = recv(conn.fd, chunk.data(), chunk.size(), 0);
+                if (n < 0 && would_block()) {
+                    continue;
+                }
+                if (n <= 0) {
+                    drop(conn);
+                    --open;
+                    continue;
+                }
+                conn.in.append(chunk.data(), static_cast<size_t>(n));
+                if (!decode(conn)) {
+                    drop(conn);
+                    --open;
+                }
+            }
+        }
+    }
+
+    std::vector<CommandResult>& results() { return results_; }
+    uint64_t bytes_sent() const { return bytes_sent_; }
+    uint64_t bytes_received() const { return bytes_received_; }
+    const std::string& error() const { return error_; }
+
+private:
+    const LoadConfig& config_;
+    const std::string& values_;
+    std::vector<KeyChooser> keys_;
+    SizeChooser sizes_;
+    std::mt19937_64 rng_;
+    std::atomic<uint64_t>& answered_;
+    std::vector<uint64_t> mix_weights_;
+    std::vector<int> families_;
+    std::vector<Connection> connections_;
+    std::vector<CommandResult> results_;
+    Clock::time_point deadline_;
+    Clock::duration interval_ = Clock::duration::zero();  // open loop only
+    std::string line_;
+    uint64_t bytes_sent_ = 0;
+    uint64_t bytes_received_ = 0;
+    std::string error_;
+
+    bool open_loop() const { return interval_ > Clock::duration::zero(); }
+
+    bool more_to_send(const Connection& conn) const {
+        if (config_.duration_s > 0) {
+            return (open_loop() ? conn.next_send : Clock::now()) < deadline_;
+        }
+        return conn.issued < config_.requests;
+    }
+
+    // Poll until a socket is ready or the next scheduled send is due
+    int wait(std::vector<pollfd>& fds, Clock::time_point wake) {
+        std::chrono::nanoseconds timeout = std::chrono::seconds(1);
+        if (wake != Clock::time_point::max()) {
+            auto until = std::chrono::duration_cast<std::chrono::nanoseconds>(wake - Clock::now());
+            timeout = std::min(timeout, std::max(until, std::chrono::nanoseconds(0)));
+        }
+#ifdef __linux__
+        // Nanosecond timeouts, so an open-loop send is not held back to
+        // the next millisecond
+        struct timespec ts;
+        ts.tv_sec = static_cast<time_t>(timeout.count() / 1000000000);
+        ts.tv_nsec = static_cast<long>(timeout.count() % 1000000000);
+        return ppoll(fds.data(), fds.size(), &ts, nullptr);
+#else
+        auto ms = std::chrono::ceil<std::chrono::milliseconds>(timeout);
+        return poll(fds.data(), fds.size(), static_cast<int>(ms.count()));
+#endif
+    }
+
+    void append_value() {
+        line_.append(values_, rng_() % VALUE_OFFSETS, sizes_.next(rng_));
+    }
+
+    // Queue requests until the pipeline is full
+    void fill(Connection& conn) {
+        while (conn.pending.size() < config_.pipeline && more_to_send(conn)) {
+            // Open loop measures from when the request was due, however
+            // late it goes out
+            Clock::time_point started = Clock::now();
+            if (open_loop()) {
+                if (conn.next_send > started) {
+                    break;
+                }
+                started = conn.next_send;
+                conn.next_send += interval_;
+            }
+            size_t index = pick(mix_weights_, rng_);
+            CommandType command = config_.mix[index].command;
+
+            line_ = Protocol::command_to_string(command);
+            line_ += ' ';
+            line_ += config_.key_prefix;
+            int family = families_[index];
+            line_ += FAMILIES[family];
+            line_ += std::to_string(keys_[family].next(rng_, is_write(command)));
+            switch (command) {
+                case CommandType::SET:
+                case CommandType::LPUSH:
+                case CommandType::RPUSH:
+                    line_ += ' ';
+                    append_value();
+                    break;
+                case CommandType::EXPIRE:
+                    line_ += " 3600";
+                    break;
+                case CommandType::LRANGE:
+                    line_ += " 0 " + std::to_string(config_.range - 1);
+                    break;
+                case CommandType::SADD:
+                case CommandType::SREM:
+                case CommandType::SISMEMBER:
+                    line_ += " member:" + std::to_string(rng_() % config_.set_members);
+                    break;
+                default:
+                    break;
+            }
+
+            uint16_t id = conn.next_id++;
+            if (config_.binary) {
+                BinaryProtocol::append_request(conn.out, id, line_);
+            } else {
+                line_ += '\n';
+                conn.out += line_;
+            }
+            conn.pending.push_back({index, id, started});
+            ++conn.issued;
+        }
+    }
+
+    bool flush(Connection& conn) {
+        while (conn.out_pos < conn.out.size()) {
+            ssize_t n = send(conn.fd, conn.out.data() + conn.out_pos, conn.out.size() - conn.out_pos, SEND_FLAGS);
+            if (n < 0 && would_block()) {
+                return true;
+            }
+            if (n <= 0) {
+                return false;
+            }
+            conn.out_pos += static_cast<size_t>(n);
+            bytes_sent_ += static_cast<uint64_t>(n);
+        }
+        conn.out.clear();
+        conn.out_pos = 0;
+        return true;
+    }
+
+    void record(Connection& conn, bool error, bool found) {
+        const Pending& request = conn.pending.front();
+        CommandResult& result = results_[request.command];
+        result.latency.record(static_cast<uint64_t>(
+            std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - request.started).count()));
+        ++result.ops;
+        if (error) {
+            ++result.errors;
+        } else if (is_read(config_.mix[request.command].command)) {
+            ++(found ? result.hits : result.misses);
+        }
+        conn.pending.pop_front();
+        answered_.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    // Match decoded replies to pending requests; false if the stream is
+    // broken
+    bool decode(Connection& conn) {
+        size_t start = conn.in_pos;
+        while (!conn.pending.empty() && conn.in_pos < conn.in.size()) {
+            if (config_.binary) {
+                size_t needed;
+                auto status = BinaryProtocol::parse(conn.in.data(), conn.in.size(), conn.in_pos, conn.frame, needed);
+                if (status == BinaryProtocol::Status::NEED_MORE) {
+                    break;
+                }
+                if (status == BinaryProtocol::Status::ERROR) {
+                    error_ = "Malformed reply frame";
+                    return false;
+                }
+                if (conn.frame.code == BinaryProtocol::PUSH) {
+                    continue;
+                }
+                if (conn.frame.id != conn.pending.front().id) {
+                    error_ = "Reply for request " + std::to_string(conn.frame.id) + " out of order";
+                    return false;
+                }
+                auto status_code = static_cast<StatusCode>(conn.frame.code);
+                record(conn, status_code != StatusCode::OK && status_code != StatusCode::NOT_FOUND,
+                       status_code == StatusCode::OK);
+            } else {
+                RespReply reply;
+                auto status = conn.parser.parse(conn.in.data(), conn.in.size(), conn.in_pos, reply);
+                if (status == RespParser::Status::NEED_MORE) {
+                    break;
+                }
+                if (status == RespParser::Status::ERROR) {
+                    error_ = "Malformed reply";
+                    return false;
+                }
+                if (reply.type == RespReply::Type::PUSH) {
+                    continue;
+                }
+                record(conn, !reply.ok(), !reply.is_nil());
+            }
+        }
+        bytes_received_ += conn.in_pos - start;
+        if (conn.in_pos == conn.in.size()) {
+            conn.in.clear();
+            conn.in_pos = 0;
+        } else if (conn.in_pos > READ_CHUNK) {
+            conn.in.erase(0, conn.in_pos);
+            conn.in_pos = 0;
+        }
+        return true;
+    }
+
+    // Requests still in flight on a lost connection count as errors
+    void drop(Connection& conn) {
+        if (error_.empty()) {
+            error_ = "Connection lost";
+        }
+        while (!conn.pending.empty()) {
+            record(conn, true, false);
+        }
+        close(conn.fd);
+        conn.fd = -1;
+        conn.closed = true;
+    }
+};
+
+#endif
+
+} // namespace
+
+bool SizeSpec::parse(const std::string& spec) {
+    weighted.clear();
+    zipfian = false;
+    if (spec.compare(0, 5, "zipf:") == 0) {
+        zipfian = true;
+        size_t dash = spec.find('-');
+        return dash != std::string::npos && parse_count(spec.substr(5, dash - 5), min) &&
+               parse_count(spec.substr(dash + 1), max) && min > 0 && min <= max;
+    }
+    size_t dash = spec.find('-');
+    if (spec.find(':') != std::string::npos) {
+        std::istringstream iss(spec);
+        std::string item;
+        while (std::getline(iss, item, ',')) {
+            size_t colon = item.find(':');
+            size_t size, weight;
+            if (colon == std::string::npos || !parse_count(item.substr(0, colon), size) ||
+                !parse_count(item.substr(colon + 1), weight) || size == 0 || weight == 0) {
+                return false;
+            }
+            weighted.emplace_back(size, static_cast<unsigned>(weight));
+        }
+        if (weighted.empty()) {
+            return false;
+        }
+        min = max = weighted[0].first;
+        for (const auto& entry : weighted) {
+            min = std::min(min, entry.first);
+            max = std::max(max, entry.first);
+        }
+        return true;
+    }
+    if (dash != std::string::npos) {
+        return parse_count(spec.substr(0, dash), min) && parse_count(spec.substr(dash + 1), max) &&
+               min > 0 && min <= max;
+    }
+    if (!parse_count(spec, min) || min == 0) {
+        return false;
+    }
+    max = min;
+    return true;
+}
+
+size_t SizeSpec::largest() const {
+    return max;
+}
+
+std::string SizeSpec::describe() const {
+    if (!weighted.empty()) {
+        std::string text;
+        for (const auto& entry : weighted) {
+            text += (text.empty() ? "" : ",") + std::to_string(entry.first) + ":" + std::to_string(entry.second);
+        }
+        return text + " bytes";
+    }
+    if (min != max) {
+        return std::to_string(min) + "-" + std::to_string(max) + " bytes" + (zipfian ? ", zipfian" : "");
+    }
+    return std::to_string(min) + " bytes";
+}
+
+bool parse_mix(const std::string& spec, std::vector<MixEntry>& mix) {
+    std::vector<MixEntry> parsed;
+    std::istringstream iss(spec);
+    std::string item;
+    while (std::getline(iss, item, ',')) {
+        size_t colon = item.find(':');
+        size_t weight = 1;
+        if (colon != std::string::npos && !parse_count(item.substr(colon + 1), weight)) {
+            return false;
+        }
+        CommandType command = Protocol::string_to_command(upper(item.substr(0, colon)));
+        if (key_family(command) < 0) {
+            return false;
+        }
+        auto same = std::find_if(parsed.begin(), parsed.end(),
+                                 [command](const MixEntry& entry) { return entry.command == command; });
+        if (same != parsed.end()) {
+            same->weight += static_cast<unsigned>(weight);
+        } else if (weight > 0) {
+            parsed.push_back({command, static_cast<unsigned>(weight)});
+        }
+    }
+    parsed.erase(std::remove_if(parsed.begin(), parsed.end(), [](const MixEntry& entry) { return entry.weight == 0; }),
+                 parsed.end());
+    if (parsed.empty()) {
+        return false;
+    }
+    mix = parsed;
+    return true;
+}
+
+std::string describe_mix(const std::vector<MixEntry>& mix) {
+    std::string text;
+    for (const auto& entry : mix) {
+        text += (text.empty() ? "" : ",") + Protocol::command_to_string(entry.command) + ":" +
+                std::to_string(entry.weight);
+    }
+    return text;
+}
+
+void CommandResult::merge(const CommandResult& other) {
+    ops += other.ops;
+    errors += other.errors;
+    hits += other.hits;
+    misses += other.misses;
+    latency.merge(other.latency);
+}
+
+std::string LoadResult::report() const {
+    std::ostringstream out;
+    out << std::fixed;
+    out << std::left << std::setw(11) << "Type" << std::right << std::setw(12) << "Ops/sec"
+        << std::setw(11) << "Hits/sec" << std::setw(12) << "Misses/sec" << std::setw(10) << "Errors"
+        << std::setw(10) << "Avg(ms)" << std::setw(10) << "p50(ms)" << std::setw(10) << "p99(ms)"
+        << std::setw(11) << "p99.9(ms)" << std::setw(12) << "p99.99(ms)" << std::setw(10) << "Max(ms)" << "\n";
+    out << std::string(119, '-') << "\n";
+
+    auto row = [&](const CommandResult& result, const std::string& name) {
+        const LatencyHistogram& latency = result.latency;
+        double per_sec = seconds > 0 ? 1.0 / seconds : 0;
+        out << std::left << std::setw(11) << name << std::right << std::setprecision(2)
+            << std::setw(12) << result.ops * per_sec << std::setw(11) << result.hits * per_sec
+            << std::setw(12) << result.misses * per_sec << std::setw(10) << result.errors
+            << std::setprecision(3) << std::setw(10) << latency.mean() / 1e6
+            << std::setw(10) << latency.value_at(0.50) / 1e6 << std::setw(10) << latency.value_at(0.99) / 1e6
+            << std::setw(11) << latency.value_at(0.999) / 1e6 << std::setw(12) << latency.value_at(0.9999) / 1e6
+            << std::setw(10) << latency.max() / 1e6 << "\n";
+    };
+    for (const auto& result : commands) {
+        row(result, result.name);
+    }
+    row(totals, "Totals");
+
+    out << std::setprecision(2) << "\n"
+        << totals.ops << " requests in " << seconds << "s, "
+        << (seconds > 0 ? bytes_sent / 1024.0 / seconds : 0) << " KB/sec sent, "
+        << (seconds > 0 ? bytes_received / 1024.0 / seconds : 0) << " KB/sec received\n";
+    if (target_rate > 0) {
+        out << "Open loop at " << target_rate << " requests/sec; latency measured from each request's "
+            << "scheduled send time\n";
+    }
+    return out.str();
+}
+
+std::string LoadResult::histograms() const {
+    std::string out;
+    for (const auto& result : commands) {
+        out += "# " + result.name + "\n" + result.latency.percentile_distribution() + "\n";
+    }
+    return out + "# Totals\n" + totals.latency.percentile_distribution();
+}
+
+ResultDocument LoadResult::document(const LoadConfig& config) const {
+    ResultDocument doc("bench");
+    doc.set_error(ok ? "" : error);
+    doc.set_config("server", config.unix_socket.empty() ? config.host + ":" + std::to_string(config.port)
+                                                        : config.unix_socket);
+    doc.set_config("protocol", std::string(config.binary ? "binary" : "text"));
+    doc.set_config("threads", static_cast<double>(config.threads));
+    doc.set_config("clients", static_cast<double>(config.clients));
+    doc.set_config("pipeline", static_cast<double>(config.pipeline));
+    if (config.duration_s > 0) {
+        doc.set_config("test_time", config.duration_s);
+    } else {
+        doc.set_config("requests", static_cast<double>(config.requests));
+    }
+    doc.set_config("rate", target_rate);
+    doc.set_config("key_space", static_cast<double>(config.key_space));
+    doc.set_config("key_distribution", config.key_distribution.describe());
+    doc.set_config("key_prefix", config.key_prefix);
+    doc.set_config("data_size", config.value_size.describe());
+    doc.set_config("command_mix", describe_mix(config.mix));
+    doc.set_config("range", static_cast<double>(config.range));
+    doc.set_config("preload", config.preload);
+    doc.set_config("seed", std::to_string(config.seed));
+
+    auto add = [&](const CommandResult& result, const std::string& name) {
+        const LatencyHistogram& latency = result.latency;
+        doc.add_benchmark(name, {{"ops_per_sec", seconds > 0 ? result.ops / seconds : 0},
+                                 {"errors", static_cast<double>(result.errors)},
+                                 {"mean_us", latency.mean() / 1e3},
+                                 {"p50_us", latency.value_at(0.5) / 1e3},
+                                 {"p90_us", latency.value_at(0.9) / 1e3},
+                                 {"p99_us", latency.value_at(0.99) / 1e3},
+                                 {"p99_9_us", latency.value_at(0.999) / 1e3},
+                                 {"p99_99_us", latency.value_at(0.9999) / 1e3},
+                                 {"max_us", latency.max() / 1e3}});
+    };
+    for (const auto& result : commands) {
+        add(result, result.name);
+    }
+    add(totals, "Totals");
+    if (seconds > 0) {
+        doc.add_benchmark("Network", {{"sent_bytes_per_sec", bytes_sent / seconds},
+                                      {"received_bytes_per_sec", bytes_received / seconds}});
+    }
+    doc.set_resource("peak_rss_bytes", static_cast<double>(peak_rss_bytes()));
+    return doc;
+}
+
+LoadGenerator::LoadGenerator(const LoadConfig& config) : config_(config) {
+    config_.threads = std::max<size_t>(config_.threads, 1);
+    config_.clients = std::max<size_t>(config_.clients, 1);
+    config_.pipeline = std::max<size_t>(config_.pipeline, 1);
+    config_.key_space = std::max<size_t>(config_.key_space, 1);
+    config_.set_members = std::max<size_t>(config_.set_members, 1);
+    config_.range = std::max(config_.range, 1);
+    if (config_.seed == 0) {
+        config_.seed = static_cast<uint64_t>(Clock::now().time_since_epoch().count());
+    }
+}
+
+bool LoadGenerator::preload(std::string& error) {
+    Client client;
+    bool connected = config_.unix_socket.empty() ? client.connect(config_.host, config_.port)
+                                                 : client.connect_unix(config_.unix_socket);
+    if (!connected) {
+        error = "Preload: " + client.get_error();
+        return false;
+    }
+
+    std::string values = random_values(config_.value_size.largest() + VALUE_OFFSETS, config_.seed);
+    std::mt19937_64 rng(config_.seed);
+    SizeChooser sizes(config_.value_size);
+    for (size_t first = 0; first < config_.key_space; first += PRELOAD_BATCH) {
+        auto pipeline = client.pipeline();
+        size_t last = std::min(first + PRELOAD_BATCH, config_.key_space);
+        for (size_t n = first; n < last; ++n) {
+            pipeline.set(config_.key_prefix + FAMILIES[0] + std::to_string(n),
+                         values.substr(rng() % VALUE_OFFSETS, sizes.next(rng)));
+        }
+        for (const auto& reply : pipeline.execute()) {
+            if (!reply.ok()) {
+                error = "Preload: " + (reply.str.empty() ? client.get_error() : reply.str);
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+LoadResult LoadGenerator::run(const std::function<void(double, uint64_t)>& progress) {
+    LoadResult result;
+#ifdef _WIN32
+    (void)progress;
+    result.error = "The load generator is not supported on Windows";
+    return result;
+#else
+    for (const auto& entry : config_.mix) {
+        if (key_family(entry.command) < 0 || entry.weight == 0) {
+            result.error = "Unsupported command mix";
+            return result;
+        }
+    }
+    if (config_.mix.empty()) {
+        result.error = "Empty command mix";
+        return result;
+    }
+    if (config_.preload && !preload(result.error)) {
+        return result;
+    }
+
+    std::string values = random_values(config_.value_size.largest() + VALUE_OFFSETS, config_.seed + 1);
+    std::atomic<uint64_t> answered(0);
+
+    // Under LATEST each family counts the keys written so far, from the
+    // key space the run starts with
+    std::atomic<uint64_t> newest[FAMILY_COUNT];
+    std::vector<KeyChooser> keys;
+    for (int family = 0; family < FAMILY_COUNT; ++family) {
+        newest[family] = config_.key_space;
+        keys.emplace_back(config_.key_distribution, config_.key_space, &newest[family]);
+    }
+
+    std::vector<std::unique_ptr<Worker>> workers;
+    for (size_t t = 0; t < config_.threads; ++t) {
+        workers.push_back(std::make_unique<Worker>(config_, values, keys, config_.seed + 2 + t, answered));
+        if (!workers.back()->connect(result.error)) {
+            return result;
+        }
+    }
+
+    std::atomic<size_t> running(workers.size());
+    auto start = Clock::now();
+    auto deadline = start + std::chrono::duration_cast<Clock::duration>(
+                                std::chrono::duration<double>(config_.duration_s));
+    if (config_.rate > 0) {
+        size_t total = workers.size() * config_.clients;
+        auto interval = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(total / config_.rate));
+        interval = std::max(interval, Clock::duration(1));
+        for (size_t t = 0; t < workers.size(); ++t) {
+            workers[t]->schedule(start, interval, t * config_.clients, total);
+        }
+        result.target_rate = config_.rate;
+    }
+    std::vector<std::thread> threads;
+    for (auto& worker : workers) {
+        threads.emplace_back([&worker, &running, deadline]() {
+            worker->run(deadline);
+            --running;
+        });
+    }
+
+    auto next_report = start + std::chrono::seconds(1);
+    while (running > 0) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        auto now = Clock::now();
+        if (progress && now >= next_report) {
+            progress(std::chrono::duration<double>(now - start).count(), answered.load());
+            next_report += std::chrono::seconds(1);
+        }
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    result.seconds = std::chrono::duration<double>(Clock::now() - start).count();
+
+    // Merge per-thread results, per command and in total
+    result.totals.name = "TOTALS";
+    for (auto& worker : workers) {
+        auto& partial = worker->results();
+        if (result.commands.empty()) {
+            for (const auto& command : partial) {
+                result.commands.emplace_back();
+                result.commands.back().name = command.name;
+            }
+        }
+        for (size_t i = 0; i < partial.size(); ++i) {
+            result.commands[i].merge(partial[i]);
+            result.totals.merge(partial[i]);
+        }
+        result.bytes_sent += worker->bytes_sent();
+        result.bytes_received += worker->bytes_received();
+        if (result.error.empty()) {
+            result.error = worker->error();
+        }
+    }
+    result.ok = result.error.empty();
+    return result;
+#endif
+}
+
+} // namespace distkv
@@ -0,0 +1,142 @@
+#ifndef DISTKV_LOAD_GENERATOR_H
+#define DISTKV_LOAD_GENERATOR_H
+
+#include "protocol.h"
+#include "latency_histogram.h"
+#include "key_distribution.h"
+#include "bench_results.h"
+#include <string>
+#include <vector>
+#include <utility>
+#include <functional>
+#include <cstddef>
+#include <cstdint>
+
+namespace distkv {
+
+// One command of a traffic mix, chosen in proportion to its weight
+struct MixEntry {
+    CommandType command;
+    unsigned weight;
+};
+
+// Value sizes: a fixed size, a uniform or zipfian range, or weighted sizes
+struct SizeSpec {
+    size_t min = 32;
+    size_t max = 32;
+    bool zipfian = false;            // over [min, max], smallest most common
+    std::vector<std::pair<size_t, unsigned>> weighted;  // (size, weight); empty unless weighted
+
+    // "100", "32-1024", "zipf:32-65536" or "32:60,1024:30,65536:10"
+    // (size:weight)
+    bool parse(const std::string& spec);
+    size_t largest() const;
+    std::string describe() const;
+};
+
+struct LoadConfig {
+    std::string host = "127.0.0.1";
+    int port = 6379;
+    std::string unix_socket;         // connect here instead of host:port
+    bool binary = false;             // PROTOCOL BINARY on every connection
+
+    size_t threads = 4;
+    size_t clients = 10;             // connections per thread
+    size_t pipeline = 1;             // requests in flight per connection
+    size_t requests = 10000;         // per connection, unless duration_s is set
+    double duration_s = 0;           // run for this long instead
+    // Open loop: requests per second over all connections, each sent on a
+    // fixed schedule whether or not earlier replies have arrived. 0 runs
+    // closed loop, sending as soon as the pipeline has room.
+    double rate = 0;
+
+    // Keys are <key_prefix><family>:<n> with n below key_space (or, under
+    // a LATEST distribution, counting up from it); strings, lists and sets
+    // each get their own family ("key", "list", "set"), so no mix runs
+    // into WRONGTYPE
+    size_t key_space = 100000;
+    std::string key_prefix;
+    KeyDistribution key_distribution;
+    std::vector<MixEntry> mix = {{CommandType::SET, 1}, {CommandType::GET, 10}};
+    SizeSpec value_size;
+    int range = 10;                  // elements LRANGE asks for
+    size_t set_members = 100;        // distinct SADD/SREM/SISMEMBER members
+
+    bool preload = false;            // SET every key before the run
+    uint64_t seed = 0;               // 0 = seeded from the clock
+};
+
+// "set:1,get:10" (command:weight); any of SET GET DEL EXISTS EXPIRE TTL
+// LPUSH RPUSH LPOP RPOP LRANGE LLEN SADD SREM SISMEMBER SMEMBERS SCARD
+bool parse_mix(const std::string& spec, std::vector<MixEntry>& mix);
+// "SET:1,GET:10"
+std::string describe_mix(const std::vector<MixEntry>& mix);
+
+struct CommandResult {
+    std::string name;
+    uint64_t ops = 0;                // answered, errors included
+    uint64_t errors = 0;             // error replies, or lost with a connection
+    uint64_t hits = 0;               // reads that found a value
+    uint64_t misses = 0;             // reads of missing keys
+    LatencyHistogram latency;        // nanoseconds, one sample per answered request
+
+    void merge(const CommandResult& other);
+};
+
+struct LoadResult {
+    bool ok = false;
+    std::string error;               // why the run failed or stopped early
+    double seconds = 0;
+    double target_rate = 0;          // config.rate; 0 for a closed-loop run
+    uint64_t bytes_sent = 0;
+    uint64_t bytes_received = 0;
+    std::vector<CommandResult> commands;  // in mix order
+    CommandResult totals;
+
+    double ops_per_sec() const { return seconds > 0 ? totals.ops / seconds : 0; }
+
+    // Throughput, hits and misses and latency percentiles per command
+    std::string report() const;
+    // Each command's percentile distribution, in HdrHistogram's .hgrm layout
+    std::string histograms() const;
+    // Result file for bench-compare: the run's config, then throughput,
+    // errors and latency percentiles per command and for the totals, and
+    // this process's peak RSS (add the server's with set_resource)
+    ResultDocument document(const LoadConfig& config) const;
+};
+
+// Load generator in the style of memtier_benchmark: threads each drive
+// their connections from one poll loop, keeping up to `pipeline` requests
+// in flight on every connection.
+//
+// Closed loop (the default) sends the next request as soon as a reply
+// comes back, and measures latency from the moment a request is written.
+// Under a stall that hides the tail: the generator stops sending, so the
+// requests that would have waited are never measured (coordinated
+// omission). Open loop (config.rate) gives every request an intended send
+// time on a fixed schedule and measures from that instead, so time spent
+// queued behind a slow reply, in a full pipeline, or in a late generator
+// counts against the server as it would for real clients.
+//
+// POSIX only; run() fails on Windows.
+class LoadGenerator {
+public:
+    explicit LoadGenerator(const LoadConfig& config);
+
+    // SET every key of the key space (done by run() if config.preload)
+    bool preload(std::string& error);
+
+    // Run the load; progress, if set, is called about once a second with
+    // the seconds elapsed and requests answered so far
+    LoadResult run(const std::function<void(double, uint64_t)>& progress = nullptr);
+
+    // The config as run: limits clamped, seed chosen
+    const LoadConfig& config() const { return config_; }
+
+private:
+    LoadConfig config_;
+};
+
+} // namespace distkv
+
+#endif // DISTKV_LOAD_GENERATOR_H
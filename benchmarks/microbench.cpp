@@ -0,0 +1,626 @@
+#include "storage.h"
+#include "protocol.h"
+#include "binary_protocol.h"
+#include "persistence.h"
+#include "bench_results.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <new>
+#include <random>
+#include <set>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#ifndef _WIN32
+    #include <unistd.h>
+#endif
+
+using namespace distkv;
+
+// Every heap allocation in this binary goes through here, so a case can
+// count what its operations allocate. Counters are per thread, so threads
+// measuring side by side do not contend on them.
+//
+// All the operators share one out-of-line pair of helpers: inlined, GCC
+// would see free() on a pointer from operator new and warn
+// (-Wmismatched-new-delete).
+#if defined(__GNUC__)
+    #define MICROBENCH_NOINLINE __attribute__((noinline))
+#elif defined(_MSC_VER)
+    #define MICROBENCH_NOINLINE __declspec(noinline)
+#else
+    #define MICROBENCH_NOINLINE
+#endif
+
+namespace {
+thread_local uint64_t t_allocations = 0;
+
+MICROBENCH_NOINLINE void* counted_alloc(std::size_t size) noexcept {
+    ++t_allocations;
+    return std::malloc(size ? size : 1);
+}
+
+MICROBENCH_NOINLINE void counted_free(void* p) noexcept {
+    std::free(p);
+}
+}
+
+void* operator new(std::size_t size) {
+    if (void* p = counted_alloc(size)) {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+
+void* operator new[](std::size_t size) {
+    return operator new(size);
+}
+
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept {
+    return counted_alloc(size);
+}
+
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept {
+    return counted_alloc(size);
+}
+
+void operator delete(void* p) noexcept {
+    counted_free(p);
+}
+
+void operator delete[](void* p) noexcept {
+    counted_free(p);
+}
+
+void operator delete(void* p, std::size_t) noexcept {
+    counted_free(p);
+}
+
+void operator delete[](void* p, std::size_t) noexcept {
+    counted_free(p);
+}
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+// One measured operation. body(thread, first, n) performs operations
+// [first, first + n) on one thread; every thread of a multi-threaded case
+// runs the same body with its own thread index.
+struct Case {
+    std::string name;
+    size_t threads = 1;
+    size_t bytes_per_op = 0;   // shown as MB/s when set
+    std::function<void(size_t, uint64_t, uint64_t)> body;
+};
+
+struct Measurement {
+    uint64_t iterations = 0;   // per thread
+    double seconds = 0;
+    uint64_t allocations = 0;  // all threads
+};
+
+Measurement run_once(const Case& c, uint64_t n) {
+    std::vector<uint64_t> allocations(c.threads, 0);
+    std::atomic<size_t> ready(0);
+    std::atomic<bool> go(false);
+    std::vector<std::thread> threads;
+    for (size_t t = 0; t < c.threads; ++t) {
+        threads.emplace_back([&, t]() {
+            ++ready;
+            while (!go.load(std::memory_order_acquire)) {
+                std::this_thread::yield();
+            }
+            uint64_t before = t_allocations;
+            c.body(t, t * n, n);
+            allocations[t] = t_allocations - before;
+        });
+    }
+    while (ready.load() < c.threads) {
+        std::this_thread::yield();
+    }
+    auto start = Clock::now();
+    go.store(true, std::memory_order_release);
+    for (auto& thread : threads) {
+        thread.join();
+    }
+
+    Measurement m;
+    m.iterations = n;
+    m.seconds = std::chrono::duration<double>(Clock::now() - start).count();
+    for (uint64_t count : allocations) {
+        m.allocations += count;
+    }
+    return m;
+}
+
+// Grow the iteration count until a run takes at least min_seconds, as
+// Google Benchmark does, and report that run
+Measurement measure(const Case& c, double min_seconds) {
+    uint64_t n = 1;
+    while (true) {
+        Measurement m = run_once(c, n);
+        if (m.seconds >= min_seconds || n >= (1ULL << 40)) {
+            return m;
+        }
+        double scale = m.seconds > 0 ? 1.4 * min_seconds / m.seconds : 100;
+        n = static_cast<uint64_t>(n * std::min(std::max(scale, 2.0), 100.0));
+    }
+}
+
+void print_header() {
+    std::printf("%-52s %8s %12s %12s %10s %14s %10s\n", "Benchmark", "Threads", "Iterations", "ns/op",
+                "allocs/op", "ops/sec", "MB/s");
+    std::printf("%s\n", std::string(124, '-').c_str());
+}
+
+void print_row(const Case& c, const Measurement& m) {
+    double total = static_cast<double>(m.iterations) * c.threads;
+    double ns_per_op = m.seconds * 1e9 / m.iterations;
+    char mb[32] = "";
+    if (c.bytes_per_op) {
+        std::snprintf(mb, sizeof(mb), "%.1f", total * c.bytes_per_op / m.seconds / 1e6);
+    }
+    std::printf("%-52s %8zu %12llu %12.1f %10.2f %14.0f %10s\n", c.name.c_str(), c.threads,
+                static_cast<unsigned long long>(m.iterations), ns_per_op, m.allocations / total,
+                total / m.seconds, mb);
+    std::fflush(stdout);
+}
+
+std::string value_of(size_t size) {
+    std::string value(size, 'v');
+    for (size_t i = 0; i < size; ++i) {
+        value[i] = static_cast<char>('a' + i % 26);
+    }
+    return value;
+}
+
+// A store of `count` string keys holding `size`-byte values, with the keys
+// in a shuffled order so successive operations do not walk memory in
+// insertion order
+struct Dataset {
+    Storage storage;
+    std::vector<std::string> keys;
+    std::vector<std::string> missing;
+    std::string value;
+
+    Dataset(size_t count, size_t size) : value(value_of(size)) {
+        keys.reserve(count);
+        for (size_t i = 0; i < count; ++i) {
+            keys.push_back("key:" + std::to_string(i));
+            storage.set(keys.back(), value);
+        }
+        std::shuffle(keys.begin(), keys.end(), std::mt19937_64(1));
+        for (size_t i = 0; i < std::min<size_t>(count, 65536); ++i) {
+            missing.push_back("missing:" + std::to_string(i));
+        }
+    }
+
+    const std::string& key(uint64_t i) const { return keys[i % keys.size()]; }
+};
+
+struct Options {
+    std::string filter;
+    double min_seconds = 0.2;
+    std::vector<size_t> threads = {1, 2, 4, 8};
+    std::vector<size_t> key_counts = {1000, 100000, 1000000};
+    std::vector<size_t> value_sizes = {16, 256, 4096, 65536};
+    bool list = false;
+    std::string json_file;
+    std::string label;
+};
+
+// Collects cases, skipping those the filter excludes before any setup,
+// and records each measurement in the result document
+class Suite {
+public:
+    Suite(const Options& options, ResultDocument& results) : options_(options), results_(results) {}
+
+    bool wants(const std::string& name) const {
+        return options_.filter.empty() || name.find(options_.filter) != std::string::npos;
+    }
+
+    void run(Case c) {
+        if (!wants(c.name) || !seen_.insert(c.name + "/" + std::to_string(c.threads)).second) {
+            return;
+        }
+        if (options_.list) {
+            std::printf("%s (threads: %zu)\n", c.name.c_str(), c.threads);
+            return;
+        }
+        Measurement m = measure(c, options_.min_seconds);
+        print_row(c, m);
+
+        double total = static_cast<double>(m.iterations) * c.threads;
+        results_.add_benchmark(c.name + "/threads:" + std::to_string(c.threads),
+                               {{"ns_per_op", m.seconds * 1e9 / m.iterations},
+                                {"ops_per_sec", total / m.seconds},
+                                {"allocs_per_op", m.allocations / total}});
+    }
+
+    const Options& options() const { return options_; }
+
+private:
+    const Options& options_;
+    ResultDocument& results_;
+    std::set<std::string> seen_;
+};
+
+std::string with(const std::string& op, size_t keys, size_t size) {
+    return "storage/" + op + "/keys:" + std::to_string(keys) + "/size:" + std::to_string(size);
+}
+
+// Every storage operation on one mid-sized store
+void storage_operations(Suite& suite) {
+    const size_t keys = 10000;
+    const size_t size = 64;
+    bool any = false;
+    for (const char* op : {"set", "get", "get_miss", "exists", "ttl", "expire", "del_set", "lpush_rpop",
+                           "lrange", "sadd_srem", "sismember", "smembers"}) {
+        any = any || suite.wants(with(op, keys, size));
+    }
+    if (!any) {
+        return;
+    }
+
+    Dataset data(keys, size);
+    Storage& s = data.storage;
+    std::vector<std::string> lists;
+    std::vector<std::string> sets;
+    for (size_t i = 0; i < 1000; ++i) {
+        lists.push_back("list:" + std::to_string(i));
+        sets.push_back("set:" + std::to_string(i));
+        for (int e = 0; e < 10; ++e) {
+            s.rpush(lists.back(), data.value);
+            s.sadd(sets.back(), "member:" + std::to_string(e));
+        }
+    }
+    std::vector<std::string> members;
+    for (int e = 0; e < 20; ++e) {
+        members.push_back("member:" + std::to_string(e));
+    }
+
+    auto body = [&](std::function<void(uint64_t)> op) {
+        return [op](size_t, uint64_t first, uint64_t n) {
+            for (uint64_t i = first; i < first + n; ++i) {
+                op(i);
+            }
+        };
+    };
+    suite.run({with("set", keys, size), 1, size, body([&](uint64_t i) { s.set(data.key(i), data.value); })});
+    suite.run({with("get", keys, size), 1, size, body([&](uint64_t i) { s.get(data.key(i)); })});
+    suite.run({with("get_miss", keys, size), 1, 0,
+               body([&](uint64_t i) { s.get(data.missing[i % data.missing.size()]); })});
+    suite.run({with("exists", keys, size), 1, 0, body([&](uint64_t i) { s.exists(data.key(i)); })});
+    suite.run({with("ttl", keys, size), 1, 0, body([&](uint64_t i) { s.ttl(data.key(i)); })});
+    suite.run({with("expire", keys, size), 1, 0, body([&](uint64_t i) { s.expire(data.key(i), 3600); })});
+    suite.run({with("del_set", keys, size), 1, size, body([&](uint64_t i) {
+                   s.del(data.key(i));
+                   s.set(data.key(i), data.value);
+               })});
+    suite.run({with("lpush_rpop", keys, size), 1, size, body([&](uint64_t i) {
+                   s.lpush(lists[i % lists.size()], data.value);
+                   s.rpop(lists[i % lists.size()]);
+               })});
+    suite.run({with("lrange", keys, size), 1, 10 * size,
+               body([&](uint64_t i) { s.lrange(lists[i % lists.size()], 0, 9); })});
+    suite.run({with("sadd_srem", keys, size), 1, 0, body([&](uint64_t i) {
+                   s.sadd(sets[i % sets.size()], members[10 + i % 10]);
+                   s.srem(sets[i % sets.size()], members[10 + i % 10]);
+               })});
+    suite.run({with("sismember", keys, size), 1, 0,
+               body([&](uint64_t i) { s.sismember(sets[i % sets.size()], members[i % members.size()]); })});
+    suite.run({with("smembers", keys, size), 1, 0, body([&](uint64_t i) { s.smembers(sets[i % sets.size()]); })});
+}
+
+// GET and SET as the store grows (cache misses) and as values grow (copies)
+void storage_scaling(Suite& suite) {
+    std::vector<std::pair<size_t, size_t>> shapes;
+    for (size_t keys : suite.options().key_counts) {
+        shapes.emplace_back(keys, 64);
+    }
+    for (size_t size : suite.options().value_sizes) {
+        shapes.emplace_back(10000, size);
+    }
+    for (const auto& shape : shapes) {
+        size_t keys = shape.first;
+        size_t size = shape.second;
+        if (!suite.wants(with("get", keys, size)) && !suite.wants(with("set", keys, size))) {
+            continue;
+        }
+        Dataset data(keys, size);
+        suite.run({with("get", keys, size), 1, size, [&](size_t, uint64_t first, uint64_t n) {
+                       for (uint64_t i = first; i < first + n; ++i) {
+                           data.storage.get(data.key(i));
+                       }
+                   }});
+        suite.run({with("set", keys, size), 1, size, [&](size_t, uint64_t first, uint64_t n) {
+                       for (uint64_t i = first; i < first + n; ++i) {
+                           data.storage.set(data.key(i), data.value);
+                       }
+                   }});
+    }
+}
+
+// Contention: threads sharing one store
+void storage_threads(Suite& suite) {
+    const size_t keys = 100000;
+    const size_t size = 64;
+    bool any = false;
+    for (const char* op : {"get", "set", "mixed_90_10"}) {
+        any = any || suite.wants(with(op, keys, size));
+    }
+    if (!any) {
+        return;
+    }
+
+    Dataset data(keys, size);
+    for (size_t threads : suite.options().threads) {
+        suite.run({with("get", keys, size), threads, size, [&](size_t, uint64_t first, uint64_t n) {
+                       for (uint64_t i = first; i < first + n; ++i) {
+                           data.storage.get(data.key(i * 7919));
+                       }
+                   }});
+        suite.run({with("set", keys, size), threads, size, [&](size_t, uint64_t first, uint64_t n) {
+                       for (uint64_t i = first; i < first + n; ++i) {
+                           data.storage.set(data.key(i * 7919), data.value);
+                       }
+                   }});
+        suite.run({with("mixed_90_10", keys, size), threads, size, [&](size_t, uint64_t first, uint64_t n) {
+                       for (uint64_t i = first; i < first + n; ++i) {
+                           if (i % 10 == 0) {
+                               data.storage.set(data.key(i * 7919), data.value);
+                           } else {
+                               data.storage.get(data.key(i * 7919));
+                           }
+                       }
+                   }});
+    }
+}
+
+// Request parsing and reply encoding, text and binary
+void protocol(Suite& suite) {
+    std::string value = value_of(64);
+    std::string set_line = "SET key:12345 " + value;
+    std::string get_line = "GET key:12345";
+    std::string lrange_line = "LRANGE list:12345 0 9";
+    Response ok(StatusCode::OK);
+    Response bulk(StatusCode::OK, value);
+    Response array(StatusCode::OK, std::vector<std::string>(10, value));
+    Response error(StatusCode::WRONG_TYPE, "Operation against a key holding the wrong kind of value");
+
+    auto parse = [](const std::string& line) {
+        return [&line](size_t, uint64_t, uint64_t n) {
+            for (uint64_t i = 0; i < n; ++i) {
+                Request req = Protocol::parse_request(line);
+                (void)req;
+            }
+        };
+    };
+    auto serialize = [](const Response& response) {
+        return [&response](size_t, uint64_t, uint64_t n) {
+            for (uint64_t i = 0; i < n; ++i) {
+                std::string out = Protocol::serialize_response(response);
+                (void)out;
+            }
+        };
+    };
+    suite.run({"protocol/parse_request/set", 1, set_line.size(), parse(set_line)});
+    suite.run({"protocol/parse_request/get", 1, get_line.size(), parse(get_line)});
+    suite.run({"protocol/parse_request/lrange", 1, lrange_line.size(), parse(lrange_line)});
+    suite.run({"protocol/serialize_response/ok", 1, 0, serialize(ok)});
+    suite.run({"protocol/serialize_response/bulk", 1, value.size(), serialize(bulk)});
+    suite.run({"protocol/serialize_response/array_10", 1, 10 * value.size(), serialize(array)});
+    suite.run({"protocol/serialize_response/error", 1, 0, serialize(error)});
+
+    std::string frame;
+    BinaryProtocol::append_request(frame, 1, set_line);
+    suite.run({"binary_protocol/parse/set", 1, frame.size(), [&frame](size_t, uint64_t, uint64_t n) {
+                   BinaryProtocol::Frame decoded;
+                   for (uint64_t i = 0; i < n; ++i) {
+                       size_t pos = 0;
+                       size_t needed;
+                       BinaryProtocol::parse(frame.data(), frame.size(), pos, decoded, needed);
+                       Request req = BinaryProtocol::to_request(decoded);
+                       (void)req;
+                   }
+               }});
+    suite.run({"binary_protocol/append_response/bulk", 1, value.size(), [&bulk](size_t, uint64_t, uint64_t n) {
+                   std::string out;
+                   for (uint64_t i = 0; i < n; ++i) {
+                       out.clear();
+                       BinaryProtocol::append_response(out, 1, bulk);
+                   }
+               }});
+}
+
+// Snapshot encoding and decoding, in memory and through a file. One
+// operation is a whole snapshot; MB/s is over its encoded size.
+void persistence(Suite& suite) {
+    const size_t keys = 100000;
+    const size_t size = 64;
+    std::string tag = "/keys:" + std::to_string(keys) + "/size:" + std::to_string(size);
+    bool any = false;
+    for (const char* op : {"write_snapshot", "read_snapshot", "save_snapshot", "load_snapshot"}) {
+        any = any || suite.wants(std::string("persistence/") + op + tag);
+    }
+    if (!any) {
+        return;
+    }
+
+    Dataset data(keys, size);
+    std::ostringstream encoded;
+    Persistence::write_snapshot(data.storage, encoded);
+    std::string snapshot = encoded.str();
+#ifdef _WIN32
+    std::string path = "distkv-microbench.rdb";
+#else
+    std::string path = "/tmp/distkv-microbench-" + std::to_string(getpid()) + ".rdb";
+#endif
+
+    suite.run({"persistence/write_snapshot" + tag, 1, snapshot.size(), [&](size_t, uint64_t, uint64_t n) {
+                   for (uint64_t i = 0; i < n; ++i) {
+                       std::ostringstream os;
+                       Persistence::write_snapshot(data.storage, os);
+                   }
+               }});
+    suite.run({"persistence/read_snapshot" + tag, 1, snapshot.size(), [&](size_t, uint64_t, uint64_t n) {
+                   for (uint64_t i = 0; i < n; ++i) {
+                       Storage restored;
+                       std::istringstream is(snapshot);
+                       Persistence::read_snapshot(restored, is);
+                   }
+               }});
+    // save_snapshot and load_snapshot report each call on stdout; mute it
+    // so the table stays readable
+    suite.run({"persistence/save_snapshot" + tag, 1, snapshot.size(), [&](size_t, uint64_t, uint64_t n) {
+                   std::cout.setstate(std::ios::failbit);
+                   for (uint64_t i = 0; i < n; ++i) {
+                       Persistence::save_snapshot(data.storage, path);
+                   }
+                   std::cout.clear();
+               }});
+    suite.run({"persistence/load_snapshot" + tag, 1, snapshot.size(), [&](size_t, uint64_t, uint64_t n) {
+                   std::cout.setstate(std::ios::failbit);
+                   Persistence::save_snapshot(data.storage, path);
+                   for (uint64_t i = 0; i < n; ++i) {
+                       Storage restored;
+                       Persistence::load_snapshot(restored, path);
+                   }
+                   std::cout.clear();
+               }});
+    std::remove(path.c_str());
+}
+
+// Parse "1,2,4" into positive numbers
+bool parse_list(const std::string& spec, std::vector<size_t>& values) {
+    std::vector<size_t> parsed;
+    std::istringstream iss(spec);
+    std::string item;
+    while (std::getline(iss, item, ',')) {
+        if (item.empty() || item.find_first_not_of("0123456789") != std::string::npos || std::atoll(item.c_str()) == 0) {
+            return false;
+        }
+        parsed.push_back(static_cast<size_t>(std::atoll(item.c_str())));
+    }
+    if (parsed.empty()) {
+        return false;
+    }
+    values = parsed;
+    return true;
+}
+
+std::string join(const std::vector<size_t>& values) {
+    std::string text;
+    for (size_t value : values) {
+        text += (text.empty() ? "" : ",") + std::to_string(value);
+    }
+    return text;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    Options options;
+
+    // Parse command line arguments
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--filter") == 0 && i + 1 < argc) {
+            options.filter = argv[i + 1];
+            ++i;
+        } else if (std::strcmp(argv[i], "--min-time") == 0 && i + 1 < argc) {
+            options.min_seconds = std::atof(argv[i + 1]);
+            ++i;
+        } else if (std::strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+            if (!parse_list(argv[i + 1], options.threads)) {
+                std::cerr << "Invalid --threads " << argv[i + 1] << ", expected e.g. 1,2,4\n";
+                return 1;
+            }
+            ++i;
+        } else if (std::strcmp(argv[i], "--keys") == 0 && i + 1 < argc) {
+            if (!parse_list(argv[i + 1], options.key_counts)) {
+                std::cerr << "Invalid --keys " << argv[i + 1] << ", expected e.g. 1000,100000\n";
+                return 1;
+            }
+            ++i;
+        } else if (std::strcmp(argv[i], "--sizes") == 0 && i + 1 < argc) {
+            if (!parse_list(argv[i + 1], options.value_sizes)) {
+                std::cerr << "Invalid --sizes " << argv[i + 1] << ", expected e.g. 16,4096\n";
+                return 1;
+            }
+            ++i;
+        } else if (std::strcmp(argv[i], "--json-out-file") == 0 && i + 1 < argc) {
+            options.json_file = argv[i + 1];
+            ++i;
+        } else if (std::strcmp(argv[i], "--label") == 0 && i + 1 < argc) {
+            options.label = argv[i + 1];
+            ++i;
+        } else if (std::strcmp(argv[i], "--list") == 0) {
+            options.list = true;
+        } else if (std::strcmp(argv[i], "--help") == 0) {
+            std::cout << "DistKV Microbenchmarks - in-process storage, protocol and persistence\n\n";
+            std::cout << "Usage: " << argv[0] << " [options]\n\n";
+            std::cout << "Options:\n";
+            std::cout << "  --filter <text>          Only benchmarks whose name contains text\n";
+            std::cout << "  --min-time <secs>        Minimum time per benchmark (default: 0.2)\n";
+            std::cout << "  --threads <list>         Thread counts for contention runs (default: 1,2,4,8)\n";
+            std::cout << "  --keys <list>            Key counts for GET/SET scaling (default: 1000,100000,1000000)\n";
+            std::cout << "  --sizes <list>           Value sizes for GET/SET scaling (default: 16,256,4096,65536)\n";
+            std::cout << "  --json-out-file <path>   Write results as JSON, for bench-compare\n";
+            std::cout << "  --label <text>           Name for this run in the JSON (e.g. a version)\n";
+            std::cout << "  --list                   List benchmarks without running them\n";
+            std::cout << "  --help                   Show this help message\n";
+            std::cout << "\nns/op is the time per operation on each thread; ops/sec is over all\n";
+            std::cout << "threads; allocs/op counts heap allocations per operation.\n";
+            return 0;
+        } else {
+            std::cerr << "Unknown option " << argv[i] << ", see --help\n";
+            return 1;
+        }
+    }
+
+    if (!options.list) {
+        std::cout << "\n========================================\n";
+        std::cout << "     DistKV Microbenchmarks\n";
+        std::cout << "========================================\n\n";
+#ifndef __OPTIMIZE__
+        std::cout << "Warning: built without optimization, timings are not representative\n\n";
+#endif
+        print_header();
+    }
+
+    ResultDocument results("microbench");
+    results.set_label(options.label);
+    results.set_config("filter", options.filter);
+    results.set_config("min_time", options.min_seconds);
+    results.set_config("threads", join(options.threads));
+    results.set_config("keys", join(options.key_counts));
+    results.set_config("sizes", join(options.value_sizes));
+
+    Suite suite(options, results);
+    storage_operations(suite);
+    storage_scaling(suite);
+    storage_threads(suite);
+    protocol(suite);
+    persistence(suite);
+
+    results.set_resource("peak_rss_bytes", static_cast<double>(peak_rss_bytes()));
+    if (!options.list && !options.json_file.empty()) {
+        std::ofstream file(options.json_file);
+        file << results.to_json();
+        if (!file) {
+            std::cerr << "Failed to write " << options.json_file << "\n";
+            return 1;
+        }
+    }
+    return 0;
+}
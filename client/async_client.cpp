@@ -0,0 +1,600 @@
+#include "async_client.h"
+#include <algorithm>
+#include <cstring>
+#include <cerrno>
+
+// Platform-specific includes
+#ifdef _WIN32
+    #include <winsock2.h>
+#else
+    #include <sys/socket.h>
+    #include <netinet/in.h>
+    #include <netinet/tcp.h>
+    #include <arpa/inet.h>
+    #include <fcntl.h>
+    #include <poll.h>
+    #include <unistd.h>
+    #ifdef __linux__
+        #include <sys/epoll.h>
+    #endif
+    #define CLOSE_SOCKET close
+    #define INVALID_SOCKET -1
+#endif
+
+namespace distkv {
+
+#ifndef _WIN32
+
+namespace {
+
+// Pause before reopening a connection that dropped or failed to connect
+constexpr int RECONNECT_DELAY_MS = 1000;
+
+// Bytes received per recv() call
+constexpr size_t READ_CHUNK = 16384;
+
+#ifdef MSG_NOSIGNAL
+constexpr int SEND_FLAGS = MSG_NOSIGNAL;
+#else
+constexpr int SEND_FLAGS = 0;
+#endif
+
+bool would_block() {
+    return errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR;
+}
+
+void set_nonblocking(int fd) {
+    fcntl(fd, F_SETFL, fcntl(fd, F_GETFL, 0) | O_NONBLOCK);
+}
+
+// Open a TCP socket to host:port. With wait the connect completes (or
+// fails) before returning; otherwise in_progress reports a connect still
+// under way. The returned socket is non-blocking either way.
+int open_socket(const std::string& host, int port, bool wait, bool& in_progress) {
+    in_progress = false;
+    struct sockaddr_in addr;
+    std::memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    std::string ip = (host == "localhost") ? "127.0.0.1" : host;
+    if (inet_pton(AF_INET, ip.c_str(), &addr.sin_addr) <= 0) {
+        return INVALID_SOCKET;
+    }
+
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    if (fd == INVALID_SOCKET) {
+        return INVALID_SOCKET;
+    }
+    int opt = 1;
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &opt, sizeof(opt));
+    if (!wait) {
+        set_nonblocking(fd);
+    }
+
+    if (::connect(fd, (struct sockaddr*)&addr, sizeof(addr)) < 0) {
+        if (wait || errno != EINPROGRESS) {
+            CLOSE_SOCKET(fd);
+            return INVALID_SOCKET;
+        }
+        in_progress = true;
+    }
+    if (wait) {
+        set_nonblocking(fd);
+    }
+    return fd;
+}
+
+} // namespace
+
+// Readiness of a handful of sockets: epoll on Linux, poll() elsewhere.
+// Only used by the thread running the event loop (or while it is stopped)
+class AsyncClient::Poller {
+public:
+    struct Event {
+        int fd;
+        bool readable;  // also set for errors and hangups
+        bool writable;
+    };
+
+#ifdef __linux__
+    Poller() : epoll_fd_(epoll_create1(0)) {}
+    ~Poller() {
+        if (epoll_fd_ >= 0) {
+            CLOSE_SOCKET(epoll_fd_);
+        }
+    }
+
+    bool valid() const { return epoll_fd_ >= 0; }
+
+    void add(int fd, bool write) { control(EPOLL_CTL_ADD, fd, write); }
+    void modify(int fd, bool write) { control(EPOLL_CTL_MOD, fd, write); }
+    void remove(int fd) { epoll_ctl(epoll_fd_, EPOLL_CTL_DEL, fd, nullptr); }
+
+    void wait(int timeout_ms, std::vector<Event>& events) {
+        struct epoll_event ready[64];
+        int n = epoll_wait(epoll_fd_, ready, 64, timeout_ms);
+        events.clear();
+        for (int i = 0; i < n; ++i) {
+            uint32_t flags = ready[i].events;
+            events.push_back({ready[i].data.fd, (flags & (EPOLLIN | EPOLLERR | EPOLLHUP)) != 0,
+                              (flags & (EPOLLOUT | EPOLLERR | EPOLLHUP)) != 0});
+        }
+    }
+
+private:
+    int epoll_fd_;
+
+    void control(int op, int fd, bool write) {
+        struct epoll_event ev;
+        std::memset(&ev, 0, sizeof(ev));
+        ev.events = EPOLLIN | (write ? static_cast<uint32_t>(EPOLLOUT) : 0u);
+        ev.data.fd = fd;
+        epoll_ctl(epoll_fd_, op, fd, &ev);
+    }
+#else
+    bool valid() const { return true; }
+
+    void add(int fd, bool write) { fds_.push_back({fd, static_cast<short>(POLLIN | (write ? POLLOUT : 0)), 0}); }
+    void modify(int fd, bool write) {
+        for (auto& p : fds_) {
+            if (p.fd == fd) {
+                p.events = static_cast<short>(POLLIN | (write ? POLLOUT : 0));
+            }
+        }
+    }
+    void remove(int fd) {
+        fds_.erase(std::remove_if(fds_.begin(), fds_.end(), [fd](const pollfd& p) { return p.fd == fd; }),
+                   fds_.end());
+    }
+
+    void wait(int timeout_ms, std::vector<Event>& events) {
+        events.clear();
+        if (poll(fds_.data(), fds_.size(), timeout_ms) <= 0) {
+            return;
+        }
+        for (const auto& p : fds_) {
+            if (p.revents != 0) {
+                events.push_back({p.fd, (p.revents & (POLLIN | POLLERR | POLLHUP)) != 0,
+                                  (p.revents & (POLLOUT | POLLERR | POLLHUP)) != 0});
+            }
+        }
+    }
+
+private:
+    std::vector<pollfd> fds_;
+#endif
+};
+
+AsyncClient::AsyncClient(size_t connections)
+    : connection_count_(std::max<size_t>(connections, 1)),
+      port_(0),
+      wake_fds_{INVALID_SOCKET, INVALID_SOCKET},
+      wake_pending_(false),
+      running_(false) {}
+
+AsyncClient::~AsyncClient() {
+    disconnect();
+}
+
+bool AsyncClient::connect(const std::string& host, int port) {
+    disconnect();
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    host_ = host;
+    port_ = port;
+    poller_ = std::make_unique<Poller>();
+    if (!poller_->valid() || pipe(wake_fds_) < 0) {
+        last_error_ = "Failed to create event loop";
+        poller_.reset();
+        return false;
+    }
+    set_nonblocking(wake_fds_[0]);
+    set_nonblocking(wake_fds_[1]);
+    poller_->add(wake_fds_[0], false);
+
+    bool any_open = false;
+    for (size_t i = 0; i < connection_count_; ++i) {
+        auto conn = std::make_unique<Connection>();
+        bool in_progress;
+        conn->fd = open_socket(host_, port_, true, in_progress);
+        if (conn->fd != INVALID_SOCKET) {
+            conn->state = State::OPEN;
+            poller_->add(conn->fd, false);
+            any_open = true;
+        }
+        connections_.push_back(std::move(conn));
+    }
+
+    if (!any_open) {
+        last_error_ = "Connection failed";
+        connections_.clear();
+        poller_.reset();
+        CLOSE_SOCKET(wake_fds_[0]);
+        CLOSE_SOCKET(wake_fds_[1]);
+        wake_fds_[0] = wake_fds_[1] = INVALID_SOCKET;
+        return false;
+    }
+
+    last_error_.clear();
+    running_ = true;
+    loop_thread_ = std::thread([this]() { run_loop(); });
+    return true;
+}
+
+void AsyncClient::disconnect() {
+    if (running_.exchange(false)) {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            wake();
+        }
+        if (loop_thread_.joinable()) {
+            loop_thread_.join();
+        }
+    }
+
+    std::vector<Completion> done;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (auto& conn : connections_) {
+            fail(*conn, "Client disconnected", done);
+        }
+        connections_.clear();
+        poller_.reset();
+        for (int& fd : wake_fds_) {
+            if (fd != INVALID_SOCKET) {
+                CLOSE_SOCKET(fd);
+                fd = INVALID_SOCKET;
+            }
+        }
+    }
+    run_completions(done);
+}
+
+bool AsyncClient::is_connected() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (const auto& conn : connections_) {
+        if (conn->state == State::OPEN) {
+            return true;
+        }
+    }
+    return false;
+}
+
+size_t AsyncClient::in_flight() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    size_t total = 0;
+    for (const auto& conn : connections_) {
+        total += conn->pending.size();
+    }
+    return total;
+}
+
+std::string AsyncClient::get_error() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return last_error_;
+}
+
+void AsyncClient::command(const std::vector<std::string>& args, Callback callback) {
+    std::string line;
+    for (const auto& arg : args) {
+        if (!line.empty()) {
+            line += ' ';
+        }
+        line += arg;
+    }
+    line += '\n';
+
+    std::vector<Completion> done;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        Connection* conn = running_ ? pick_connection() : nullptr;
+        if (!conn) {
+            last_error_ = "Not connected";
+            done.emplace_back(std::move(callback), error_reply(last_error_));
+        } else {
+            bool idle = conn->out_pos == conn->out.size() && conn->pending.empty();
+            conn->out += line;
+            conn->pending.push_back(std::move(callback));
+
+            // A lone request is written straight away. Behind others it is
+            // left for the event loop, which sends everything queued in
+            // the meantime with one write. Errors are left for the loop to
+            // notice either way
+            if (conn->state == State::OPEN && idle) {
+                while (conn->out_pos < conn->out.size()) {
+                    ssize_t n = send(conn->fd, conn->out.data() + conn->out_pos,
+                                     conn->out.size() - conn->out_pos, SEND_FLAGS);
+                    if (n <= 0) {
+                        break;
+                    }
+                    conn->out_pos += static_cast<size_t>(n);
+                }
+                if (conn->out_pos == conn->out.size()) {
+                    conn->out.clear();
+                    conn->out_pos = 0;
+                }
+            }
+            if (conn->state != State::OPEN || conn->out_pos < conn->out.size()) {
+                wake();
+            }
+        }
+    }
+    run_completions(done);
+}
+
+std::future<AsyncClient::Reply> AsyncClient::command(const std::vector<std::string>& args) {
+    auto promise = std::make_shared<std::promise<Reply>>();
+    std::future<Reply> future = promise->get_future();
+    command(args, [promise](Reply reply) { promise->set_value(std::move(reply)); });
+    return future;
+}
+
+void AsyncClient::run_loop() {
+    std::vector<Poller::Event> events;
+    std::vector<Completion> done;
+
+    while (running_) {
+        {
+            // Open connections that have work queued and push out requests
+            // queued by other threads
+            std::lock_guard<std::mutex> lock(mutex_);
+            for (auto& conn : connections_) {
+                if (conn->state == State::CLOSED && !conn->pending.empty()) {
+                    if (!start_connect(*conn)) {
+                        fail(*conn, "Connection failed", done);
+                    }
+                } else if (conn->state == State::OPEN && conn->out_pos < conn->out.size() &&
+                           !conn->want_write) {
+                    flush(*conn, done);
+                }
+            }
+        }
+        run_completions(done);
+
+        poller_->wait(-1, events);
+
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            for (const auto& event : events) {
+                if (event.fd == wake_fds_[0]) {
+                    char drain[256];
+                    while (read(wake_fds_[0], drain, sizeof(drain)) > 0) {
+                    }
+                    wake_pending_ = false;
+                    continue;
+                }
+
+                auto it = std::find_if(connections_.begin(), connections_.end(),
+                                       [&event](const std::unique_ptr<Connection>& c) { return c->fd == event.fd; });
+                if (it == connections_.end()) {
+                    continue;  // closed earlier in this round
+                }
+                Connection& conn = **it;
+                if (conn.state == State::CONNECTING) {
+                    finish_connect(conn, done);
+                    continue;
+                }
+                if (event.writable && conn.state == State::OPEN) {
+                    flush(conn, done);
+                }
+                if (event.readable && conn.state == State::OPEN) {
+                    receive(conn, done);
+                }
+            }
+        }
+        run_completions(done);
+    }
+}
+
+void AsyncClient::wake() {
+    if (!wake_pending_ && wake_fds_[1] != INVALID_SOCKET) {
+        char byte = 1;
+        wake_pending_ = write(wake_fds_[1], &byte, 1) == 1;
+    }
+}
+
+AsyncClient::Connection* AsyncClient::pick_connection() {
+    Connection* best = nullptr;
+    for (auto& conn : connections_) {
+        if (conn->state == State::OPEN && (!best || conn->pending.size() < best->pending.size())) {
+            best = conn.get();
+        }
+    }
+    if (best) {
+        return best;
+    }
+
+    // Nothing open: queue behind a connect in progress, or start one
+    for (auto& conn : connections_) {
+        if (conn->state == State::CONNECTING) {
+            return conn.get();
+        }
+    }
+    auto now = std::chrono::steady_clock::now();
+    for (auto& conn : connections_) {
+        if (conn->state == State::CLOSED && now >= conn->retry_at) {
+            return conn.get();
+        }
+    }
+    return nullptr;
+}
+
+bool AsyncClient::start_connect(Connection& conn) {
+    bool in_progress;
+    conn.fd = open_socket(host_, port_, false, in_progress);
+    if (conn.fd == INVALID_SOCKET) {
+        return false;
+    }
+    conn.state = in_progress ? State::CONNECTING : State::OPEN;
+    conn.want_write = true;
+    poller_->add(conn.fd, true);
+    return true;
+}
+
+void AsyncClient::finish_connect(Connection& conn, std::vector<Completion>& done) {
+    int error = 0;
+    socklen_t len = sizeof(error);
+    if (getsockopt(conn.fd, SOL_SOCKET, SO_ERROR, &error, &len) < 0 || error != 0) {
+        fail(conn, "Connection failed", done);
+        return;
+    }
+    conn.state = State::OPEN;
+    flush(conn, done);
+}
+
+void AsyncClient::flush(Connection& conn, std::vector<Completion>& done) {
+    while (conn.out_pos < conn.out.size()) {
+        ssize_t n = send(conn.fd, conn.out.data() + conn.out_pos, conn.out.size() - conn.out_pos, SEND_FLAGS);
+        if (n > 0) {
+            conn.out_pos += static_cast<size_t>(n);
+        } else if (n < 0 && would_block()) {
+            break;
+        } else {
+            fail(conn, "Connection closed", done);
+            return;
+        }
+    }
+    if (conn.out_pos == conn.out.size()) {
+        conn.out.clear();
+        conn.out_pos = 0;
+    }
+    set_want_write(conn, conn.out_pos < conn.out.size());
+}
+
+void AsyncClient::receive(Connection& conn, std::vector<Completion>& done) {
+    while (true) {
+        // Keep only the undecoded tail, then read into the buffer itself
+        if (conn.in_pos == conn.in.size()) {
+            conn.in.clear();
+        } else if (conn.in_pos > 0) {
+            conn.in.erase(0, conn.in_pos);
+        }
+        conn.in_pos = 0;
+
+        size_t old_size = conn.in.size();
+        conn.in.resize(old_size + READ_CHUNK);
+        ssize_t n = recv(conn.fd, &conn.in[old_size], READ_CHUNK, 0);
+        conn.in.resize(old_size + static_cast<size_t>(std::max<ssize_t>(n, 0)));
+        if (n < 0 && would_block()) {
+            return;
+        }
+        if (n <= 0) {
+            fail(conn, "Connection closed", done);
+            return;
+        }
+
+        Reply reply;
+        RespParser::Status status;
+        while ((status = conn.parser.parse(conn.in.data(), conn.in.size(), conn.in_pos, reply)) ==
+               RespParser::Status::DONE) {
+            if (conn.pending.empty()) {
+                fail(conn, "Unexpected reply", done);
+                return;
+            }
+            done.emplace_back(std::move(conn.pending.front()), std::move(reply));
+            conn.pending.pop_front();
+        }
+        if (status == RespParser::Status::ERROR) {
+            fail(conn, "Protocol error", done);
+            return;
+        }
+        if (static_cast<size_t>(n) < READ_CHUNK) {
+            return;  // drained
+        }
+    }
+}
+
+void AsyncClient::set_want_write(Connection& conn, bool want) {
+    if (conn.want_write != want) {
+        conn.want_write = want;
+        poller_->modify(conn.fd, want);
+    }
+}
+
+void AsyncClient::fail(Connection& conn, const std::string& error, std::vector<Completion>& done) {
+    if (conn.fd != INVALID_SOCKET) {
+        if (poller_) {
+            poller_->remove(conn.fd);
+        }
+        CLOSE_SOCKET(conn.fd);
+        conn.fd = INVALID_SOCKET;
+    }
+    conn.state = State::CLOSED;
+    conn.want_write = false;
+    conn.out.clear();
+    conn.out_pos = 0;
+    conn.in.clear();
+    conn.in_pos = 0;
+    conn.parser.reset();
+    conn.retry_at = std::chrono::steady_clock::now() + std::chrono::milliseconds(RECONNECT_DELAY_MS);
+
+    for (auto& callback : conn.pending) {
+        done.emplace_back(std::move(callback), error_reply(error));
+    }
+    if (!conn.pending.empty()) {
+        last_error_ = error;
+    }
+    conn.pending.clear();
+}
+
+#else  // _WIN32
+
+class AsyncClient::Poller {};
+
+AsyncClient::AsyncClient(size_t connections)
+    : connection_count_(connections), port_(0), wake_fds_{-1, -1}, wake_pending_(false), running_(false) {}
+
+AsyncClient::~AsyncClient() {}
+
+bool AsyncClient::connect(const std::string& host, int port) {
+    host_ = host;
+    port_ = port;
+    last_error_ = "AsyncClient is not supported on Windows";
+    return false;
+}
+
+void AsyncClient::disconnect() {}
+
+bool AsyncClient::is_connected() const {
+    return false;
+}
+
+size_t AsyncClient::in_flight() const {
+    return 0;
+}
+
+std::string AsyncClient::get_error() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return last_error_;
+}
+
+void AsyncClient::command(const std::vector<std::string>&, Callback callback) {
+    callback(error_reply("Not connected"));
+}
+
+std::future<AsyncClient::Reply> AsyncClient::command(const std::vector<std::string>& args) {
+    auto promise = std::make_shared<std::promise<Reply>>();
+    std::future<Reply> future = promise->get_future();
+    command(args, [promise](Reply reply) { promise->set_value(std::move(reply)); });
+    return future;
+}
+
+#endif  // _WIN32
+
+AsyncClient::Reply AsyncClient::error_reply(const std::string& message) {
+    Reply reply;
+    reply.type = Reply::Type::ERROR;
+    reply.str = message;
+    return reply;
+}
+
+void AsyncClient::run_completions(std::vector<Completion>& done) {
+    for (auto& completion : done) {
+        if (completion.first) {
+            completion.first(std::move(completion.second));
+        }
+    }
+    done.clear();
+}
+
+} // namespace distkv
@@ -0,0 +1,148 @@
+#ifndef DISTKV_ASYNC_CLIENT_H
+#define DISTKV_ASYNC_CLIENT_H
+
+#include "resp_parser.h"
+#include <string>
+#include <vector>
+#include <deque>
+#include <memory>
+#include <functional>
+#include <future>
+#include <mutex>
+#include <thread>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+
+#if defined(__cpp_impl_coroutine) && __cpp_impl_coroutine >= 201902L
+    #include <coroutine>
+    #define DISTKV_HAS_COROUTINES 1
+#endif
+
+namespace distkv {
+
+// Non-blocking client: commands are queued from any thread and complete
+// through a callback or a std::future, so many requests can be in flight
+// without a thread per call.
+//
+// A small fixed set of connections is driven by one event loop thread
+// (epoll on Linux, poll elsewhere). Each command goes to the open
+// connection with the fewest outstanding replies and is written right
+// away if that connection is idle. Replies come back in
+// order per connection and complete their commands in that order. While
+// a connection has replies outstanding, new commands are queued and the
+// loop writes them out together.
+//
+// Callbacks run on the event loop thread: they must not block (waiting on
+// another future from this client would deadlock) but may queue more
+// commands. A connection that drops fails its outstanding commands and is
+// reopened in the background; commands are failed immediately while no
+// connection is usable.
+//
+// POSIX only; on Windows connect() fails.
+class AsyncClient {
+public:
+    using Reply = RespReply;
+    using Callback = std::function<void(Reply)>;
+
+    explicit AsyncClient(size_t connections = 2);
+    ~AsyncClient();
+
+    // Open the connections and start the event loop; true if at least
+    // one connection is up
+    bool connect(const std::string& host, int port);
+    // Stop the loop; outstanding commands fail with an error reply
+    void disconnect();
+    bool is_connected() const;
+
+    // Queue a command; callback gets its reply (or an ERROR reply if the
+    // command could not be sent or its connection dropped)
+    void command(const std::vector<std::string>& args, Callback callback);
+    std::future<Reply> command(const std::vector<std::string>& args);
+
+    std::future<Reply> get(const std::string& key) { return command({"GET", key}); }
+    std::future<Reply> set(const std::string& key, const std::string& value) {
+        return command({"SET", key, value});
+    }
+    std::future<Reply> del(const std::string& key) { return command({"DEL", key}); }
+
+    // Commands sent or queued and not yet answered
+    size_t in_flight() const;
+
+    std::string get_error() const;
+
+#ifdef DISTKV_HAS_COROUTINES
+    // co_await client.co_command({"GET", "k"}) inside a C++20 coroutine;
+    // the coroutine resumes on the event loop thread
+    struct Awaiter {
+        AsyncClient& client;
+        std::vector<std::string> args;
+        Reply reply;
+
+        bool await_ready() const noexcept { return false; }
+        void await_suspend(std::coroutine_handle<> handle) {
+            client.command(args, [this, handle](Reply result) {
+                reply = std::move(result);
+                handle.resume();
+            });
+        }
+        Reply await_resume() { return std::move(reply); }
+    };
+
+    Awaiter co_command(std::vector<std::string> args) { return Awaiter{*this, std::move(args), Reply()}; }
+#endif
+
+private:
+    enum class State { CLOSED, CONNECTING, OPEN };
+
+    struct Connection {
+        int fd = -1;
+        State state = State::CLOSED;
+        std::string out;                // requests not yet written
+        size_t out_pos = 0;
+        std::string in;                 // received, not yet decoded
+        size_t in_pos = 0;
+        RespParser parser;
+        std::deque<Callback> pending;   // one per request, in send order
+        bool want_write = false;        // registered for writability
+        std::chrono::steady_clock::time_point retry_at;
+    };
+
+    class Poller;
+
+    // A callback with its reply, run once mutex_ is released
+    using Completion = std::pair<Callback, Reply>;
+
+    size_t connection_count_;
+    std::string host_;
+    int port_;
+
+    mutable std::mutex mutex_;  // connections, last_error_
+    std::vector<std::unique_ptr<Connection>> connections_;
+    std::string last_error_;
+
+    std::unique_ptr<Poller> poller_;
+    int wake_fds_[2];               // self-pipe that interrupts the poller
+    bool wake_pending_;             // a byte is in the pipe (mutex_)
+    std::atomic<bool> running_;
+    std::thread loop_thread_;
+
+    void run_loop();
+    void wake();  // mutex_ held
+
+    // All with mutex_ held
+    Connection* pick_connection();
+    bool start_connect(Connection& conn);
+    void finish_connect(Connection& conn, std::vector<Completion>& done);
+    void flush(Connection& conn, std::vector<Completion>& done);
+    void receive(Connection& conn, std::vector<Completion>& done);
+    void set_want_write(Connection& conn, bool want);
+    void fail(Connection& conn, const std::string& error, std::vector<Completion>& done);
+
+    static Reply error_reply(const std::string& message);
+    static void run_completions(std::vector<Completion>& done);
+};
+
+} // namespace distkv
+
+#endif // DISTKV_ASYNC_CLIENT_H
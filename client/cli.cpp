@@ -54,6 +54,7 @@ std::vector<std::string> parse_command(const std::string& input) {
 int main(int argc, char* argv[]) {
     std::string host = "127.0.0.1";
     int port = 6379;
+    std::string socket_path;
 
     // Parse command line arguments
     for (int i = 1; i < argc; ++i) {
@@ -63,13 +64,22 @@ int main(int argc, char* argv[]) {
         } else if (std::string(argv[i]) == "-p" && i + 1 < argc) {
             port = std::atoi(argv[i + 1]);
             ++i;
+        } else if (std::string(argv[i]) == "-s" && i + 1 < argc) {
+            socket_path = argv[i + 1];
+            ++i;
         }
     }
 
-    std::cout << "DistKV CLI - Connecting to " << host << ":" << port << "...\n";
-
     distkv::Client client;
-    if (!client.connect(host, port)) {
+    bool connected;
+    if (socket_path.empty()) {
+        std::cout << "DistKV CLI - Connecting to " << host << ":" << port << "...\n";
+        connected = client.connect(host, port);
+    } else {
+        std::cout << "DistKV CLI - Connecting to " << socket_path << "...\n";
+        connected = client.connect_unix(socket_path);
+    }
+    if (!connected) {
         std::cerr << "Failed to connect: " << client.get_error() << "\n";
         return 1;
     }
@@ -1,7 +1,10 @@
 #include "client.h"
+#include "shm_channel.h"
 #include <iostream>
-#include <sstream>
 #include <cstring>
+#include <algorithm>
+#include <cstdlib>
+#include <cerrno>
 
 // Platform-specific includes
 #ifdef _WIN32
@@ -13,6 +16,7 @@
     #include <sys/socket.h>
     #include <netinet/in.h>
     #include <arpa/inet.h>
+    #include <sys/un.h>
     #include <unistd.h>
     #define CLOSE_SOCKET close
     #define INVALID_SOCKET -1
@@ -20,7 +24,50 @@
 
 namespace distkv {
 
-Client::Client() : socket_fd_(INVALID_SOCKET), connected_(false) {
+namespace {
+
+// Request bytes a pipeline sends before reading their replies. The server
+// stops reading while its replies are not drained, so an unbounded batch
+// could leave both sides blocked in send
+constexpr size_t PIPELINE_WINDOW_BYTES = 64 * 1024;
+
+// Bytes asked of each recv, unless a larger bulk body is known to follow
+constexpr size_t READ_CHUNK_BYTES = 16384;
+
+// An empty receive buffer larger than this is released, so one huge value
+// does not pin its memory for the life of the connection
+constexpr size_t READ_BUFFER_KEEP_BYTES = 1024 * 1024;
+
+// Same limit as the parser's
+constexpr long long MAX_BULK_LEN = 512LL * 1024 * 1024;
+
+// False once the server closed the connection; the socket stays open
+// next to a shared-memory segment only to tell this
+bool peer_open(int fd) {
+#ifdef _WIN32
+    (void)fd;
+    return true;
+#else
+    char c;
+    ssize_t n = recv(fd, &c, 1, MSG_PEEK | MSG_DONTWAIT);
+    return n > 0 || (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR));
+#endif
+}
+
+} // namespace
+
+Client::Client()
+    : socket_fd_(INVALID_SOCKET),
+      connected_(false),
+      read_pos_(0),
+      read_end_(0),
+      binary_(false),
+      request_id_(0),
+      reply_id_(0),
+      cache_capacity_(0),
+      cache_hits_(0),
+      cache_misses_(0),
+      loading_invalidated_(false) {
 #ifdef _WIN32
     WSADATA wsaData;
     WSAStartup(MAKEWORD(2, 2), &wsaData);
@@ -69,311 +116,875 @@ bool Client::connect(const std::string& host, int port) {
         return false;
     }
 
+    return on_connected();
+}
+
+bool Client::connect_unix(const std::string& path) {
+    return open_unix(path) && on_connected();
+}
+
+bool Client::open_unix(const std::string& path) {
+#ifdef _WIN32
+    (void)path;
+    last_error_ = "Unix domain sockets are not supported";
+    return false;
+#else
+    if (connected_) {
+        disconnect();
+    }
+
+    struct sockaddr_un server_addr;
+    std::memset(&server_addr, 0, sizeof(server_addr));
+    server_addr.sun_family = AF_UNIX;
+    if (path.size() >= sizeof(server_addr.sun_path)) {
+        last_error_ = "Socket path too long";
+        return false;
+    }
+    std::memcpy(server_addr.sun_path, path.c_str(), path.size());
+
+    socket_fd_ = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (socket_fd_ == INVALID_SOCKET) {
+        last_error_ = "Failed to create socket";
+        return false;
+    }
+    if (::connect(socket_fd_, (struct sockaddr*)&server_addr, sizeof(server_addr)) < 0) {
+        last_error_ = "Connection failed";
+        CLOSE_SOCKET(socket_fd_);
+        socket_fd_ = INVALID_SOCKET;
+        return false;
+    }
+    return true;
+#endif
+}
+
+bool Client::connect_shm(const std::string& path, const ShmConfig& config) {
+#ifdef _WIN32
+    (void)path;
+    (void)config;
+    last_error_ = "Shared memory transport is not supported";
+    return false;
+#else
+    if (!open_unix(path) ||
+        !send_all("SHM " + std::to_string(config.ring_bytes) + " " + std::to_string(config.spin_us) + "\n")) {
+        return false;
+    }
+
+    // The reply line carries the segment's descriptor
+    std::string line;
+    int fd = -1;
+    while (line.find('\n') == std::string::npos) {
+        char data[256];
+        struct iovec iov;
+        iov.iov_base = data;
+        iov.iov_len = sizeof(data);
+        union {
+            char buf[CMSG_SPACE(sizeof(int))];
+            struct cmsghdr align;
+        } control;
+        struct msghdr msg;
+        std::memset(&msg, 0, sizeof(msg));
+        msg.msg_iov = &iov;
+        msg.msg_iovlen = 1;
+        msg.msg_control = control.buf;
+        msg.msg_controllen = sizeof(control.buf);
+
+        ssize_t n = recvmsg(socket_fd_, &msg, MSG_CMSG_CLOEXEC);
+        if (n <= 0) {
+            break;
+        }
+        for (struct cmsghdr* cmsg = CMSG_FIRSTHDR(&msg); cmsg; cmsg = CMSG_NXTHDR(&msg, cmsg)) {
+            if (cmsg->cmsg_level == SOL_SOCKET && cmsg->cmsg_type == SCM_RIGHTS && fd < 0) {
+                std::memcpy(&fd, CMSG_DATA(cmsg), sizeof(int));
+            }
+        }
+        line.append(data, static_cast<size_t>(n));
+    }
+
+    std::unique_ptr<ShmChannel> channel;
+    if (!line.empty() && line[0] == '+' && fd >= 0) {
+        channel = ShmChannel::attach(fd);
+        last_error_ = "Failed to map shared memory";
+    } else {
+        if (fd >= 0) {
+            CLOSE_SOCKET(fd);
+        }
+        size_t end = line.find_first_of("\r\n");
+        last_error_ = line.size() > 1 && line[0] == '-' ? line.substr(1, end - 1) : "Connection closed";
+    }
+    if (!channel) {
+        disconnect();
+        return false;
+    }
+    last_error_.clear();
+
+    channel->set_spin_us(config.spin_us);
+    int sock = socket_fd_;
+    channel->set_alive_check([sock]() { return peer_open(sock); });
+    shm_ = std::move(channel);
+    return on_connected();
+#endif
+}
+
+bool Client::on_connected() {
     connected_ = true;
+
+    // A new connection speaks text and is not tracked until asked again
+    if (binary_) {
+        binary_ = false;
+        enable_binary();
+    }
+    if (cache_capacity_ > 0) {
+        Reply reply;
+        if (!call("CLIENT TRACKING ON", reply) || !reply.ok()) {
+            cache_capacity_ = 0;
+        }
+    }
     return true;
 }
 
 void Client::disconnect() {
+    shm_.reset();
     if (socket_fd_ != INVALID_SOCKET) {
         CLOSE_SOCKET(socket_fd_);
         socket_fd_ = INVALID_SOCKET;
     }
     connected_ = false;
+    read_buffer_.clear();
+    read_pos_ = 0;
+    read_end_ = 0;
+    parser_.reset();
+    // Invalidations are no longer received
+    clear_cache();
 }
 
-bool Client::send_command(const std::string& cmd) {
-    if (!connected_) {
-        last_error_ = "Not connected";
-        return false;
+// ============= Pipelining and Reply I/O =============
+
+Client::Pipeline& Client::Pipeline::command(const std::vector<std::string>& args) {
+    std::string line;
+    for (const auto& arg : args) {
+        if (!line.empty()) {
+            line += ' ';
+        }
+        line += arg;
     }
+    lines_.push_back(std::move(line));
+    return *this;
+}
 
-    std::string msg = cmd + "\n";
-    ssize_t sent = send(socket_fd_, msg.c_str(), msg.length(), 0);
+std::vector<Client::Reply> Client::Pipeline::execute() {
+    std::vector<Reply> replies(lines_.size());
+    client_.last_error_.clear();
+
+    size_t answered = 0;
+    std::vector<bool> filled(lines_.size());
+    bool failed = !client_.connected_;
+    while (answered < lines_.size() && !failed) {
+        size_t first = answered;
+        size_t end = answered;
+        uint16_t first_id = static_cast<uint16_t>(client_.request_id_ + 1);
+        std::string batch;
+        while (end < lines_.size() && batch.size() < PIPELINE_WINDOW_BYTES) {
+            if (client_.binary_) {
+                BinaryProtocol::append_request(batch, ++client_.request_id_, lines_[end++]);
+            } else {
+                batch += lines_[end++];
+                batch += '\n';
+            }
+        }
+        failed = !client_.send_all(batch);
+        while (!failed && answered < end) {
+            Reply reply;
+            failed = !client_.read_reply(reply);
+            if (failed) {
+                break;
+            }
+            // Binary replies go where their id says, whatever their order
+            size_t index = answered;
+            if (client_.binary_) {
+                index = first + static_cast<uint16_t>(client_.reply_id_ - first_id);
+                if (index >= end || filled[index]) {
+                    client_.last_error_ = "Protocol error";
+                    failed = true;
+                    break;
+                }
+            }
+            replies[index] = std::move(reply);
+            filled[index] = true;
+            ++answered;
+        }
+    }
+
+    // Whatever was not answered failed with the connection
+    if (failed) {
+        if (client_.last_error_.empty()) {
+            client_.last_error_ = client_.connected_ ? "Protocol error" : "Not connected";
+        }
+        for (size_t i = 0; i < replies.size(); ++i) {
+            if (!filled[i]) {
+                replies[i] = Reply();
+                replies[i].str = client_.last_error_;
+            }
+        }
+        client_.disconnect();
+    }
 
-    if (sent <= 0) {
-        last_error_ = "Failed to send command";
+    lines_.clear();
+    return replies;
+}
+
+bool Client::send_all(const std::string& data) {
+    if (shm_) {
+        if (!shm_->write(data.data(), data.size())) {
+            last_error_ = "Failed to send command";
+            disconnect();
+            return false;
+        }
+        return true;
+    }
+
+    size_t sent = 0;
+    while (sent < data.size()) {
+#ifdef _WIN32
+        int n = send(socket_fd_, data.data() + sent, static_cast<int>(data.size() - sent), 0);
+#elif defined(MSG_NOSIGNAL)
+        ssize_t n = send(socket_fd_, data.data() + sent, data.size() - sent, MSG_NOSIGNAL);
+#else
+        ssize_t n = send(socket_fd_, data.data() + sent, data.size() - sent, 0);
+#endif
+        if (n <= 0) {
+            last_error_ = "Failed to send command";
+            disconnect();
+            return false;
+        }
+        sent += static_cast<size_t>(n);
+    }
+    return true;
+}
+
+bool Client::send_command(const std::string& cmd) {
+    if (!binary_) {
+        return send_all(cmd + "\n");
+    }
+    std::string frame;
+    BinaryProtocol::append_request(frame, ++request_id_, cmd);
+    return send_all(frame);
+}
+
+bool Client::reply_matches() {
+    if (binary_ && reply_id_ != request_id_) {
+        last_error_ = "Protocol error";
         disconnect();
         return false;
     }
-
     return true;
 }
 
-std::string Client::receive_response() {
-    if (!connected_) {
-        return "";
+bool Client::read_reply(Reply& reply) {
+    while (read_one(reply)) {
+        if (reply.type != Reply::Type::PUSH) {
+            return true;
+        }
+        handle_push(reply);
+    }
+    return false;
+}
+
+bool Client::read_one(Reply& reply) {
+    while (true) {
+        size_t want = 0;
+        RespParser::Status status = binary_ ? decode_frame(reply, nullptr, want)
+                                            : parser_.parse(read_buffer_.data(), read_end_, read_pos_, reply);
+        switch (status) {
+            case RespParser::Status::DONE:
+                return true;
+            case RespParser::Status::ERROR:
+                last_error_ = "Protocol error";
+                disconnect();
+                return false;
+            case RespParser::Status::NEED_MORE:
+                if (!fill_buffer(want)) {
+                    return false;
+                }
+                break;
+        }
+    }
+}
+
+RespParser::Status Client::decode_frame(Reply& reply, std::string_view* bulk, size_t& want) {
+    size_t needed = 0;
+    switch (BinaryProtocol::parse(read_buffer_.data(), read_end_, read_pos_, frame_, needed)) {
+        case BinaryProtocol::Status::NEED_MORE:
+            want = needed;
+            return RespParser::Status::NEED_MORE;
+        case BinaryProtocol::Status::ERROR:
+            return RespParser::Status::ERROR;
+        case BinaryProtocol::Status::DONE:
+            break;
     }
 
-    char buffer[4096];
-    std::string response;
+    // The same replies the text form of each status decodes to
+    reply = Reply();
+    reply_id_ = frame_.id;
+    const auto& elements = frame_.elements;
+    if (frame_.code == BinaryProtocol::PUSH) {
+        reply.type = Reply::Type::PUSH;
+        reply.elements.resize(2);
+        reply.elements[0].type = Reply::Type::BULK;
+        reply.elements[0].str = "invalidate";
+        reply.elements[1].type = Reply::Type::ARRAY;
+        for (const auto& key : elements) {
+            Reply item;
+            item.type = Reply::Type::BULK;
+            item.str.assign(key.data(), key.size());
+            reply.elements[1].elements.push_back(std::move(item));
+        }
+        return RespParser::Status::DONE;
+    }
+    if (frame_.code > static_cast<uint8_t>(StatusCode::ASK)) {
+        return RespParser::Status::ERROR;
+    }
+
+    StatusCode status = static_cast<StatusCode>(frame_.code);
+    if (status == StatusCode::NOT_FOUND) {
+        reply.type = Reply::Type::NIL;
+    } else if (status != StatusCode::OK) {
+        Response response(status);
+        if (!elements.empty()) {
+            response.data.emplace_back(elements[0]);
+        }
+        reply.str = Protocol::error_message(response);
+    } else if (elements.empty()) {
+        reply.type = Reply::Type::STATUS;
+        reply.str = "OK";
+    } else if (elements.size() == 1) {
+        reply.type = Reply::Type::BULK;
+        if (bulk) {
+            *bulk = elements[0];
+        } else {
+            reply.str.assign(elements[0].data(), elements[0].size());
+        }
+    } else {
+        reply.type = Reply::Type::ARRAY;
+        reply.elements.resize(elements.size());
+        for (size_t i = 0; i < elements.size(); ++i) {
+            reply.elements[i].type = Reply::Type::BULK;
+            reply.elements[i].str.assign(elements[i].data(), elements[i].size());
+        }
+    }
+    return RespParser::Status::DONE;
+}
+
+bool Client::read_reply_view(Reply& reply, std::string_view& bulk) {
+    while (binary_) {
+        size_t want = 0;
+        switch (decode_frame(reply, &bulk, want)) {
+            case RespParser::Status::DONE:
+                if (reply.type != Reply::Type::PUSH) {
+                    return true;
+                }
+                handle_push(reply);
+                break;
+            case RespParser::Status::ERROR:
+                last_error_ = "Protocol error";
+                disconnect();
+                return false;
+            case RespParser::Status::NEED_MORE:
+                if (!fill_buffer(want)) {
+                    return false;
+                }
+                break;
+        }
+    }
 
     while (true) {
-        ssize_t received = recv(socket_fd_, buffer, sizeof(buffer) - 1, 0);
+        if (read_pos_ == read_end_) {
+            if (!fill_buffer()) {
+                return false;
+            }
+            continue;
+        }
+        if (!parser_.idle() || read_buffer_[read_pos_] != '$') {
+            // Not a bulk string: decoded as usual, pushes included
+            if (!read_one(reply)) {
+                return false;
+            }
+            if (reply.type != Reply::Type::PUSH) {
+                return true;
+            }
+            handle_push(reply);
+            continue;
+        }
 
-        if (received <= 0) {
-            last_error_ = "Connection closed";
+        const char* start = read_buffer_.data() + read_pos_;
+        const void* newline = std::memchr(start, '\n', read_end_ - read_pos_);
+        if (!newline) {
+            if (!fill_buffer()) {
+                return false;
+            }
+            continue;
+        }
+        char* digits_end = nullptr;
+        long long len = std::strtoll(start + 1, &digits_end, 10);
+        if (len < 0 || digits_end == start + 1) {
+            // Nil (or garbage, which the parser reports)
+            if (!read_one(reply)) {
+                return false;
+            }
+            return true;
+        }
+        if (len > MAX_BULK_LEN) {
+            last_error_ = "Protocol error";
             disconnect();
-            return "";
+            return false;
         }
 
-        buffer[received] = '\0';
-        response += buffer;
+        // Wait until the body and its CRLF are buffered, reading the rest
+        // of a large body straight into place
+        size_t header = static_cast<size_t>(static_cast<const char*>(newline) - start) + 1;
+        size_t total = header + static_cast<size_t>(len) + 2;
+        if (read_end_ - read_pos_ < total) {
+            if (!fill_buffer(total)) {
+                return false;
+            }
+            continue;
+        }
+        reply = Reply();
+        reply.type = Reply::Type::BULK;
+        bulk = std::string_view(read_buffer_.data() + read_pos_ + header, static_cast<size_t>(len));
+        read_pos_ += total;
+        return true;
+    }
+}
 
-        // Check if we have a complete response (ends with \r\n)
-        if (response.size() >= 2 && response.substr(response.size() - 2) == "\r\n") {
-            break;
+bool Client::fill_buffer(size_t want) {
+    if (!connected_) {
+        return false;
+    }
+    size_t room = reserve_buffer(want);
+
+    if (shm_) {
+        long n;
+        while ((n = shm_->read(&read_buffer_[read_end_], room)) == 0) {
+        }
+        if (n < 0) {
+            last_error_ = "Connection closed";
+            disconnect();
+            return false;
         }
+        read_end_ += static_cast<size_t>(n);
+        return true;
     }
 
-    return response;
+#ifdef _WIN32
+    int received = recv(socket_fd_, &read_buffer_[read_end_], static_cast<int>(room), 0);
+#else
+    ssize_t received = recv(socket_fd_, &read_buffer_[read_end_], room, 0);
+#endif
+    if (received <= 0) {
+        last_error_ = "Connection closed";
+        disconnect();
+        return false;
+    }
+    read_end_ += static_cast<size_t>(received);
+    return true;
 }
 
-Client::ParseResult Client::parse_response(const std::string& response) {
-    ParseResult result;
-    result.success = false;
+size_t Client::reserve_buffer(size_t want) {
+    // Keep only the undecoded tail, at the front
+    size_t pending = read_end_ - read_pos_;
+    if (pending == 0 && read_buffer_.size() > READ_BUFFER_KEEP_BYTES) {
+        std::string().swap(read_buffer_);
+    } else if (read_pos_ > 0 && pending > 0) {
+        std::memmove(&read_buffer_[0], &read_buffer_[read_pos_], pending);
+    }
+    read_pos_ = 0;
+    read_end_ = pending;
 
-    if (response.empty()) {
-        result.error = "Empty response";
-        return result;
+    // Grown (and zero-filled) only here; received bytes land in place
+    size_t needed = std::max(pending + READ_CHUNK_BYTES, want);
+    if (read_buffer_.size() < needed) {
+        read_buffer_.resize(needed);
     }
+    return read_buffer_.size() - read_end_;
+}
 
-    char type = response[0];
+bool Client::call(const std::string& cmd, Reply& reply) {
+    if (!connected_) {
+        last_error_ = "Not connected";
+        return false;
+    }
+    last_error_.clear();
+    if (!send_command(cmd) || !read_reply(reply) || !reply_matches()) {
+        return false;
+    }
+    if (!reply.ok()) {
+        last_error_ = reply.str;
+    }
+    return true;
+}
 
-    switch (type) {
-        case '+': {  // Simple string
-            result.success = true;
-            result.data.push_back(response.substr(1, response.size() - 3));  // Remove +, \r\n
-            break;
+bool Client::call_write(const std::string& key, const std::string& cmd, Reply& reply) {
+    bool answered = call(cmd, reply);
+    // Our own invalidation may still be on its way
+    forget(key);
+    return answered;
+}
+
+bool Client::call_view(const std::string& cmd, Reply& reply, std::string_view& bulk) {
+    if (!connected_) {
+        last_error_ = "Not connected";
+        return false;
+    }
+    last_error_.clear();
+    if (!send_command(cmd) || !read_reply_view(reply, bulk) || !reply_matches()) {
+        return false;
+    }
+    if (!reply.ok()) {
+        last_error_ = reply.str;
+    }
+    return true;
+}
+
+// ============= Binary Protocol =============
+
+bool Client::enable_binary() {
+    if (binary_) {
+        return true;
+    }
+    Reply reply;
+    if (!call("PROTOCOL BINARY", reply) || !reply.ok()) {
+        return false;
+    }
+    binary_ = true;
+    return true;
+}
+
+void Client::disable_binary() {
+    if (binary_ && connected_) {
+        Reply reply;
+        if (!call("PROTOCOL TEXT", reply) || !reply.ok()) {
+            // Cannot tell where the server stands any more
+            disconnect();
         }
+    }
+    binary_ = false;
+}
 
-        case '-': {  // Error
-            result.success = false;
-            result.error = response.substr(1, response.size() - 3);
-            break;
+// ============= Client-Side Caching =============
+
+bool Client::enable_cache(size_t max_entries) {
+    if (max_entries == 0) {
+        disable_cache();
+        return true;
+    }
+    if (cache_capacity_ == 0) {
+        Reply reply;
+        if (!call("CLIENT TRACKING ON", reply) || !reply.ok()) {
+            return false;
         }
+    }
+    cache_capacity_ = max_entries;
+    while (cache_.size() > cache_capacity_) {
+        forget(cache_lru_.back());
+    }
+    return true;
+}
 
-        case '$': {  // Bulk string
-            if (response.substr(1, 2) == "-1") {
-                // Null bulk string (key not found)
-                result.success = false;
-                result.error = "Not found";
-            } else {
-                // Find the content after the first \r\n
-                size_t pos = response.find("\r\n");
-                if (pos != std::string::npos) {
-                    std::string content = response.substr(pos + 2);
-                    content = content.substr(0, content.size() - 2);  // Remove trailing \r\n
-                    result.success = true;
-                    result.data.push_back(content);
+void Client::disable_cache() {
+    if (cache_capacity_ > 0 && connected_) {
+        Reply reply;
+        call("CLIENT TRACKING OFF", reply);
+    }
+    cache_capacity_ = 0;
+    clear_cache();
+}
+
+void Client::poll_pushes() {
+    while (connected_) {
+        size_t room = reserve_buffer(0);
+        if (shm_) {
+            size_t n = shm_->read_available(&read_buffer_[read_end_], room);
+            if (n == 0) {
+                if (shm_->corrupt() || !peer_open(socket_fd_)) {
+                    last_error_ = "Connection closed";
+                    disconnect();
+                    return;
                 }
+                break;
             }
+            read_end_ += n;
+            continue;
+        }
+#ifdef _WIN32
+        u_long available = 0;
+        if (ioctlsocket(socket_fd_, FIONREAD, &available) != 0 || available == 0) {
             break;
         }
-
-        case '*': {  // Array
-            result.success = true;
-            // Simple array parsing - split by \r\n and extract bulk strings
-            std::istringstream iss(response.substr(1));
-            int count;
-            iss >> count;
-
-            // For now, simple implementation
-            // TODO: Proper RESP array parsing
+        int received = recv(socket_fd_, &read_buffer_[read_end_], static_cast<int>(room), 0);
+#else
+        ssize_t received = recv(socket_fd_, &read_buffer_[read_end_], room, MSG_DONTWAIT);
+        if (received < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
             break;
         }
+#endif
+        if (received <= 0) {
+            last_error_ = "Connection closed";
+            disconnect();
+            return;
+        }
+        read_end_ += static_cast<size_t>(received);
+    }
+    apply_pushes();
+}
 
-        default:
-            result.error = "Unknown response type";
+void Client::apply_pushes() {
+    // Every reply has been read, so only pushes can be waiting
+    while (connected_ && read_pos_ < read_end_) {
+        Reply push;
+        size_t want = 0;
+        RespParser::Status status = binary_ ? decode_frame(push, nullptr, want)
+                                            : parser_.parse(read_buffer_.data(), read_end_, read_pos_, push);
+        if (status == RespParser::Status::NEED_MORE) {
             break;
+        }
+        if (status == RespParser::Status::ERROR || push.type != Reply::Type::PUSH) {
+            last_error_ = "Protocol error";
+            disconnect();
+            return;
+        }
+        handle_push(push);
+    }
+}
+
+void Client::handle_push(const Reply& push) {
+    // >2 "invalidate" [key...]; a nil key list means everything
+    if (push.elements.size() != 2 || push.elements[0].str != "invalidate") {
+        return;
+    }
+    const Reply& keys = push.elements[1];
+    if (keys.is_nil()) {
+        clear_cache();
+        loading_invalidated_ = true;
+        return;
+    }
+    for (const auto& key : keys.elements) {
+        forget(key.str);
+        if (key.str == loading_key_) {
+            loading_invalidated_ = true;
+        }
     }
+}
 
-    return result;
+void Client::cache_store(const std::string& key, const std::optional<std::string>& value) {
+    auto it = cache_.find(key);
+    if (it != cache_.end()) {
+        it->second.value = value;
+        cache_lru_.splice(cache_lru_.begin(), cache_lru_, it->second.lru);
+        return;
+    }
+    if (cache_.size() >= cache_capacity_) {
+        forget(cache_lru_.back());
+    }
+    cache_lru_.push_front(key);
+    cache_.emplace(key, CacheEntry{value, cache_lru_.begin()});
+}
+
+void Client::forget(const std::string& key) {
+    auto it = cache_.find(key);
+    if (it != cache_.end()) {
+        cache_lru_.erase(it->second.lru);
+        cache_.erase(it);
+    }
+}
+
+void Client::clear_cache() {
+    cache_.clear();
+    cache_lru_.clear();
 }
 
 // ============= Command Implementations =============
 
 bool Client::ping() {
-    if (!send_command("PING")) return false;
-    std::string resp = receive_response();
-    auto result = parse_response(resp);
-    return result.success;
+    Reply reply;
+    return call("PING", reply) && reply.ok();
 }
 
 bool Client::set(const std::string& key, const std::string& value) {
-    std::string cmd = "SET " + key + " " + value;
-    if (!send_command(cmd)) return false;
-    std::string resp = receive_response();
-    auto result = parse_response(resp);
-    return result.success;
+    Reply reply;
+    return call_write(key, "SET " + key + " " + value, reply) && reply.ok();
 }
 
 std::optional<std::string> Client::get(const std::string& key) {
-    std::string cmd = "GET " + key;
-    if (!send_command(cmd)) return std::nullopt;
-    std::string resp = receive_response();
-    auto result = parse_response(resp);
-    if (result.success && !result.data.empty()) {
-        return result.data[0];
+    std::optional<std::string_view> value;
+    if (!fetch(key, value) || !value) return std::nullopt;
+    return std::string(*value);
+}
+
+std::optional<std::string_view> Client::get_view(const std::string& key) {
+    std::optional<std::string_view> value;
+    if (!fetch(key, value)) return std::nullopt;
+    return value;
+}
+
+bool Client::get_into(const std::string& key, std::string& value) {
+    std::optional<std::string_view> view;
+    if (!fetch(key, view) || !view) return false;
+    value.assign(view->data(), view->size());
+    return true;
+}
+
+std::optional<size_t> Client::get_into(const std::string& key, char* buffer, size_t size) {
+    std::optional<std::string_view> view;
+    if (!fetch(key, view) || !view) return std::nullopt;
+    std::memcpy(buffer, view->data(), std::min(size, view->size()));
+    return view->size();
+}
+
+bool Client::fetch(const std::string& key, std::optional<std::string_view>& value) {
+    bool caching = cache_capacity_ > 0;
+    if (caching) {
+        poll_pushes();
+        auto it = cache_.find(key);
+        if (it != cache_.end()) {
+            ++cache_hits_;
+            last_error_.clear();
+            cache_lru_.splice(cache_lru_.begin(), cache_lru_, it->second.lru);
+            value.reset();
+            if (it->second.value) {
+                value = *it->second.value;
+            }
+            return true;
+        }
+        ++cache_misses_;
+        loading_key_ = key;
+        loading_invalidated_ = false;
+    }
+
+    Reply reply;
+    std::string_view bulk;
+    bool answered = call_view("GET " + key, reply, bulk);
+    if (caching) {
+        // An invalidation sent along with the reply (a key with a TTL)
+        apply_pushes();
+        loading_key_.clear();
+    }
+    // A bad push behind the reply drops the buffer the value is in
+    if (!answered || !connected_) return false;
+
+    value.reset();
+    if (reply.type == Reply::Type::BULK) {
+        value = bulk;
+    }
+    if (caching && reply.ok() && !loading_invalidated_ && cache_capacity_ > 0) {
+        cache_store(key, value ? std::optional<std::string>(std::string(*value)) : std::nullopt);
     }
-    return std::nullopt;
+    return true;
 }
 
 bool Client::del(const std::string& key) {
-    std::string cmd = "DEL " + key;
-    if (!send_command(cmd)) return false;
-    std::string resp = receive_response();
-    auto result = parse_response(resp);
-    return result.success && !result.data.empty() && result.data[0] == "1";
+    Reply reply;
+    return call_write(key, "DEL " + key, reply) && reply.boolean();
 }
 
 bool Client::exists(const std::string& key) {
-    std::string cmd = "EXISTS " + key;
-    if (!send_command(cmd)) return false;
-    std::string resp = receive_response();
-    auto result = parse_response(resp);
-    return result.success && !result.data.empty() && result.data[0] == "1";
+    Reply reply;
+    return call("EXISTS " + key, reply) && reply.boolean();
 }
 
 bool Client::expire(const std::string& key, int seconds) {
-    std::string cmd = "EXPIRE " + key + " " + std::to_string(seconds);
-    if (!send_command(cmd)) return false;
-    std::string resp = receive_response();
-    auto result = parse_response(resp);
-    return result.success && !result.data.empty() && result.data[0] == "1";
+    Reply reply;
+    return call_write(key, "EXPIRE " + key + " " + std::to_string(seconds), reply) && reply.boolean();
 }
 
 int Client::ttl(const std::string& key) {
-    std::string cmd = "TTL " + key;
-    if (!send_command(cmd)) return -2;
-    std::string resp = receive_response();
-    auto result = parse_response(resp);
-    if (result.success && !result.data.empty()) {
-        return std::stoi(result.data[0]);
-    }
-    return -2;
+    Reply reply;
+    if (!call("TTL " + key, reply)) return -2;
+    return static_cast<int>(reply.integer(-2));
 }
 
 std::vector<std::string> Client::keys() {
-    if (!send_command("KEYS")) return {};
-    std::string resp = receive_response();
-    auto result = parse_response(resp);
-    return result.data;
+    Reply reply;
+    if (!call("KEYS", reply)) return {};
+    return reply.list();
 }
 
 size_t Client::dbsize() {
-    if (!send_command("DBSIZE")) return 0;
-    std::string resp = receive_response();
-    auto result = parse_response(resp);
-    if (result.success && !result.data.empty()) {
-        return std::stoull(result.data[0]);
-    }
-    return 0;
+    Reply reply;
+    if (!call("DBSIZE", reply)) return 0;
+    return static_cast<size_t>(reply.integer(0));
 }
 
 int Client::lpush(const std::string& key, const std::string& value) {
-    std::string cmd = "LPUSH " + key + " " + value;
-    if (!send_command(cmd)) return 0;
-    std::string resp = receive_response();
-    auto result = parse_response(resp);
-    if (result.success && !result.data.empty()) {
-        return std::stoi(result.data[0]);
-    }
-    return 0;
+    Reply reply;
+    if (!call_write(key, "LPUSH " + key + " " + value, reply)) return 0;
+    return static_cast<int>(reply.integer(0));
 }
 
 int Client::rpush(const std::string& key, const std::string& value) {
-    std::string cmd = "RPUSH " + key + " " + value;
-    if (!send_command(cmd)) return 0;
-    std::string resp = receive_response();
-    auto result = parse_response(resp);
-    if (result.success && !result.data.empty()) {
-        return std::stoi(result.data[0]);
-    }
-    return 0;
+    Reply reply;
+    if (!call_write(key, "RPUSH " + key + " " + value, reply)) return 0;
+    return static_cast<int>(reply.integer(0));
 }
 
 std::optional<std::string> Client::lpop(const std::string& key) {
-    std::string cmd = "LPOP " + key;
-    if (!send_command(cmd)) return std::nullopt;
-    std::string resp = receive_response();
-    auto result = parse_response(resp);
-    if (result.success && !result.data.empty()) {
-        return result.data[0];
-    }
-    return std::nullopt;
+    Reply reply;
+    if (!call_write(key, "LPOP " + key, reply)) return std::nullopt;
+    return reply.value();
 }
 
 std::optional<std::string> Client::rpop(const std::string& key) {
-    std::string cmd = "RPOP " + key;
-    if (!send_command(cmd)) return std::nullopt;
-    std::string resp = receive_response();
-    auto result = parse_response(resp);
-    if (result.success && !result.data.empty()) {
-        return result.data[0];
-    }
-    return std::nullopt;
+    Reply reply;
+    if (!call_write(key, "RPOP " + key, reply)) return std::nullopt;
+    return reply.value();
 }
 
 std::vector<std::string> Client::lrange(const std::string& key, int start, int stop) {
-    std::string cmd = "LRANGE " + key + " " + std::to_string(start) + " " + std::to_string(stop);
-    if (!send_command(cmd)) return {};
-    std::string resp = receive_response();
-    auto result = parse_response(resp);
-    return result.data;
+    Reply reply;
+    if (!call("LRANGE " + key + " " + std::to_string(start) + " " + std::to_string(stop), reply)) return {};
+    return reply.list();
 }
 
 int Client::llen(const std::string& key) {
-    std::string cmd = "LLEN " + key;
-    if (!send_command(cmd)) return 0;
-    std::string resp = receive_response();
-    auto result = parse_response(resp);
-    if (result.success && !result.data.empty()) {
-        return std::stoi(result.data[0]);
-    }
-    return 0;
+    Reply reply;
+    if (!call("LLEN " + key, reply)) return 0;
+    return static_cast<int>(reply.integer(0));
 }
 
 bool Client::sadd(const std::string& key, const std::string& member) {
-    std::string cmd = "SADD " + key + " " + member;
-    if (!send_command(cmd)) return false;
-    std::string resp = receive_response();
-    auto result = parse_response(resp);
-    return result.success && !result.data.empty() && result.data[0] == "1";
+    Reply reply;
+    return call_write(key, "SADD " + key + " " + member, reply) && reply.boolean();
 }
 
 bool Client::srem(const std::string& key, const std::string& member) {
-    std::string cmd = "SREM " + key + " " + member;
-    if (!send_command(cmd)) return false;
-    std::string resp = receive_response();
-    auto result = parse_response(resp);
-    return result.success && !result.data.empty() && result.data[0] == "1";
+    Reply reply;
+    return call_write(key, "SREM " + key + " " + member, reply) && reply.boolean();
 }
 
 bool Client::sismember(const std::string& key, const std::string& member) {
-    std::string cmd = "SISMEMBER " + key + " " + member;
-    if (!send_command(cmd)) return false;
-    std::string resp = receive_response();
-    auto result = parse_response(resp);
-    return result.success && !result.data.empty() && result.data[0] == "1";
+    Reply reply;
+    return call("SISMEMBER " + key + " " + member, reply) && reply.boolean();
 }
 
 std::vector<std::string> Client::smembers(const std::string& key) {
-    std::string cmd = "SMEMBERS " + key;
-    if (!send_command(cmd)) return {};
-    std::string resp = receive_response();
-    auto result = parse_response(resp);
-    return result.data;
+    Reply reply;
+    if (!call("SMEMBERS " + key, reply)) return {};
+    return reply.list();
 }
 
 int Client::scard(const std::string& key) {
-    std::string cmd = "SCARD " + key;
-    if (!send_command(cmd)) return 0;
-    std::string resp = receive_response();
-    auto result = parse_response(resp);
-    if (result.success && !result.data.empty()) {
-        return std::stoi(result.data[0]);
-    }
-    return 0;
+    Reply reply;
+    if (!call("SCARD " + key, reply)) return 0;
+    return static_cast<int>(reply.integer(0));
+}
+
+bool Client::set_max_staleness_ms(int max_lag_ms) {
+    Reply reply;
+    return call("STALENESS MS " + std::to_string(max_lag_ms), reply) && reply.ok();
+}
+
+bool Client::set_max_staleness_offset(long long max_lag_offset) {
+    Reply reply;
+    return call("STALENESS OFFSET " + std::to_string(max_lag_offset), reply) && reply.ok();
 }
 
 } // namespace distkv
@@ -1,19 +1,97 @@
 #ifndef DISTKV_CLIENT_H
 #define DISTKV_CLIENT_H
 
+#include "resp_parser.h"
+#include "binary_protocol.h"
 #include <string>
 #include <vector>
 #include <optional>
+#include <string_view>
+#include <list>
+#include <unordered_map>
+#include <memory>
+#include <cstddef>
 
 namespace distkv {
 
+class ShmChannel;
+
+// Shared-memory transport settings (Client::connect_shm)
+struct ShmConfig {
+    size_t ring_bytes = 1024 * 1024;  // per direction
+    int spin_us = 50;                 // spin before sleeping while waiting (both
+                                      // sides); -1 busy-polls, never sleeping
+};
+
 class Client {
 public:
+    // Decoded server reply (see resp_parser.h)
+    using Reply = RespReply;
+
+    // Commands queued on a client and sent together: one write for the
+    // whole batch (in windows, see client.cpp) and all replies read back
+    // in order, instead of one round trip per command.
+    //
+    //   auto replies = client.pipeline().set("a", "1").get("a").execute();
+    //   replies[1].value();  // "1"
+    class Pipeline {
+    public:
+        explicit Pipeline(Client& client) : client_(client) {}
+
+        Pipeline& command(const std::vector<std::string>& args);
+
+        Pipeline& ping() { return command({"PING"}); }
+        Pipeline& set(const std::string& key, const std::string& value) { return command({"SET", key, value}); }
+        Pipeline& get(const std::string& key) { return command({"GET", key}); }
+        Pipeline& del(const std::string& key) { return command({"DEL", key}); }
+        Pipeline& exists(const std::string& key) { return command({"EXISTS", key}); }
+        Pipeline& expire(const std::string& key, int seconds) {
+            return command({"EXPIRE", key, std::to_string(seconds)});
+        }
+        Pipeline& ttl(const std::string& key) { return command({"TTL", key}); }
+        Pipeline& lpush(const std::string& key, const std::string& value) { return command({"LPUSH", key, value}); }
+        Pipeline& rpush(const std::string& key, const std::string& value) { return command({"RPUSH", key, value}); }
+        Pipeline& lpop(const std::string& key) { return command({"LPOP", key}); }
+        Pipeline& rpop(const std::string& key) { return command({"RPOP", key}); }
+        Pipeline& lrange(const std::string& key, int start, int stop) {
+            return command({"LRANGE", key, std::to_string(start), std::to_string(stop)});
+        }
+        Pipeline& llen(const std::string& key) { return command({"LLEN", key}); }
+        Pipeline& sadd(const std::string& key, const std::string& member) { return command({"SADD", key, member}); }
+        Pipeline& srem(const std::string& key, const std::string& member) { return command({"SREM", key, member}); }
+        Pipeline& sismember(const std::string& key, const std::string& member) {
+            return command({"SISMEMBER", key, member});
+        }
+        Pipeline& smembers(const std::string& key) { return command({"SMEMBERS", key}); }
+        Pipeline& scard(const std::string& key) { return command({"SCARD", key}); }
+
+        size_t size() const { return lines_.size(); }
+        void clear() { lines_.clear(); }
+
+        // Send everything queued and read the replies, one per command in
+        // queue order. If the connection fails, the unanswered commands
+        // get ERROR replies. The queue is empty afterwards.
+        std::vector<Reply> execute();
+
+    private:
+        Client& client_;
+        std::vector<std::string> lines_;
+    };
+
     Client();
     ~Client();
 
     // Connection management
     bool connect(const std::string& host, int port);
+    // Connect over the server's Unix domain socket (--unix-socket), which
+    // skips the TCP stack for clients on the same host
+    bool connect_unix(const std::string& path);
+    // Connect over the Unix socket, then move the connection onto
+    // shared-memory rings: requests and replies skip the kernel entirely
+    // while both sides are awake. With busy polling, each side keeps a
+    // core spinning for as long as the connection is open.
+    bool connect_shm(const std::string& path, const ShmConfig& config = ShmConfig());
+    bool is_shm() const { return shm_ != nullptr; }
     void disconnect();
     bool is_connected() const { return connected_; }
 
@@ -21,6 +99,15 @@ public:
     bool ping();
     bool set(const std::string& key, const std::string& value);
     std::optional<std::string> get(const std::string& key);
+
+    // GET without copying the value into a new string. get_view() returns
+    // a view into the client's receive buffer (or cache), valid until the
+    // next call on this client; get_into() copies it once into the
+    // caller's buffer. The char* form copies at most size bytes and
+    // returns the full length of the value.
+    std::optional<std::string_view> get_view(const std::string& key);
+    bool get_into(const std::string& key, std::string& value);
+    std::optional<size_t> get_into(const std::string& key, char* buffer, size_t size);
     bool del(const std::string& key);
     bool exists(const std::string& key);
     bool expire(const std::string& key, int seconds);
@@ -43,25 +130,121 @@ public:
     std::vector<std::string> smembers(const std::string& key);
     int scard(const std::string& key);
 
-    // Get last error
+    // Start a pipeline on this connection
+    Pipeline pipeline() { return Pipeline(*this); }
+
+    // Replica read bounds for this connection (see STALENESS)
+    bool set_max_staleness_ms(int max_lag_ms);
+    bool set_max_staleness_offset(long long max_lag_offset);
+
+    // Client-side caching. The server remembers the keys this connection
+    // reads (CLIENT TRACKING) and pushes an invalidation when one changes;
+    // until then get() answers repeated reads of a key from a local LRU
+    // cache of up to max_entries keys, without a round trip. Invalidations
+    // are picked up before each cached read. The cache is emptied when the
+    // connection drops and tracking is turned on again by connect().
+    bool enable_cache(size_t max_entries = 10000);
+    void disable_cache();
+    size_t cache_size() const { return cache_.size(); }
+    size_t cache_hits() const { return cache_hits_; }
+    size_t cache_misses() const { return cache_misses_; }
+
+    // Move this connection to the binary protocol (see binary_protocol.h):
+    // length-prefixed frames with opcodes and request ids instead of text
+    // lines, so neither side scans for delimiters or parses numbers, and
+    // replies take fewer bytes. Stays on across reconnects, falling back
+    // to text against a server that refuses it. Pipelines are matched to
+    // their replies by id.
+    bool enable_binary();
+    void disable_binary();
+    bool is_binary() const { return binary_; }
+
+    // Get last error (including the last error reply from the server)
     std::string get_error() const { return last_error_; }
 
 private:
     int socket_fd_;
     bool connected_;
+    std::unique_ptr<ShmChannel> shm_;  // set once connect_shm switched over
     std::string last_error_;
 
-    // Send command and receive response
-    bool send_command(const std::string& cmd);
-    std::string receive_response();
+    // Received bytes are read_buffer_[0, read_end_), undecoded from
+    // read_pos_; the rest of the string is room for the next recv. Replies
+    // that arrive together (pipelines) or in pieces are split by parser_
+    std::string read_buffer_;
+    size_t read_pos_;
+    size_t read_end_;
+    RespParser parser_;
 
-    // Parse response
-    struct ParseResult {
-        bool success;
-        std::vector<std::string> data;
-        std::string error;
+    // Binary protocol state: frames decode into frame_ (reused), request
+    // ids count up from request_id_ (the last one sent), and reply_id_ is
+    // the id of the last reply read
+    bool binary_;
+    BinaryProtocol::Frame frame_;
+    uint16_t request_id_;
+    uint16_t reply_id_;
+
+    // Cached GET results; nullopt records a missing key
+    struct CacheEntry {
+        std::optional<std::string> value;
+        std::list<std::string>::iterator lru;
     };
-    ParseResult parse_response(const std::string& response);
+    size_t cache_capacity_;                  // 0 = caching off
+    std::unordered_map<std::string, CacheEntry> cache_;
+    std::list<std::string> cache_lru_;       // most recently used first
+    size_t cache_hits_;
+    size_t cache_misses_;
+    // Key of the GET awaiting its reply (empty if none). An invalidation
+    // arriving first means the reply may predate the change, so it is
+    // not cached.
+    std::string loading_key_;
+    bool loading_invalidated_;
+
+    // Send one command and read its reply; error replies also set
+    // last_error_
+    bool call(const std::string& cmd, Reply& reply);
+    // call() for a command that modifies key
+    bool call_write(const std::string& key, const std::string& cmd, Reply& reply);
+    // call() that leaves a bulk reply in read_buffer_ (see read_reply_view)
+    bool call_view(const std::string& cmd, Reply& reply, std::string_view& bulk);
+    // GET through the cache; the value is a view as for get_view()
+    bool fetch(const std::string& key, std::optional<std::string_view>& value);
+    // Connect socket_fd_ to a Unix socket, not yet set up
+    bool open_unix(const std::string& path);
+    // Set up a newly connected socket_fd_
+    bool on_connected();
+
+    bool send_all(const std::string& data);
+    // Send one command line in the connection's protocol
+    bool send_command(const std::string& cmd);
+    // In the binary protocol, check that the reply just read answers the
+    // request just sent
+    bool reply_matches();
+    // Read the next reply, applying push messages that come before it
+    bool read_reply(Reply& reply);
+    // Read the next reply or push
+    bool read_one(Reply& reply);
+    // Decode the next binary frame in read_buffer_ as read_one() would,
+    // except that with bulk set a one-element reply is left in place as
+    // for read_reply_view(). NEED_MORE sets want for fill_buffer().
+    RespParser::Status decode_frame(Reply& reply, std::string_view* bulk, size_t& want);
+    // read_reply(), except that a bulk string reply is not copied: reply
+    // is an empty BULK and bulk views it in read_buffer_
+    bool read_reply_view(Reply& reply, std::string_view& bulk);
+    // Receive more bytes; want is how many the undecoded data needs in all
+    bool fill_buffer(size_t want = 0);
+    // Move undecoded bytes to the front and make room for want of them;
+    // returns the free space after read_end_
+    size_t reserve_buffer(size_t want);
+
+    // Apply invalidations already received, without blocking
+    void poll_pushes();
+    // Apply those already in read_buffer_
+    void apply_pushes();
+    void handle_push(const Reply& push);
+    void cache_store(const std::string& key, const std::optional<std::string>& value);
+    void forget(const std::string& key);
+    void clear_cache();
 };
 
 } // namespace distkv
@@ -0,0 +1,660 @@
+#include "cluster_client.h"
+#include "../include/cluster.h"
+#include <sstream>
+#include <thread>
+#include <chrono>
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+#include <cstdlib>
+
+// Platform-specific includes
+#ifdef _WIN32
+    #include <winsock2.h>
+    #include <ws2tcpip.h>
+    #pragma comment(lib, "ws2_32.lib")
+    #define CLOSE_SOCKET closesocket
+#else
+    #include <sys/socket.h>
+    #include <netinet/in.h>
+    #include <netinet/tcp.h>
+    #include <arpa/inet.h>
+    #include <unistd.h>
+    #define CLOSE_SOCKET close
+    #define INVALID_SOCKET -1
+#endif
+
+namespace distkv {
+
+namespace {
+
+// Redirects followed for one command before giving up
+constexpr int MAX_REDIRECTS = 5;
+constexpr int TRYAGAIN_DELAY_MS = 5;
+
+// Request bytes sent before reading their replies. The server stops reading
+// while its replies are not drained, so an unbounded pipeline could leave
+// both sides blocked in send
+constexpr size_t PIPELINE_WINDOW_BYTES = 64 * 1024;
+
+// Commands whose first argument is a key
+bool has_key(std::string cmd) {
+    std::transform(cmd.begin(), cmd.end(), cmd.begin(),
+                   [](unsigned char c) { return std::toupper(c); });
+    static const char* const keyed[] = {
+        "SET", "GET", "DEL", "EXISTS", "EXPIRE", "TTL",
+        "LPUSH", "RPUSH", "LPOP", "RPOP", "LRANGE", "LLEN",
+        "SADD", "SREM", "SISMEMBER", "SMEMBERS", "SCARD",
+    };
+    for (const char* name : keyed) {
+        if (cmd == name) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool starts_with(const std::string& s, const char* prefix) {
+    return s.rfind(prefix, 0) == 0;
+}
+
+// "MOVED 3999 127.0.0.1:6381" -> slot, host, port
+bool parse_redirect(const std::string& error, int& slot, std::string& host, int& port) {
+    std::istringstream iss(error);
+    std::string kind, address;
+    if (!(iss >> kind >> slot >> address)) {
+        return false;
+    }
+    size_t colon = address.rfind(':');
+    if (colon == std::string::npos) {
+        return false;
+    }
+    host = address.substr(0, colon);
+    port = std::atoi(address.c_str() + colon + 1);
+    return slot >= 0 && slot < CLUSTER_SLOTS && port > 0;
+}
+
+} // namespace
+
+// One connection to a node with a persistent read buffer, so pipelined
+// replies can be read back one at a time
+class ClusterClient::Connection {
+public:
+    Connection() : fd_(INVALID_SOCKET), pos_(0) {}
+    ~Connection() { disconnect(); }
+
+    bool connected() const { return fd_ != INVALID_SOCKET; }
+
+    bool open(const std::string& host, int port) {
+        disconnect();
+        fd_ = socket(AF_INET, SOCK_STREAM, 0);
+        if (fd_ == INVALID_SOCKET) {
+            return false;
+        }
+
+        struct sockaddr_in addr;
+        std::memset(&addr, 0, sizeof(addr));
+        addr.sin_family = AF_INET;
+        addr.sin_port = htons(port);
+        std::string ip = (host == "localhost") ? "127.0.0.1" : host;
+        if (inet_pton(AF_INET, ip.c_str(), &addr.sin_addr) <= 0 ||
+            ::connect(fd_, (struct sockaddr*)&addr, sizeof(addr)) < 0) {
+            disconnect();
+            return false;
+        }
+
+        int opt = 1;
+#ifdef _WIN32
+        setsockopt(fd_, IPPROTO_TCP, TCP_NODELAY, (const char*)&opt, sizeof(opt));
+#else
+        setsockopt(fd_, IPPROTO_TCP, TCP_NODELAY, &opt, sizeof(opt));
+#endif
+        return true;
+    }
+
+    void disconnect() {
+        if (fd_ != INVALID_SOCKET) {
+            CLOSE_SOCKET(fd_);
+            fd_ = INVALID_SOCKET;
+        }
+        buffer_.clear();
+        pos_ = 0;
+    }
+
+    bool send_all(const std::string& data) {
+        size_t sent = 0;
+        while (sent < data.size()) {
+#ifdef _WIN32
+            int n = send(fd_, data.data() + sent, static_cast<int>(data.size() - sent), 0);
+#elif defined(MSG_NOSIGNAL)
+            ssize_t n = send(fd_, data.data() + sent, data.size() - sent, MSG_NOSIGNAL);
+#else
+            ssize_t n = send(fd_, data.data() + sent, data.size() - sent, 0);
+#endif
+            if (n <= 0) {
+                disconnect();
+                return false;
+            }
+            sent += static_cast<size_t>(n);
+        }
+        return true;
+    }
+
+    bool read_reply(Reply& reply) {
+        std::string line;
+        if (!read_line(line) || line.empty()) {
+            return false;
+        }
+
+        reply = Reply();
+        switch (line[0]) {
+            case '+':
+                reply.type = Reply::Type::STATUS;
+                reply.str = line.substr(1);
+                return true;
+            case '-':
+                reply.type = Reply::Type::ERROR;
+                reply.str = line.substr(1);
+                return true;
+            case '$': {
+                long len = std::atol(line.c_str() + 1);
+                if (len < 0) {
+                    reply.type = Reply::Type::NIL;
+                    return true;
+                }
+                reply.type = Reply::Type::BULK;
+                return read_bulk(static_cast<size_t>(len), reply.str);
+            }
+            case '*': {
+                long count = std::atol(line.c_str() + 1);
+                reply.type = Reply::Type::ARRAY;
+                for (long i = 0; i < count; ++i) {
+                    if (!read_line(line) || line.empty() || line[0] != '$') {
+                        return false;
+                    }
+                    std::string element;
+                    if (!read_bulk(static_cast<size_t>(std::atol(line.c_str() + 1)), element)) {
+                        return false;
+                    }
+                    reply.elements.push_back(std::move(element));
+                }
+                return true;
+            }
+            default:
+                return false;
+        }
+    }
+
+private:
+    int fd_;
+    std::string buffer_;
+    size_t pos_;
+
+    bool fill() {
+        if (pos_ > 0) {
+            buffer_.erase(0, pos_);
+            pos_ = 0;
+        }
+        char chunk[16384];
+#ifdef _WIN32
+        int n = recv(fd_, chunk, sizeof(chunk), 0);
+#else
+        ssize_t n = recv(fd_, chunk, sizeof(chunk), 0);
+#endif
+        if (n <= 0) {
+            disconnect();
+            return false;
+        }
+        buffer_.append(chunk, static_cast<size_t>(n));
+        return true;
+    }
+
+    bool read_line(std::string& line) {
+        size_t end;
+        while ((end = buffer_.find("\r\n", pos_)) == std::string::npos) {
+            if (!connected() || !fill()) {
+                return false;
+            }
+        }
+        line.assign(buffer_, pos_, end - pos_);
+        pos_ = end + 2;
+        return true;
+    }
+
+    bool read_bulk(size_t len, std::string& out) {
+        while (buffer_.size() - pos_ < len + 2) {
+            if (!connected() || !fill()) {
+                return false;
+            }
+        }
+        out.assign(buffer_, pos_, len);
+        pos_ += len + 2;
+        return true;
+    }
+};
+
+ClusterClient::ClusterClient()
+    : slot_node_(CLUSTER_SLOTS, -1),
+      map_stale_(false),
+      moved_(0),
+      asks_(0) {
+#ifdef _WIN32
+    WSADATA wsaData;
+    WSAStartup(MAKEWORD(2, 2), &wsaData);
+#endif
+}
+
+ClusterClient::~ClusterClient() {
+    disconnect();
+
+#ifdef _WIN32
+    WSACleanup();
+#endif
+}
+
+bool ClusterClient::connect(const std::string& host, int port) {
+    seeds_.emplace_back(host, port);
+    node_for(host, port);
+    return refresh_slots();
+}
+
+void ClusterClient::disconnect() {
+    seeds_.clear();
+    nodes_.clear();
+    node_index_.clear();
+    std::fill(slot_node_.begin(), slot_node_.end(), -1);
+}
+
+size_t ClusterClient::node_for(const std::string& host, int port) {
+    std::string address = host + ":" + std::to_string(port);
+    auto it = node_index_.find(address);
+    if (it != node_index_.end()) {
+        return it->second;
+    }
+    nodes_.push_back(Node{host, port, std::make_unique<Connection>()});
+    node_index_[address] = nodes_.size() - 1;
+    return nodes_.size() - 1;
+}
+
+bool ClusterClient::refresh_slots() {
+    // Try the seeds first, then every node we know of
+    std::vector<std::pair<std::string, int>> candidates = seeds_;
+    for (const auto& node : nodes_) {
+        candidates.emplace_back(node.host, node.port);
+    }
+
+    for (const auto& candidate : candidates) {
+        std::vector<Reply> replies;
+        Node& node = nodes_[node_for(candidate.first, candidate.second)];
+        if (!run_pipeline(node, {"CLUSTER NODES"}, replies) ||
+            replies[0].type != Reply::Type::BULK) {
+            continue;
+        }
+
+        std::vector<std::string> owners;
+        if (!parse_slot_owners(replies[0].str, owners)) {
+            continue;
+        }
+        std::vector<int> slot_node(CLUSTER_SLOTS, -1);
+        for (int slot = 0; slot < CLUSTER_SLOTS; ++slot) {
+            const std::string& address = owners[slot];
+            if (address.empty()) {
+                continue;
+            }
+            if (slot > 0 && address == owners[slot - 1]) {
+                slot_node[slot] = slot_node[slot - 1];
+                continue;
+            }
+            size_t colon = address.rfind(':');
+            slot_node[slot] = static_cast<int>(
+                node_for(address.substr(0, colon), std::atoi(address.c_str() + colon + 1)));
+        }
+        slot_node_ = std::move(slot_node);
+        map_stale_ = false;
+        return true;
+    }
+
+    last_error_ = "no cluster node reachable";
+    return false;
+}
+
+std::string ClusterClient::join(const std::vector<std::string>& args) {
+    std::string line;
+    for (const auto& arg : args) {
+        if (!line.empty()) {
+            line += ' ';
+        }
+        line += arg;
+    }
+    return line;
+}
+
+size_t ClusterClient::route(const std::vector<std::string>& args) {
+    if (args.size() >= 2 && has_key(args[0])) {
+        int index = slot_node_[key_hash_slot(args[1])];
+        if (index >= 0) {
+            return static_cast<size_t>(index);
+        }
+    }
+    // Keyless or unmapped: any node answers (or redirects)
+    return node_for(seeds_.front().first, seeds_.front().second);
+}
+
+bool ClusterClient::run_pipeline(Node& node, const std::vector<std::string>& lines,
+                                 std::vector<Reply>& replies) {
+    if (!node.conn->connected() && !node.conn->open(node.host, node.port)) {
+        return false;
+    }
+
+    replies.resize(lines.size());
+    size_t next = 0;
+    while (next < lines.size()) {
+        size_t first = next;
+        std::string batch;
+        while (next < lines.size() && batch.size() < PIPELINE_WINDOW_BYTES) {
+            batch += lines[next++];
+            batch += '\n';
+        }
+        if (!node.conn->send_all(batch)) {
+            node.conn->disconnect();
+            return false;
+        }
+        for (size_t i = first; i < next; ++i) {
+            if (!node.conn->read_reply(replies[i])) {
+                node.conn->disconnect();
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+ClusterClient::Reply ClusterClient::run(const std::vector<std::string>& args) {
+    if (nodes_.empty()) {
+        Reply error;
+        error.str = last_error_ = "Not connected";
+        return error;
+    }
+    if (map_stale_) {
+        refresh_slots();
+    }
+
+    std::string line = join(args);
+    size_t index = route(args);
+    bool asking = false;
+    Reply reply;
+
+    for (int attempt = 0; attempt <= MAX_REDIRECTS; ++attempt) {
+        std::vector<Reply> replies;
+        std::vector<std::string> lines;
+        if (asking) {
+            lines.push_back("ASKING");
+        }
+        lines.push_back(line);
+
+        if (!run_pipeline(nodes_[index], lines, replies)) {
+            // The node may be gone; reload the map and retry elsewhere
+            reply = Reply();
+            reply.str = "connection to " + nodes_[index].host + ":" +
+                        std::to_string(nodes_[index].port) + " failed";
+            refresh_slots();
+            index = route(args);
+            asking = false;
+            continue;
+        }
+        reply = replies.back();
+        asking = false;
+
+        int slot;
+        std::string host;
+        int port;
+        if (reply.type != Reply::Type::ERROR) {
+            break;
+        }
+        if (starts_with(reply.str, "MOVED ") && parse_redirect(reply.str, slot, host, port)) {
+            ++moved_;
+            index = node_for(host, port);
+            slot_node_[slot] = static_cast<int>(index);
+            map_stale_ = true;
+        } else if (starts_with(reply.str, "ASK ") && parse_redirect(reply.str, slot, host, port)) {
+            ++asks_;
+            index = node_for(host, port);
+            asking = true;
+        } else if (starts_with(reply.str, "ERR TRYAGAIN")) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(TRYAGAIN_DELAY_MS));
+            index = route(args);
+        } else {
+            break;
+        }
+    }
+
+    if (!reply.ok()) {
+        last_error_ = reply.str;
+    }
+    return reply;
+}
+
+ClusterClient::Reply ClusterClient::command(const std::vector<std::string>& args) {
+    last_error_.clear();
+    return run(args);
+}
+
+std::vector<ClusterClient::Reply> ClusterClient::execute(
+    const std::vector<std::vector<std::string>>& commands) {
+    last_error_.clear();
+    std::vector<Reply> results(commands.size());
+    if (nodes_.empty()) {
+        for (auto& result : results) {
+            result.str = last_error_ = "Not connected";
+        }
+        return results;
+    }
+    if (map_stale_) {
+        refresh_slots();
+    }
+
+    // Group commands by node
+    std::map<size_t, std::vector<size_t>> groups;
+    for (size_t i = 0; i < commands.size(); ++i) {
+        groups[route(commands[i])].push_back(i);
+    }
+
+    // One pipeline per node, all nodes at once
+    struct Work {
+        size_t node;
+        std::vector<size_t> indices;
+        std::vector<std::string> lines;
+        std::vector<Reply> replies;
+        bool ok = false;
+    };
+    std::vector<Work> work;
+    for (auto& group : groups) {
+        Work w;
+        w.node = group.first;
+        w.indices = std::move(group.second);
+        for (size_t i : w.indices) {
+            w.lines.push_back(join(commands[i]));
+        }
+        work.push_back(std::move(w));
+    }
+
+    std::vector<std::thread> threads;
+    for (size_t i = 1; i < work.size(); ++i) {
+        threads.emplace_back([this, &work, i]() {
+            work[i].ok = run_pipeline(nodes_[work[i].node], work[i].lines, work[i].replies);
+        });
+    }
+    if (!work.empty()) {
+        work[0].ok = run_pipeline(nodes_[work[0].node], work[0].lines, work[0].replies);
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+
+    // Redirected or failed commands are retried one by one
+    for (auto& w : work) {
+        for (size_t j = 0; j < w.indices.size(); ++j) {
+            size_t i = w.indices[j];
+            const Reply* reply = w.ok ? &w.replies[j] : nullptr;
+            bool redirected = reply && reply->type == Reply::Type::ERROR &&
+                              (starts_with(reply->str, "MOVED ") || starts_with(reply->str, "ASK ") ||
+                               starts_with(reply->str, "ERR TRYAGAIN"));
+            if (!reply || redirected) {
+                results[i] = run(commands[i]);
+            } else {
+                results[i] = *reply;
+                if (!reply->ok()) {
+                    last_error_ = reply->str;
+                }
+            }
+        }
+    }
+    return results;
+}
+
+// ============= Multi-key helpers =============
+
+std::vector<std::optional<std::string>> ClusterClient::mget(const std::vector<std::string>& keys) {
+    std::vector<std::vector<std::string>> commands;
+    for (const auto& key : keys) {
+        commands.push_back({"GET", key});
+    }
+    std::vector<std::optional<std::string>> values;
+    for (auto& reply : execute(commands)) {
+        if (reply.type == Reply::Type::BULK) {
+            values.push_back(std::move(reply.str));
+        } else {
+            values.push_back(std::nullopt);
+        }
+    }
+    return values;
+}
+
+bool ClusterClient::mset(const std::vector<std::pair<std::string, std::string>>& pairs) {
+    std::vector<std::vector<std::string>> commands;
+    for (const auto& pair : pairs) {
+        commands.push_back({"SET", pair.first, pair.second});
+    }
+    bool ok = true;
+    for (const auto& reply : execute(commands)) {
+        ok = ok && reply.ok();
+    }
+    return ok;
+}
+
+size_t ClusterClient::del(const std::vector<std::string>& keys) {
+    std::vector<std::vector<std::string>> commands;
+    for (const auto& key : keys) {
+        commands.push_back({"DEL", key});
+    }
+    size_t deleted = 0;
+    for (const auto& reply : execute(commands)) {
+        if (reply.type == Reply::Type::BULK && reply.str == "1") {
+            ++deleted;
+        }
+    }
+    return deleted;
+}
+
+// ============= Single-key commands =============
+
+bool ClusterClient::set(const std::string& key, const std::string& value) {
+    return command({"SET", key, value}).ok();
+}
+
+std::optional<std::string> ClusterClient::get(const std::string& key) {
+    Reply reply = command({"GET", key});
+    if (reply.type == Reply::Type::BULK) {
+        return reply.str;
+    }
+    return std::nullopt;
+}
+
+bool ClusterClient::del(const std::string& key) {
+    Reply reply = command({"DEL", key});
+    return reply.type == Reply::Type::BULK && reply.str == "1";
+}
+
+bool ClusterClient::exists(const std::string& key) {
+    Reply reply = command({"EXISTS", key});
+    return reply.type == Reply::Type::BULK && reply.str == "1";
+}
+
+bool ClusterClient::expire(const std::string& key, int seconds) {
+    Reply reply = command({"EXPIRE", key, std::to_string(seconds)});
+    return reply.type == Reply::Type::BULK && reply.str == "1";
+}
+
+int ClusterClient::ttl(const std::string& key) {
+    Reply reply = command({"TTL", key});
+    return reply.type == Reply::Type::BULK ? std::atoi(reply.str.c_str()) : -2;
+}
+
+int ClusterClient::lpush(const std::string& key, const std::string& value) {
+    Reply reply = command({"LPUSH", key, value});
+    return reply.type == Reply::Type::BULK ? std::atoi(reply.str.c_str()) : 0;
+}
+
+int ClusterClient::rpush(const std::string& key, const std::string& value) {
+    Reply reply = command({"RPUSH", key, value});
+    return reply.type == Reply::Type::BULK ? std::atoi(reply.str.c_str()) : 0;
+}
+
+std::optional<std::string> ClusterClient::lpop(const std::string& key) {
+    Reply reply = command({"LPOP", key});
+    if (reply.type == Reply::Type::BULK) {
+        return reply.str;
+    }
+    return std::nullopt;
+}
+
+std::optional<std::string> ClusterClient::rpop(const std::string& key) {
+    Reply reply = command({"RPOP", key});
+    if (reply.type == Reply::Type::BULK) {
+        return reply.str;
+    }
+    return std::nullopt;
+}
+
+std::vector<std::string> ClusterClient::lrange(const std::string& key, int start, int stop) {
+    Reply reply = command({"LRANGE", key, std::to_string(start), std::to_string(stop)});
+    if (reply.type == Reply::Type::BULK) {
+        return {reply.str};  // single-element lists come back as a bulk string
+    }
+    return reply.elements;
+}
+
+int ClusterClient::llen(const std::string& key) {
+    Reply reply = command({"LLEN", key});
+    return reply.type == Reply::Type::BULK ? std::atoi(reply.str.c_str()) : 0;
+}
+
+bool ClusterClient::sadd(const std::string& key, const std::string& member) {
+    Reply reply = command({"SADD", key, member});
+    return reply.type == Reply::Type::BULK && reply.str == "1";
+}
+
+bool ClusterClient::srem(const std::string& key, const std::string& member) {
+    Reply reply = command({"SREM", key, member});
+    return reply.type == Reply::Type::BULK && reply.str == "1";
+}
+
+bool ClusterClient::sismember(const std::string& key, const std::string& member) {
+    Reply reply = command({"SISMEMBER", key, member});
+    return reply.type == Reply::Type::BULK && reply.str == "1";
+}
+
+std::vector<std::string> ClusterClient::smembers(const std::string& key) {
+    Reply reply = command({"SMEMBERS", key});
+    if (reply.type == Reply::Type::BULK) {
+        return {reply.str};
+    }
+    return reply.elements;
+}
+
+int ClusterClient::scard(const std::string& key) {
+    Reply reply = command({"SCARD", key});
+    return reply.type == Reply::Type::BULK ? std::atoi(reply.str.c_str()) : 0;
+}
+
+} // namespace distkv
@@ -0,0 +1,123 @@
+#ifndef DISTKV_CLUSTER_CLIENT_H
+#define DISTKV_CLUSTER_CLIENT_H
+
+#include <string>
+#include <vector>
+#include <map>
+#include <memory>
+#include <optional>
+#include <utility>
+#include <cstddef>
+
+namespace distkv {
+
+// Client for a cluster of DistKV nodes (see CLUSTER in the README).
+//
+// The slot map is loaded from CLUSTER NODES of any reachable node and
+// cached; every command goes straight to the node owning its key's slot.
+// MOVED replies update the cached map (and trigger a reload before the
+// next command), ASK replies are followed once with ASKING, and TRYAGAIN
+// during a slot migration is retried after a short pause.
+//
+// Batches are split by node and each node's share is sent as one pipeline
+// on its own connection, all nodes in parallel.
+//
+// Like Client, a ClusterClient is not thread-safe.
+class ClusterClient {
+public:
+    // Reply to a generic command
+    struct Reply {
+        enum class Type { STATUS, ERROR, BULK, NIL, ARRAY };
+        Type type = Type::ERROR;
+        std::string str;                   // status, error or bulk text
+        std::vector<std::string> elements; // ARRAY
+
+        bool ok() const { return type != Type::ERROR; }
+    };
+
+    ClusterClient();
+    ~ClusterClient();
+
+    // Add a seed node and load the slot map from it
+    bool connect(const std::string& host, int port);
+    void disconnect();
+    bool is_connected() const { return !nodes_.empty(); }
+
+    // Reload the slot map from the first node that answers
+    bool refresh_slots();
+
+    // Run any command; commands with a key are routed by their first
+    // argument, others go to the first seed
+    Reply command(const std::vector<std::string>& args);
+
+    // Run many commands; results are in the same order as the commands
+    std::vector<Reply> execute(const std::vector<std::vector<std::string>>& commands);
+
+    // Multi-key helpers built on execute()
+    std::vector<std::optional<std::string>> mget(const std::vector<std::string>& keys);
+    bool mset(const std::vector<std::pair<std::string, std::string>>& pairs);
+    size_t del(const std::vector<std::string>& keys);
+
+    // Single-key commands
+    bool set(const std::string& key, const std::string& value);
+    std::optional<std::string> get(const std::string& key);
+    bool del(const std::string& key);
+    bool exists(const std::string& key);
+    bool expire(const std::string& key, int seconds);
+    int ttl(const std::string& key);
+    int lpush(const std::string& key, const std::string& value);
+    int rpush(const std::string& key, const std::string& value);
+    std::optional<std::string> lpop(const std::string& key);
+    std::optional<std::string> rpop(const std::string& key);
+    std::vector<std::string> lrange(const std::string& key, int start, int stop);
+    int llen(const std::string& key);
+    bool sadd(const std::string& key, const std::string& member);
+    bool srem(const std::string& key, const std::string& member);
+    bool sismember(const std::string& key, const std::string& member);
+    std::vector<std::string> smembers(const std::string& key);
+    int scard(const std::string& key);
+
+    // Redirects followed so far (for monitoring)
+    size_t moved_redirects() const { return moved_; }
+    size_t ask_redirects() const { return asks_; }
+
+    std::string get_error() const { return last_error_; }
+
+private:
+    class Connection;
+
+    struct Node {
+        std::string host;
+        int port;
+        std::unique_ptr<Connection> conn;
+    };
+
+    std::vector<std::pair<std::string, int>> seeds_;
+    std::vector<Node> nodes_;
+    std::map<std::string, size_t> node_index_;  // "host:port" -> nodes_ index
+    std::vector<int> slot_node_;                // slot -> nodes_ index, -1 = unknown
+    bool map_stale_;
+    size_t moved_;
+    size_t asks_;
+    std::string last_error_;
+
+    // Node for "host:port", added on first use
+    size_t node_for(const std::string& host, int port);
+
+    // Node serving a command (by its key's slot)
+    size_t route(const std::vector<std::string>& args);
+
+    // Run one command, following redirects
+    Reply run(const std::vector<std::string>& args);
+
+    // Send commands to one node as a pipeline and read all replies
+    bool run_pipeline(Node& node, const std::vector<std::string>& lines,
+                      std::vector<Reply>& replies);
+
+    // Build a protocol line from arguments
+    static std::string join(const std::vector<std::string>& args);
+};
+
+} // namespace distkv
+
+#endif // DISTKV_CLUSTER_CLIENT_H
@@ -0,0 +1,158 @@
+#include "connection_pool.h"
+#include <algorithm>
+
+namespace distkv {
+
+ConnectionPool::Lease::Lease(Lease&& other) noexcept : pool_(other.pool_), slot_(other.slot_) {
+    other.pool_ = nullptr;
+    other.slot_ = nullptr;
+}
+
+ConnectionPool::Lease& ConnectionPool::Lease::operator=(Lease&& other) noexcept {
+    if (this != &other) {
+        release();
+        pool_ = other.pool_;
+        slot_ = other.slot_;
+        other.pool_ = nullptr;
+        other.slot_ = nullptr;
+    }
+    return *this;
+}
+
+Client* ConnectionPool::Lease::operator->() const {
+    return &slot_->client;
+}
+
+Client& ConnectionPool::Lease::operator*() const {
+    return slot_->client;
+}
+
+void ConnectionPool::Lease::release() {
+    if (pool_ && slot_) {
+        pool_->release(slot_);
+    }
+    pool_ = nullptr;
+    slot_ = nullptr;
+}
+
+ConnectionPool::ConnectionPool(const std::string& host, int port, const PoolConfig& config)
+    : host_(host), port_(port), config_(config) {
+    config_.max_connections = std::max<size_t>(config_.max_connections, 1);
+}
+
+ConnectionPool::~ConnectionPool() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    slots_.clear();
+}
+
+ConnectionPool::Lease ConnectionPool::acquire() {
+    std::thread::id self = std::this_thread::get_id();
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(config_.acquire_timeout_ms);
+    Slot* slot = nullptr;
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        while (!(slot = pick_idle(self)) && slots_.size() >= config_.max_connections) {
+            if (released_.wait_until(lock, deadline) == std::cv_status::timeout) {
+                slot = pick_idle(self);
+                if (!slot && slots_.size() >= config_.max_connections) {
+                    last_error_ = "Timed out waiting for a connection";
+                    return Lease();
+                }
+                break;
+            }
+        }
+        if (!slot) {
+            // Below the limit: open a new connection (outside the lock)
+            slots_.push_back(std::make_unique<Slot>());
+            slot = slots_.back().get();
+        }
+        slot->leased = true;
+        slot->last_owner = self;
+    }
+
+    if (!prepare(*slot)) {
+        release(slot);
+        return Lease();
+    }
+    return Lease(this, slot);
+}
+
+ConnectionPool::Slot* ConnectionPool::pick_idle(std::thread::id self) {
+    Slot* any = nullptr;
+    for (auto& slot : slots_) {
+        if (slot->leased) {
+            continue;
+        }
+        if (slot->last_owner == self) {
+            return slot.get();
+        }
+        // Otherwise the least recently used, leaving recently used
+        // connections to the threads that are likely to come back for them
+        if (!any || slot->last_used < any->last_used) {
+            any = slot.get();
+        }
+    }
+    return any;
+}
+
+bool ConnectionPool::prepare(Slot& slot) {
+    if (slot.client.is_connected()) {
+        if (config_.health_check_idle_ms < 0 ||
+            std::chrono::steady_clock::now() - slot.last_used < std::chrono::milliseconds(config_.health_check_idle_ms)) {
+            return true;
+        }
+        // The server may have closed it while idle
+        if (slot.client.ping()) {
+            return true;
+        }
+        slot.client.disconnect();
+    }
+    if (slot.client.connect(host_, port_)) {
+        return true;
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    last_error_ = slot.client.get_error();
+    return false;
+}
+
+void ConnectionPool::release(Slot* slot) {
+    // A connection that failed while leased is dropped, so its place is
+    // taken by a fresh one on demand
+    bool usable = slot->client.is_connected();
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        slot->leased = false;
+        slot->last_used = std::chrono::steady_clock::now();
+        if (!usable) {
+            slots_.erase(std::find_if(slots_.begin(), slots_.end(),
+                                      [slot](const std::unique_ptr<Slot>& s) { return s.get() == slot; }));
+        }
+    }
+    released_.notify_one();
+}
+
+void ConnectionPool::close_idle() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    slots_.erase(std::remove_if(slots_.begin(), slots_.end(),
+                                [](const std::unique_ptr<Slot>& slot) { return !slot->leased; }),
+                 slots_.end());
+    released_.notify_all();
+}
+
+size_t ConnectionPool::size() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return slots_.size();
+}
+
+size_t ConnectionPool::idle() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return static_cast<size_t>(std::count_if(slots_.begin(), slots_.end(),
+                                             [](const std::unique_ptr<Slot>& slot) { return !slot->leased; }));
+}
+
+std::string ConnectionPool::get_error() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return last_error_;
+}
+
+} // namespace distkv
@@ -0,0 +1,115 @@
+#ifndef DISTKV_CONNECTION_POOL_H
+#define DISTKV_CONNECTION_POOL_H
+
+#include "client.h"
+#include <string>
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <chrono>
+#include <cstddef>
+
+namespace distkv {
+
+struct PoolConfig {
+    size_t max_connections = 8;
+    int acquire_timeout_ms = 1000;      // wait for a free connection; 0 = fail at once
+    int health_check_idle_ms = 5000;    // PING connections idle this long before reuse; -1 = never
+};
+
+// A bounded set of Client connections to one server, shared by many
+// threads.
+//
+// acquire() lends a connection for as long as the returned Lease lives.
+// Connections are opened lazily, only when no idle one is available and
+// the pool is below max_connections. Beyond that, callers wait for a
+// release. A thread is given back the connection it used last when that
+// one is idle, so a steady set of threads keeps its own warm sockets.
+//
+// Connections that were idle longer than health_check_idle_ms are pinged
+// before being lent out and reopened if the ping fails. A connection that
+// is disconnected when returned is closed and reopened on next use.
+//
+// The pool must outlive its leases.
+class ConnectionPool {
+    struct Slot;
+
+public:
+    // A borrowed connection, returned to the pool on destruction
+    class Lease {
+    public:
+        Lease() = default;
+        ~Lease() { release(); }
+        Lease(Lease&& other) noexcept;
+        Lease& operator=(Lease&& other) noexcept;
+        Lease(const Lease&) = delete;
+        Lease& operator=(const Lease&) = delete;
+
+        // False if acquire() failed (see ConnectionPool::get_error())
+        explicit operator bool() const { return slot_ != nullptr; }
+        Client* operator->() const;
+        Client& operator*() const;
+
+        // Return the connection early
+        void release();
+
+    private:
+        friend class ConnectionPool;
+
+        Lease(ConnectionPool* pool, Slot* slot) : pool_(pool), slot_(slot) {}
+
+        ConnectionPool* pool_ = nullptr;
+        Slot* slot_ = nullptr;
+    };
+
+    ConnectionPool(const std::string& host, int port, const PoolConfig& config = PoolConfig());
+    ~ConnectionPool();
+
+    ConnectionPool(const ConnectionPool&) = delete;
+    ConnectionPool& operator=(const ConnectionPool&) = delete;
+
+    // Borrow a connected client; an empty lease on timeout or when the
+    // server cannot be reached
+    Lease acquire();
+
+    // Close idle connections (leased ones are closed when returned)
+    void close_idle();
+
+    size_t size() const;        // connections open or being opened
+    size_t idle() const;        // open and not leased
+    size_t max_size() const { return config_.max_connections; }
+
+    std::string get_error() const;
+
+private:
+    struct Slot {
+        Client client;
+        bool leased = false;
+        std::thread::id last_owner;
+        std::chrono::steady_clock::time_point last_used;
+    };
+
+    std::string host_;
+    int port_;
+    PoolConfig config_;
+
+    mutable std::mutex mutex_;          // slots_, last_error_
+    std::condition_variable released_;
+    std::vector<std::unique_ptr<Slot>> slots_;
+    std::string last_error_;
+
+    // With mutex_ held: the idle slot to lend, preferring this thread's
+    // previous connection; nullptr if all are leased
+    Slot* pick_idle(std::thread::id self);
+
+    // Without mutex_ held: make a leased slot's connection usable
+    bool prepare(Slot& slot);
+
+    void release(Slot* slot);
+};
+
+} // namespace distkv
+
+#endif // DISTKV_CONNECTION_POOL_H
@@ -0,0 +1,162 @@
+#include "replicated_client.h"
+
+namespace distkv {
+
+ReplicatedClient::ReplicatedClient()
+    : next_replica_(0),
+      max_lag_ms_(-1),
+      max_lag_offset_(-1),
+      replica_reads_(0),
+      primary_reads_(0) {}
+
+bool ReplicatedClient::connect(const std::string& host, int port) {
+    return primary_.connect(host, port);
+}
+
+void ReplicatedClient::add_replica(const std::string& host, int port) {
+    replicas_.push_back(Replica{host, port, std::make_unique<Client>()});
+}
+
+void ReplicatedClient::disconnect() {
+    primary_.disconnect();
+    for (auto& replica : replicas_) {
+        replica.client->disconnect();
+    }
+}
+
+void ReplicatedClient::set_max_staleness_ms(int max_lag_ms) {
+    max_lag_ms_ = max_lag_ms;
+    // Reconnect so the new bound is applied to every replica connection
+    for (auto& replica : replicas_) {
+        replica.client->disconnect();
+    }
+}
+
+void ReplicatedClient::set_max_staleness_offset(long long max_lag_offset) {
+    max_lag_offset_ = max_lag_offset;
+    for (auto& replica : replicas_) {
+        replica.client->disconnect();
+    }
+}
+
+bool ReplicatedClient::ensure_connected(Replica& replica) {
+    if (replica.client->is_connected()) {
+        return true;
+    }
+    if (!replica.client->connect(replica.host, replica.port)) {
+        return false;
+    }
+    if ((max_lag_ms_ >= 0 && !replica.client->set_max_staleness_ms(max_lag_ms_)) ||
+        (max_lag_offset_ >= 0 && !replica.client->set_max_staleness_offset(max_lag_offset_))) {
+        // Never read unbounded from a replica that did not take the bound
+        replica.client->disconnect();
+        return false;
+    }
+    return true;
+}
+
+template <typename Fn>
+auto ReplicatedClient::route_read(Fn fn) -> decltype(fn(primary_)) {
+    for (size_t attempt = 0; attempt < replicas_.size(); ++attempt) {
+        Replica& replica = replicas_[next_replica_];
+        next_replica_ = (next_replica_ + 1) % replicas_.size();
+
+        if (!ensure_connected(replica)) {
+            continue;
+        }
+
+        auto result = fn(*replica.client);
+        // A dropped connection or a STALE reply means this replica can't
+        // serve the read within the bound; anything else is the answer
+        if (replica.client->is_connected() &&
+            replica.client->get_error().rfind("ERR STALE", 0) != 0) {
+            ++replica_reads_;
+            return result;
+        }
+    }
+
+    ++primary_reads_;
+    return fn(primary_);
+}
+
+// ============= Writes =============
+
+bool ReplicatedClient::set(const std::string& key, const std::string& value) {
+    return primary_.set(key, value);
+}
+
+bool ReplicatedClient::del(const std::string& key) {
+    return primary_.del(key);
+}
+
+bool ReplicatedClient::expire(const std::string& key, int seconds) {
+    return primary_.expire(key, seconds);
+}
+
+int ReplicatedClient::lpush(const std::string& key, const std::string& value) {
+    return primary_.lpush(key, value);
+}
+
+int ReplicatedClient::rpush(const std::string& key, const std::string& value) {
+    return primary_.rpush(key, value);
+}
+
+std::optional<std::string> ReplicatedClient::lpop(const std::string& key) {
+    return primary_.lpop(key);
+}
+
+std::optional<std::string> ReplicatedClient::rpop(const std::string& key) {
+    return primary_.rpop(key);
+}
+
+bool ReplicatedClient::sadd(const std::string& key, const std::string& member) {
+    return primary_.sadd(key, member);
+}
+
+bool ReplicatedClient::srem(const std::string& key, const std::string& member) {
+    return primary_.srem(key, member);
+}
+
+// ============= Reads =============
+
+std::optional<std::string> ReplicatedClient::get(const std::string& key) {
+    return route_read([&](Client& c) { return c.get(key); });
+}
+
+bool ReplicatedClient::exists(const std::string& key) {
+    return route_read([&](Client& c) { return c.exists(key); });
+}
+
+int ReplicatedClient::ttl(const std::string& key) {
+    return route_read([&](Client& c) { return c.ttl(key); });
+}
+
+std::vector<std::string> ReplicatedClient::keys() {
+    return route_read([&](Client& c) { return c.keys(); });
+}
+
+size_t ReplicatedClient::dbsize() {
+    return route_read([&](Client& c) { return c.dbsize(); });
+}
+
+std::vector<std::string> ReplicatedClient::lrange(const std::string& key, int start, int stop) {
+    return route_read([&](Client& c) { return c.lrange(key, start, stop); });
+}
+
+int ReplicatedClient::llen(const std::string& key) {
+    return route_read([&](Client& c) { return c.llen(key); });
+}
+
+bool ReplicatedClient::sismember(const std::string& key, const std::string& member) {
+    return route_read([&](Client& c) { return c.sismember(key, member); });
+}
+
+std::vector<std::string> ReplicatedClient::smembers(const std::string& key) {
+    return route_read([&](Client& c) { return c.smembers(key); });
+}
+
+int ReplicatedClient::scard(const std::string& key) {
+    return route_read([&](Client& c) { return c.scard(key); });
+}
+
+} // namespace distkv
@@ -0,0 +1,91 @@
+#ifndef DISTKV_REPLICATED_CLIENT_H
+#define DISTKV_REPLICATED_CLIENT_H
+
+#include "client.h"
+#include <string>
+#include <vector>
+#include <optional>
+#include <memory>
+#include <cstddef>
+
+namespace distkv {
+
+// Client for a primary with read replicas.
+//
+// Writes always go to the primary. Reads are spread round-robin over the
+// replicas, each connection carrying the configured staleness bound; a
+// replica that is further behind than the bound answers "STALE" and the
+// read moves on to the next replica, and finally to the primary.
+class ReplicatedClient {
+public:
+    ReplicatedClient();
+
+    // Connect to the primary
+    bool connect(const std::string& host, int port);
+
+    // Add a replica to route reads to (connected lazily)
+    void add_replica(const std::string& host, int port);
+
+    void disconnect();
+    bool is_connected() const { return primary_.is_connected(); }
+
+    // Bounds for replica reads; -1 = unbounded. With no bound at all reads
+    // may be arbitrarily stale.
+    void set_max_staleness_ms(int max_lag_ms);
+    void set_max_staleness_offset(long long max_lag_offset);
+
+    // Writes (primary)
+    bool set(const std::string& key, const std::string& value);
+    bool del(const std::string& key);
+    bool expire(const std::string& key, int seconds);
+    int lpush(const std::string& key, const std::string& value);
+    int rpush(const std::string& key, const std::string& value);
+    std::optional<std::string> lpop(const std::string& key);
+    std::optional<std::string> rpop(const std::string& key);
+    bool sadd(const std::string& key, const std::string& member);
+    bool srem(const std::string& key, const std::string& member);
+
+    // Reads (replicas within the bound, else primary)
+    std::optional<std::string> get(const std::string& key);
+    bool exists(const std::string& key);
+    int ttl(const std::string& key);
+    std::vector<std::string> keys();
+    size_t dbsize();
+    std::vector<std::string> lrange(const std::string& key, int start, int stop);
+    int llen(const std::string& key);
+    bool sismember(const std::string& key, const std::string& member);
+    std::vector<std::string> smembers(const std::string& key);
+    int scard(const std::string& key);
+
+    // Where reads were served (for monitoring)
+    size_t replica_reads() const { return replica_reads_; }
+    size_t primary_reads() const { return primary_reads_; }
+
+    std::string get_error() const { return primary_.get_error(); }
+
+private:
+    struct Replica {
+        std::string host;
+        int port;
+        std::unique_ptr<Client> client;
+    };
+
+    Client primary_;
+    std::vector<Replica> replicas_;
+    size_t next_replica_;
+    int max_lag_ms_;
+    long long max_lag_offset_;
+    size_t replica_reads_;
+    size_t primary_reads_;
+
+    // Connect (or reconnect) a replica and apply the staleness bounds
+    bool ensure_connected(Replica& replica);
+
+    // Run a read on the first replica that accepts it, else on the primary
+    template <typename Fn>
+    auto route_read(Fn fn) -> decltype(fn(primary_));
+};
+
+} // namespace distkv
+
+#endif // DISTKV_REPLICATED_CLIENT_H
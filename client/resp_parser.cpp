@@ -0,0 +1,182 @@
+#include "resp_parser.h"
+#include <algorithm>
+#include <cstring>
+#include <cstdlib>
+
+namespace distkv {
+
+namespace {
+
+// Largest bulk string accepted, so a corrupt length cannot exhaust memory
+constexpr long long MAX_BULK_LEN = 512LL * 1024 * 1024;
+
+// Elements reserved up front for an array; larger arrays grow as they fill
+constexpr long long MAX_ARRAY_RESERVE = 1024;
+
+// Parse a whole signed decimal number
+bool parse_number(const char* text, size_t len, long long& value) {
+    if (len == 0) {
+        return false;
+    }
+    bool negative = text[0] == '-';
+    size_t i = negative ? 1 : 0;
+    if (i == len) {
+        return false;
+    }
+    long long n = 0;
+    for (; i < len; ++i) {
+        if (text[i] < '0' || text[i] > '9') {
+            return false;
+        }
+        n = n * 10 + (text[i] - '0');
+    }
+    value = negative ? -n : n;
+    return true;
+}
+
+} // namespace
+
+std::optional<std::string> RespReply::value() const {
+    if (type == Type::BULK || type == Type::STATUS) {
+        return str;
+    }
+    return std::nullopt;
+}
+
+long long RespReply::integer(long long fallback) const {
+    long long n;
+    if (type == Type::INTEGER) {
+        return number;
+    }
+    if (type == Type::BULK && parse_number(str.data(), str.size(), n)) {
+        return n;
+    }
+    return fallback;
+}
+
+std::vector<std::string> RespReply::list() const {
+    std::vector<std::string> items;
+    if (type == Type::ARRAY) {
+        items.reserve(elements.size());
+        for (const auto& element : elements) {
+            if (element.type == Type::INTEGER) {
+                items.push_back(std::to_string(element.number));
+            } else {
+                items.push_back(element.str);
+            }
+        }
+    } else if (type == Type::BULK) {
+        items.push_back(str);
+    }
+    return items;
+}
+
+RespParser::Status RespParser::parse(const char* data, size_t len, size_t& pos, RespReply& out) {
+    while (true) {
+        RespReply value;
+
+        if (bulk_len_ >= 0) {
+            // Body and its CRLF must be complete
+            size_t need = static_cast<size_t>(bulk_len_) + 2;
+            if (len - pos < need) {
+                return Status::NEED_MORE;
+            }
+            value.type = RespReply::Type::BULK;
+            value.str.assign(data + pos, static_cast<size_t>(bulk_len_));
+            pos += need;
+            bulk_len_ = -1;
+        } else {
+            const char* start = data + pos + scanned_;
+            const void* newline = std::memchr(start, '\n', len - pos - scanned_);
+            if (!newline) {
+                scanned_ = len - pos;
+                return Status::NEED_MORE;
+            }
+            scanned_ = 0;
+
+            size_t end = static_cast<size_t>(static_cast<const char*>(newline) - data);
+            size_t line_end = (end > pos && data[end - 1] == '\r') ? end - 1 : end;
+            if (line_end == pos) {
+                return Status::ERROR;
+            }
+            char kind = data[pos];
+            const char* body = data + pos + 1;
+            size_t body_len = line_end - pos - 1;
+            pos = end + 1;
+
+            long long n = 0;
+            switch (kind) {
+                case '+':
+                    value.type = RespReply::Type::STATUS;
+                    value.str.assign(body, body_len);
+                    break;
+                case '-':
+                    value.type = RespReply::Type::ERROR;
+                    value.str.assign(body, body_len);
+                    break;
+                case ':':
+                    if (!parse_number(body, body_len, n)) {
+                        return Status::ERROR;
+                    }
+                    value.type = RespReply::Type::INTEGER;
+                    value.number = n;
+                    break;
+                case '$':
+                    if (!parse_number(body, body_len, n) || n > MAX_BULK_LEN) {
+                        return Status::ERROR;
+                    }
+                    if (n >= 0) {
+                        bulk_len_ = n;
+                        continue;
+                    }
+                    value.type = RespReply::Type::NIL;
+                    break;
+                case '*':
+                case '>':
+                    if (!parse_number(body, body_len, n)) {
+                        return Status::ERROR;
+                    }
+                    if (n > 0) {
+                        Frame frame;
+                        frame.array.type = kind == '>' ? RespReply::Type::PUSH : RespReply::Type::ARRAY;
+                        frame.array.elements.reserve(static_cast<size_t>(std::min(n, MAX_ARRAY_RESERVE)));
+                        frame.remaining = n;
+                        stack_.push_back(std::move(frame));
+                        continue;
+                    }
+                    if (n == 0) {
+                        value.type = kind == '>' ? RespReply::Type::PUSH : RespReply::Type::ARRAY;
+                    } else {
+                        value.type = RespReply::Type::NIL;
+                    }
+                    break;
+                default:
+                    return Status::ERROR;
+            }
+        }
+
+        // Attach the value to the innermost open array, closing arrays
+        // that are now complete
+        while (true) {
+            if (stack_.empty()) {
+                out = std::move(value);
+                return Status::DONE;
+            }
+            Frame& top = stack_.back();
+            top.array.elements.push_back(std::move(value));
+            if (--top.remaining > 0) {
+                break;
+            }
+            value = std::move(top.array);
+            stack_.pop_back();
+        }
+    }
+}
+
+void RespParser::reset() {
+    stack_.clear();
+    bulk_len_ = -1;
+    scanned_ = 0;
+}
+
+} // namespace distkv
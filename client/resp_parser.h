@@ -0,0 +1,71 @@
+#ifndef DISTKV_RESP_PARSER_H
+#define DISTKV_RESP_PARSER_H
+
+#include <string>
+#include <vector>
+#include <optional>
+#include <cstddef>
+
+namespace distkv {
+
+// One decoded RESP reply; arrays hold nested replies
+struct RespReply {
+    // PUSH is an out-of-band message, not the reply to a command
+    // (invalidations for client-side caching)
+    enum class Type { STATUS, ERROR, INTEGER, BULK, NIL, ARRAY, PUSH };
+    Type type = Type::ERROR;
+    std::string str;                  // status, error or bulk text
+    long long number = 0;             // INTEGER
+    std::vector<RespReply> elements;  // ARRAY, PUSH
+
+    bool ok() const { return type != Type::ERROR; }
+    bool is_nil() const { return type == Type::NIL; }
+
+    // Bulk or status text; nullopt for nil, errors and arrays (GET, LPOP, ...)
+    std::optional<std::string> value() const;
+    // Integer replies, or bulk text holding a number (TTL, LPUSH, LLEN,
+    // SCARD, DBSIZE); fallback otherwise
+    long long integer(long long fallback = 0) const;
+    // 1/0 replies (DEL, EXISTS, EXPIRE, SADD, SREM, SISMEMBER)
+    bool boolean() const { return integer(0) != 0; }
+    // Multi-element replies (KEYS, LRANGE, SMEMBERS) as strings, whichever
+    // way the server encoded them: an array, one bulk string, or +OK for
+    // no elements
+    std::vector<std::string> list() const;
+};
+
+// Incremental RESP decoder. parse() consumes what it can of a buffer and
+// keeps its place across calls, so a reply split over many reads is
+// decoded in one pass: partial lines are not searched again, bulk bodies
+// are copied once into their reply, and open arrays stay on a stack until
+// their last element arrives.
+class RespParser {
+public:
+    enum class Status { DONE, NEED_MORE, ERROR };
+
+    // Decode from data[pos, len). Consumed bytes advance pos (the caller
+    // keeps the rest for the next call). DONE moves one complete reply
+    // into out; NEED_MORE wants more bytes appended; ERROR means the
+    // stream is not valid RESP.
+    Status parse(const char* data, size_t len, size_t& pos, RespReply& out);
+
+    // Drop any partly decoded reply (e.g. after reconnecting)
+    void reset();
+
+    // True at a reply boundary, with nothing partly decoded
+    bool idle() const { return stack_.empty() && bulk_len_ < 0 && scanned_ == 0; }
+
+private:
+    struct Frame {
+        RespReply array;
+        long long remaining;
+    };
+
+    std::vector<Frame> stack_;   // arrays being filled, outermost first
+    long long bulk_len_ = -1;    // >= 0 while waiting for a bulk body
+    size_t scanned_ = 0;         // bytes after pos already searched for '\n'
+};
+
+} // namespace distkv
+
+#endif // DISTKV_RESP_PARSER_H
@@ -0,0 +1,318 @@
+#include "sharded_client.h"
+#include <algorithm>
+#include <map>
+#include <thread>
+
+namespace distkv {
+
+namespace {
+
+// 64-bit FNV-1a, finished with the splitmix64 mixer so that labels that
+// differ only in their last characters ("host:port-1", "host:port-2")
+// still land far apart on the ring
+uint64_t ring_hash(const std::string& data) {
+    uint64_t hash = 14695981039346656037ULL;
+    for (unsigned char c : data) {
+        hash ^= c;
+        hash *= 1099511628211ULL;
+    }
+    hash ^= hash >> 30;
+    hash *= 0xbf58476d1ce4e5b9ULL;
+    hash ^= hash >> 27;
+    hash *= 0x94d049bb133111ebULL;
+    hash ^= hash >> 31;
+    return hash;
+}
+
+} // namespace
+
+ShardedClient::ShardedClient() {}
+
+ShardedClient::~ShardedClient() {
+    disconnect();
+}
+
+bool ShardedClient::add_server(const std::string& host, int port, unsigned weight) {
+    std::string address = host + ":" + std::to_string(port);
+    if (weight == 0) {
+        last_error_ = "weight must be positive";
+        return false;
+    }
+    for (const auto& server : servers_) {
+        if (server.address() == address) {
+            last_error_ = "server " + address + " already added";
+            return false;
+        }
+    }
+    servers_.push_back(Server{host, port, weight, std::make_unique<Client>()});
+    rebuild_ring();
+    return true;
+}
+
+bool ShardedClient::remove_server(const std::string& host, int port) {
+    std::string address = host + ":" + std::to_string(port);
+    auto it = std::find_if(servers_.begin(), servers_.end(),
+                           [&address](const Server& server) { return server.address() == address; });
+    if (it == servers_.end()) {
+        return false;
+    }
+    servers_.erase(it);
+    rebuild_ring();
+    return true;
+}
+
+void ShardedClient::rebuild_ring() {
+    // Points depend only on a server's own address and weight, never on
+    // the other servers, so changing the set leaves existing points put
+    ring_.clear();
+    for (size_t i = 0; i < servers_.size(); ++i) {
+        std::string address = servers_[i].address();
+        unsigned points = POINTS_PER_WEIGHT * servers_[i].weight;
+        for (unsigned point = 0; point < points; ++point) {
+            ring_.emplace_back(ring_hash(address + "-" + std::to_string(point)), i);
+        }
+    }
+    std::sort(ring_.begin(), ring_.end());
+}
+
+size_t ShardedClient::locate(const std::string& key) const {
+    uint64_t hash = ring_hash(key);
+    auto it = std::lower_bound(ring_.begin(), ring_.end(), std::make_pair(hash, size_t(0)));
+    if (it == ring_.end()) {
+        it = ring_.begin();  // wrap around
+    }
+    return it->second;
+}
+
+std::string ShardedClient::server_for(const std::string& key) const {
+    if (ring_.empty()) {
+        return "";
+    }
+    return servers_[locate(key)].address();
+}
+
+void ShardedClient::disconnect() {
+    for (auto& server : servers_) {
+        server.client->disconnect();
+    }
+}
+
+bool ShardedClient::ensure_connected(Server& server, std::string& error) {
+    if (server.client->is_connected() || server.client->connect(server.host, server.port)) {
+        return true;
+    }
+    error = "connection to " + server.address() + " failed";
+    return false;
+}
+
+ShardedClient::Reply ShardedClient::error_reply(const std::string& message) {
+    Reply reply;
+    reply.type = Reply::Type::ERROR;
+    reply.str = message;
+    return reply;
+}
+
+std::vector<ShardedClient::Reply> ShardedClient::run_pipeline(
+    Server& server, const std::vector<std::vector<std::string>>& commands,
+    const std::vector<size_t>& indices) {
+    std::string error;
+    if (!ensure_connected(server, error)) {
+        return std::vector<Reply>(indices.size(), error_reply(error));
+    }
+    auto pipeline = server.client->pipeline();
+    for (size_t i : indices) {
+        pipeline.command(commands[i]);
+    }
+    return pipeline.execute();
+}
+
+ShardedClient::Reply ShardedClient::command(const std::vector<std::string>& args) {
+    last_error_.clear();
+    if (servers_.empty()) {
+        last_error_ = "No servers";
+        return error_reply(last_error_);
+    }
+
+    Server& server = servers_[args.size() >= 2 ? locate(args[1]) : 0];
+    Reply reply = run_pipeline(server, {args}, {0}).front();
+    if (!reply.ok()) {
+        last_error_ = reply.str;
+    }
+    return reply;
+}
+
+std::vector<ShardedClient::Reply> ShardedClient::execute(
+    const std::vector<std::vector<std::string>>& commands) {
+    last_error_.clear();
+    std::vector<Reply> results(commands.size());
+    if (servers_.empty()) {
+        last_error_ = "No servers";
+        std::fill(results.begin(), results.end(), error_reply(last_error_));
+        return results;
+    }
+
+    // Group commands by server
+    std::map<size_t, std::vector<size_t>> groups;
+    for (size_t i = 0; i < commands.size(); ++i) {
+        groups[commands[i].size() >= 2 ? locate(commands[i][1]) : 0].push_back(i);
+    }
+
+    // One pipeline per server, all servers at once
+    struct Work {
+        size_t server;
+        std::vector<size_t> indices;
+        std::vector<Reply> replies;
+    };
+    std::vector<Work> work;
+    for (auto& group : groups) {
+        work.push_back(Work{group.first, std::move(group.second), {}});
+    }
+
+    std::vector<std::thread> threads;
+    for (size_t i = 1; i < work.size(); ++i) {
+        threads.emplace_back([this, &work, &commands, i]() {
+            work[i].replies = run_pipeline(servers_[work[i].server], commands, work[i].indices);
+        });
+    }
+    if (!work.empty()) {
+        work[0].replies = run_pipeline(servers_[work[0].server], commands, work[0].indices);
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+
+    for (auto& w : work) {
+        for (size_t j = 0; j < w.indices.size(); ++j) {
+            results[w.indices[j]] = std::move(w.replies[j]);
+            if (!results[w.indices[j]].ok()) {
+                last_error_ = results[w.indices[j]].str;
+            }
+        }
+    }
+    return results;
+}
+
+// ============= Multi-key helpers =============
+
+std::vector<std::optional<std::string>> ShardedClient::mget(const std::vector<std::string>& keys) {
+    std::vector<std::vector<std::string>> commands;
+    for (const auto& key : keys) {
+        commands.push_back({"GET", key});
+    }
+    std::vector<std::optional<std::string>> values;
+    for (const auto& reply : execute(commands)) {
+        values.push_back(reply.value());
+    }
+    return values;
+}
+
+bool ShardedClient::mset(const std::vector<std::pair<std::string, std::string>>& pairs) {
+    std::vector<std::vector<std::string>> commands;
+    for (const auto& pair : pairs) {
+        commands.push_back({"SET", pair.first, pair.second});
+    }
+    bool ok = true;
+    for (const auto& reply : execute(commands)) {
+        ok = ok && reply.ok();
+    }
+    return ok;
+}
+
+size_t ShardedClient::del(const std::vector<std::string>& keys) {
+    std::vector<std::vector<std::string>> commands;
+    for (const auto& key : keys) {
+        commands.push_back({"DEL", key});
+    }
+    size_t deleted = 0;
+    for (const auto& reply : execute(commands)) {
+        if (reply.boolean()) {
+            ++deleted;
+        }
+    }
+    return deleted;
+}
+
+size_t ShardedClient::dbsize() {
+    last_error_.clear();
+    size_t total = 0;
+    for (auto& server : servers_) {
+        Reply reply = run_pipeline(server, {{"DBSIZE"}}, {0}).front();
+        if (!reply.ok()) {
+            last_error_ = reply.str;
+        }
+        total += static_cast<size_t>(std::max(reply.integer(0), 0LL));
+    }
+    return total;
+}
+
+// ============= Single-key commands =============
+
+bool ShardedClient::set(const std::string& key, const std::string& value) {
+    return command({"SET", key, value}).ok();
+}
+
+std::optional<std::string> ShardedClient::get(const std::string& key) {
+    return command({"GET", key}).value();
+}
+
+bool ShardedClient::del(const std::string& key) {
+    return command({"DEL", key}).boolean();
+}
+
+bool ShardedClient::exists(const std::string& key) {
+    return command({"EXISTS", key}).boolean();
+}
+
+bool ShardedClient::expire(const std::string& key, int seconds) {
+    return command({"EXPIRE", key, std::to_string(seconds)}).boolean();
+}
+
+int ShardedClient::ttl(const std::string& key) {
+    return static_cast<int>(command({"TTL", key}).integer(-2));
+}
+
+int ShardedClient::lpush(const std::string& key, const std::string& value) {
+    return static_cast<int>(command({"LPUSH", key, value}).integer());
+}
+
+int ShardedClient::rpush(const std::string& key, const std::string& value) {
+    return static_cast<int>(command({"RPUSH", key, value}).integer());
+}
+
+std::optional<std::string> ShardedClient::lpop(const std::string& key) {
+    return command({"LPOP", key}).value();
+}
+
+std::optional<std::string> ShardedClient::rpop(const std::string& key) {
+    return command({"RPOP", key}).value();
+}
+
+std::vector<std::string> ShardedClient::lrange(const std::string& key, int start, int stop) {
+    return command({"LRANGE", key, std::to_string(start), std::to_string(stop)}).list();
+}
+
+int ShardedClient::llen(const std::string& key) {
+    return static_cast<int>(command({"LLEN", key}).integer());
+}
+
+bool ShardedClient::sadd(const std::string& key, const std::string& member) {
+    return command({"SADD", key, member}).boolean();
+}
+
+bool ShardedClient::srem(const std::string& key, const std::string& member) {
+    return command({"SREM", key, member}).boolean();
+}
+
+bool ShardedClient::sismember(const std::string& key, const std::string& member) {
+    return command({"SISMEMBER", key, member}).boolean();
+}
+
+std::vector<std::string> ShardedClient::smembers(const std::string& key) {
+    return command({"SMEMBERS", key}).list();
+}
+
+int ShardedClient::scard(const std::string& key) {
+    return static_cast<int>(command({"SCARD", key}).integer());
+}
+
+} // namespace distkv
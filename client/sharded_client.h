@@ -0,0 +1,119 @@
+#ifndef DISTKV_SHARDED_CLIENT_H
+#define DISTKV_SHARDED_CLIENT_H
+
+#include "client.h"
+#include <string>
+#include <vector>
+#include <memory>
+#include <optional>
+#include <utility>
+#include <cstdint>
+#include <cstddef>
+
+namespace distkv {
+
+// Client that spreads keys over independent standalone servers (no
+// cluster mode needed) with a ketama-style consistent hash ring.
+//
+// Each server is placed on a 64-bit ring at POINTS_PER_WEIGHT * weight
+// points derived from its address; a key belongs to the first point at or
+// after its own hash. Adding a server therefore only takes over the keys
+// that now fall just before its points, about weight / total weight of
+// them, and removing one only moves that server's keys.
+//
+// Batches are split by server and each server's share is sent as one
+// pipeline on its own connection, all servers in parallel. Connections
+// are opened on first use and reopened after a failure; keys of a server
+// that is down fail rather than move, so they never show stale values
+// after it comes back.
+//
+// Like Client, a ShardedClient is not thread-safe.
+class ShardedClient {
+public:
+    using Reply = Client::Reply;
+
+    static constexpr unsigned POINTS_PER_WEIGHT = 160;
+
+    ShardedClient();
+    ~ShardedClient();
+
+    // Add a server to the ring; weight scales its share of the keys.
+    // Returns false if it is already there or weight is 0.
+    bool add_server(const std::string& host, int port, unsigned weight = 1);
+    bool remove_server(const std::string& host, int port);
+    size_t server_count() const { return servers_.size(); }
+
+    // "host:port" of the server that owns key ("" without servers)
+    std::string server_for(const std::string& key) const;
+
+    void disconnect();
+
+    // Run a command routed by its first argument (the key); commands
+    // without arguments go to the first server
+    Reply command(const std::vector<std::string>& args);
+
+    // Run many keyed commands; results are in the same order as the commands
+    std::vector<Reply> execute(const std::vector<std::vector<std::string>>& commands);
+
+    // Multi-key helpers built on execute()
+    std::vector<std::optional<std::string>> mget(const std::vector<std::string>& keys);
+    bool mset(const std::vector<std::pair<std::string, std::string>>& pairs);
+    size_t del(const std::vector<std::string>& keys);
+
+    // Keys on all servers together
+    size_t dbsize();
+
+    // Single-key commands
+    bool set(const std::string& key, const std::string& value);
+    std::optional<std::string> get(const std::string& key);
+    bool del(const std::string& key);
+    bool exists(const std::string& key);
+    bool expire(const std::string& key, int seconds);
+    int ttl(const std::string& key);
+    int lpush(const std::string& key, const std::string& value);
+    int rpush(const std::string& key, const std::string& value);
+    std::optional<std::string> lpop(const std::string& key);
+    std::optional<std::string> rpop(const std::string& key);
+    std::vector<std::string> lrange(const std::string& key, int start, int stop);
+    int llen(const std::string& key);
+    bool sadd(const std::string& key, const std::string& member);
+    bool srem(const std::string& key, const std::string& member);
+    bool sismember(const std::string& key, const std::string& member);
+    std::vector<std::string> smembers(const std::string& key);
+    int scard(const std::string& key);
+
+    std::string get_error() const { return last_error_; }
+
+private:
+    struct Server {
+        std::string host;
+        int port;
+        unsigned weight;
+        std::unique_ptr<Client> client;
+
+        std::string address() const { return host + ":" + std::to_string(port); }
+    };
+
+    std::vector<Server> servers_;
+    std::vector<std::pair<uint64_t, size_t>> ring_;  // (point, servers_ index), sorted
+    std::string last_error_;
+
+    // Place every server's points on the ring
+    void rebuild_ring();
+
+    // servers_ index owning key
+    size_t locate(const std::string& key) const;
+
+    // Connect a server if needed; fills error on failure
+    bool ensure_connected(Server& server, std::string& error);
+
+    // Send commands to one server as a pipeline; replies in order
+    std::vector<Reply> run_pipeline(Server& server, const std::vector<std::vector<std::string>>& commands,
+                                    const std::vector<size_t>& indices);
+
+    static Reply error_reply(const std::string& message);
+};
+
+} // namespace distkv
+
+#endif // DISTKV_SHARDED_CLIENT_H
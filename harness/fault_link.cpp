@@ -0,0 +1,231 @@
+#include "fault_link.h"
+#include "../include/net_util.h"
+#include <iostream>
+#include <cstring>
+
+// Platform-specific includes
+#ifdef _WIN32
+    #include <winsock2.h>
+    #include <ws2tcpip.h>
+    #pragma comment(lib, "ws2_32.lib")
+    typedef int socklen_t;
+    #define CLOSE_SOCKET closesocket
+#else
+    #include <sys/socket.h>
+    #include <netinet/in.h>
+    #include <arpa/inet.h>
+    #include <unistd.h>
+    #define CLOSE_SOCKET close
+    #define INVALID_SOCKET -1
+    #define SOCKET_ERROR -1
+#endif
+
+namespace distkv {
+
+FaultLink::FaultLink(int listen_port, const std::string& target_host, int target_port)
+    : listen_port_(listen_port),
+      target_host_(target_host),
+      target_port_(target_port),
+      listen_fd_(INVALID_SOCKET),
+      running_(false),
+      latency_ms_(0),
+      partitioned_(false),
+      bytes_forwarded_(0) {}
+
+FaultLink::~FaultLink() {
+    stop();
+}
+
+bool FaultLink::start() {
+    listen_fd_ = socket(AF_INET, SOCK_STREAM, 0);
+    if (listen_fd_ == INVALID_SOCKET) {
+        return false;
+    }
+
+    int opt = 1;
+#ifdef _WIN32
+    setsockopt(listen_fd_, SOL_SOCKET, SO_REUSEADDR, (const char*)&opt, sizeof(opt));
+#else
+    setsockopt(listen_fd_, SOL_SOCKET, SO_REUSEADDR, &opt, sizeof(opt));
+#endif
+
+    struct sockaddr_in addr;
+    std::memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    addr.sin_port = htons(listen_port_);
+
+    if (bind(listen_fd_, (struct sockaddr*)&addr, sizeof(addr)) == SOCKET_ERROR ||
+        listen(listen_fd_, 64) == SOCKET_ERROR) {
+        std::cerr << "Fault link: cannot listen on port " << listen_port_ << "\n";
+        CLOSE_SOCKET(listen_fd_);
+        listen_fd_ = INVALID_SOCKET;
+        return false;
+    }
+
+    running_ = true;
+    accept_thread_ = std::thread([this]() { accept_loop(); });
+    return true;
+}
+
+void FaultLink::stop() {
+    if (!running_.exchange(false)) {
+        return;
+    }
+
+    net::shutdown_socket(listen_fd_);
+    if (accept_thread_.joinable()) {
+        accept_thread_.join();
+    }
+    net::close_socket(listen_fd_);
+    listen_fd_ = INVALID_SOCKET;
+
+    std::lock_guard<std::mutex> lock(connections_mutex_);
+    for (auto& conn : connections_) {
+        cut(*conn);
+    }
+    for (auto& conn : connections_) {
+        join(*conn);
+    }
+    connections_.clear();
+}
+
+void FaultLink::set_partitioned(bool partitioned) {
+    partitioned_ = partitioned;
+    if (partitioned) {
+        std::lock_guard<std::mutex> lock(connections_mutex_);
+        for (auto& conn : connections_) {
+            cut(*conn);
+        }
+    }
+}
+
+void FaultLink::accept_loop() {
+    while (running_) {
+        struct sockaddr_in client_addr;
+        socklen_t client_len = sizeof(client_addr);
+        int client_fd = accept(listen_fd_, (struct sockaddr*)&client_addr, &client_len);
+        if (client_fd == INVALID_SOCKET) {
+            continue;
+        }
+
+        int target_fd = partitioned_ ? -1 : net::connect_tcp(target_host_, target_port_);
+        if (target_fd < 0) {
+            CLOSE_SOCKET(client_fd);
+            continue;
+        }
+        net::set_nodelay(client_fd);
+
+        std::lock_guard<std::mutex> lock(connections_mutex_);
+        reap_locked();
+        if (!running_) {
+            CLOSE_SOCKET(client_fd);
+            CLOSE_SOCKET(target_fd);
+            break;
+        }
+        auto conn = std::make_unique<Connection>();
+        conn->client_fd = client_fd;
+        conn->target_fd = target_fd;
+        start_pipe(*conn, conn->up, client_fd, target_fd);
+        start_pipe(*conn, conn->down, target_fd, client_fd);
+        connections_.push_back(std::move(conn));
+    }
+}
+
+void FaultLink::start_pipe(Connection& conn, Pipe& pipe, int from, int to) {
+    pipe.from = from;
+    pipe.to = to;
+    pipe.reader = std::thread([this, &conn, &pipe]() { read_loop(conn, pipe); });
+    pipe.writer = std::thread([this, &conn, &pipe]() { write_loop(conn, pipe); });
+}
+
+void FaultLink::read_loop(Connection& conn, Pipe& pipe) {
+    char buffer[16384];
+    while (true) {
+#ifdef _WIN32
+        int n = recv(pipe.from, buffer, sizeof(buffer), 0);
+#else
+        ssize_t n = recv(pipe.from, buffer, sizeof(buffer), 0);
+#endif
+        if (n <= 0 || partitioned_) {
+            break;
+        }
+        auto due = std::chrono::steady_clock::now() + std::chrono::milliseconds(latency_ms_);
+        {
+            std::lock_guard<std::mutex> lock(pipe.mutex);
+            pipe.chunks.emplace_back(due, std::string(buffer, static_cast<size_t>(n)));
+        }
+        pipe.cv.notify_one();
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(pipe.mutex);
+        pipe.closed = true;
+    }
+    pipe.cv.notify_one();
+    ++conn.finished;
+}
+
+void FaultLink::write_loop(Connection& conn, Pipe& pipe) {
+    std::unique_lock<std::mutex> lock(pipe.mutex);
+    while (true) {
+        pipe.cv.wait(lock, [&pipe]() { return pipe.closed || !pipe.chunks.empty(); });
+        if (pipe.chunks.empty()) {
+            break;  // closed and drained
+        }
+
+        auto due = pipe.chunks.front().first;
+        if (std::chrono::steady_clock::now() < due) {
+            pipe.cv.wait_until(lock, due);
+            continue;
+        }
+        std::string chunk = std::move(pipe.chunks.front().second);
+        pipe.chunks.pop_front();
+
+        lock.unlock();
+        bool sent = !partitioned_ && net::send_all(pipe.to, chunk);
+        if (sent) {
+            bytes_forwarded_ += chunk.size();
+        }
+        lock.lock();
+        if (!sent) {
+            break;
+        }
+    }
+    lock.unlock();
+
+    // Either side closing ends the whole connection
+    cut(conn);
+    ++conn.finished;
+}
+
+void FaultLink::cut(Connection& conn) {
+    net::shutdown_socket(conn.client_fd);
+    net::shutdown_socket(conn.target_fd);
+}
+
+void FaultLink::join(Connection& conn) {
+    for (Pipe* pipe : {&conn.up, &conn.down}) {
+        if (pipe->reader.joinable()) {
+            pipe->reader.join();
+        }
+        if (pipe->writer.joinable()) {
+            pipe->writer.join();
+        }
+    }
+    net::close_socket(conn.client_fd);
+    net::close_socket(conn.target_fd);
+}
+
+void FaultLink::reap_locked() {
+    for (auto it = connections_.begin(); it != connections_.end();) {
+        if ((*it)->finished == 4) {
+            join(**it);
+            it = connections_.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+} // namespace distkv
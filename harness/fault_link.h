@@ -0,0 +1,93 @@
+#ifndef DISTKV_FAULT_LINK_H
+#define DISTKV_FAULT_LINK_H
+
+#include <string>
+#include <vector>
+#include <deque>
+#include <memory>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <chrono>
+#include <cstdint>
+
+namespace distkv {
+
+// TCP forwarder standing in for the network between two nodes: the source
+// node is configured to reach the target through listen_port, and the link
+// can then add latency or cut the connection.
+//
+// Latency delays every chunk by the same amount in each direction without
+// limiting throughput (chunks are queued, not forwarded one at a time). A
+// partitioned link drops its open connections and closes new ones as soon
+// as they are accepted, which the nodes see as a peer going away.
+class FaultLink {
+public:
+    FaultLink(int listen_port, const std::string& target_host, int target_port);
+    ~FaultLink();
+
+    bool start();
+    void stop();
+
+    void set_latency_ms(int ms) { latency_ms_ = ms; }
+    int latency_ms() const { return latency_ms_; }
+
+    void set_partitioned(bool partitioned);
+    bool partitioned() const { return partitioned_; }
+
+    int listen_port() const { return listen_port_; }
+    uint64_t bytes_forwarded() const { return bytes_forwarded_; }
+
+private:
+    // One direction of a forwarded connection: the reader queues chunks
+    // with their due time, the writer sends them once due
+    struct Pipe {
+        int from;
+        int to;
+        std::mutex mutex;
+        std::condition_variable cv;
+        std::deque<std::pair<std::chrono::steady_clock::time_point, std::string>> chunks;
+        bool closed = false;
+        std::thread reader;
+        std::thread writer;
+    };
+
+    struct Connection {
+        int client_fd;
+        int target_fd;
+        Pipe up;     // client -> target
+        Pipe down;   // target -> client
+        std::atomic<int> finished{0};
+    };
+
+    int listen_port_;
+    std::string target_host_;
+    int target_port_;
+    int listen_fd_;
+    std::atomic<bool> running_;
+    std::atomic<int> latency_ms_;
+    std::atomic<bool> partitioned_;
+    std::atomic<uint64_t> bytes_forwarded_;
+    std::thread accept_thread_;
+
+    std::mutex connections_mutex_;
+    std::vector<std::unique_ptr<Connection>> connections_;
+
+    void accept_loop();
+    void start_pipe(Connection& conn, Pipe& pipe, int from, int to);
+    void read_loop(Connection& conn, Pipe& pipe);
+    void write_loop(Connection& conn, Pipe& pipe);
+
+    // Shut down both sockets so all four threads of the connection exit
+    static void cut(Connection& conn);
+    static void join(Connection& conn);
+
+    // Join and free connections whose threads have all finished
+    // (connections_mutex_ held)
+    void reap_locked();
+};
+
+} // namespace distkv
+
+#endif // DISTKV_FAULT_LINK_H
@@ -0,0 +1,712 @@
+#include "harness.h"
+#include "../include/net_util.h"
+#include "../client/client.h"
+#include "../client/replicated_client.h"
+#include "../client/cluster_client.h"
+#include <iostream>
+#include <sstream>
+#include <filesystem>
+#include <algorithm>
+#include <random>
+#include <chrono>
+#include <cstring>
+#include <cstdlib>
+
+#ifndef _WIN32
+    #include <sys/socket.h>
+    #include <sys/time.h>
+    #include <sys/wait.h>
+    #include <fcntl.h>
+    #include <signal.h>
+    #include <unistd.h>
+#endif
+
+namespace distkv {
+
+namespace {
+
+// Key written to find the Raft leader and to check that replicas follow
+const char* const PROBE_KEY = "__harness_probe__";
+
+// How long start() waits for nodes to come up and the topology to form
+constexpr int STARTUP_TIMEOUT_MS = 15000;
+
+// How long a child gets to save its snapshot and exit after SIGTERM
+constexpr int CHILD_EXIT_TIMEOUT_MS = 3000;
+
+bool starts_with(const std::string& s, const char* prefix) {
+    return s.rfind(prefix, 0) == 0;
+}
+
+#ifndef _WIN32
+// SIGTERM, then SIGKILL if the child does not exit in time
+void stop_child(pid_t pid) {
+    kill(pid, SIGTERM);
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(CHILD_EXIT_TIMEOUT_MS);
+    while (std::chrono::steady_clock::now() < deadline) {
+        if (waitpid(pid, nullptr, WNOHANG) == pid) {
+            return;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    kill(pid, SIGKILL);
+    waitpid(pid, nullptr, 0);
+}
+#endif
+
+// One workload connection, routed according to the topology
+class WorkloadClient {
+public:
+    WorkloadClient(LocalCluster& cluster, size_t index) : cluster_(cluster), node_(index % cluster.size()) {
+        connect();
+    }
+
+    // One SET or GET; false if it failed
+    bool run(const std::string& key, const std::string& value, bool read) {
+        bool ok;
+        switch (cluster_.config().topology) {
+            case Topology::CLUSTER: {
+                ClusterClient::Reply reply = read ? cluster_client_.command({"GET", key})
+                                                  : cluster_client_.command({"SET", key, value});
+                ok = reply.ok();
+                break;
+            }
+            case Topology::REPLICATION:
+                ok = read ? (replicated_.get(key), replicated_.is_connected())
+                          : replicated_.set(key, value);
+                break;
+            default:
+                ok = read ? (client_.get(key), client_.is_connected()) : client_.set(key, value);
+                break;
+        }
+
+        if (!ok) {
+            recover();
+        }
+        return ok;
+    }
+
+private:
+    LocalCluster& cluster_;
+    size_t node_;
+    Client client_;
+    ReplicatedClient replicated_;
+    ClusterClient cluster_client_;
+
+    void connect() {
+        const int base = cluster_.port(0);
+        switch (cluster_.config().topology) {
+            case Topology::CLUSTER:
+                for (size_t i = 0; i < cluster_.size(); ++i) {
+                    if (cluster_client_.connect("127.0.0.1", base + static_cast<int>(i))) {
+                        break;
+                    }
+                }
+                break;
+            case Topology::REPLICATION:
+                replicated_.disconnect();
+                if (replicated_.connect("127.0.0.1", base)) {
+                    for (size_t i = 1; i < cluster_.size(); ++i) {
+                        replicated_.add_replica("127.0.0.1", base + static_cast<int>(i));
+                    }
+                }
+                break;
+            default:
+                client_.disconnect();
+                client_.connect("127.0.0.1", cluster_.port(node_));
+                break;
+        }
+    }
+
+    void recover() {
+        switch (cluster_.config().topology) {
+            case Topology::RAFT:
+                // Writes only succeed on the leader; try the next member
+                node_ = (node_ + 1) % cluster_.size();
+                connect();
+                break;
+            case Topology::CLUSTER:
+                cluster_client_.refresh_slots();
+                break;
+            default:
+                if (!client_.is_connected() || !replicated_.is_connected()) {
+                    connect();
+                }
+                break;
+        }
+        // Do not spin while the cluster is unavailable
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+};
+
+} // namespace
+
+std::string WorkloadResult::summary() const {
+    std::ostringstream oss;
+    oss.setf(std::ios::fixed);
+    oss.precision(0);
+    oss << ops << " ops, " << errors << " errors in " << seconds << "s: " << ops_per_sec
+        << " ops/s, p50 " << p50_us << "us, p99 " << p99_us << "us, max " << max_us << "us";
+    return oss.str();
+}
+
+LocalCluster::LocalCluster(const HarnessConfig& config)
+    : config_(config),
+      owns_data_dir_(false),
+      running_(false) {
+    if (config_.nodes == 0 || config_.nodes > HARNESS_MAX_NODES) {
+        config_.nodes = std::min<size_t>(std::max<size_t>(config_.nodes, 1), HARNESS_MAX_NODES);
+    }
+    nodes_.resize(config_.nodes);
+    links_.resize(config_.nodes);
+    for (auto& row : links_) {
+        row.resize(config_.nodes);
+    }
+}
+
+LocalCluster::~LocalCluster() {
+    stop();
+}
+
+int LocalCluster::link_port(size_t from, size_t to) const {
+    return config_.base_port + HARNESS_LINK_PORT_OFFSET +
+           static_cast<int>(from * HARNESS_MAX_NODES + to);
+}
+
+bool LocalCluster::start() {
+    if (running_) {
+        return true;
+    }
+
+    if (config_.data_dir.empty()) {
+#ifdef _WIN32
+        config_.data_dir = "harness-data";
+        std::filesystem::create_directories(config_.data_dir);
+#else
+        char dir_template[] = "/tmp/distkv-harness-XXXXXX";
+        if (!mkdtemp(dir_template)) {
+            std::cerr << "Harness: cannot create data directory\n";
+            return false;
+        }
+        config_.data_dir = dir_template;
+#endif
+        owns_data_dir_ = true;
+    } else {
+        std::filesystem::create_directories(config_.data_dir);
+    }
+    running_ = true;
+
+    // Links first, so nodes can reach each other as soon as they start
+    for (size_t from = 0; from < size(); ++from) {
+        for (size_t to = 0; to < size(); ++to) {
+            int target;
+            if (config_.topology == Topology::REPLICATION && from != 0 && to == 0) {
+                target = port(0);
+            } else if (config_.topology == Topology::RAFT && from != to) {
+                target = port(to) + RAFT_PORT_OFFSET;
+            } else {
+                continue;
+            }
+            links_[from][to] = std::make_unique<FaultLink>(link_port(from, to), "127.0.0.1", target);
+            if (!links_[from][to]->start()) {
+                stop();
+                return false;
+            }
+        }
+    }
+
+    for (size_t i = 0; i < size(); ++i) {
+        if (!launch(i)) {
+            std::cerr << "Harness: node " << i << " did not start\n";
+            stop();
+            return false;
+        }
+    }
+
+    if (!form_cluster()) {
+        std::cerr << "Harness: the topology did not form\n";
+        stop();
+        return false;
+    }
+    return true;
+}
+
+void LocalCluster::stop() {
+    if (!running_) {
+        return;
+    }
+    running_ = false;
+
+    for (size_t i = 0; i < size(); ++i) {
+        Node& node = nodes_[i];
+        if (node.server) {
+            node.server->stop();
+        }
+        if (node.thread.joinable()) {
+            node.thread.join();
+        }
+        node.server.reset();
+#ifndef _WIN32
+        if (node.pid > 0) {
+            if (node.paused) {
+                kill(node.pid, SIGCONT);
+            }
+            stop_child(node.pid);
+            node.pid = -1;
+        }
+#endif
+        node.up = false;
+        node.paused = false;
+    }
+
+    for (auto& row : links_) {
+        for (auto& link : row) {
+            link.reset();
+        }
+    }
+
+    if (owns_data_dir_) {
+        std::error_code ec;
+        std::filesystem::remove_all(config_.data_dir, ec);
+        config_.data_dir.clear();
+        owns_data_dir_ = false;
+    }
+}
+
+RaftConfig LocalCluster::raft_config(size_t node) const {
+    RaftConfig raft;
+    raft.node_id = static_cast<int>(node) + 1;
+    raft.port = port(node) + RAFT_PORT_OFFSET;
+    raft.data_dir = config_.data_dir + "/raft-" + std::to_string(node);
+    for (size_t peer = 0; peer < size(); ++peer) {
+        if (peer != node) {
+            raft.peers.push_back(RaftPeer{static_cast<int>(peer) + 1, "127.0.0.1", link_port(node, peer)});
+        }
+    }
+    return raft;
+}
+
+std::vector<std::string> LocalCluster::server_args(size_t node) const {
+    std::vector<std::string> args = {
+        config_.server_binary,
+        "--port", std::to_string(port(node)),
+        "--snapshot", config_.data_dir + "/dump-" + std::to_string(node) + ".rdb",
+    };
+
+    switch (config_.topology) {
+        case Topology::REPLICATION:
+            if (node != 0) {
+                args.insert(args.end(), {"--replicaof", "127.0.0.1", std::to_string(link_port(node, 0))});
+            }
+            break;
+        case Topology::RAFT: {
+            // --raft-peers takes client ports and adds RAFT_PORT_OFFSET
+            RaftConfig raft = raft_config(node);
+            std::string peers;
+            for (const auto& peer : raft.peers) {
+                if (!peers.empty()) {
+                    peers += ",";
+                }
+                peers += std::to_string(peer.id) + "@" + peer.host + ":" +
+                         std::to_string(peer.port - RAFT_PORT_OFFSET);
+            }
+            args.insert(args.end(), {"--raft-id", std::to_string(raft.node_id), "--raft-peers", peers,
+                                     "--raft-dir", raft.data_dir});
+            break;
+        }
+        case Topology::CLUSTER:
+            args.insert(args.end(), {"--cluster", "--cluster-config",
+                                     config_.data_dir + "/nodes-" + std::to_string(node) + ".conf",
+                                     "--cluster-node-timeout",
+                                     std::to_string(config_.cluster_node_timeout_ms)});
+            break;
+        case Topology::STANDALONE:
+            break;
+    }
+    return args;
+}
+
+bool LocalCluster::launch(size_t index) {
+    Node& node = nodes_[index];
+
+    if (config_.mode == LaunchMode::IN_PROCESS) {
+        node.server = std::make_unique<Server>(port(index), 4);
+        switch (config_.topology) {
+            case Topology::REPLICATION:
+                if (index != 0) {
+                    node.server->set_replica_of("127.0.0.1", link_port(index, 0));
+                }
+                break;
+            case Topology::RAFT:
+                if (!node.server->enable_raft(raft_config(index))) {
+                    return false;
+                }
+                break;
+            case Topology::CLUSTER: {
+                GossipConfig gossip;
+                gossip.node_timeout_ms = config_.cluster_node_timeout_ms;
+                std::string path = config_.data_dir + "/nodes-" + std::to_string(index) + ".conf";
+                if (!node.server->enable_cluster(path, "127.0.0.1", gossip)) {
+                    return false;
+                }
+                break;
+            }
+            case Topology::STANDALONE:
+                break;
+        }
+        Server* server = node.server.get();
+        node.thread = std::thread([server]() { server->start(); });
+    } else {
+#ifdef _WIN32
+        std::cerr << "Harness: child processes are not supported on Windows\n";
+        return false;
+#else
+        std::vector<std::string> args = server_args(index);
+        std::string log = config_.data_dir + "/node-" + std::to_string(index) + ".log";
+
+        pid_t pid = fork();
+        if (pid < 0) {
+            return false;
+        }
+        if (pid == 0) {
+            // Link and node sockets must not stay open in the child
+            for (int fd = 3; fd < 1024; ++fd) {
+                close(fd);
+            }
+            int fd = open(log.c_str(), O_WRONLY | O_CREAT | O_APPEND, 0644);
+            if (fd >= 0) {
+                dup2(fd, STDOUT_FILENO);
+                dup2(fd, STDERR_FILENO);
+                close(fd);
+            }
+            std::vector<char*> argv;
+            for (auto& arg : args) {
+                argv.push_back(&arg[0]);
+            }
+            argv.push_back(nullptr);
+            execv(argv[0], argv.data());
+            _exit(127);
+        }
+        node.pid = pid;
+#endif
+    }
+
+    node.up = true;
+    node.paused = false;
+    return wait_for([&]() { return ping(index); }, STARTUP_TIMEOUT_MS);
+}
+
+bool LocalCluster::form_cluster() {
+    switch (config_.topology) {
+        case Topology::REPLICATION: {
+            // Replicas are in sync once they see a write made on the primary
+            if (command(0, std::string("SET ") + PROBE_KEY + " 1") != "+OK\r\n") {
+                return false;
+            }
+            for (size_t i = 1; i < size(); ++i) {
+                if (!wait_for([&]() { return command(i, std::string("GET ") + PROBE_KEY) == "$1\r\n1\r\n"; },
+                              STARTUP_TIMEOUT_MS)) {
+                    return false;
+                }
+            }
+            command(0, std::string("DEL ") + PROBE_KEY);
+            return true;
+        }
+
+        case Topology::RAFT:
+            return wait_for([&]() { return leader().has_value(); }, STARTUP_TIMEOUT_MS);
+
+        case Topology::CLUSTER: {
+            for (size_t i = 0; i < size(); ++i) {
+                int first = static_cast<int>(i * CLUSTER_SLOTS / size());
+                int last = static_cast<int>((i + 1) * CLUSTER_SLOTS / size()) - 1;
+                std::string reply = command(i, "CLUSTER ADDSLOTSRANGE " + std::to_string(first) + " " +
+                                                   std::to_string(last));
+                if (reply != "+OK\r\n") {
+                    return false;
+                }
+                if (i > 0 && command(i, "CLUSTER MEET 127.0.0.1 " + std::to_string(port(0))) != "+OK\r\n") {
+                    return false;
+                }
+            }
+            std::string known = "cluster_known_nodes:" + std::to_string(size());
+            return wait_for([&]() {
+                for (size_t i = 0; i < size(); ++i) {
+                    std::string info = command(i, "CLUSTER INFO");
+                    if (info.find("cluster_state:ok") == std::string::npos ||
+                        info.find(known) == std::string::npos) {
+                        return false;
+                    }
+                }
+                return true;
+            }, STARTUP_TIMEOUT_MS);
+        }
+
+        case Topology::STANDALONE:
+            return true;
+    }
+    return true;
+}
+
+bool LocalCluster::crash(size_t index) {
+    if (index >= size() || !nodes_[index].up) {
+        return false;
+    }
+    Node& node = nodes_[index];
+
+    if (node.server) {
+        node.server->stop();
+        if (node.thread.joinable()) {
+            node.thread.join();
+        }
+        node.server.reset();
+    }
+#ifndef _WIN32
+    if (node.pid > 0) {
+        kill(node.pid, SIGKILL);
+        waitpid(node.pid, nullptr, 0);
+        node.pid = -1;
+    }
+#endif
+    node.up = false;
+    node.paused = false;
+    return true;
+}
+
+bool LocalCluster::restart(size_t index) {
+    if (index >= size()) {
+        return false;
+    }
+    if (nodes_[index].up) {
+        crash(index);
+    }
+    return launch(index);
+}
+
+bool LocalCluster::pause(size_t index) {
+#ifdef _WIN32
+    (void)index;
+    return false;
+#else
+    if (index >= size() || nodes_[index].pid <= 0 || nodes_[index].paused) {
+        return false;
+    }
+    nodes_[index].paused = kill(nodes_[index].pid, SIGSTOP) == 0;
+    return nodes_[index].paused;
+#endif
+}
+
+bool LocalCluster::resume(size_t index) {
+#ifdef _WIN32
+    (void)index;
+    return false;
+#else
+    if (index >= size() || !nodes_[index].paused) {
+        return false;
+    }
+    nodes_[index].paused = false;
+    return kill(nodes_[index].pid, SIGCONT) == 0;
+#endif
+}
+
+void LocalCluster::partition(const std::vector<size_t>& side_a, const std::vector<size_t>& side_b) {
+    for (size_t a : side_a) {
+        for (size_t b : side_b) {
+            if (a < size() && b < size()) {
+                if (links_[a][b]) links_[a][b]->set_partitioned(true);
+                if (links_[b][a]) links_[b][a]->set_partitioned(true);
+            }
+        }
+    }
+}
+
+void LocalCluster::isolate(size_t node) {
+    std::vector<size_t> others;
+    for (size_t i = 0; i < size(); ++i) {
+        if (i != node) {
+            others.push_back(i);
+        }
+    }
+    partition({node}, others);
+}
+
+void LocalCluster::set_latency(size_t from, size_t to, int ms) {
+    if (from < size() && to < size() && links_[from][to]) {
+        links_[from][to]->set_latency_ms(ms);
+    }
+}
+
+void LocalCluster::set_latency_all(int ms) {
+    for (auto& row : links_) {
+        for (auto& link : row) {
+            if (link) {
+                link->set_latency_ms(ms);
+            }
+        }
+    }
+}
+
+void LocalCluster::heal() {
+    for (auto& row : links_) {
+        for (auto& link : row) {
+            if (link) {
+                link->set_partitioned(false);
+                link->set_latency_ms(0);
+            }
+        }
+    }
+}
+
+bool LocalCluster::is_up(size_t node) const {
+    return node < size() && nodes_[node].up && !nodes_[node].paused;
+}
+
+bool LocalCluster::ping(size_t node) const {
+    return command(node, "PING") == "$4\r\nPONG\r\n";
+}
+
+Server* LocalCluster::server(size_t node) {
+    return node < size() ? nodes_[node].server.get() : nullptr;
+}
+
+std::optional<size_t> LocalCluster::leader() {
+    if (config_.topology != Topology::RAFT) {
+        if (is_up(0)) {
+            return 0;
+        }
+        return std::nullopt;
+    }
+    // Only the leader accepts writes
+    for (size_t i = 0; i < size(); ++i) {
+        if (is_up(i) && command(i, std::string("SET ") + PROBE_KEY + " 1") == "+OK\r\n") {
+            return i;
+        }
+    }
+    return std::nullopt;
+}
+
+long long LocalCluster::dbsize(size_t node) const {
+    std::string reply = command(node, "DBSIZE");
+    size_t body = reply.find("\r\n");
+    if (!starts_with(reply, "$") || body == std::string::npos) {
+        return -1;
+    }
+    return std::atoll(reply.c_str() + body + 2);
+}
+
+bool LocalCluster::wait_for(const std::function<bool()>& pred, int timeout_ms) {
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeout_ms);
+    while (std::chrono::steady_clock::now() < deadline) {
+        if (pred()) {
+            return true;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    return pred();
+}
+
+std::string LocalCluster::command(size_t node, const std::string& line) const {
+    if (!is_up(node)) {
+        return "";
+    }
+    int fd = net::connect_tcp("127.0.0.1", port(node));
+    if (fd < 0) {
+        return "";
+    }
+
+#ifndef _WIN32
+    // A stuck node must not hang the harness
+    struct timeval timeout = {1, 0};
+    setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+#endif
+
+    std::string reply;
+    net::SocketReader reader(fd);
+    std::string header;
+    if (net::send_all(fd, line + "\n") && reader.read_line(header) && !header.empty()) {
+        reply = header + "\r\n";
+        long len = header[0] == '$' ? std::atol(header.c_str() + 1) : -1;
+        std::string body;
+        if (len >= 0 && reader.read_exact(static_cast<size_t>(len) + 2, body)) {
+            reply += body;
+        }
+    }
+    net::close_socket(fd);
+    return reply;
+}
+
+WorkloadResult LocalCluster::run_workload(const WorkloadConfig& workload) {
+    using Clock = std::chrono::steady_clock;
+    const int interval_ms = std::max(workload.interval_ms, 1);
+    const size_t intervals = static_cast<size_t>((workload.duration_ms + interval_ms - 1) / interval_ms);
+    const auto begin = Clock::now();
+    const auto deadline = begin + std::chrono::milliseconds(workload.duration_ms);
+
+    struct ThreadResult {
+        std::vector<WorkloadResult::Interval> timeline;
+        std::vector<uint32_t> latencies_us;
+    };
+    std::vector<ThreadResult> results(workload.clients);
+    std::vector<std::thread> threads;
+
+    for (size_t t = 0; t < workload.clients; ++t) {
+        threads.emplace_back([&, t]() {
+            ThreadResult& result = results[t];
+            result.timeline.resize(std::max<size_t>(intervals, 1));
+            WorkloadClient client(*this, t);
+            std::mt19937 rng(static_cast<uint32_t>(t + 1));
+            std::uniform_real_distribution<double> coin(0.0, 1.0);
+            std::string value(workload.value_size, 'v');
+
+            while (true) {
+                auto start = Clock::now();
+                if (start >= deadline) {
+                    break;
+                }
+                std::string key = "key:" + std::to_string(rng() % std::max<size_t>(workload.key_space, 1));
+                bool ok = client.run(key, value, coin(rng) < workload.read_ratio);
+                auto end = Clock::now();
+
+                size_t slot = std::min<size_t>(
+                    static_cast<size_t>(std::chrono::duration_cast<std::chrono::milliseconds>(start - begin).count() /
+                                        interval_ms),
+                    result.timeline.size() - 1);
+                if (ok) {
+                    ++result.timeline[slot].ops;
+                    result.latencies_us.push_back(static_cast<uint32_t>(
+                        std::chrono::duration_cast<std::chrono::microseconds>(end - start).count()));
+                } else {
+                    ++result.timeline[slot].errors;
+                }
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+
+    WorkloadResult total;
+    total.seconds = std::chrono::duration<double>(Clock::now() - begin).count();
+    total.timeline.resize(std::max<size_t>(intervals, 1));
+    std::vector<uint32_t> latencies;
+    for (const auto& result : results) {
+        for (size_t i = 0; i < result.timeline.size(); ++i) {
+            total.timeline[i].ops += result.timeline[i].ops;
+            total.timeline[i].errors += result.timeline[i].errors;
+            total.ops += result.timeline[i].ops;
+            total.errors += result.timeline[i].errors;
+        }
+        latencies.insert(latencies.end(), result.latencies_us.begin(), result.latencies_us.end());
+    }
+    total.ops_per_sec = total.seconds > 0 ? total.ops / total.seconds : 0;
+
+    if (!latencies.empty()) {
+        std::sort(latencies.begin(), latencies.end());
+        total.p50_us = latencies[latencies.size() / 2];
+        total.p99_us = latencies[std::min(latencies.size() - 1, latencies.size() * 99 / 100)];
+        total.max_us = latencies.back();
+    }
+    return total;
+}
+
+} // namespace distkv
@@ -0,0 +1,144 @@
+#ifndef DISTKV_HARNESS_H
+#define DISTKV_HARNESS_H
+
+#include "fault_link.h"
+#include "../include/server.h"
+#include <string>
+#include <vector>
+#include <memory>
+#include <optional>
+#include <functional>
+#include <thread>
+#include <cstdint>
+
+namespace distkv {
+
+// Local multi-node test environment: N servers on loopback ports, either
+// as Server objects in this process or as distkv-server child processes,
+// wired up as replicas, a Raft group or a cluster.
+//
+// Node-to-node TCP traffic (replication and Raft) goes through a FaultLink
+// per direction, so partitions and latency can be injected between any two
+// nodes; nodes can also be crashed, restarted and (child processes only)
+// paused. Clients, including the built-in workload, talk to the nodes
+// directly. Cluster mode gossips over UDP and moves slots over direct
+// connections, so only crash/restart/pause apply there.
+
+enum class Topology {
+    STANDALONE,   // independent servers
+    REPLICATION,  // node 0 is the primary, all others replicate it
+    RAFT,         // one Raft group
+    CLUSTER       // hash slots split evenly, nodes introduced with MEET
+};
+
+enum class LaunchMode { IN_PROCESS, CHILD_PROCESS };
+
+// Links listen on the client port plus this offset (see link_port())
+constexpr int HARNESS_LINK_PORT_OFFSET = 30000;
+constexpr size_t HARNESS_MAX_NODES = 16;
+
+struct HarnessConfig {
+    size_t nodes = 3;
+    int base_port = 7100;                        // node i serves base_port + i
+    Topology topology = Topology::REPLICATION;
+    LaunchMode mode = LaunchMode::IN_PROCESS;
+    std::string server_binary = "./distkv-server";
+    std::string data_dir;                        // default: fresh directory in /tmp
+    int cluster_node_timeout_ms = 1000;
+};
+
+struct WorkloadConfig {
+    size_t clients = 4;
+    int duration_ms = 5000;
+    double read_ratio = 0.5;         // share of GETs, the rest are SETs
+    size_t key_space = 10000;
+    size_t value_size = 32;
+    int interval_ms = 1000;          // timeline resolution
+};
+
+struct WorkloadResult {
+    struct Interval {
+        uint64_t ops = 0;
+        uint64_t errors = 0;
+    };
+
+    uint64_t ops = 0;                // successful operations
+    uint64_t errors = 0;             // failed ones (redirects, lost connections)
+    double seconds = 0;
+    double ops_per_sec = 0;
+    double p50_us = 0;
+    double p99_us = 0;
+    double max_us = 0;
+    std::vector<Interval> timeline;  // one entry per interval_ms
+
+    std::string summary() const;
+};
+
+class LocalCluster {
+public:
+    explicit LocalCluster(const HarnessConfig& config);
+    ~LocalCluster();
+
+    // Launch all nodes and links and wait until the topology is formed
+    // (replicas synced, a Raft leader elected, the cluster map converged)
+    bool start();
+    void stop();
+
+    size_t size() const { return config_.nodes; }
+    int port(size_t node) const { return config_.base_port + static_cast<int>(node); }
+    const HarnessConfig& config() const { return config_; }
+
+    // Port of the link that carries node from's traffic to node to
+    int link_port(size_t from, size_t to) const;
+
+    // Faults
+    bool crash(size_t node);                  // SIGKILL or Server::stop()
+    bool restart(size_t node);
+    bool pause(size_t node);                  // SIGSTOP (child processes only)
+    bool resume(size_t node);
+    void partition(const std::vector<size_t>& side_a, const std::vector<size_t>& side_b);
+    void isolate(size_t node);
+    void set_latency(size_t from, size_t to, int ms);
+    void set_latency_all(int ms);
+    void heal();                              // no partitions, no latency
+
+    // Inspection
+    bool is_up(size_t node) const;
+    bool ping(size_t node) const;
+    Server* server(size_t node);              // IN_PROCESS only, nullptr if down
+    std::optional<size_t> leader();           // node accepting writes
+    long long dbsize(size_t node) const;      // -1 if unreachable
+
+    // Poll pred every 10ms until it holds or timeout_ms passes
+    static bool wait_for(const std::function<bool()>& pred, int timeout_ms);
+
+    // Drive SET/GET traffic at the cluster from this process
+    WorkloadResult run_workload(const WorkloadConfig& workload);
+
+private:
+    struct Node {
+        std::unique_ptr<Server> server;       // IN_PROCESS
+        std::thread thread;                   // runs server->start()
+        int pid = -1;                         // CHILD_PROCESS
+        bool up = false;
+        bool paused = false;
+    };
+
+    HarnessConfig config_;
+    bool owns_data_dir_;
+    bool running_;
+    std::vector<Node> nodes_;
+    std::vector<std::vector<std::unique_ptr<FaultLink>>> links_;  // [from][to]
+
+    bool launch(size_t node);
+    std::vector<std::string> server_args(size_t node) const;
+    RaftConfig raft_config(size_t node) const;
+    bool form_cluster();
+
+    // Send one command to a node and return the raw reply ("" on failure)
+    std::string command(size_t node, const std::string& line) const;
+};
+
+} // namespace distkv
+
+#endif // DISTKV_HARNESS_H
@@ -0,0 +1,218 @@
+#include "harness.h"
+#include <iostream>
+#include <sstream>
+#include <thread>
+#include <chrono>
+#include <algorithm>
+#include <cstring>
+#include <cstdlib>
+
+using namespace distkv;
+
+// One scheduled fault, e.g. "crash:0@3000" or "partition:0/1,2@4000"
+struct FaultEvent {
+    int at_ms = 0;
+    std::string action;
+    std::vector<size_t> side_a;   // node arguments, or the latency in ms
+    std::vector<size_t> side_b;   // second side of a partition
+};
+
+// Parse "0,1,2" into node indexes
+bool parse_nodes(const std::string& spec, std::vector<size_t>& nodes) {
+    std::istringstream iss(spec);
+    std::string item;
+    while (std::getline(iss, item, ',')) {
+        if (item.empty() || item.find_first_not_of("0123456789") != std::string::npos) {
+            return false;
+        }
+        nodes.push_back(static_cast<size_t>(std::atoi(item.c_str())));
+    }
+    return !nodes.empty();
+}
+
+// Parse "action[:args]@ms"
+bool parse_fault(const std::string& spec, FaultEvent& event) {
+    size_t at = spec.rfind('@');
+    if (at == std::string::npos) {
+        return false;
+    }
+    event.at_ms = std::atoi(spec.c_str() + at + 1);
+
+    std::string head = spec.substr(0, at);
+    size_t colon = head.find(':');
+    event.action = head.substr(0, colon);
+    std::string args = colon == std::string::npos ? "" : head.substr(colon + 1);
+
+    if (event.action == "heal") {
+        return args.empty();
+    }
+    if (event.action == "partition") {
+        size_t slash = args.find('/');
+        return slash != std::string::npos && parse_nodes(args.substr(0, slash), event.side_a) &&
+               parse_nodes(args.substr(slash + 1), event.side_b);
+    }
+    if (event.action == "crash" || event.action == "restart" || event.action == "pause" ||
+        event.action == "resume" || event.action == "isolate" || event.action == "latency") {
+        return parse_nodes(args, event.side_a);
+    }
+    return false;
+}
+
+void apply_fault(LocalCluster& cluster, const FaultEvent& event) {
+    std::cout << "[" << event.at_ms << "ms] " << event.action << "\n";
+    if (event.action == "heal") {
+        cluster.heal();
+    } else if (event.action == "partition") {
+        cluster.partition(event.side_a, event.side_b);
+    } else if (event.action == "latency") {
+        cluster.set_latency_all(static_cast<int>(event.side_a[0]));
+    } else {
+        for (size_t node : event.side_a) {
+            bool ok = true;
+            if (event.action == "crash") {
+                ok = cluster.crash(node);
+            } else if (event.action == "restart") {
+                ok = cluster.restart(node);
+            } else if (event.action == "pause") {
+                ok = cluster.pause(node);
+            } else if (event.action == "resume") {
+                ok = cluster.resume(node);
+            } else if (event.action == "isolate") {
+                cluster.isolate(node);
+            }
+            if (!ok) {
+                std::cerr << "  " << event.action << " " << node << " failed\n";
+            }
+        }
+    }
+}
+
+bool parse_topology(const std::string& name, Topology& topology) {
+    if (name == "standalone") {
+        topology = Topology::STANDALONE;
+    } else if (name == "replication") {
+        topology = Topology::REPLICATION;
+    } else if (name == "raft") {
+        topology = Topology::RAFT;
+    } else if (name == "cluster") {
+        topology = Topology::CLUSTER;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+int main(int argc, char* argv[]) {
+    HarnessConfig config;
+    WorkloadConfig workload;
+    std::vector<FaultEvent> faults;
+
+    // Parse command line arguments
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--nodes") == 0 && i + 1 < argc) {
+            config.nodes = static_cast<size_t>(std::atoi(argv[i + 1]));
+            ++i;
+        } else if (std::strcmp(argv[i], "--topology") == 0 && i + 1 < argc) {
+            if (!parse_topology(argv[i + 1], config.topology)) {
+                std::cerr << "Invalid --topology, expected standalone, replication, raft or cluster\n";
+                return 1;
+            }
+            ++i;
+        } else if (std::strcmp(argv[i], "--base-port") == 0 && i + 1 < argc) {
+            config.base_port = std::atoi(argv[i + 1]);
+            ++i;
+        } else if (std::strcmp(argv[i], "--processes") == 0) {
+            config.mode = LaunchMode::CHILD_PROCESS;
+        } else if (std::strcmp(argv[i], "--server") == 0 && i + 1 < argc) {
+            config.server_binary = argv[i + 1];
+            ++i;
+        } else if (std::strcmp(argv[i], "--data-dir") == 0 && i + 1 < argc) {
+            config.data_dir = argv[i + 1];
+            ++i;
+        } else if (std::strcmp(argv[i], "--clients") == 0 && i + 1 < argc) {
+            workload.clients = static_cast<size_t>(std::atoi(argv[i + 1]));
+            ++i;
+        } else if (std::strcmp(argv[i], "--duration") == 0 && i + 1 < argc) {
+            workload.duration_ms = std::atoi(argv[i + 1]);
+            ++i;
+        } else if (std::strcmp(argv[i], "--read-ratio") == 0 && i + 1 < argc) {
+            workload.read_ratio = std::atof(argv[i + 1]);
+            ++i;
+        } else if (std::strcmp(argv[i], "--keys") == 0 && i + 1 < argc) {
+            workload.key_space = static_cast<size_t>(std::atoi(argv[i + 1]));
+            ++i;
+        } else if (std::strcmp(argv[i], "--value-size") == 0 && i + 1 < argc) {
+            workload.value_size = static_cast<size_t>(std::atoi(argv[i + 1]));
+            ++i;
+        } else if (std::strcmp(argv[i], "--interval") == 0 && i + 1 < argc) {
+            workload.interval_ms = std::atoi(argv[i + 1]);
+            ++i;
+        } else if (std::strcmp(argv[i], "--fault") == 0 && i + 1 < argc) {
+            FaultEvent event;
+            if (!parse_fault(argv[i + 1], event)) {
+                std::cerr << "Invalid --fault " << argv[i + 1] << ", see --help\n";
+                return 1;
+            }
+            faults.push_back(event);
+            ++i;
+        } else if (std::strcmp(argv[i], "--help") == 0) {
+            std::cout << "DistKV Harness - local multi-node cluster with fault injection\n\n";
+            std::cout << "Usage: " << argv[0] << " [options]\n\n";
+            std::cout << "Options:\n";
+            std::cout << "  --nodes <n>           Number of nodes (default: 3, max: " << HARNESS_MAX_NODES << ")\n";
+            std::cout << "  --topology <t>        standalone, replication, raft or cluster\n";
+            std::cout << "                        (default: replication)\n";
+            std::cout << "  --base-port <port>    Node i listens on base-port + i (default: 7100)\n";
+            std::cout << "  --processes           Run nodes as child processes instead of in-process\n";
+            std::cout << "  --server <path>       Server binary for --processes (default: ./distkv-server)\n";
+            std::cout << "  --data-dir <dir>      Node data and logs (default: temporary directory)\n";
+            std::cout << "  --clients <n>         Workload connections (default: 4)\n";
+            std::cout << "  --duration <ms>       Workload duration (default: 5000)\n";
+            std::cout << "  --read-ratio <r>      Share of GETs (default: 0.5)\n";
+            std::cout << "  --keys <n>            Key space (default: 10000)\n";
+            std::cout << "  --value-size <bytes>  Value size (default: 32)\n";
+            std::cout << "  --interval <ms>       Timeline resolution (default: 1000)\n";
+            std::cout << "  --fault <event>       Schedule a fault during the workload (repeatable):\n";
+            std::cout << "                          crash:<nodes>@<ms>    restart:<nodes>@<ms>\n";
+            std::cout << "                          pause:<nodes>@<ms>    resume:<nodes>@<ms>\n";
+            std::cout << "                          isolate:<nodes>@<ms>  partition:<nodes>/<nodes>@<ms>\n";
+            std::cout << "                          latency:<ms>@<ms>     heal@<ms>\n";
+            std::cout << "                        <nodes> is a comma-separated list of indexes\n";
+            std::cout << "  --help                Show this help message\n";
+            return 0;
+        }
+    }
+
+    LocalCluster cluster(config);
+    std::cout << "Starting " << cluster.size() << " nodes on ports " << cluster.port(0) << "-"
+              << cluster.port(cluster.size() - 1) << "...\n";
+    if (!cluster.start()) {
+        std::cerr << "Failed to start the cluster\n";
+        return 1;
+    }
+    std::cout << "Cluster ready, running workload for " << workload.duration_ms << "ms\n";
+
+    // Faults fire on their own thread while the workload runs
+    std::sort(faults.begin(), faults.end(),
+              [](const FaultEvent& a, const FaultEvent& b) { return a.at_ms < b.at_ms; });
+    auto begin = std::chrono::steady_clock::now();
+    std::thread fault_thread([&]() {
+        for (const auto& event : faults) {
+            std::this_thread::sleep_until(begin + std::chrono::milliseconds(event.at_ms));
+            apply_fault(cluster, event);
+        }
+    });
+
+    WorkloadResult result = cluster.run_workload(workload);
+    fault_thread.join();
+
+    std::cout << "\nTimeline:\n";
+    for (size_t i = 0; i < result.timeline.size(); ++i) {
+        std::cout << "  " << i * workload.interval_ms << "ms\t" << result.timeline[i].ops << " ops\t"
+                  << result.timeline[i].errors << " errors\n";
+    }
+    std::cout << "\n" << result.summary() << "\n";
+
+    cluster.stop();
+    return 0;
+}
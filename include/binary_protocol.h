@@ -0,0 +1,75 @@
+#ifndef DISTKV_BINARY_PROTOCOL_H
+#define DISTKV_BINARY_PROTOCOL_H
+
+#include "protocol.h"
+#include <string>
+#include <string_view>
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+
+namespace distkv {
+
+// Compact binary framing, negotiated per connection (PROTOCOL BINARY).
+//
+// Every frame, request or reply, is a fixed header followed by elements:
+//
+//   0  u8      opcode (CommandType) of a request; StatusCode of a reply,
+//              or PUSH for an invalidation
+//   1  u16     request id, little-endian; a reply carries the id of its
+//              request, a push carries 0
+//   3  varint  element count
+//      then per element a varint length and that many bytes
+//
+// Varints are LEB128 (7 bits per byte, low bits first). Request elements
+// are the arguments, reply elements the Response data (an error's message,
+// a push's keys). Arguments are length-prefixed, so unlike the text
+// protocol they may hold spaces, newlines or any other bytes.
+//
+// Ids let a client match replies to requests without relying on order.
+// The server answers each connection's requests in order today, and ids
+// wrap at 65536, far above the requests a client has in flight (a pipeline
+// sends at most 64 KB of requests before reading).
+class BinaryProtocol {
+public:
+    static constexpr size_t HEADER_BYTES = 3;
+    static constexpr uint8_t PUSH = 0x80;
+
+    // Limits checked while decoding, so a corrupt frame cannot exhaust memory
+    static constexpr uint64_t MAX_ELEMENT_BYTES = 512ULL * 1024 * 1024;
+    static constexpr uint64_t MAX_ELEMENTS = 64ULL * 1024 * 1024;
+
+    enum class Status { DONE, NEED_MORE, ERROR };
+
+    // One decoded frame; elements view into the buffer it was decoded from
+    struct Frame {
+        uint8_t code = 0;
+        uint16_t id = 0;
+        std::vector<std::string_view> elements;
+    };
+
+    // Decode the frame at data[pos, len). DONE fills frame and advances pos
+    // past it; NEED_MORE sets needed to the bytes from pos the frame takes,
+    // as far as known so far; ERROR means the stream is not valid.
+    static Status parse(const char* data, size_t len, size_t& pos, Frame& frame, size_t& needed);
+
+    // Request for a decoded frame; UNKNOWN for opcodes CommandType lacks
+    static Request to_request(const Frame& frame);
+
+    static void append_request(std::string& out, uint16_t id, CommandType command,
+                               const std::vector<std::string>& args);
+    // A text protocol command line ("SET k v"), split on whitespace as the
+    // server splits it
+    static void append_request(std::string& out, uint16_t id, const std::string& line);
+
+    static void append_response(std::string& out, uint16_t id, const Response& response);
+
+    // Push telling a tracking client that key changed
+    static void append_invalidation(std::string& out, const std::string& key);
+
+    static void append_varint(std::string& out, uint64_t value);
+};
+
+} // namespace distkv
+
+#endif // DISTKV_BINARY_PROTOCOL_H
@@ -0,0 +1,152 @@
+#ifndef DISTKV_CLUSTER_H
+#define DISTKV_CLUSTER_H
+
+#include <string>
+#include <vector>
+#include <map>
+#include <optional>
+#include <shared_mutex>
+#include <cstdint>
+
+namespace distkv {
+
+// Cluster mode: the keyspace is split into CLUSTER_SLOTS hash slots and
+// each slot is served by exactly one node. A key's slot is the CRC16
+// (XMODEM) of the key modulo 16384; if the key contains "{...}" with a
+// non-empty body, only that hashtag is hashed, so related keys can be
+// kept on one node.
+//
+// A node answers commands for slots it does not own with
+// "-MOVED <slot> <host>:<port>". While a slot is being migrated the source
+// answers "-ASK <slot> <host>:<port>" for keys it no longer has; the client
+// then sends ASKING followed by the command to the target.
+
+constexpr int CLUSTER_SLOTS = 16384;
+
+// Slot migration (CLUSTER MIGRATESLOT): keys per IMPORTBATCH and how many
+// batches may be in flight on the connection to the target
+constexpr size_t MIGRATION_BATCH_KEYS = 100;
+constexpr size_t MIGRATION_PIPELINE = 4;
+// How long the source waits for the target to acknowledge a step before
+// giving the migration up
+constexpr int MIGRATION_ACK_TIMEOUT_MS = 10000;
+
+// CRC16-CCITT (XMODEM), as used for slot hashing
+uint16_t crc16(const char* data, size_t len);
+
+// Hash slot of a key, honouring {hashtags}
+int key_hash_slot(const std::string& key);
+
+// Parse CLUSTER NODES text into the "host:port" serving each slot ("" for
+// unassigned slots). Returns false if the text has no node lines.
+bool parse_slot_owners(const std::string& nodes_text, std::vector<std::string>& owners);
+
+struct ClusterNode {
+    std::string id;          // 40 hex characters
+    std::string host;
+    int port = 0;
+    uint64_t config_epoch = 0;
+    bool pfail = false;      // this node got no reply within the node timeout
+    bool fail = false;       // a majority of nodes agreed it is unreachable
+
+    std::string address() const { return host + ":" + std::to_string(port); }
+};
+
+// Routing information for one slot
+struct SlotState {
+    bool assigned = false;
+    bool mine = false;                       // owned by this node
+    ClusterNode owner;                       // valid when assigned
+    std::optional<ClusterNode> migrating_to; // set on the owner during migration
+    bool importing = false;                  // set on the migration target
+};
+
+// Thread-safe cluster topology of one node, persisted to a config file
+// ("nodes.conf") in CLUSTER NODES format after every change.
+class ClusterState {
+public:
+    // An empty config_path keeps the topology in memory only
+    explicit ClusterState(const std::string& config_path);
+
+    // Load the config file, or create a fresh node identity if there is
+    // none. host/port are this node's advertised address. Returns false if
+    // an existing config file cannot be parsed.
+    bool init(const std::string& host, int port);
+
+    std::string myself_id() const;
+    ClusterNode myself() const;
+
+    // Topology
+    bool add_node(const std::string& id, const std::string& host, int port);
+    bool forget_node(const std::string& id);
+    std::optional<ClusterNode> node(const std::string& id) const;
+    std::vector<ClusterNode> nodes() const;
+
+    // Slot ownership. add_slots claims slots for this node and fails if any
+    // is already assigned; assign_slots hands slots to any known node. A
+    // node taking over slots from another one gets a new config epoch so
+    // the change wins over the old owner's claims.
+    bool add_slots(const std::vector<int>& slots);
+    bool del_slots(const std::vector<int>& slots);
+    bool assign_slots(const std::vector<int>& slots, const std::string& node_id);
+
+    // Migration markers (CLUSTER SETSLOT ... MIGRATING/IMPORTING/STABLE);
+    // the range forms mark all slots or none
+    bool set_migrating(int slot, const std::string& target_id);
+    bool set_migrating(const std::vector<int>& slots, const std::string& target_id);
+    bool set_importing(int slot, const std::string& source_id);
+    bool set_importing(const std::vector<int>& slots, const std::string& source_id);
+    void set_stable(int slot);
+
+    SlotState slot_state(int slot) const;
+
+    // Gossip (see ClusterBus)
+    uint64_t current_epoch() const;
+    void observe_epoch(uint64_t epoch);
+
+    // Bitmap of this node's slots, CLUSTER_SLOTS bits, slot 0 in bit 0
+    std::string slot_bitmap() const;
+
+    // Apply another node's view of its own slots: a slot moves to it when
+    // unassigned or owned by a node with an older config epoch. Returns
+    // true if any slot changed owner.
+    bool apply_slot_claims(const std::string& id, uint64_t config_epoch,
+                           const std::string& bitmap);
+
+    // Two nodes must never share a config epoch; the one with the larger
+    // id takes a new one. Returns true if this node's epoch changed.
+    bool resolve_epoch_collision(const std::string& id, uint64_t config_epoch);
+
+    void set_node_health(const std::string& id, bool pfail, bool fail);
+
+    // CLUSTER NODES / CLUSTER INFO text
+    std::string describe_nodes() const;
+    std::string info() const;
+
+    // Parse a slot number; returns -1 if invalid
+    static int parse_slot(const std::string& text);
+
+private:
+    std::string config_path_;
+    mutable std::shared_mutex mutex_;
+
+    std::string myself_id_;
+    uint64_t current_epoch_;
+    std::map<std::string, ClusterNode> nodes_;
+    std::vector<std::string> slot_owner_;          // node id per slot, "" = unassigned
+    std::map<int, std::string> migrating_;         // slot -> target node id
+    std::map<int, std::string> importing_;         // slot -> source node id
+
+    // Helpers (mutex_ held)
+    std::string describe_nodes_locked() const;
+    void bump_epoch_locked();
+    bool load_locked();
+    // Parse a config epoch; false if not a plain unsigned number in range
+    static bool parse_epoch(const std::string& text, uint64_t& epoch);
+    void save_locked() const;
+    static std::string generate_id();
+};
+
+} // namespace distkv
+
+#endif // DISTKV_CLUSTER_H
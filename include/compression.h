@@ -0,0 +1,36 @@
+#ifndef DISTKV_COMPRESSION_H
+#define DISTKV_COMPRESSION_H
+
+#include <string>
+#include <cstddef>
+
+namespace distkv {
+
+// Fast LZ77 block codec (LZ4-style sequences) used for the replication
+// stream. It favours speed over ratio: one hash probe per position, no
+// entropy coding. Text command streams typically shrink 3-5x.
+//
+// Block format: a series of sequences, each
+//   token        high nibble = literal count, low nibble = match length - 4
+//                (15 = more length bytes follow, each adding up to 255)
+//   literals
+//   offset       2 bytes little-endian distance back into the output
+//   match length extra bytes
+// The final sequence carries only literals; the decoder stops once it has
+// produced the expected number of bytes.
+class Compression {
+public:
+    // Compress len bytes of data into a block
+    static std::string compress(const char* data, size_t len);
+    static std::string compress(const std::string& data) {
+        return compress(data.data(), data.size());
+    }
+
+    // Decode a block that expands to exactly raw_len bytes, appending to out.
+    // Returns false (out unspecified) on malformed input.
+    static bool decompress(const char* data, size_t len, size_t raw_len, std::string& out);
+};
+
+} // namespace distkv
+
+#endif // DISTKV_COMPRESSION_H
@@ -0,0 +1,121 @@
+#ifndef DISTKV_GOSSIP_H
+#define DISTKV_GOSSIP_H
+
+#include "cluster.h"
+#include <string>
+#include <vector>
+#include <map>
+#include <random>
+#include <mutex>
+#include <thread>
+#include <atomic>
+#include <cstdint>
+
+namespace distkv {
+
+// Cluster bus: nodes exchange small UDP datagrams to learn the topology and
+// detect failures without a coordinator.
+//
+// Every tick a node pings the few peers it has waited longest to ping (plus
+// any peer close to the node timeout) instead of everyone, so the traffic
+// per node grows with the tick rate, not with the cluster size. Each
+// message carries the sender's epochs and slot bitmap and a few entries
+// about other nodes, which spreads membership and failure reports.
+//
+// A peer that does not answer a ping within the node timeout is flagged
+// PFAIL; once a majority of nodes report it, it is marked FAIL and the FAIL
+// is broadcast. Slot ownership follows the highest config epoch.
+
+// The bus listens on UDP at the client port plus this offset
+constexpr int CLUSTER_BUS_PORT_OFFSET = 20000;
+
+struct GossipConfig {
+    int tick_ms = 100;
+    size_t fanout = 3;           // peers pinged per tick
+    size_t gossip_entries = 3;   // other nodes described per message
+    int node_timeout_ms = 5000;
+};
+
+// Wire format of one bus message (little-endian, see gossip.cpp)
+struct GossipMessage {
+    enum Type : uint8_t { PING = 1, PONG = 2, MEET = 3, FAIL = 4 };
+
+    struct Entry {
+        std::string id;
+        std::string host;
+        int port = 0;
+        bool pfail = false;
+        bool fail = false;
+    };
+
+    Type type = PING;
+    std::string sender_id;
+    std::string sender_host;
+    int sender_port = 0;             // client port
+    uint64_t current_epoch = 0;
+    uint64_t config_epoch = 0;
+    std::string slots;               // CLUSTER_SLOTS bits
+    std::vector<Entry> gossip;
+    std::string failed_id;           // FAIL only
+
+    std::string encode() const;
+    static bool decode(const std::string& data, GossipMessage& msg);
+};
+
+class ClusterBus {
+public:
+    ClusterBus(ClusterState& cluster, const GossipConfig& config = GossipConfig());
+    ~ClusterBus();
+
+    // Bind the UDP port (this node's port + CLUSTER_BUS_PORT_OFFSET)
+    bool start();
+    void stop();
+
+    // CLUSTER MEET: introduce this node to the node at host:port (client
+    // port); the whole cluster learns about it through gossip
+    bool meet(const std::string& host, int port);
+
+    uint64_t messages_sent() const { return messages_sent_; }
+    uint64_t messages_received() const { return messages_received_; }
+
+private:
+    // Per-peer liveness, not persisted
+    struct PeerState {
+        int64_t ping_sent_ms = 0;    // outstanding ping, 0 = none
+        int64_t last_ping_ms = 0;    // last time we pinged it
+        int64_t pong_ms = 0;         // last time we heard from it
+        bool pfail = false;
+        bool fail = false;
+        std::map<std::string, int64_t> failure_reports;  // reporter -> time
+    };
+
+    ClusterState& cluster_;
+    GossipConfig config_;
+    int fd_;
+    std::atomic<bool> running_;
+    std::thread thread_;
+
+    std::mutex mutex_;
+    std::map<std::string, PeerState> peers_;
+    std::map<std::string, int64_t> pending_meets_;  // "host:port" -> give up time
+    std::mt19937 rng_;
+
+    std::atomic<uint64_t> messages_sent_;
+    std::atomic<uint64_t> messages_received_;
+
+    void run();
+    void tick();
+    void handle(const GossipMessage& msg);
+
+    // Build a message of the given type describing this node (mutex_ held)
+    GossipMessage make_message(GossipMessage::Type type);
+    void send_to(const std::string& host, int port, const GossipMessage& msg);
+    void set_health(const std::string& id, PeerState& peer, bool pfail, bool fail);
+
+    // Check failure reports and promote PFAIL to FAIL (mutex_ held)
+    void check_failure(const std::string& id, int64_t now);
+};
+
+} // namespace distkv
+
+#endif // DISTKV_GOSSIP_H
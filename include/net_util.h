@@ -0,0 +1,67 @@
+#ifndef DISTKV_NET_UTIL_H
+#define DISTKV_NET_UTIL_H
+
+#include <string>
+#include <cstddef>
+
+namespace distkv {
+namespace net {
+
+// Connect to host:port over TCP. Returns -1 on failure.
+int connect_tcp(const std::string& host, int port);
+
+// Send the whole buffer, retrying on short writes
+bool send_all(int fd, const char* data, size_t len);
+bool send_all(int fd, const std::string& data);
+
+// Send the whole buffer only as far as the socket takes it without
+// blocking; false if some of it was not sent (blocking send on Windows)
+bool try_send_all(int fd, const std::string& data);
+
+// Send data with a descriptor attached (SCM_RIGHTS); Unix domain sockets
+// only, false elsewhere
+bool send_with_fd(int fd, const std::string& data, int passed_fd);
+
+// True if fd is a Unix domain socket
+bool is_unix_socket(int fd);
+
+// False once the peer has closed the connection (or it was shut down);
+// peeks without blocking or consuming data
+bool peer_open(int fd);
+
+// Disable Nagle's algorithm, so replies to pipelined commands are not held
+// back waiting for the peer's (delayed) ACK
+void set_nodelay(int fd);
+
+// Fail blocking reads on fd (and SocketReader reads) after timeout_ms
+// without data; 0 waits forever
+void set_recv_timeout(int fd, int timeout_ms);
+
+// Close a socket / wake up threads blocked on it
+void close_socket(int fd);
+void shutdown_socket(int fd);
+
+// Buffered reader for line- and length-delimited data on a socket
+class SocketReader {
+public:
+    explicit SocketReader(int fd) : fd_(fd), pos_(0) {}
+
+    // Read one line, stripping the trailing \n (and \r if present)
+    bool read_line(std::string& line);
+
+    // Read exactly n bytes
+    bool read_exact(size_t n, std::string& out);
+
+private:
+    int fd_;
+    std::string buffer_;
+    size_t pos_;
+
+    // Pull more bytes from the socket into buffer_
+    bool fill();
+};
+
+} // namespace net
+} // namespace distkv
+
+#endif // DISTKV_NET_UTIL_H
@@ -3,6 +3,7 @@
 
 #include "storage.h"
 #include <string>
+#include <iosfwd>
 
 namespace distkv {
 
@@ -14,6 +15,18 @@ public:
     // Load snapshot from file
     static bool load_snapshot(Storage& storage, const std::string& filepath);
 
+    // Encode/decode a snapshot to/from a stream (shared by the file
+    // snapshot and replication full sync). Return the number of keys
+    // written/read, or -1 on a malformed stream.
+    static long write_snapshot(const Storage& storage, std::ostream& os);
+    static long read_snapshot(Storage& storage, std::istream& is);
+
+    // Same encoding for an arbitrary set of entries (slot migration)
+    static long write_entries(const std::unordered_map<std::string, std::shared_ptr<Value>>& entries,
+                              std::ostream& os);
+    static long read_entries(std::istream& is,
+                             std::unordered_map<std::string, std::shared_ptr<Value>>& entries);
+
     // Append-only file operations (AOF)
     static bool append_command(const std::string& filepath, const std::string& command);
     static bool replay_aof(Storage& storage, const std::string& filepath);
@@ -12,6 +12,8 @@ enum class CommandType : uint8_t {
     // String commands
     SET = 0x01,
     GET = 0x02,
+    MGET = 0x03,     // multi-key forms are served by distkv-proxy
+    MSET = 0x04,
 
     // Generic commands
     DEL = 0x10,
@@ -36,9 +38,24 @@ enum class CommandType : uint8_t {
     SMEMBERS = 0x33,
     SCARD = 0x34,
 
+    // Replication commands
+    SYNC = 0x40,
+    REPLCONF = 0x41,
+    WAIT = 0x42,
+    STALENESS = 0x43,
+    BOUNDED = 0x44,
+
+    // Cluster commands
+    CLUSTER = 0x50,
+    ASKING = 0x51,
+    IMPORTBATCH = 0x52,
+
     // Server commands
     PING = 0xF0,
     QUIT = 0xF1,
+    CLIENT = 0xF2,
+    SHM = 0xF3,
+    PROTOCOL = 0xF4,  // PROTOCOL TEXT|BINARY (see binary_protocol.h)
 
     UNKNOWN = 0xFF
 };
@@ -49,7 +66,9 @@ enum class StatusCode : uint8_t {
     ERROR = 0x01,
     NOT_FOUND = 0x02,
     WRONG_TYPE = 0x03,
-    INVALID_ARGS = 0x04
+    INVALID_ARGS = 0x04,
+    MOVED = 0x05,        // data: "<slot> <host>:<port>"
+    ASK = 0x06
 };
 
 // Request structure
@@ -82,11 +101,31 @@ public:
     // Serialize response to text format
     static std::string serialize_response(const Response& response);
 
+    // Error text of a failed response ("ERR ...", "WRONGTYPE ...",
+    // "MOVED ..."), as sent after the '-' in text format
+    static std::string error_message(const Response& response);
+
     // Helper to convert command string to CommandType
     static CommandType string_to_command(const std::string& cmd);
 
     // Helper to convert CommandType to string
     static std::string command_to_string(CommandType cmd);
+
+    // Serialize a request back to its wire form (used for replication)
+    static std::string serialize_request(const Request& request);
+
+    // Out-of-band message telling a tracking client that key changed:
+    // a RESP3 push, >2 "invalidate" [key]
+    static std::string serialize_invalidation(const std::string& key);
+
+    // True for commands that modify the keyspace
+    static bool is_write_command(CommandType cmd);
+
+    // True for commands that only read the keyspace
+    static bool is_read_command(CommandType cmd);
+
+    // True for commands whose first argument is a key
+    static bool has_key(CommandType cmd);
 };
 
 } // namespace distkv
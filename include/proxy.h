@@ -0,0 +1,111 @@
+#ifndef DISTKV_PROXY_H
+#define DISTKV_PROXY_H
+
+#include "protocol.h"
+#include "cluster.h"
+#include <string>
+#include <vector>
+#include <map>
+#include <set>
+#include <memory>
+#include <atomic>
+#include <mutex>
+#include <shared_mutex>
+#include <condition_variable>
+#include <utility>
+#include <cstdint>
+
+namespace distkv {
+
+// Proxy in front of a cluster for clients that cannot follow MOVED/ASK.
+//
+// Clients speak the same protocol as to a Server. Each command is sent to
+// the node owning its key's slot; MGET, MSET and DEL with several keys are
+// split into single-key commands per node and the replies merged, and KEYS
+// and DBSIZE are answered by every node. Redirects are followed inside the
+// proxy, so clients never see them.
+//
+// Backend traffic runs over a small pool of connections per node shared by
+// all clients. Each connection is pipelined: a writer sends everything
+// queued since its last write in one go and a reader hands the replies back
+// in order, so under load many client commands share one system call and
+// one round trip.
+
+struct ProxyConfig {
+    int port = 7000;
+    std::vector<std::pair<std::string, int>> seeds;  // cluster nodes to load the slot map from
+    size_t pool_size = 4;                            // connections per node
+};
+
+class Proxy {
+public:
+    explicit Proxy(const ProxyConfig& config);
+    ~Proxy();
+
+    // Load the slot map and serve clients (blocking)
+    void start();
+    void stop();
+
+    // Reload the slot map from the seeds or any known node
+    bool refresh_slots();
+
+    // Redirects followed on behalf of clients (for monitoring)
+    uint64_t redirects() const { return redirects_; }
+
+private:
+    class Backend;
+    struct Batch;
+    struct SubCommand;
+    struct Plan;
+
+    // Pooled connections to one cluster node
+    struct Node {
+        std::vector<std::unique_ptr<Backend>> pool;
+    };
+
+    ProxyConfig config_;
+    std::atomic<bool> running_;
+    int listen_fd_;
+
+    std::mutex nodes_mutex_;
+    std::map<std::string, std::unique_ptr<Node>> nodes_;  // "host:port" -> node
+
+    // Slot map ("host:port" per slot), reloaded after MOVED or a node failure
+    std::shared_mutex slots_mutex_;
+    std::vector<std::string> slot_owner_;
+    std::atomic<bool> map_stale_;
+    std::mutex refresh_mutex_;
+
+    // Client connections, so stop() can close them and wait for their threads
+    std::mutex clients_mutex_;
+    std::condition_variable clients_cv_;
+    std::set<int> client_fds_;
+    uint64_t next_client_;
+
+    std::atomic<uint64_t> redirects_;
+
+    bool init_socket();
+    void handle_client(int client_fd, size_t pool_index);
+
+    // Run the commands a client sent in one read; returns all replies
+    std::string execute(const std::vector<std::string>& lines, size_t pool_index, bool& quit);
+
+    // Split a client command into backend commands
+    Plan plan(const std::string& line, std::vector<SubCommand>& subs, bool& quit);
+
+    // Send some backend commands (by index into subs) and wait for them
+    void dispatch(std::vector<SubCommand>& subs, const std::vector<size_t>& indices,
+                  Batch& batch, size_t pool_index);
+
+    // Merge the backend replies of one client command
+    std::string merge(const Plan& plan, const std::vector<std::string>& replies) const;
+
+    // Node serving a slot, "" if unassigned
+    std::string owner_of(int slot);
+    std::vector<std::string> all_owners();
+    Node& node_for(const std::string& address);
+};
+
+} // namespace distkv
+
+#endif // DISTKV_PROXY_H
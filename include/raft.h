@@ -0,0 +1,208 @@
+#ifndef DISTKV_RAFT_H
+#define DISTKV_RAFT_H
+
+#include "storage.h"
+#include "protocol.h"
+#include <string>
+#include <vector>
+#include <deque>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <atomic>
+#include <functional>
+#include <chrono>
+#include <random>
+#include <cstdint>
+#include <cstdio>
+
+namespace distkv {
+
+// Raft consensus for strongly consistent writes.
+//
+// Write commands are appended to a replicated log; a command is applied to
+// the state machine (and the client answered) once a majority stored it.
+// The leader pipelines AppendEntries (several batches in flight per peer),
+// packs every entry proposed since the previous send into one message and
+// fsyncs its own log in parallel with the network round trip, so a commit
+// costs about one RTT. The log is compacted by taking a storage snapshot
+// with Persistence; followers that fall behind the snapshot receive it via
+// InstallSnapshot.
+
+// Raft RPCs listen on the client port plus this offset
+constexpr int RAFT_PORT_OFFSET = 10000;
+
+struct RaftPeer {
+    int id;
+    std::string host;
+    int port;  // Raft RPC port
+};
+
+struct RaftConfig {
+    int node_id = 0;
+    int port = 0;                        // Raft RPC listen port
+    std::vector<RaftPeer> peers;         // other members of the group
+    std::string data_dir;                // empty = keep log in memory only
+
+    int election_timeout_min_ms = 300;
+    int election_timeout_max_ms = 600;
+    int heartbeat_interval_ms = 50;
+    size_t max_batch_entries = 1024;     // entries per AppendEntries
+    size_t max_inflight = 8;             // pipelined AppendEntries per peer
+    uint64_t snapshot_threshold = 100000; // compact after this many entries
+};
+
+class RaftNode {
+public:
+    enum class Role { FOLLOWER, CANDIDATE, LEADER };
+
+    // Applies a committed command to the state machine
+    using ApplyFn = std::function<Response(const std::string& command)>;
+
+    RaftNode(const RaftConfig& config, Storage& storage, ApplyFn apply);
+    ~RaftNode();
+
+    // Create dir and any missing parents; false if it is not a usable
+    // directory afterwards
+    static bool prepare_data_dir(const std::string& dir);
+
+    // Load persisted state, start listening and join the group. Fails if
+    // the data directory, meta file or log file cannot be created.
+    bool start();
+    void stop();
+
+    // Replicate a command and wait until it is committed and applied.
+    // Returns false if this node is not the leader, loses leadership or
+    // the timeout expires; result holds the state machine's response.
+    bool propose(const std::string& command, Response& result, int timeout_ms = 5000);
+
+    bool is_leader() const;
+    int leader_id() const;
+    Role role() const;
+    uint64_t current_term() const;
+    int voted_for() const;
+    uint64_t last_index() const;
+    uint64_t commit_index() const;
+    uint64_t last_applied() const;
+    uint64_t snapshot_index() const;
+
+private:
+    struct Entry {
+        uint64_t term;
+        std::string command;
+    };
+
+    struct PeerState {
+        RaftPeer info;
+        int fd = -1;
+        uint64_t next_index = 1;
+        uint64_t match_index = 0;
+        uint64_t epoch = 0;                 // bumped when the pipeline is reset
+        std::deque<uint64_t> inflight;      // epochs of unanswered AppendEntries
+        bool snapshot_inflight = false;
+        uint64_t vote_requested_term = 0;
+        uint64_t vote_granted_term = 0;
+        std::chrono::steady_clock::time_point last_send;
+        std::thread sender;
+        std::thread reader;
+    };
+
+    struct Proposal {
+        uint64_t term;
+        bool done = false;
+        bool ok = false;
+        Response result;
+    };
+
+    RaftConfig config_;
+    Storage& storage_;
+    ApplyFn apply_;
+
+    mutable std::mutex mutex_;
+    std::condition_variable cv_;          // wakes senders, ticker, applier
+    std::condition_variable applied_cv_;  // wakes proposers
+    std::atomic<bool> running_;
+
+    // Persistent state
+    uint64_t current_term_;
+    int voted_for_;
+    std::deque<Entry> log_;               // entries after the snapshot
+    uint64_t snapshot_index_;
+    uint64_t snapshot_term_;
+    std::string snapshot_data_;           // encoded with Persistence
+
+    // Volatile state
+    Role role_;
+    int leader_id_;
+    uint64_t commit_index_;
+    uint64_t last_applied_;
+    uint64_t durable_index_;              // last index fsynced locally
+    bool disk_failed_;                    // a write to data_dir failed
+    int votes_;
+    std::chrono::steady_clock::time_point election_deadline_;
+    std::mt19937 rng_;
+    std::map<uint64_t, Proposal*> proposals_;
+
+    std::vector<std::unique_ptr<PeerState>> peers_;
+
+    int listen_fd_;
+    std::thread accept_thread_;
+    std::thread ticker_thread_;
+    std::thread applier_thread_;
+    std::mutex conn_mutex_;
+    std::vector<int> conn_fds_;
+    std::vector<std::thread> conn_threads_;
+
+    // Serializes state machine mutation (apply vs snapshot install)
+    std::mutex apply_mutex_;
+
+    // Log file (only with data_dir)
+    std::FILE* log_file_;
+    std::mutex sync_mutex_;
+
+    // Log helpers (mutex_ held)
+    uint64_t last_log_index() const { return snapshot_index_ + log_.size(); }
+    uint64_t last_log_term() const;
+    uint64_t term_at(uint64_t index) const;
+    const Entry& entry_at(uint64_t index) const { return log_[index - snapshot_index_ - 1]; }
+    size_t majority() const { return (peers_.size() + 1) / 2 + 1; }
+
+    // Role transitions (mutex_ held)
+    void become_follower(uint64_t term);
+    void become_candidate();
+    void become_leader();
+    void reset_election_deadline();
+    void advance_commit();
+    void fail_proposals();
+    void fail_disk();
+
+    // Threads
+    void accept_loop();
+    void serve_connection(int fd);
+    void sender_loop(PeerState* peer);
+    void reader_loop(PeerState* peer, int fd);
+    void ticker_loop();
+    void applier_loop();
+
+    // RPC handlers; each returns the encoded reply frame
+    std::string handle_request_vote(const std::string& payload);
+    std::string handle_append_entries(const std::string& payload);
+    std::string handle_install_snapshot(const std::string& payload);
+    void handle_reply(PeerState* peer, uint8_t type, const std::string& payload);
+
+    // Durability
+    bool load_state();
+    bool persist_meta();
+    void append_log_records(uint64_t from_index);
+    bool rewrite_log_file();
+    bool persist_snapshot();
+    bool sync_log();
+    void take_snapshot();
+    std::string path(const std::string& name) const;
+};
+
+} // namespace distkv
+
+#endif // DISTKV_RAFT_H
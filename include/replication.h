@@ -1,31 +1,164 @@
 #ifndef DISTKV_REPLICATION_H
 #define DISTKV_REPLICATION_H
 
+#include "storage.h"
+#include "protocol.h"
 #include <string>
 #include <vector>
 #include <atomic>
+#include <memory>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <functional>
+#include <cstdint>
 
 namespace distkv {
 
-// Placeholder for replication functionality
-// Will be implemented in future phases
+// Asynchronous primary -> replica replication.
+//
+// A replica opens a normal client connection and sends SYNC. The primary
+// answers with "+FULLRESYNC <offset>", a "$<len>" snapshot payload and then
+// streams every write command as a text line. The replication offset counts
+// the bytes of streamed command lines, so both sides agree on it without
+// extra bookkeeping. Replicas report their offset with "REPLCONF ACK <n>"
+// once a second, or immediately when the primary sends "REPLCONF GETACK".
+//
+// After every batch, and every HEARTBEAT_INTERVAL_MS while idle, the primary
+// sends "REPLCONF OFFSET <n>" with its current offset. A replica that has
+// applied everything up to that line knows it was fully caught up at that
+// moment, which bounds how stale its reads can be.
+//
+// A replica may ask for "SYNC COMPRESS". The primary then confirms with
+// "+FULLRESYNC <offset> COMPRESS" and everything after that line is sent as
+// frames: [u8 codec][u32 raw length][u32 data length][data], little-endian,
+// codec 0 = stored, 1 = Compression block. Each sender batch becomes one or
+// more frames, so compression adds no extra buffering delay. Offsets keep
+// counting uncompressed command bytes.
 
 class ReplicationMaster {
 public:
-    void register_slave(int fd);
-    void replicate_command(const std::string& cmd);
+    // Offset heartbeat period on an idle link
+    static constexpr int HEARTBEAT_INTERVAL_MS = 100;
+
+    ReplicationMaster();
+    ~ReplicationMaster();
+
+    // Attach a replica connection: queues the full snapshot and starts
+    // streaming. Callers must hold off writes while this runs so the
+    // snapshot and the stream offset line up.
+    void register_slave(int fd, const Storage& storage, bool compress = false);
+
+    // Detach a replica (connection closed); stops its sender thread
+    void unregister_slave(int fd);
+
+    // Append a write command to the stream; returns the new master offset
+    uint64_t replicate_command(const std::string& cmd);
+
+    // Record an offset acknowledgement from a replica
+    void acknowledge(int fd, uint64_t offset);
+
+    // Block until num_replicas replicas have acknowledged offset or
+    // timeout_ms elapses (0 = wait forever). Returns the number of
+    // replicas that reached the offset.
+    int wait_for_replicas(uint64_t offset, int num_replicas, int timeout_ms);
+
+    uint64_t offset() const;
+    size_t slave_count() const;
+    bool has_slaves() const { return slave_count_.load() > 0; }
+
+    // Drop all replicas
+    void shutdown();
 
 private:
-    std::vector<int> slave_fds_;
+    struct SlaveLink {
+        int fd;
+        bool compress = false;      // stream is sent as compressed frames
+        std::string handshake;      // FULLRESYNC line, always sent uncompressed
+        std::string pending;        // bytes waiting to be sent
+        uint64_t ack_offset = 0;
+        uint64_t raw_bytes = 0;     // stream bytes before / after framing
+        uint64_t wire_bytes = 0;
+        bool closed = false;
+        std::thread sender;
+    };
+
+    // Replicas whose unsent backlog exceeds this are disconnected
+    static constexpr size_t MAX_PENDING_BYTES = 64 * 1024 * 1024;
+
+    mutable std::mutex mutex_;
+    std::condition_variable send_cv_;   // wakes sender threads
+    std::condition_variable ack_cv_;    // wakes WAIT callers
+    std::vector<std::unique_ptr<SlaveLink>> slaves_;
+    std::atomic<size_t> slave_count_;
+    uint64_t master_offset_;
+
+    void sender_loop(SlaveLink* link);
+    void queue_to_all(const std::string& data);
+    int count_acked(uint64_t offset) const;
 };
 
 class ReplicationSlave {
 public:
-    void connect_to_master(const std::string& host, int port);
-    void sync_from_master();
+    // A replica that heard no offset heartbeat for this long may have lost
+    // its primary without noticing; its lag figures mean nothing then
+    static constexpr int HEARTBEAT_TIMEOUT_MS = 5 * ReplicationMaster::HEARTBEAT_INTERVAL_MS;
+
+    // Called for every write command received from the primary
+    using ApplyFn = std::function<void(const Request&)>;
+
+    ReplicationSlave(Storage& storage, ApplyFn apply);
+    ~ReplicationSlave();
+
+    // Start following host:port in the background (reconnects on failure);
+    // compress asks the primary for a compressed stream
+    void connect_to_master(const std::string& host, int port, bool compress = false);
+
+    // Stop following and join the background threads
+    void stop();
+
+    // Bytes of the replication stream applied so far
+    uint64_t offset() const { return offset_.load(); }
+    bool is_linked() const { return linked_.load(); }
+
+    // Bytes the replica is behind the latest primary offset it has heard of
+    uint64_t lag_offset() const;
+
+    // Milliseconds since the replica was last known to be fully caught up
+    // with the primary; -1 if it never completed a sync
+    int64_t lag_ms() const;
+
+    // Milliseconds since the primary was last heard from (sync or offset
+    // heartbeat); -1 if never
+    int64_t heartbeat_age_ms() const;
 
 private:
+    Storage& storage_;
+    ApplyFn apply_;
+    std::string master_host_;
+    int master_port_;
+    bool compress_;
+
+    std::atomic<bool> running_;
+    std::atomic<bool> linked_;
+    std::atomic<uint64_t> offset_;
+    std::atomic<uint64_t> master_offset_;   // latest offset announced by the primary
+    std::atomic<int64_t> caught_up_ms_;     // steady clock ms of last catch-up, -1 = never
+    std::atomic<int64_t> heartbeat_ms_;     // steady clock ms of last heartbeat, -1 = never
     int master_fd_;
+
+    std::mutex mutex_;               // guards master_fd_ and sends
+    std::condition_variable stop_cv_;
+    std::thread sync_thread_;
+    std::thread ack_thread_;
+
+    // One replication session: full sync followed by the command stream
+    void sync_from_master();
+
+    void run();
+    void ack_loop();
+    void send_ack();
+    void mark_caught_up();
 };
 
 } // namespace distkv
@@ -3,13 +3,57 @@
 
 #include "storage.h"
 #include "protocol.h"
+#include "replication.h"
+#include "raft.h"
+#include "cluster.h"
+#include "gossip.h"
 #include <memory>
 #include <atomic>
 #include <thread>
 #include <vector>
+#include <mutex>
+#include <shared_mutex>
+#include <unordered_map>
+#include <unordered_set>
+#include <set>
+#include <condition_variable>
+#include <string>
+#include <cstdint>
 
 namespace distkv {
 
+class ShmChannel;
+
+// Per-connection state
+struct ClientSession {
+    int fd;
+    uint64_t last_write_offset;  // replication offset after this client's last write
+    bool is_replica;             // connection is a replica's SYNC link
+    int64_t max_lag_ms;          // staleness bound for reads on a replica, -1 = none
+    int64_t max_lag_offset;
+    bool asking;                 // ASKING was sent; next command may hit an importing slot
+
+    // Client-side caching (CLIENT TRACKING). Writers queue invalidations
+    // in pushes and send them unless another thread is writing to fd, in
+    // which case that thread sends them when done.
+    uint64_t tracking_id;        // 0 = tracking off
+    std::mutex send_mutex;       // held while writing to fd
+    std::mutex push_mutex;
+    std::string pushes;          // invalidations not yet sent (push_mutex)
+
+    // Replies and pushes go through this segment instead of fd once the
+    // client switched to shared memory (SHM); set under send_mutex
+    ShmChannel* shm;
+
+    // Requests, replies and pushes use the binary protocol (PROTOCOL
+    // BINARY); changed by the session's thread under push_mutex
+    bool binary;
+
+    explicit ClientSession(int f)
+        : fd(f), last_write_offset(0), is_replica(false), max_lag_ms(-1), max_lag_offset(-1),
+          asking(false), tracking_id(0), shm(nullptr), binary(false) {}
+};
+
 class Server {
 public:
     Server(int port, int num_threads = 4);
@@ -18,12 +62,39 @@ public:
     // Start the server (blocking)
     void start();
 
-    // Stop the server
+    // Stop the server. start() returns, and all client connections are
+    // closed and their threads finished by the time this returns.
     void stop();
 
     // Get storage instance (for testing)
     Storage* get_storage() { return storage_.get(); }
 
+    // Follow a primary instead of accepting writes (call before start);
+    // compress requests a compressed replication stream
+    void set_replica_of(const std::string& host, int port, bool compress = false);
+
+    // Route writes through a Raft group (call before start); false if the
+    // Raft data directory cannot be created
+    bool enable_raft(const RaftConfig& config);
+
+    // Serve only the hash slots assigned to this node (call before start).
+    // The topology is kept in config_path; host is the address other nodes
+    // and clients are redirected to. Nodes gossip on port + 20000. Returns
+    // false if the config is corrupt.
+    bool enable_cluster(const std::string& config_path, const std::string& host,
+                        const GossipConfig& gossip = GossipConfig());
+    ClusterState* get_cluster() { return cluster_.get(); }
+
+    // How long a slot migration waits for each acknowledgement from the
+    // target before aborting (default MIGRATION_ACK_TIMEOUT_MS)
+    void set_migration_timeout(int timeout_ms) { migration_timeout_ms_ = timeout_ms; }
+
+    // Also accept clients on a Unix domain socket at path (call before
+    // start). A stale socket file left by a previous run is replaced, and
+    // the file is removed when the server stops. Returns false on
+    // platforms without Unix sockets.
+    bool set_unix_socket(const std::string& path);
+
 private:
     int port_;
     int num_threads_;
@@ -31,17 +102,128 @@ private:
     std::unique_ptr<Storage> storage_;
     std::vector<std::thread> worker_threads_;
 
-    // Socket descriptor
+    // Replication
+    std::unique_ptr<ReplicationMaster> repl_master_;
+    std::unique_ptr<ReplicationSlave> repl_slave_;
+    std::string master_host_;
+    int master_port_;
+    bool repl_compress_;
+
+    // Cluster mode
+    std::unique_ptr<ClusterState> cluster_;
+    std::unique_ptr<ClusterBus> cluster_bus_;
+    GossipConfig gossip_config_;
+
+    // Slot migration. Keyed commands hold migration_mutex_ shared; the
+    // migrator takes it exclusively to copy out or drop a batch of keys.
+    // migrating_keys_ were sent to the target but not acknowledged yet, so
+    // writes to them are refused with TRYAGAIN.
+    std::shared_mutex migration_mutex_;
+    std::unordered_set<std::string> migrating_keys_;
+    int migration_timeout_ms_ = MIGRATION_ACK_TIMEOUT_MS;
+
+    // Raft mode
+    std::unique_ptr<RaftNode> raft_;
+    RaftConfig raft_config_;
+    bool raft_enabled_;
+
+    // Serializes applying a write with appending it to the replication
+    // stream, so replicas see writes in the order they were applied
+    std::mutex write_mutex_;
+
+    // Client-side caching: which tracking sessions read each key since it
+    // last changed. Entries are one-shot (cleared when the key changes) and
+    // may name sessions that have since gone; those are skipped.
+    std::mutex tracking_mutex_;
+    std::unordered_map<uint64_t, ClientSession*> tracking_sessions_;
+    std::unordered_map<std::string, std::unordered_set<uint64_t>> tracked_keys_;
+    std::atomic<uint64_t> next_tracking_id_;
+    std::atomic<size_t> tracking_count_;  // sessions with tracking on
+
+    // Socket descriptors
     int listen_fd_;
+    int unix_fd_;              // INVALID_SOCKET unless unix_path_ is set
+    std::string unix_path_;
 
-    // Initialize socket
+    // Open client connections, so stop() can close them and wait for
+    // their threads
+    std::mutex clients_mutex_;
+    std::condition_variable clients_cv_;
+    std::set<int> client_fds_;
+
+    // Initialize sockets
     bool init_socket();
+    bool init_unix_socket();
+    void close_listeners();
+
+    // Accept connections on listen_fd until the server stops; tcp
+    // connections get TCP_NODELAY
+    void accept_loop(int listen_fd, bool tcp);
 
-    // Handle single client connection
+    // Handle single client connection (the caller closes client_fd)
     void handle_client(int client_fd);
 
-    // Execute a command and return response
-    Response execute_command(const Request& req);
+    // SHM [<ring_bytes> [<spin_us>]]: create a shared-memory segment for a
+    // client on the Unix socket and pass it back with +OK. On success the
+    // session's traffic moves to shm; otherwise error is the reply.
+    bool attach_shm(const Request& req, ClientSession& session,
+                    std::unique_ptr<ShmChannel>& shm, Response& error);
+
+    // PROTOCOL TEXT|BINARY: the reply, and pushes queued before it, go out
+    // in the old protocol; everything after in the new one
+    bool switch_protocol(const Request& req, ClientSession& session, uint16_t id,
+                         std::string& replies);
+
+    // Execute a command on behalf of a client and return response
+    Response execute_command(const Request& req, ClientSession& session);
+
+    // Apply a command to storage (no replication or access checks)
+    Response apply_command(const Request& req);
+
+    // Apply a write and append it to the replication stream
+    Response apply_and_replicate(const Request& req, ClientSession* session);
+
+    // Error returned to writes on a Raft follower
+    Response raft_redirect() const;
+
+    // Check that this node serves the command's key; otherwise fill
+    // redirect with MOVED/ASK/CLUSTERDOWN and return false
+    bool cluster_route(const Request& req, ClientSession& session, Response& redirect);
+
+    // CLUSTER subcommands
+    Response cluster_command(const Request& req);
+
+    // Move the keys of some slots to another node, then hand the slots over
+    Response migrate_slots(const std::vector<int>& slots, const std::string& target_id,
+                           size_t batch_keys);
+
+    // Store a batch of snapshot-encoded entries sent by a migrating node
+    Response import_batch(const std::string& payload);
+
+    // CLIENT subcommands
+    Response client_command(const Request& req, ClientSession& session);
+
+    // Turn tracking off for a session (no-op if it is off)
+    void stop_tracking(ClientSession& session);
+
+    // Remember that a tracking session read the key of req. Called before
+    // the read, so a write racing with it is always reported.
+    void track_read(const Request& req, ClientSession& session);
+
+    // Tell the sessions that read key that it changed
+    void invalidate(const std::string& key);
+
+    // Queue an invalidation of key for a session and send what is queued
+    // (tracking_mutex_ held); a session that cannot take it without
+    // blocking is dropped
+    void queue_push(ClientSession& session, const std::string& key);
+
+    // Send queued pushes unless another thread holds the socket
+    bool send_pushes(ClientSession& session, bool may_block);
+
+    // Check a read against a staleness bound (-1 = unbounded); fills error
+    // and returns false when this replica lags further behind its primary
+    bool within_staleness(int64_t max_lag_ms, int64_t max_lag_offset, Response& error) const;
 
     // Worker thread function
     void worker_thread();
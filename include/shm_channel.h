@@ -0,0 +1,95 @@
+#ifndef DISTKV_SHM_CHANNEL_H
+#define DISTKV_SHM_CHANNEL_H
+
+#include <memory>
+#include <functional>
+#include <cstddef>
+#include <cstdint>
+
+namespace distkv {
+
+// Control block of one ring (defined in shm_channel.cpp)
+struct ShmRing;
+
+// Shared-memory transport between a server and a client on the same host.
+//
+// One memfd segment holds two single-producer single-consumer byte rings,
+// requests one way and replies the other, carrying exactly the bytes the
+// socket would. Writing and reading are plain copies plus one atomic store
+// each, with no system call while the other side keeps up. A reader with
+// nothing to read spins for spin_us, then sleeps on a futex that the
+// writer wakes (a writer facing a full ring does the same); with spin_us
+// = -1 it never sleeps. Sleepers wake every WAIT_SLICE_MS to run the alive
+// check, which is how a dead peer or a stopping server is noticed.
+//
+// The server creates the segment and hands its descriptor to the client
+// over the Unix socket (SCM_RIGHTS). Either side can scribble on the
+// shared counters, so a fill level beyond the ring marks the channel
+// corrupt: from then on reads return -1 and writes fail. Linux only: create() and attach()
+// return nullptr elsewhere.
+class ShmChannel {
+public:
+    static constexpr size_t MIN_RING_BYTES = 4096;
+    static constexpr size_t MAX_RING_BYTES = 64 * 1024 * 1024;
+    static constexpr int WAIT_SLICE_MS = 100;
+
+    // Server side: a new segment with two rings of ring_bytes (rounded up
+    // to a power of two within the limits). Reads requests, writes replies.
+    static std::unique_ptr<ShmChannel> create(size_t ring_bytes);
+
+    // Client side: map a segment created by the server, taking ownership
+    // of fd. Writes requests, reads replies.
+    static std::unique_ptr<ShmChannel> attach(int fd);
+
+    ~ShmChannel();
+    ShmChannel(const ShmChannel&) = delete;
+    ShmChannel& operator=(const ShmChannel&) = delete;
+
+    int fd() const { return fd_; }
+    size_t ring_bytes() const { return capacity_; }
+    // The peer left the ring counters inconsistent; the channel is unusable
+    bool corrupt() const { return corrupt_; }
+
+    // Time a waiting read or write spins before sleeping; -1 never sleeps
+    void set_spin_us(int spin_us) { spin_us_ = spin_us; }
+    // Run while waiting; returning false gives up the wait
+    void set_alive_check(std::function<bool()> alive) { alive_ = std::move(alive); }
+
+    // Read up to len bytes, waiting for some. Returns 0 if a wait slice
+    // passed with nothing to read, -1 if the alive check failed.
+    long read(char* buffer, size_t len);
+    // Read only what is already there (0 if nothing, or if corrupt)
+    size_t read_available(char* buffer, size_t len);
+
+    // Write all of data, waiting for room as needed. One writer at a time:
+    // concurrent writers must serialize among themselves.
+    bool write(const char* data, size_t len);
+    // Write all of data only if it fits without waiting
+    bool try_write(const char* data, size_t len);
+
+private:
+    int fd_;
+    void* base_;
+    size_t mapped_bytes_;
+    size_t capacity_;
+    ShmRing* rx_;
+    ShmRing* tx_;
+    char* rx_data_;
+    char* tx_data_;
+    int spin_us_;
+    std::function<bool()> alive_;
+    bool corrupt_;
+
+    ShmChannel(int fd, void* base, size_t mapped_bytes, size_t capacity, bool server);
+
+    // False (and corrupt from then on) if used exceeds the ring
+    bool check_fill(uint64_t used);
+    // Copy len bytes into the tx ring; the caller checked there is room
+    void publish(const char* data, size_t len);
+    // Wait until the tx ring has room; false if the alive check failed
+    bool wait_for_room();
+};
+
+} // namespace distkv
+
+#endif // DISTKV_SHM_CHANNEL_H
@@ -75,6 +75,12 @@ public:
     std::unordered_map<std::string, std::shared_ptr<Value>> get_snapshot() const;
     void restore_snapshot(const std::unordered_map<std::string, std::shared_ptr<Value>>& data);
 
+    // For slot migration: copy out live entries for some keys / add entries
+    // (overwriting existing keys)
+    std::unordered_map<std::string, std::shared_ptr<Value>> get_entries(
+        const std::vector<std::string>& keys) const;
+    void merge_entries(const std::unordered_map<std::string, std::shared_ptr<Value>>& data);
+
 private:
     std::unordered_map<std::string, std::shared_ptr<Value>> data_;
     mutable std::shared_mutex mutex_;  // Reader-writer lock
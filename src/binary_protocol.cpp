@@ -0,0 +1,161 @@
+#include "binary_protocol.h"
+#include <algorithm>
+#include <cctype>
+
+namespace distkv {
+
+namespace {
+
+// A 64-bit varint never takes more than 10 bytes
+constexpr size_t MAX_VARINT_BYTES = 10;
+
+BinaryProtocol::Status read_varint(const char* data, size_t len, size_t& at, uint64_t& value) {
+    value = 0;
+    for (size_t i = 0; i < MAX_VARINT_BYTES; ++i) {
+        if (at + i >= len) {
+            return BinaryProtocol::Status::NEED_MORE;
+        }
+        uint8_t byte = static_cast<uint8_t>(data[at + i]);
+        value |= static_cast<uint64_t>(byte & 0x7F) << (7 * i);
+        if ((byte & 0x80) == 0) {
+            at += i + 1;
+            return BinaryProtocol::Status::DONE;
+        }
+    }
+    return BinaryProtocol::Status::ERROR;
+}
+
+void append_header(std::string& out, uint8_t code, uint16_t id, uint64_t count) {
+    out.push_back(static_cast<char>(code));
+    out.push_back(static_cast<char>(id & 0xFF));
+    out.push_back(static_cast<char>(id >> 8));
+    BinaryProtocol::append_varint(out, count);
+}
+
+void append_element(std::string& out, const char* data, size_t len) {
+    BinaryProtocol::append_varint(out, len);
+    out.append(data, len);
+}
+
+bool is_space(char c) {
+    return std::isspace(static_cast<unsigned char>(c)) != 0;
+}
+
+} // namespace
+
+void BinaryProtocol::append_varint(std::string& out, uint64_t value) {
+    while (value >= 0x80) {
+        out.push_back(static_cast<char>((value & 0x7F) | 0x80));
+        value >>= 7;
+    }
+    out.push_back(static_cast<char>(value));
+}
+
+BinaryProtocol::Status BinaryProtocol::parse(const char* data, size_t len, size_t& pos,
+                                             Frame& frame, size_t& needed) {
+    size_t at = pos;
+    if (len < at + HEADER_BYTES + 1) {
+        needed = HEADER_BYTES + 1;
+        return Status::NEED_MORE;
+    }
+    frame.code = static_cast<uint8_t>(data[at]);
+    frame.id = static_cast<uint16_t>(static_cast<uint8_t>(data[at + 1]) |
+                                     (static_cast<uint8_t>(data[at + 2]) << 8));
+    at += HEADER_BYTES;
+
+    uint64_t count;
+    Status status = read_varint(data, len, at, count);
+    if (status != Status::DONE || count > MAX_ELEMENTS) {
+        needed = at - pos + 1;
+        return status == Status::DONE ? Status::ERROR : status;
+    }
+
+    frame.elements.clear();
+    for (uint64_t i = 0; i < count; ++i) {
+        uint64_t element_len;
+        status = read_varint(data, len, at, element_len);
+        if (status != Status::DONE || element_len > MAX_ELEMENT_BYTES) {
+            needed = at - pos + 1;
+            return status == Status::DONE ? Status::ERROR : status;
+        }
+        if (len - at < element_len) {
+            // At least this body, plus a length byte if more elements follow
+            needed = at - pos + static_cast<size_t>(element_len) + (i + 1 < count ? 1 : 0);
+            return Status::NEED_MORE;
+        }
+        frame.elements.emplace_back(data + at, static_cast<size_t>(element_len));
+        at += static_cast<size_t>(element_len);
+    }
+
+    pos = at;
+    return Status::DONE;
+}
+
+Request BinaryProtocol::to_request(const Frame& frame) {
+    Request req;
+    CommandType command = static_cast<CommandType>(frame.code);
+    req.command = Protocol::command_to_string(command) == "UNKNOWN" ? CommandType::UNKNOWN : command;
+    req.args.reserve(frame.elements.size());
+    for (const auto& element : frame.elements) {
+        req.args.emplace_back(element);
+    }
+    return req;
+}
+
+void BinaryProtocol::append_request(std::string& out, uint16_t id, CommandType command,
+                                    const std::vector<std::string>& args) {
+    append_header(out, static_cast<uint8_t>(command), id, args.size());
+    for (const auto& arg : args) {
+        append_element(out, arg.data(), arg.size());
+    }
+}
+
+void BinaryProtocol::append_request(std::string& out, uint16_t id, const std::string& line) {
+    // First pass: the command name and how many arguments follow it
+    size_t start = 0;
+    std::string name;
+    uint64_t count = 0;
+    size_t i = 0;
+    while (i < line.size()) {
+        while (i < line.size() && is_space(line[i])) ++i;
+        size_t word = i;
+        while (i < line.size() && !is_space(line[i])) ++i;
+        if (word == i) {
+            break;
+        }
+        if (name.empty()) {
+            name = line.substr(word, i - word);
+            start = i;
+        } else {
+            ++count;
+        }
+    }
+    std::transform(name.begin(), name.end(), name.begin(),
+                   [](unsigned char c) { return std::toupper(c); });
+
+    // Second pass: the arguments themselves
+    append_header(out, static_cast<uint8_t>(Protocol::string_to_command(name)), id, count);
+    i = start;
+    while (i < line.size()) {
+        while (i < line.size() && is_space(line[i])) ++i;
+        size_t word = i;
+        while (i < line.size() && !is_space(line[i])) ++i;
+        if (word < i) {
+            append_element(out, line.data() + word, i - word);
+        }
+    }
+}
+
+void BinaryProtocol::append_response(std::string& out, uint16_t id, const Response& response) {
+    append_header(out, static_cast<uint8_t>(response.status), id, response.data.size());
+    for (const auto& item : response.data) {
+        append_element(out, item.data(), item.size());
+    }
+}
+
+void BinaryProtocol::append_invalidation(std::string& out, const std::string& key) {
+    append_header(out, PUSH, 0, 1);
+    append_element(out, key.data(), key.size());
+}
+
+} // namespace distkv
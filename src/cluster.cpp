@@ -0,0 +1,587 @@
+#include "cluster.h"
+#include <iostream>
+#include <sstream>
+#include <fstream>
+#include <random>
+#include <cstdio>
+#include <mutex>
+#include <algorithm>
+#include <cstdlib>
+
+namespace distkv {
+
+// ============= Slot hashing =============
+
+uint16_t crc16(const char* data, size_t len) {
+    uint16_t crc = 0;
+    for (size_t i = 0; i < len; ++i) {
+        crc ^= static_cast<uint16_t>(static_cast<unsigned char>(data[i])) << 8;
+        for (int bit = 0; bit < 8; ++bit) {
+            crc = (crc & 0x8000) ? static_cast<uint16_t>((crc << 1) ^ 0x1021)
+                                 : static_cast<uint16_t>(crc << 1);
+        }
+    }
+    return crc;
+}
+
+int key_hash_slot(const std::string& key) {
+    // Hash only the first non-empty {hashtag}, if any
+    size_t open = key.find('{');
+    if (open != std::string::npos) {
+        size_t close = key.find('}', open + 1);
+        if (close != std::string::npos && close > open + 1) {
+            return crc16(key.data() + open + 1, close - open - 1) & (CLUSTER_SLOTS - 1);
+        }
+    }
+    return crc16(key.data(), key.size()) & (CLUSTER_SLOTS - 1);
+}
+
+bool parse_slot_owners(const std::string& nodes_text, std::vector<std::string>& owners) {
+    owners.assign(CLUSTER_SLOTS, "");
+    bool found = false;
+
+    // <id> <host:port> <flags> <master> <ping> <pong> <epoch> <link> <slots...>
+    std::istringstream lines(nodes_text);
+    std::string line;
+    while (std::getline(lines, line)) {
+        std::istringstream fields(line);
+        std::string id, address, skip;
+        if (!(fields >> id >> address) || address.rfind(':') == std::string::npos) {
+            continue;
+        }
+        for (int i = 0; i < 6; ++i) {
+            fields >> skip;
+        }
+        found = true;
+
+        std::string range;
+        while (fields >> range) {
+            if (range[0] == '[') {
+                continue;  // migration marker
+            }
+            size_t dash = range.find('-');
+            int start = std::atoi(range.c_str());
+            int stop = dash == std::string::npos ? start : std::atoi(range.c_str() + dash + 1);
+            for (int slot = std::max(start, 0); slot <= stop && slot < CLUSTER_SLOTS; ++slot) {
+                owners[slot] = address;
+            }
+        }
+    }
+    return found;
+}
+
+// ============= ClusterState =============
+
+ClusterState::ClusterState(const std::string& config_path)
+    : config_path_(config_path),
+      current_epoch_(0),
+      slot_owner_(CLUSTER_SLOTS) {}
+
+bool ClusterState::init(const std::string& host, int port) {
+    std::unique_lock<std::shared_mutex> lock(mutex_);
+
+    if (!config_path_.empty() && std::ifstream(config_path_)) {
+        // Never replace the identity of a node whose config is unreadable
+        if (!load_locked()) {
+            return false;
+        }
+        // The advertised address may change between restarts
+        ClusterNode& me = nodes_[myself_id_];
+        me.host = host;
+        me.port = port;
+        save_locked();
+        return true;
+    }
+
+    myself_id_ = generate_id();
+    ClusterNode me;
+    me.id = myself_id_;
+    me.host = host;
+    me.port = port;
+    nodes_[myself_id_] = me;
+    save_locked();
+    return true;
+}
+
+std::string ClusterState::myself_id() const {
+    std::shared_lock<std::shared_mutex> lock(mutex_);
+    return myself_id_;
+}
+
+ClusterNode ClusterState::myself() const {
+    std::shared_lock<std::shared_mutex> lock(mutex_);
+    return nodes_.at(myself_id_);
+}
+
+bool ClusterState::add_node(const std::string& id, const std::string& host, int port) {
+    if (id.empty() || host.empty() || port <= 0) {
+        return false;
+    }
+    std::unique_lock<std::shared_mutex> lock(mutex_);
+    ClusterNode& node = nodes_[id];
+    node.id = id;
+    node.host = host;
+    node.port = port;
+    save_locked();
+    return true;
+}
+
+bool ClusterState::forget_node(const std::string& id) {
+    std::unique_lock<std::shared_mutex> lock(mutex_);
+    if (id == myself_id_ || nodes_.erase(id) == 0) {
+        return false;
+    }
+    for (auto& owner : slot_owner_) {
+        if (owner == id) {
+            owner.clear();
+        }
+    }
+    for (auto it = migrating_.begin(); it != migrating_.end();) {
+        it = (it->second == id) ? migrating_.erase(it) : std::next(it);
+    }
+    for (auto it = importing_.begin(); it != importing_.end();) {
+        it = (it->second == id) ? importing_.erase(it) : std::next(it);
+    }
+    save_locked();
+    return true;
+}
+
+std::optional<ClusterNode> ClusterState::node(const std::string& id) const {
+    std::shared_lock<std::shared_mutex> lock(mutex_);
+    auto it = nodes_.find(id);
+    if (it == nodes_.end()) {
+        return std::nullopt;
+    }
+    return it->second;
+}
+
+std::vector<ClusterNode> ClusterState::nodes() const {
+    std::shared_lock<std::shared_mutex> lock(mutex_);
+    std::vector<ClusterNode> result;
+    for (const auto& entry : nodes_) {
+        result.push_back(entry.second);
+    }
+    return result;
+}
+
+bool ClusterState::add_slots(const std::vector<int>& slots) {
+    std::unique_lock<std::shared_mutex> lock(mutex_);
+    for (int slot : slots) {
+        if (slot < 0 || slot >= CLUSTER_SLOTS || !slot_owner_[slot].empty()) {
+            return false;
+        }
+    }
+    for (int slot : slots) {
+        slot_owner_[slot] = myself_id_;
+    }
+    save_locked();
+    return true;
+}
+
+bool ClusterState::del_slots(const std::vector<int>& slots) {
+    std::unique_lock<std::shared_mutex> lock(mutex_);
+    for (int slot : slots) {
+        if (slot < 0 || slot >= CLUSTER_SLOTS) {
+            return false;
+        }
+    }
+    for (int slot : slots) {
+        slot_owner_[slot].clear();
+        migrating_.erase(slot);
+        importing_.erase(slot);
+    }
+    save_locked();
+    return true;
+}
+
+bool ClusterState::assign_slots(const std::vector<int>& slots, const std::string& node_id) {
+    std::unique_lock<std::shared_mutex> lock(mutex_);
+    if (nodes_.count(node_id) == 0) {
+        return false;
+    }
+    for (int slot : slots) {
+        if (slot < 0 || slot >= CLUSTER_SLOTS) {
+            return false;
+        }
+    }
+    bool taken_over = false;
+    for (int slot : slots) {
+        if (node_id == myself_id_ && !slot_owner_[slot].empty() && slot_owner_[slot] != myself_id_) {
+            taken_over = true;
+        }
+        slot_owner_[slot] = node_id;
+        migrating_.erase(slot);
+        importing_.erase(slot);
+    }
+    if (taken_over) {
+        bump_epoch_locked();
+    }
+    save_locked();
+    return true;
+}
+
+bool ClusterState::set_migrating(int slot, const std::string& target_id) {
+    return set_migrating(std::vector<int>{slot}, target_id);
+}
+
+bool ClusterState::set_migrating(const std::vector<int>& slots, const std::string& target_id) {
+    std::unique_lock<std::shared_mutex> lock(mutex_);
+    if (target_id == myself_id_ || nodes_.count(target_id) == 0) {
+        return false;
+    }
+    for (int slot : slots) {
+        if (slot < 0 || slot >= CLUSTER_SLOTS || slot_owner_[slot] != myself_id_) {
+            return false;
+        }
+    }
+    for (int slot : slots) {
+        migrating_[slot] = target_id;
+    }
+    save_locked();
+    return true;
+}
+
+bool ClusterState::set_importing(int slot, const std::string& source_id) {
+    return set_importing(std::vector<int>{slot}, source_id);
+}
+
+bool ClusterState::set_importing(const std::vector<int>& slots, const std::string& source_id) {
+    std::unique_lock<std::shared_mutex> lock(mutex_);
+    if (source_id == myself_id_ || nodes_.count(source_id) == 0) {
+        return false;
+    }
+    for (int slot : slots) {
+        if (slot < 0 || slot >= CLUSTER_SLOTS || slot_owner_[slot] == myself_id_) {
+            return false;
+        }
+    }
+    for (int slot : slots) {
+        importing_[slot] = source_id;
+    }
+    save_locked();
+    return true;
+}
+
+void ClusterState::set_stable(int slot) {
+    std::unique_lock<std::shared_mutex> lock(mutex_);
+    if (migrating_.erase(slot) + importing_.erase(slot) > 0) {
+        save_locked();
+    }
+}
+
+SlotState ClusterState::slot_state(int slot) const {
+    std::shared_lock<std::shared_mutex> lock(mutex_);
+    SlotState state;
+    if (slot < 0 || slot >= CLUSTER_SLOTS) {
+        return state;
+    }
+
+    const std::string& owner = slot_owner_[slot];
+    auto it = owner.empty() ? nodes_.end() : nodes_.find(owner);
+    if (it != nodes_.end()) {
+        state.assigned = true;
+        state.mine = owner == myself_id_;
+        state.owner = it->second;
+    }
+
+    auto mig = migrating_.find(slot);
+    if (mig != migrating_.end()) {
+        auto target = nodes_.find(mig->second);
+        if (target != nodes_.end()) {
+            state.migrating_to = target->second;
+        }
+    }
+    state.importing = importing_.count(slot) > 0;
+    return state;
+}
+
+uint64_t ClusterState::current_epoch() const {
+    std::shared_lock<std::shared_mutex> lock(mutex_);
+    return current_epoch_;
+}
+
+void ClusterState::observe_epoch(uint64_t epoch) {
+    std::unique_lock<std::shared_mutex> lock(mutex_);
+    if (epoch > current_epoch_) {
+        current_epoch_ = epoch;
+        save_locked();
+    }
+}
+
+std::string ClusterState::slot_bitmap() const {
+    std::shared_lock<std::shared_mutex> lock(mutex_);
+    std::string bitmap(CLUSTER_SLOTS / 8, '\0');
+    for (int slot = 0; slot < CLUSTER_SLOTS; ++slot) {
+        if (slot_owner_[slot] == myself_id_) {
+            bitmap[slot / 8] |= static_cast<char>(1 << (slot % 8));
+        }
+    }
+    return bitmap;
+}
+
+bool ClusterState::apply_slot_claims(const std::string& id, uint64_t config_epoch,
+                                     const std::string& bitmap) {
+    std::unique_lock<std::shared_mutex> lock(mutex_);
+    auto sender = nodes_.find(id);
+    if (sender == nodes_.end() || id == myself_id_ || bitmap.size() != CLUSTER_SLOTS / 8) {
+        return false;
+    }
+
+    bool changed = sender->second.config_epoch != config_epoch;
+    sender->second.config_epoch = config_epoch;
+    for (int slot = 0; slot < CLUSTER_SLOTS; ++slot) {
+        if (!(static_cast<unsigned char>(bitmap[slot / 8]) & (1 << (slot % 8)))) {
+            continue;
+        }
+        const std::string& owner = slot_owner_[slot];
+        if (owner == id) {
+            continue;
+        }
+        auto current = owner.empty() ? nodes_.end() : nodes_.find(owner);
+        if (current != nodes_.end() && current->second.config_epoch >= config_epoch) {
+            continue;
+        }
+        slot_owner_[slot] = id;
+        migrating_.erase(slot);
+        importing_.erase(slot);
+        changed = true;
+    }
+    if (config_epoch > current_epoch_) {
+        current_epoch_ = config_epoch;
+        changed = true;
+    }
+    if (changed) {
+        save_locked();
+    }
+    return changed;
+}
+
+bool ClusterState::resolve_epoch_collision(const std::string& id, uint64_t config_epoch) {
+    std::unique_lock<std::shared_mutex> lock(mutex_);
+    if (config_epoch != nodes_.at(myself_id_).config_epoch || id >= myself_id_) {
+        return false;
+    }
+    bump_epoch_locked();
+    save_locked();
+    return true;
+}
+
+void ClusterState::set_node_health(const std::string& id, bool pfail, bool fail) {
+    std::unique_lock<std::shared_mutex> lock(mutex_);
+    auto it = nodes_.find(id);
+    if (it != nodes_.end()) {
+        it->second.pfail = pfail;
+        it->second.fail = fail;
+    }
+}
+
+void ClusterState::bump_epoch_locked() {
+    nodes_[myself_id_].config_epoch = ++current_epoch_;
+}
+
+std::string ClusterState::describe_nodes() const {
+    std::shared_lock<std::shared_mutex> lock(mutex_);
+    return describe_nodes_locked();
+}
+
+std::string ClusterState::info() const {
+    std::shared_lock<std::shared_mutex> lock(mutex_);
+    int assigned = 0;
+    bool owner_failed = false;
+    for (const auto& owner : slot_owner_) {
+        if (!owner.empty()) {
+            ++assigned;
+            owner_failed = owner_failed || nodes_.at(owner).fail;
+        }
+    }
+
+    bool ok = assigned == CLUSTER_SLOTS && !owner_failed;
+    std::ostringstream oss;
+    oss << "cluster_state:" << (ok ? "ok" : "fail") << "\r\n"
+        << "cluster_slots_assigned:" << assigned << "\r\n"
+        << "cluster_known_nodes:" << nodes_.size() << "\r\n"
+        << "cluster_current_epoch:" << current_epoch_ << "\r\n"
+        << "cluster_my_epoch:" << nodes_.at(myself_id_).config_epoch << "\r\n";
+    return oss.str();
+}
+
+int ClusterState::parse_slot(const std::string& text) {
+    try {
+        size_t used = 0;
+        int slot = std::stoi(text, &used);
+        if (used != text.size() || slot < 0 || slot >= CLUSTER_SLOTS) {
+            return -1;
+        }
+        return slot;
+    } catch (...) {
+        return -1;
+    }
+}
+
+bool ClusterState::parse_epoch(const std::string& text, uint64_t& epoch) {
+    // stoull would take a sign or leading blanks
+    if (text.empty() || text.find_first_not_of("0123456789") != std::string::npos) {
+        return false;
+    }
+    try {
+        epoch = std::stoull(text);
+        return true;
+    } catch (...) {
+        return false;
+    }
+}
+
+// One line per node:
+//   <id> <host>:<port> <flags> - 0 0 <config-epoch> connected <slots...>
+// Slots are listed as single numbers or start-end ranges; migration markers
+// are written as [slot->-<target id>] and [slot-<-<source id>].
+std::string ClusterState::describe_nodes_locked() const {
+    std::ostringstream oss;
+    for (const auto& entry : nodes_) {
+        const ClusterNode& node = entry.second;
+        oss << node.id << " " << node.address() << " "
+            << (node.id == myself_id_ ? "myself,master" : "master")
+            << (node.fail ? ",fail" : node.pfail ? ",fail?" : "")
+            << " - 0 0 " << node.config_epoch << " "
+            << (node.fail || node.pfail ? "disconnected" : "connected");
+
+        int slot = 0;
+        while (slot < CLUSTER_SLOTS) {
+            if (slot_owner_[slot] != node.id) {
+                ++slot;
+                continue;
+            }
+            int start = slot;
+            while (slot + 1 < CLUSTER_SLOTS && slot_owner_[slot + 1] == node.id) {
+                ++slot;
+            }
+            oss << " " << start;
+            if (slot > start) {
+                oss << "-" << slot;
+            }
+            ++slot;
+        }
+
+        if (node.id == myself_id_) {
+            for (const auto& m : migrating_) {
+                oss << " [" << m.first << "->-" << m.second << "]";
+            }
+            for (const auto& i : importing_) {
+                oss << " [" << i.first << "-<-" << i.second << "]";
+            }
+        }
+        oss << "\n";
+    }
+    return oss.str();
+}
+
+bool ClusterState::load_locked() {
+    std::ifstream file(config_path_);
+    if (!file) {
+        return false;
+    }
+
+    std::string line;
+    while (std::getline(file, line)) {
+        std::istringstream iss(line);
+        std::string id, addr, flags, master, ping, pong, epoch, link;
+        if (line.rfind("vars ", 0) == 0) {
+            std::string key;
+            iss >> key >> key >> current_epoch_;
+            continue;
+        }
+        if (!(iss >> id >> addr >> flags >> master >> ping >> pong >> epoch >> link)) {
+            continue;
+        }
+
+        size_t colon = addr.rfind(':');
+        if (colon == std::string::npos) {
+            std::cerr << "Cluster config: bad address '" << addr << "'\n";
+            return false;
+        }
+        ClusterNode node;
+        node.id = id;
+        node.host = addr.substr(0, colon);
+        node.port = std::atoi(addr.substr(colon + 1).c_str());
+        if (!parse_epoch(epoch, node.config_epoch)) {
+            std::cerr << "Cluster config: bad config epoch '" << epoch << "'\n";
+            return false;
+        }
+        nodes_[id] = node;
+        if (flags.find("myself") != std::string::npos) {
+            myself_id_ = id;
+        }
+
+        std::string token;
+        while (iss >> token) {
+            if (token.front() == '[') {
+                // [slot->-id] or [slot-<-id]
+                size_t arrow = token.find("->-");
+                bool outgoing = arrow != std::string::npos;
+                if (!outgoing) {
+                    arrow = token.find("-<-");
+                }
+                if (arrow == std::string::npos || token.back() != ']') {
+                    continue;
+                }
+                int slot = parse_slot(token.substr(1, arrow - 1));
+                std::string other = token.substr(arrow + 3, token.size() - arrow - 4);
+                if (slot >= 0) {
+                    (outgoing ? migrating_ : importing_)[slot] = other;
+                }
+                continue;
+            }
+
+            size_t dash = token.find('-');
+            int start = parse_slot(token.substr(0, dash));
+            int stop = dash == std::string::npos ? start : parse_slot(token.substr(dash + 1));
+            if (start < 0 || stop < start) {
+                std::cerr << "Cluster config: bad slot range '" << token << "'\n";
+                return false;
+            }
+            for (int slot = start; slot <= stop; ++slot) {
+                slot_owner_[slot] = id;
+            }
+        }
+    }
+
+    if (myself_id_.empty()) {
+        std::cerr << "Cluster config: no 'myself' node in " << config_path_ << "\n";
+        return false;
+    }
+    return true;
+}
+
+void ClusterState::save_locked() const {
+    if (config_path_.empty()) {
+        return;
+    }
+
+    std::string tmp = config_path_ + ".tmp";
+    {
+        std::ofstream file(tmp, std::ios::trunc);
+        if (!file) {
+            std::cerr << "Cluster config: cannot write " << tmp << "\n";
+            return;
+        }
+        file << describe_nodes_locked();
+        file << "vars currentEpoch " << current_epoch_ << "\n";
+    }
+#ifdef _WIN32
+    std::remove(config_path_.c_str());
+#endif
+    std::rename(tmp.c_str(), config_path_.c_str());
+}
+
+std::string ClusterState::generate_id() {
+    static const char hex[] = "0123456789abcdef";
+    std::random_device rd;
+    std::mt19937_64 rng((static_cast<uint64_t>(rd()) << 32) ^ rd());
+    std::string id;
+    for (int i = 0; i < 40; ++i) {
+        id += hex[rng() & 0xF];
+    }
+    return id;
+}
+
+} // namespace distkv
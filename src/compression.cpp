@@ -0,0 +1,166 @@
+#include "compression.h"
+#include <cstring>
+#include <cstdint>
+#include <vector>
+
+namespace distkv {
+
+namespace {
+
+constexpr int HASH_BITS = 14;
+constexpr size_t MIN_MATCH = 4;
+constexpr size_t MAX_OFFSET = 65535;
+
+uint32_t read32(const unsigned char* p) {
+    uint32_t v;
+    std::memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+uint32_t hash32(uint32_t v) {
+    return (v * 2654435761u) >> (32 - HASH_BITS);
+}
+
+// Lengths of 15 or more spill into extra bytes
+void write_length(std::string& out, size_t len) {
+    len -= 15;
+    while (len >= 255) {
+        out += static_cast<char>(255);
+        len -= 255;
+    }
+    out += static_cast<char>(len);
+}
+
+bool read_length(const unsigned char*& ip, const unsigned char* end, size_t& len) {
+    unsigned char b;
+    do {
+        if (ip >= end) {
+            return false;
+        }
+        b = *ip++;
+        len += b;
+    } while (b == 255);
+    return true;
+}
+
+void emit_sequence(std::string& out, const unsigned char* literals, size_t literal_len,
+                   size_t offset, size_t match_len) {
+    size_t match_code = match_len ? match_len - MIN_MATCH : 0;
+    unsigned char token = static_cast<unsigned char>(
+        ((literal_len < 15 ? literal_len : 15) << 4) | (match_code < 15 ? match_code : 15));
+    out += static_cast<char>(token);
+    if (literal_len >= 15) {
+        write_length(out, literal_len);
+    }
+    out.append(reinterpret_cast<const char*>(literals), literal_len);
+
+    if (match_len) {
+        out += static_cast<char>(offset & 0xFF);
+        out += static_cast<char>(offset >> 8);
+        if (match_code >= 15) {
+            write_length(out, match_code);
+        }
+    }
+}
+
+} // namespace
+
+std::string Compression::compress(const char* data, size_t len) {
+    const unsigned char* src = reinterpret_cast<const unsigned char*>(data);
+    std::string out;
+    out.reserve(len / 2 + 16);
+
+    std::vector<uint32_t> table(size_t(1) << HASH_BITS, 0);
+    size_t anchor = 0;   // start of pending literals
+    size_t ip = 0;
+    size_t misses = 0;   // skip faster through incompressible data
+
+    // Positions are stored +1 so 0 means "empty slot"
+    while (ip + MIN_MATCH <= len) {
+        uint32_t seq = read32(src + ip);
+        uint32_t h = hash32(seq);
+        size_t candidate = table[h];
+        table[h] = static_cast<uint32_t>(ip + 1);
+
+        if (candidate == 0 || ip - (candidate - 1) > MAX_OFFSET ||
+            read32(src + candidate - 1) != seq) {
+            ip += 1 + (misses++ >> 6);
+            continue;
+        }
+        misses = 0;
+
+        size_t ref = candidate - 1;
+        size_t match_len = MIN_MATCH;
+        while (ip + match_len < len && src[ref + match_len] == src[ip + match_len]) {
+            ++match_len;
+        }
+
+        emit_sequence(out, src + anchor, ip - anchor, ip - ref, match_len);
+        ip += match_len;
+        anchor = ip;
+    }
+
+    if (anchor < len) {
+        emit_sequence(out, src + anchor, len - anchor, 0, 0);
+    }
+    return out;
+}
+
+bool Compression::decompress(const char* data, size_t len, size_t raw_len, std::string& out) {
+    const unsigned char* ip = reinterpret_cast<const unsigned char*>(data);
+    const unsigned char* end = ip + len;
+    size_t base = out.size();
+    out.resize(base + raw_len);
+    char* dst = &out[0] + base;
+    size_t op = 0;
+
+    while (op < raw_len) {
+        if (ip >= end) {
+            return false;
+        }
+        unsigned char token = *ip++;
+
+        size_t literal_len = token >> 4;
+        if (literal_len == 15 && !read_length(ip, end, literal_len)) {
+            return false;
+        }
+        if (literal_len > static_cast<size_t>(end - ip) || literal_len > raw_len - op) {
+            return false;
+        }
+        std::memcpy(dst + op, ip, literal_len);
+        ip += literal_len;
+        op += literal_len;
+
+        if (op == raw_len) {
+            break;
+        }
+
+        if (end - ip < 2) {
+            return false;
+        }
+        size_t offset = ip[0] | (static_cast<size_t>(ip[1]) << 8);
+        ip += 2;
+        size_t match_len = token & 0x0F;
+        if (match_len == 15 && !read_length(ip, end, match_len)) {
+            return false;
+        }
+        match_len += MIN_MATCH;
+
+        if (offset == 0 || offset > op || match_len > raw_len - op) {
+            return false;
+        }
+        if (offset >= match_len) {
+            std::memcpy(dst + op, dst + op - offset, match_len);
+        } else {
+            // Overlapping match repeats the last offset bytes
+            for (size_t i = 0; i < match_len; ++i) {
+                dst[op + i] = dst[op + i - offset];
+            }
+        }
+        op += match_len;
+    }
+
+    return ip == end;
+}
+
+} // namespace distkv
@@ -0,0 +1,545 @@
+#include "gossip.h"
+#include <iostream>
+#include <chrono>
+#include <algorithm>
+#include <cstring>
+
+// Platform-specific includes
+#ifdef _WIN32
+    #include <winsock2.h>
+    #include <ws2tcpip.h>
+    #pragma comment(lib, "ws2_32.lib")
+    typedef int socklen_t;
+    #define CLOSE_SOCKET closesocket
+#else
+    #include <sys/socket.h>
+    #include <sys/select.h>
+    #include <netinet/in.h>
+    #include <arpa/inet.h>
+    #include <unistd.h>
+    #define CLOSE_SOCKET close
+    #define INVALID_SOCKET -1
+#endif
+
+namespace distkv {
+
+namespace {
+
+// Message layout:
+//   "DKGB" u8 type
+//   str sender_id, str sender_host, u16 sender_port
+//   u64 current_epoch, u64 config_epoch
+//   u8 slot encoding: 0 = u16 count + (u16 start, u16 end) ranges,
+//                     1 = CLUSTER_SLOTS / 8 byte bitmap
+//   u8 entry count, entries: str id, str host, u16 port, u8 flags
+//   str failed_id
+// Strings are a u8 length followed by the bytes.
+const char MAGIC[] = "DKGB";
+constexpr uint8_t ENTRY_PFAIL = 1;
+constexpr uint8_t ENTRY_FAIL = 2;
+
+int64_t now_ms() {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void put_u8(std::string& out, uint8_t v) {
+    out += static_cast<char>(v);
+}
+
+void put_u16(std::string& out, uint16_t v) {
+    out += static_cast<char>(v & 0xFF);
+    out += static_cast<char>(v >> 8);
+}
+
+void put_u64(std::string& out, uint64_t v) {
+    for (int i = 0; i < 8; ++i) {
+        out += static_cast<char>((v >> (8 * i)) & 0xFF);
+    }
+}
+
+void put_str(std::string& out, const std::string& s) {
+    size_t len = std::min<size_t>(s.size(), 255);
+    put_u8(out, static_cast<uint8_t>(len));
+    out.append(s, 0, len);
+}
+
+// Bounds-checked reader over a datagram
+class Reader {
+public:
+    explicit Reader(const std::string& data) : data_(data), pos_(0) {}
+
+    bool u8(uint8_t& v) {
+        if (pos_ + 1 > data_.size()) return false;
+        v = static_cast<uint8_t>(data_[pos_++]);
+        return true;
+    }
+    bool u16(uint16_t& v) {
+        if (pos_ + 2 > data_.size()) return false;
+        v = static_cast<uint16_t>(static_cast<uint8_t>(data_[pos_]) |
+                                  (static_cast<uint8_t>(data_[pos_ + 1]) << 8));
+        pos_ += 2;
+        return true;
+    }
+    bool u64(uint64_t& v) {
+        if (pos_ + 8 > data_.size()) return false;
+        v = 0;
+        for (int i = 0; i < 8; ++i) {
+            v |= static_cast<uint64_t>(static_cast<uint8_t>(data_[pos_ + i])) << (8 * i);
+        }
+        pos_ += 8;
+        return true;
+    }
+    bool bytes(size_t n, std::string& out) {
+        if (pos_ + n > data_.size()) return false;
+        out.assign(data_, pos_, n);
+        pos_ += n;
+        return true;
+    }
+    bool str(std::string& out) {
+        uint8_t len;
+        return u8(len) && bytes(len, out);
+    }
+    bool done() const { return pos_ == data_.size(); }
+
+private:
+    const std::string& data_;
+    size_t pos_;
+};
+
+bool slot_set(const std::string& bitmap, int slot) {
+    return static_cast<unsigned char>(bitmap[slot / 8]) & (1 << (slot % 8));
+}
+
+} // namespace
+
+// ============= GossipMessage =============
+
+std::string GossipMessage::encode() const {
+    std::string out(MAGIC, 4);
+    put_u8(out, type);
+    put_str(out, sender_id);
+    put_str(out, sender_host);
+    put_u16(out, static_cast<uint16_t>(sender_port));
+    put_u64(out, current_epoch);
+    put_u64(out, config_epoch);
+
+    // Slots are usually a few contiguous ranges; fall back to the bitmap
+    // when ranges would be larger
+    std::string ranges;
+    uint16_t count = 0;
+    if (slots.size() == CLUSTER_SLOTS / 8) {
+        int slot = 0;
+        while (slot < CLUSTER_SLOTS && ranges.size() < slots.size()) {
+            if (!slot_set(slots, slot)) {
+                ++slot;
+                continue;
+            }
+            int start = slot;
+            while (slot + 1 < CLUSTER_SLOTS && slot_set(slots, slot + 1)) {
+                ++slot;
+            }
+            put_u16(ranges, static_cast<uint16_t>(start));
+            put_u16(ranges, static_cast<uint16_t>(slot));
+            ++count;
+            ++slot;
+        }
+    }
+    if (ranges.size() < slots.size() || slots.size() != CLUSTER_SLOTS / 8) {
+        put_u8(out, 0);
+        put_u16(out, count);
+        out += ranges;
+    } else {
+        put_u8(out, 1);
+        out += slots;
+    }
+
+    put_u8(out, static_cast<uint8_t>(std::min<size_t>(gossip.size(), 255)));
+    for (size_t i = 0; i < gossip.size() && i < 255; ++i) {
+        const Entry& entry = gossip[i];
+        put_str(out, entry.id);
+        put_str(out, entry.host);
+        put_u16(out, static_cast<uint16_t>(entry.port));
+        put_u8(out, (entry.pfail ? ENTRY_PFAIL : 0) | (entry.fail ? ENTRY_FAIL : 0));
+    }
+    put_str(out, failed_id);
+    return out;
+}
+
+bool GossipMessage::decode(const std::string& data, GossipMessage& msg) {
+    if (data.size() < 5 || data.compare(0, 4, MAGIC, 4) != 0) {
+        return false;
+    }
+    Reader in(data);
+    std::string magic;
+    uint8_t type, encoding, entries;
+    uint16_t port;
+    if (!in.bytes(4, magic) || !in.u8(type) || type < PING || type > FAIL ||
+        !in.str(msg.sender_id) || !in.str(msg.sender_host) || !in.u16(port) ||
+        !in.u64(msg.current_epoch) || !in.u64(msg.config_epoch) || !in.u8(encoding)) {
+        return false;
+    }
+    msg.type = static_cast<Type>(type);
+    msg.sender_port = port;
+
+    if (encoding == 1) {
+        if (!in.bytes(CLUSTER_SLOTS / 8, msg.slots)) {
+            return false;
+        }
+    } else {
+        uint16_t count;
+        if (encoding != 0 || !in.u16(count)) {
+            return false;
+        }
+        msg.slots.assign(CLUSTER_SLOTS / 8, '\0');
+        for (uint16_t i = 0; i < count; ++i) {
+            uint16_t start, stop;
+            if (!in.u16(start) || !in.u16(stop) || stop < start || stop >= CLUSTER_SLOTS) {
+                return false;
+            }
+            for (int slot = start; slot <= stop; ++slot) {
+                msg.slots[slot / 8] |= static_cast<char>(1 << (slot % 8));
+            }
+        }
+    }
+
+    if (!in.u8(entries)) {
+        return false;
+    }
+    msg.gossip.resize(entries);
+    for (auto& entry : msg.gossip) {
+        uint8_t flags;
+        if (!in.str(entry.id) || !in.str(entry.host) || !in.u16(port) || !in.u8(flags)) {
+            return false;
+        }
+        entry.port = port;
+        entry.pfail = (flags & ENTRY_PFAIL) != 0;
+        entry.fail = (flags & ENTRY_FAIL) != 0;
+    }
+    return in.str(msg.failed_id) && in.done();
+}
+
+// ============= ClusterBus =============
+
+ClusterBus::ClusterBus(ClusterState& cluster, const GossipConfig& config)
+    : cluster_(cluster),
+      config_(config),
+      fd_(INVALID_SOCKET),
+      running_(false),
+      rng_(std::random_device{}()),
+      messages_sent_(0),
+      messages_received_(0) {}
+
+ClusterBus::~ClusterBus() {
+    stop();
+}
+
+bool ClusterBus::start() {
+    int port = cluster_.myself().port + CLUSTER_BUS_PORT_OFFSET;
+    fd_ = socket(AF_INET, SOCK_DGRAM, 0);
+    if (fd_ == INVALID_SOCKET) {
+        std::cerr << "Cluster bus: failed to create socket\n";
+        return false;
+    }
+
+    struct sockaddr_in addr;
+    std::memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = INADDR_ANY;
+    addr.sin_port = htons(port);
+    if (bind(fd_, (struct sockaddr*)&addr, sizeof(addr)) < 0) {
+        std::cerr << "Cluster bus: failed to bind UDP port " << port << "\n";
+        CLOSE_SOCKET(fd_);
+        fd_ = INVALID_SOCKET;
+        return false;
+    }
+
+    running_ = true;
+    thread_ = std::thread(&ClusterBus::run, this);
+    return true;
+}
+
+void ClusterBus::stop() {
+    if (!running_) {
+        return;
+    }
+    running_ = false;
+    if (thread_.joinable()) {
+        thread_.join();
+    }
+    CLOSE_SOCKET(fd_);
+    fd_ = INVALID_SOCKET;
+}
+
+bool ClusterBus::meet(const std::string& host, int port) {
+    if (host.empty() || port <= 0 || port + CLUSTER_BUS_PORT_OFFSET > 65535) {
+        return false;
+    }
+    std::string ip = (host == "localhost") ? "127.0.0.1" : host;
+    struct in_addr probe;
+    if (inet_pton(AF_INET, ip.c_str(), &probe) <= 0) {
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    // Resent every tick until the node answers or the timeout passes
+    pending_meets_[ip + ":" + std::to_string(port)] = now_ms() + config_.node_timeout_ms;
+    send_to(ip, port, make_message(GossipMessage::MEET));
+    return true;
+}
+
+void ClusterBus::run() {
+    char buffer[65536];
+    int64_t next_tick = now_ms();
+
+    while (running_) {
+        int64_t wait = std::max<int64_t>(0, next_tick - now_ms());
+        fd_set readable;
+        FD_ZERO(&readable);
+        FD_SET(fd_, &readable);
+        struct timeval tv;
+        tv.tv_sec = static_cast<long>(wait / 1000);
+        tv.tv_usec = static_cast<long>((wait % 1000) * 1000);
+
+        if (select(fd_ + 1, &readable, nullptr, nullptr, &tv) > 0) {
+#ifdef _WIN32
+            int n = recvfrom(fd_, buffer, sizeof(buffer), 0, nullptr, nullptr);
+#else
+            ssize_t n = recvfrom(fd_, buffer, sizeof(buffer), 0, nullptr, nullptr);
+#endif
+            GossipMessage msg;
+            if (n > 0 && GossipMessage::decode(std::string(buffer, static_cast<size_t>(n)), msg)) {
+                ++messages_received_;
+                handle(msg);
+            }
+        }
+
+        if (now_ms() >= next_tick) {
+            tick();
+            next_tick = now_ms() + config_.tick_ms;
+        }
+    }
+}
+
+void ClusterBus::tick() {
+    int64_t now = now_ms();
+    std::string myself = cluster_.myself_id();
+    std::vector<ClusterNode> nodes = cluster_.nodes();
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    for (auto it = pending_meets_.begin(); it != pending_meets_.end();) {
+        if (now > it->second) {
+            it = pending_meets_.erase(it);
+            continue;
+        }
+        size_t colon = it->first.rfind(':');
+        send_to(it->first.substr(0, colon), std::atoi(it->first.c_str() + colon + 1),
+                make_message(GossipMessage::MEET));
+        ++it;
+    }
+
+    // Forget state of nodes that were removed from the topology
+    std::map<std::string, const ClusterNode*> known;
+    for (const auto& node : nodes) {
+        if (node.id != myself) {
+            known[node.id] = &node;
+        }
+    }
+    for (auto it = peers_.begin(); it != peers_.end();) {
+        it = known.count(it->first) ? std::next(it) : peers_.erase(it);
+    }
+
+    // Ping the peers we pinged least recently, plus any peer we have not
+    // heard from for half the node timeout
+    std::vector<std::pair<int64_t, std::string>> order;
+    for (const auto& entry : known) {
+        PeerState& peer = peers_[entry.first];
+        if (peer.pong_ms == 0) {
+            peer.pong_ms = now;  // timeouts start when we learn about a node
+        }
+        order.emplace_back(peer.last_ping_ms, entry.first);
+    }
+    std::sort(order.begin(), order.end());
+
+    for (size_t i = 0; i < order.size(); ++i) {
+        const std::string& id = order[i].second;
+        PeerState& peer = peers_[id];
+        bool overdue = peer.ping_sent_ms == 0 && now - peer.pong_ms > config_.node_timeout_ms / 2;
+        if (i >= config_.fanout && !overdue) {
+            continue;
+        }
+        if (peer.ping_sent_ms == 0) {
+            peer.ping_sent_ms = now;
+        }
+        peer.last_ping_ms = now;
+        send_to(known[id]->host, known[id]->port, make_message(GossipMessage::PING));
+    }
+
+    // A ping unanswered for the node timeout makes the peer PFAIL
+    for (auto& entry : peers_) {
+        PeerState& peer = entry.second;
+        if (!peer.pfail && peer.ping_sent_ms != 0 &&
+            now - peer.ping_sent_ms > config_.node_timeout_ms) {
+            set_health(entry.first, peer, true, peer.fail);
+        }
+        check_failure(entry.first, now);
+    }
+}
+
+void ClusterBus::handle(const GossipMessage& msg) {
+    int64_t now = now_ms();
+    std::string myself = cluster_.myself_id();
+    if (msg.sender_id == myself) {
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!cluster_.node(msg.sender_id)) {
+        // Unknown nodes must be introduced with MEET, from either side
+        std::string address = msg.sender_host + ":" + std::to_string(msg.sender_port);
+        bool met = msg.type == GossipMessage::PONG && pending_meets_.erase(address) > 0;
+        if (msg.type != GossipMessage::MEET && !met) {
+            return;
+        }
+        cluster_.add_node(msg.sender_id, msg.sender_host, msg.sender_port);
+        std::cout << "Cluster bus: node " << msg.sender_id << " joined at " << address << "\n";
+    }
+
+    // Any message proves the sender is alive
+    PeerState& sender = peers_[msg.sender_id];
+    sender.pong_ms = now;
+    sender.ping_sent_ms = 0;
+    if (sender.pfail || sender.fail) {
+        set_health(msg.sender_id, sender, false, false);
+    }
+
+    // Epochs and slot ownership
+    cluster_.observe_epoch(msg.current_epoch);
+    cluster_.resolve_epoch_collision(msg.sender_id, msg.config_epoch);
+    cluster_.apply_slot_claims(msg.sender_id, msg.config_epoch, msg.slots);
+
+    // What the sender knows about other nodes
+    for (const auto& entry : msg.gossip) {
+        if (entry.id == myself || entry.id == msg.sender_id) {
+            continue;
+        }
+        if (!cluster_.node(entry.id)) {
+            cluster_.add_node(entry.id, entry.host, entry.port);
+            continue;
+        }
+        PeerState& peer = peers_[entry.id];
+        if (entry.pfail || entry.fail) {
+            peer.failure_reports[msg.sender_id] = now;
+            check_failure(entry.id, now);
+        } else {
+            peer.failure_reports.erase(msg.sender_id);
+        }
+    }
+
+    if (msg.type == GossipMessage::FAIL && msg.failed_id != myself && cluster_.node(msg.failed_id)) {
+        PeerState& peer = peers_[msg.failed_id];
+        if (!peer.fail) {
+            set_health(msg.failed_id, peer, peer.pfail, true);
+        }
+    }
+
+    if (msg.type == GossipMessage::PING || msg.type == GossipMessage::MEET) {
+        send_to(msg.sender_host, msg.sender_port, make_message(GossipMessage::PONG));
+    }
+}
+
+GossipMessage ClusterBus::make_message(GossipMessage::Type type) {
+    ClusterNode me = cluster_.myself();
+    GossipMessage msg;
+    msg.type = type;
+    msg.sender_id = me.id;
+    msg.sender_host = me.host;
+    msg.sender_port = me.port;
+    msg.current_epoch = cluster_.current_epoch();
+    msg.config_epoch = me.config_epoch;
+    msg.slots = cluster_.slot_bitmap();
+
+    // A few random nodes, plus failing ones so reports reach a majority
+    std::vector<ClusterNode> others;
+    std::vector<ClusterNode> failing;
+    for (const auto& node : cluster_.nodes()) {
+        if (node.id == me.id) {
+            continue;
+        }
+        (node.pfail || node.fail ? failing : others).push_back(node);
+    }
+    std::shuffle(others.begin(), others.end(), rng_);
+    std::shuffle(failing.begin(), failing.end(), rng_);
+    others.resize(std::min(others.size(), config_.gossip_entries));
+    failing.resize(std::min(failing.size(), config_.gossip_entries));
+    others.insert(others.end(), failing.begin(), failing.end());
+
+    for (const auto& node : others) {
+        GossipMessage::Entry entry;
+        entry.id = node.id;
+        entry.host = node.host;
+        entry.port = node.port;
+        entry.pfail = node.pfail;
+        entry.fail = node.fail;
+        msg.gossip.push_back(entry);
+    }
+    return msg;
+}
+
+void ClusterBus::send_to(const std::string& host, int port, const GossipMessage& msg) {
+    struct sockaddr_in addr;
+    std::memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(static_cast<uint16_t>(port + CLUSTER_BUS_PORT_OFFSET));
+    std::string ip = (host == "localhost") ? "127.0.0.1" : host;
+    if (inet_pton(AF_INET, ip.c_str(), &addr.sin_addr) <= 0) {
+        return;
+    }
+
+    std::string data = msg.encode();
+    sendto(fd_, data.data(), static_cast<int>(data.size()), 0, (struct sockaddr*)&addr, sizeof(addr));
+    ++messages_sent_;
+}
+
+void ClusterBus::set_health(const std::string& id, PeerState& peer, bool pfail, bool fail) {
+    if (peer.fail != fail) {
+        std::cout << "Cluster bus: node " << id << (fail ? " marked FAIL" : " is reachable again")
+                  << "\n";
+    }
+    peer.pfail = pfail;
+    peer.fail = fail;
+    if (!pfail && !fail) {
+        peer.failure_reports.clear();
+    }
+    cluster_.set_node_health(id, pfail, fail);
+}
+
+void ClusterBus::check_failure(const std::string& id, int64_t now) {
+    PeerState& peer = peers_[id];
+    if (!peer.pfail || peer.fail) {
+        return;
+    }
+
+    // Reports older than twice the node timeout no longer count
+    for (auto it = peer.failure_reports.begin(); it != peer.failure_reports.end();) {
+        it = (now - it->second > 2 * config_.node_timeout_ms) ? peer.failure_reports.erase(it)
+                                                               : std::next(it);
+    }
+
+    // Our own PFAIL plus the reports must be a majority of all nodes
+    std::vector<ClusterNode> nodes = cluster_.nodes();
+    if (peer.failure_reports.size() + 1 < nodes.size() / 2 + 1) {
+        return;
+    }
+
+    set_health(id, peer, true, true);
+    GossipMessage fail = make_message(GossipMessage::FAIL);
+    fail.failed_id = id;
+    for (const auto& node : nodes) {
+        if (node.id != id && node.id != cluster_.myself_id()) {
+            send_to(node.host, node.port, fail);
+        }
+    }
+}
+
+} // namespace distkv
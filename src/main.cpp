@@ -18,24 +18,104 @@ void signal_handler(int signal) {
     }
 }
 
+// Parse "id@host:port,..." (client ports) into Raft peers
+bool parse_raft_peers(const std::string& spec, std::vector<RaftPeer>& peers) {
+    size_t start = 0;
+    while (start < spec.size()) {
+        size_t end = spec.find(',', start);
+        if (end == std::string::npos) {
+            end = spec.size();
+        }
+        std::string item = spec.substr(start, end - start);
+        size_t at = item.find('@');
+        size_t colon = item.rfind(':');
+        if (at == std::string::npos || colon == std::string::npos || colon < at) {
+            return false;
+        }
+
+        RaftPeer peer;
+        peer.id = std::atoi(item.substr(0, at).c_str());
+        peer.host = item.substr(at + 1, colon - at - 1);
+        peer.port = std::atoi(item.substr(colon + 1).c_str()) + RAFT_PORT_OFFSET;
+        peers.push_back(peer);
+        start = end + 1;
+    }
+    return true;
+}
+
 int main(int argc, char* argv[]) {
     int port = 6379;  // Default Redis port
+    std::string unix_socket;
     std::string snapshot_file = "data/dump.rdb";
+    std::string master_host;
+    int master_port = 0;
+    bool repl_compress = false;
+    bool cluster_enabled = false;
+    std::string cluster_config;
+    std::string cluster_host = "127.0.0.1";
+    GossipConfig gossip_config;
+    RaftConfig raft_config;
+    bool raft_enabled = false;
 
     // Parse command line arguments
     for (int i = 1; i < argc; ++i) {
         if (std::strcmp(argv[i], "--port") == 0 && i + 1 < argc) {
             port = std::atoi(argv[i + 1]);
             ++i;
+        } else if (std::strcmp(argv[i], "--unix-socket") == 0 && i + 1 < argc) {
+            unix_socket = argv[i + 1];
+            ++i;
         } else if (std::strcmp(argv[i], "--snapshot") == 0 && i + 1 < argc) {
             snapshot_file = argv[i + 1];
             ++i;
+        } else if (std::strcmp(argv[i], "--replicaof") == 0 && i + 2 < argc) {
+            master_host = argv[i + 1];
+            master_port = std::atoi(argv[i + 2]);
+            i += 2;
+        } else if (std::strcmp(argv[i], "--repl-compress") == 0) {
+            repl_compress = true;
+        } else if (std::strcmp(argv[i], "--cluster") == 0) {
+            cluster_enabled = true;
+        } else if (std::strcmp(argv[i], "--cluster-config") == 0 && i + 1 < argc) {
+            cluster_config = argv[i + 1];
+            ++i;
+        } else if (std::strcmp(argv[i], "--cluster-host") == 0 && i + 1 < argc) {
+            cluster_host = argv[i + 1];
+            ++i;
+        } else if (std::strcmp(argv[i], "--cluster-node-timeout") == 0 && i + 1 < argc) {
+            gossip_config.node_timeout_ms = std::atoi(argv[i + 1]);
+            ++i;
+        } else if (std::strcmp(argv[i], "--raft-id") == 0 && i + 1 < argc) {
+            raft_config.node_id = std::atoi(argv[i + 1]);
+            raft_enabled = true;
+            ++i;
+        } else if (std::strcmp(argv[i], "--raft-peers") == 0 && i + 1 < argc) {
+            if (!parse_raft_peers(argv[i + 1], raft_config.peers)) {
+                std::cerr << "Invalid --raft-peers, expected id@host:port[,...]\n";
+                return 1;
+            }
+            ++i;
+        } else if (std::strcmp(argv[i], "--raft-dir") == 0 && i + 1 < argc) {
+            raft_config.data_dir = argv[i + 1];
+            ++i;
         } else if (std::strcmp(argv[i], "--help") == 0) {
             std::cout << "DistKV - Distributed Key-Value Store\n\n";
             std::cout << "Usage: " << argv[0] << " [options]\n\n";
             std::cout << "Options:\n";
             std::cout << "  --port <port>         Port to listen on (default: 6379)\n";
+            std::cout << "  --unix-socket <path>  Also accept local clients on a Unix domain socket\n";
             std::cout << "  --snapshot <file>     Snapshot file path (default: data/dump.rdb)\n";
+            std::cout << "  --replicaof <host> <port>  Run as a read-only replica of a primary\n";
+            std::cout << "  --repl-compress       Ask the primary for a compressed replication stream\n";
+            std::cout << "  --cluster             Enable cluster mode (hash slots)\n";
+            std::cout << "  --cluster-config <file>  Cluster topology file (default: nodes-<port>.conf)\n";
+            std::cout << "  --cluster-host <host> Address announced to clients and other nodes\n";
+            std::cout << "                        (default: 127.0.0.1)\n";
+            std::cout << "  --cluster-node-timeout <ms>  Mark unreachable nodes failed after this (default: 5000)\n";
+            std::cout << "  --raft-id <id>        Enable Raft mode with this node id\n";
+            std::cout << "  --raft-peers <list>   Other members as id@host:port,... (client ports;\n";
+            std::cout << "                        Raft uses port + " << RAFT_PORT_OFFSET << ")\n";
+            std::cout << "  --raft-dir <dir>      Raft log directory (default: data/raft-<id>)\n";
             std::cout << "  --help                Show this help message\n";
             return 0;
         }
@@ -59,12 +139,52 @@ Distributed Key-Value Store v1.0.0
     std::signal(SIGINT, signal_handler);
     std::signal(SIGTERM, signal_handler);
 
-    // Try to load snapshot
-    std::cout << "Attempting to load snapshot from " << snapshot_file << "...\n";
-    if (Persistence::load_snapshot(*server.get_storage(), snapshot_file)) {
-        std::cout << "Snapshot loaded successfully.\n";
+    if (!unix_socket.empty() && !server.set_unix_socket(unix_socket)) {
+        std::cerr << "Unix domain sockets are not supported on this platform\n";
+        return 1;
+    }
+
+    if (!master_host.empty()) {
+        if (raft_enabled) {
+            std::cerr << "--replicaof cannot be combined with Raft mode\n";
+            return 1;
+        }
+        server.set_replica_of(master_host, master_port, repl_compress);
+    }
+
+    if (cluster_enabled) {
+        if (raft_enabled) {
+            std::cerr << "--cluster cannot be combined with Raft mode\n";
+            return 1;
+        }
+        if (cluster_config.empty()) {
+            cluster_config = "nodes-" + std::to_string(port) + ".conf";
+        }
+        if (!server.enable_cluster(cluster_config, cluster_host, gossip_config)) {
+            std::cerr << "Failed to load cluster config " << cluster_config << "\n";
+            return 1;
+        }
+        std::cout << "Cluster mode, node id " << server.get_cluster()->myself_id() << "\n";
+    }
+
+    if (raft_enabled) {
+        // State is rebuilt from the Raft snapshot and log
+        raft_config.port = port + RAFT_PORT_OFFSET;
+        if (raft_config.data_dir.empty()) {
+            raft_config.data_dir = "data/raft-" + std::to_string(raft_config.node_id);
+        }
+        if (!server.enable_raft(raft_config)) {
+            std::cerr << "Failed to set up Raft data directory " << raft_config.data_dir << "\n";
+            return 1;
+        }
     } else {
-        std::cout << "No snapshot found or failed to load. Starting with empty database.\n";
+        // Try to load snapshot
+        std::cout << "Attempting to load snapshot from " << snapshot_file << "...\n";
+        if (Persistence::load_snapshot(*server.get_storage(), snapshot_file)) {
+            std::cout << "Snapshot loaded successfully.\n";
+        } else {
+            std::cout << "No snapshot found or failed to load. Starting with empty database.\n";
+        }
     }
 
     // Start server (blocking)
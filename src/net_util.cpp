@@ -0,0 +1,246 @@
+#include "net_util.h"
+#include <cstring>
+#include <cerrno>
+
+// Platform-specific includes
+#ifdef _WIN32
+    #include <winsock2.h>
+    #include <ws2tcpip.h>
+    #pragma comment(lib, "ws2_32.lib")
+    #define CLOSE_SOCKET closesocket
+    #define SHUT_RDWR SD_BOTH
+#else
+    #include <sys/socket.h>
+    #include <netinet/in.h>
+    #include <netinet/tcp.h>
+    #include <arpa/inet.h>
+    #include <unistd.h>
+    #define CLOSE_SOCKET close
+    #define INVALID_SOCKET -1
+#endif
+
+namespace distkv {
+namespace net {
+
+int connect_tcp(const std::string& host, int port) {
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    if (fd == INVALID_SOCKET) {
+        return -1;
+    }
+
+    struct sockaddr_in addr;
+    std::memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+
+    std::string ip = (host == "localhost") ? "127.0.0.1" : host;
+    if (inet_pton(AF_INET, ip.c_str(), &addr.sin_addr) <= 0) {
+        CLOSE_SOCKET(fd);
+        return -1;
+    }
+
+    if (::connect(fd, (struct sockaddr*)&addr, sizeof(addr)) < 0) {
+        CLOSE_SOCKET(fd);
+        return -1;
+    }
+
+    // Internal links carry small latency-sensitive messages
+    set_nodelay(fd);
+    return fd;
+}
+
+void set_nodelay(int fd) {
+    int opt = 1;
+#ifdef _WIN32
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, (const char*)&opt, sizeof(opt));
+#else
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &opt, sizeof(opt));
+#endif
+}
+
+bool send_all(int fd, const char* data, size_t len) {
+    size_t sent = 0;
+    while (sent < len) {
+#ifdef _WIN32
+        int n = send(fd, data + sent, static_cast<int>(len - sent), 0);
+#elif defined(MSG_NOSIGNAL)
+        ssize_t n = send(fd, data + sent, len - sent, MSG_NOSIGNAL);
+#else
+        ssize_t n = send(fd, data + sent, len - sent, 0);
+#endif
+        if (n <= 0) {
+            return false;
+        }
+        sent += static_cast<size_t>(n);
+    }
+    return true;
+}
+
+bool send_all(int fd, const std::string& data) {
+    return send_all(fd, data.data(), data.size());
+}
+
+bool try_send_all(int fd, const std::string& data) {
+#if defined(_WIN32) || !defined(MSG_DONTWAIT)
+    return send_all(fd, data);
+#else
+    size_t sent = 0;
+    while (sent < data.size()) {
+    #ifdef MSG_NOSIGNAL
+        ssize_t n = send(fd, data.data() + sent, data.size() - sent, MSG_DONTWAIT | MSG_NOSIGNAL);
+    #else
+        ssize_t n = send(fd, data.data() + sent, data.size() - sent, MSG_DONTWAIT);
+    #endif
+        if (n <= 0) {
+            return false;
+        }
+        sent += static_cast<size_t>(n);
+    }
+    return true;
+#endif
+}
+
+bool send_with_fd(int fd, const std::string& data, int passed_fd) {
+#ifdef _WIN32
+    (void)fd;
+    (void)data;
+    (void)passed_fd;
+    return false;
+#else
+    struct iovec iov;
+    iov.iov_base = const_cast<char*>(data.data());
+    iov.iov_len = data.size();
+
+    union {
+        char buf[CMSG_SPACE(sizeof(int))];
+        struct cmsghdr align;
+    } control;
+    std::memset(&control, 0, sizeof(control));
+
+    struct msghdr msg;
+    std::memset(&msg, 0, sizeof(msg));
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = control.buf;
+    msg.msg_controllen = sizeof(control.buf);
+
+    struct cmsghdr* cmsg = CMSG_FIRSTHDR(&msg);
+    cmsg->cmsg_level = SOL_SOCKET;
+    cmsg->cmsg_type = SCM_RIGHTS;
+    cmsg->cmsg_len = CMSG_LEN(sizeof(int));
+    std::memcpy(CMSG_DATA(cmsg), &passed_fd, sizeof(int));
+
+    #ifdef MSG_NOSIGNAL
+    ssize_t n = sendmsg(fd, &msg, MSG_NOSIGNAL);
+    #else
+    ssize_t n = sendmsg(fd, &msg, 0);
+    #endif
+    // The descriptor goes with the first byte; the rest is plain data
+    if (n <= 0) {
+        return false;
+    }
+    return static_cast<size_t>(n) == data.size() ||
+           send_all(fd, data.data() + n, data.size() - static_cast<size_t>(n));
+#endif
+}
+
+bool is_unix_socket(int fd) {
+#ifdef _WIN32
+    (void)fd;
+    return false;
+#else
+    struct sockaddr_storage addr;
+    socklen_t len = sizeof(addr);
+    return getsockname(fd, (struct sockaddr*)&addr, &len) == 0 && addr.ss_family == AF_UNIX;
+#endif
+}
+
+bool peer_open(int fd) {
+#ifdef _WIN32
+    (void)fd;
+    return true;
+#else
+    char c;
+    ssize_t n = recv(fd, &c, 1, MSG_PEEK | MSG_DONTWAIT);
+    return n > 0 || (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR));
+#endif
+}
+
+void close_socket(int fd) {
+    if (fd >= 0) {
+        CLOSE_SOCKET(fd);
+    }
+}
+
+void shutdown_socket(int fd) {
+    if (fd >= 0) {
+        shutdown(fd, SHUT_RDWR);
+    }
+}
+
+void set_recv_timeout(int fd, int timeout_ms) {
+#ifdef _WIN32
+    DWORD timeout = static_cast<DWORD>(timeout_ms);
+    setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, (const char*)&timeout, sizeof(timeout));
+#else
+    struct timeval timeout;
+    timeout.tv_sec = timeout_ms / 1000;
+    timeout.tv_usec = (timeout_ms % 1000) * 1000;
+    setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+#endif
+}
+
+// ============= SocketReader =============
+
+bool SocketReader::fill() {
+    // Compact consumed bytes before reading more
+    if (pos_ > 0) {
+        buffer_.erase(0, pos_);
+        pos_ = 0;
+    }
+
+    char chunk[16384];
+#ifdef _WIN32
+    int n = recv(fd_, chunk, sizeof(chunk), 0);
+#else
+    ssize_t n = recv(fd_, chunk, sizeof(chunk), 0);
+#endif
+    if (n <= 0) {
+        return false;
+    }
+
+    buffer_.append(chunk, static_cast<size_t>(n));
+    return true;
+}
+
+bool SocketReader::read_line(std::string& line) {
+    while (true) {
+        size_t nl = buffer_.find('\n', pos_);
+        if (nl != std::string::npos) {
+            size_t end = nl;
+            if (end > pos_ && buffer_[end - 1] == '\r') {
+                --end;
+            }
+            line.assign(buffer_, pos_, end - pos_);
+            pos_ = nl + 1;
+            return true;
+        }
+        if (!fill()) {
+            return false;
+        }
+    }
+}
+
+bool SocketReader::read_exact(size_t n, std::string& out) {
+    while (buffer_.size() - pos_ < n) {
+        if (!fill()) {
+            return false;
+        }
+    }
+    out.assign(buffer_, pos_, n);
+    pos_ += n;
+    return true;
+}
+
+} // namespace net
+} // namespace distkv
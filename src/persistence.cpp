@@ -1,9 +1,37 @@
 #include "persistence.h"
+#include <algorithm>
 #include <fstream>
 #include <iostream>
+#include <vector>
 
 namespace distkv {
 
+namespace {
+
+// Strings are read this much at a time
+constexpr size_t READ_CHUNK_BYTES = 1 << 20;
+
+// Read a length-prefixed string. The length comes from the stream, so the
+// buffer grows only as data actually arrives: a corrupt or hostile length
+// fails at the end of the stream instead of allocating it up front.
+bool read_string(std::istream& is, std::string& out) {
+    size_t len = 0;
+    if (!is.read(reinterpret_cast<char*>(&len), sizeof(len))) {
+        return false;
+    }
+    out.clear();
+    while (out.size() < len) {
+        size_t have = out.size();
+        out.resize(have + std::min(len - have, READ_CHUNK_BYTES));
+        if (!is.read(&out[have], static_cast<std::streamsize>(out.size() - have))) {
+            return false;
+        }
+    }
+    return true;
+}
+
+} // namespace
+
 bool Persistence::save_snapshot(const Storage& storage, const std::string& filepath) {
     std::ofstream file(filepath, std::ios::binary);
     if (!file) {
@@ -11,27 +39,10 @@ bool Persistence::save_snapshot(const Storage& storage, const std::string& filep
         return false;
     }
 
-    // Get snapshot from storage
-    auto snapshot = storage.get_snapshot();
-
-    // Write number of entries
-    size_t count = snapshot.size();
-    file.write(reinterpret_cast<const char*>(&count), sizeof(count));
-
-    // Write each key-value pair
-    for (const auto& [key, value] : snapshot) {
-        // Skip expired keys
-        if (value->is_expired()) {
-            continue;
-        }
-
-        // Write key
-        size_t key_len = key.length();
-        file.write(reinterpret_cast<const char*>(&key_len), sizeof(key_len));
-        file.write(key.c_str(), key_len);
-
-        // Write value
-        serialize_value(file, value);
+    long count = write_snapshot(storage, file);
+    if (count < 0 || !file) {
+        std::cerr << "Failed to write snapshot: " << filepath << "\n";
+        return false;
     }
 
     std::cout << "Snapshot saved to " << filepath << " (" << count << " keys)\n";
@@ -45,42 +56,89 @@ bool Persistence::load_snapshot(Storage& storage, const std::string& filepath) {
         return false;
     }
 
-    storage.clear();
+    long count = read_snapshot(storage, file);
+    if (count < 0) {
+        std::cerr << "Corrupt snapshot: " << filepath << "\n";
+        return false;
+    }
+
+    std::cout << "Snapshot loaded from " << filepath << " (" << count << " keys)\n";
+    return true;
+}
+
+long Persistence::write_snapshot(const Storage& storage, std::ostream& os) {
+    return write_entries(storage.get_snapshot(), os);
+}
+
+long Persistence::read_snapshot(Storage& storage, std::istream& is) {
+    std::unordered_map<std::string, std::shared_ptr<Value>> data;
+    if (read_entries(is, data) < 0) {
+        return -1;
+    }
+
+    storage.restore_snapshot(data);
+    return static_cast<long>(data.size());
+}
+
+long Persistence::write_entries(const std::unordered_map<std::string, std::shared_ptr<Value>>& entries,
+                                std::ostream& os) {
+    // Decide expiry once: a key whose TTL passes while writing must not be
+    // counted in the header and then left out
+    std::vector<const std::pair<const std::string, std::shared_ptr<Value>>*> live;
+    live.reserve(entries.size());
+    for (const auto& entry : entries) {
+        if (!entry.second->is_expired()) {
+            live.push_back(&entry);
+        }
+    }
+
+    // Write number of live entries
+    size_t count = live.size();
+    os.write(reinterpret_cast<const char*>(&count), sizeof(count));
 
+    // Write each key-value pair
+    for (const auto* entry : live) {
+        // Write key
+        const std::string& key = entry->first;
+        size_t key_len = key.length();
+        os.write(reinterpret_cast<const char*>(&key_len), sizeof(key_len));
+        os.write(key.c_str(), key_len);
+
+        // Write value
+        serialize_value(os, entry->second);
+    }
+
+    return os ? static_cast<long>(count) : -1;
+}
+
+long Persistence::read_entries(std::istream& is,
+                               std::unordered_map<std::string, std::shared_ptr<Value>>& entries) {
     // Read number of entries
     size_t count;
-    file.read(reinterpret_cast<char*>(&count), sizeof(count));
+    if (!is.read(reinterpret_cast<char*>(&count), sizeof(count))) {
+        return -1;
+    }
 
     // Read each key-value pair
     for (size_t i = 0; i < count; ++i) {
         // Read key
-        size_t key_len;
-        file.read(reinterpret_cast<char*>(&key_len), sizeof(key_len));
-
-        std::string key(key_len, '\0');
-        file.read(&key[0], key_len);
+        std::string key;
+        if (!read_string(is, key)) {
+            return -1;
+        }
 
         // Read value
-        auto value = deserialize_value(file);
+        auto value = deserialize_value(is);
+        if (!is) {
+            return -1;
+        }
 
-        // Restore to storage (simplified - direct access)
-        // In production, you'd use a proper restoration API
-        // For now, use the public API
-        if (value->type == ValueType::STRING) {
-            auto str_ptr = std::static_pointer_cast<std::string>(value->data);
-            storage.set(key, *str_ptr);
-            if (value->expires_at != -1) {
-                int ttl = static_cast<int>(value->expires_at - std::time(nullptr));
-                if (ttl > 0) {
-                    storage.expire(key, ttl);
-                }
-            }
+        if (!value->is_expired()) {
+            entries[key] = value;
         }
-        // TODO: Handle LIST and SET types
     }
 
-    std::cout << "Snapshot loaded from " << filepath << " (" << count << " keys)\n";
-    return true;
+    return static_cast<long>(entries.size());
 }
 
 bool Persistence::append_command(const std::string& filepath, const std::string& command) {
@@ -163,23 +221,21 @@ std::shared_ptr<Value> Persistence::deserialize_value(std::istream& is) {
     // Read data based on type
     switch (type) {
         case ValueType::STRING: {
-            size_t len;
-            is.read(reinterpret_cast<char*>(&len), sizeof(len));
-            std::string str(len, '\0');
-            is.read(&str[0], len);
-            value->data = std::make_shared<std::string>(str);
+            auto str = std::make_shared<std::string>();
+            read_string(is, *str);
+            value->data = str;
             break;
         }
 
         case ValueType::LIST: {
-            size_t count;
+            size_t count = 0;
             is.read(reinterpret_cast<char*>(&count), sizeof(count));
             auto list = std::make_shared<std::vector<std::string>>();
-            for (size_t i = 0; i < count; ++i) {
-                size_t len;
-                is.read(reinterpret_cast<char*>(&len), sizeof(len));
-                std::string item(len, '\0');
-                is.read(&item[0], len);
+            for (size_t i = 0; i < count && is; ++i) {
+                std::string item;
+                if (!read_string(is, item)) {
+                    break;
+                }
                 list->push_back(item);
             }
             value->data = list;
@@ -187,19 +243,24 @@ std::shared_ptr<Value> Persistence::deserialize_value(std::istream& is) {
         }
 
         case ValueType::SET: {
-            size_t count;
+            size_t count = 0;
             is.read(reinterpret_cast<char*>(&count), sizeof(count));
             auto set = std::make_shared<std::unordered_set<std::string>>();
-            for (size_t i = 0; i < count; ++i) {
-                size_t len;
-                is.read(reinterpret_cast<char*>(&len), sizeof(len));
-                std::string item(len, '\0');
-                is.read(&item[0], len);
+            for (size_t i = 0; i < count && is; ++i) {
+                std::string item;
+                if (!read_string(is, item)) {
+                    break;
+                }
                 set->insert(item);
             }
             value->data = set;
             break;
         }
+
+        default:
+            // Unknown type tag: corrupt stream
+            is.setstate(std::ios::failbit);
+            break;
     }
 
     return value;
@@ -57,31 +57,35 @@ std::string Protocol::serialize_response(const Response& response) {
             oss << "$-1\r\n";  // Null bulk string
             break;
 
-        case StatusCode::ERROR:
-            oss << "-ERR ";
-            if (!response.data.empty()) {
-                oss << response.data[0];
-            } else {
-                oss << "unknown error";
-            }
-            oss << "\r\n";
+        default:
+            oss << "-" << error_message(response) << "\r\n";
             break;
+    }
 
-        case StatusCode::WRONG_TYPE:
-            oss << "-WRONGTYPE Operation against a key holding the wrong kind of value\r\n";
-            break;
+    return oss.str();
+}
 
+std::string Protocol::error_message(const Response& response) {
+    std::string detail = response.data.empty() ? "" : response.data[0];
+    switch (response.status) {
+        case StatusCode::WRONG_TYPE:
+            return "WRONGTYPE Operation against a key holding the wrong kind of value";
         case StatusCode::INVALID_ARGS:
-            oss << "-ERR wrong number of arguments\r\n";
-            break;
+            return "ERR wrong number of arguments";
+        case StatusCode::MOVED:
+            return "MOVED " + detail;
+        case StatusCode::ASK:
+            return "ASK " + detail;
+        default:
+            return "ERR " + (response.data.empty() ? std::string("unknown error") : detail);
     }
-
-    return oss.str();
 }
 
 CommandType Protocol::string_to_command(const std::string& cmd) {
     if (cmd == "SET") return CommandType::SET;
     if (cmd == "GET") return CommandType::GET;
+    if (cmd == "MGET") return CommandType::MGET;
+    if (cmd == "MSET") return CommandType::MSET;
     if (cmd == "DEL") return CommandType::DEL;
     if (cmd == "EXISTS") return CommandType::EXISTS;
     if (cmd == "EXPIRE") return CommandType::EXPIRE;
@@ -99,8 +103,19 @@ CommandType Protocol::string_to_command(const std::string& cmd) {
     if (cmd == "SISMEMBER") return CommandType::SISMEMBER;
     if (cmd == "SMEMBERS") return CommandType::SMEMBERS;
     if (cmd == "SCARD") return CommandType::SCARD;
+    if (cmd == "SYNC") return CommandType::SYNC;
+    if (cmd == "REPLCONF") return CommandType::REPLCONF;
+    if (cmd == "WAIT") return CommandType::WAIT;
+    if (cmd == "STALENESS") return CommandType::STALENESS;
+    if (cmd == "BOUNDED") return CommandType::BOUNDED;
+    if (cmd == "CLUSTER") return CommandType::CLUSTER;
+    if (cmd == "ASKING") return CommandType::ASKING;
+    if (cmd == "IMPORTBATCH") return CommandType::IMPORTBATCH;
     if (cmd == "PING") return CommandType::PING;
     if (cmd == "QUIT") return CommandType::QUIT;
+    if (cmd == "CLIENT") return CommandType::CLIENT;
+    if (cmd == "SHM") return CommandType::SHM;
+    if (cmd == "PROTOCOL") return CommandType::PROTOCOL;
 
     return CommandType::UNKNOWN;
 }
@@ -109,6 +124,8 @@ std::string Protocol::command_to_string(CommandType cmd) {
     switch (cmd) {
         case CommandType::SET: return "SET";
         case CommandType::GET: return "GET";
+        case CommandType::MGET: return "MGET";
+        case CommandType::MSET: return "MSET";
         case CommandType::DEL: return "DEL";
         case CommandType::EXISTS: return "EXISTS";
         case CommandType::EXPIRE: return "EXPIRE";
@@ -126,10 +143,76 @@ std::string Protocol::command_to_string(CommandType cmd) {
         case CommandType::SISMEMBER: return "SISMEMBER";
         case CommandType::SMEMBERS: return "SMEMBERS";
         case CommandType::SCARD: return "SCARD";
+        case CommandType::SYNC: return "SYNC";
+        case CommandType::REPLCONF: return "REPLCONF";
+        case CommandType::WAIT: return "WAIT";
+        case CommandType::STALENESS: return "STALENESS";
+        case CommandType::BOUNDED: return "BOUNDED";
+        case CommandType::CLUSTER: return "CLUSTER";
+        case CommandType::ASKING: return "ASKING";
+        case CommandType::IMPORTBATCH: return "IMPORTBATCH";
         case CommandType::PING: return "PING";
         case CommandType::QUIT: return "QUIT";
+        case CommandType::CLIENT: return "CLIENT";
+        case CommandType::SHM: return "SHM";
+        case CommandType::PROTOCOL: return "PROTOCOL";
         default: return "UNKNOWN";
     }
 }
 
+std::string Protocol::serialize_request(const Request& request) {
+    std::string out = command_to_string(request.command);
+    for (const auto& arg : request.args) {
+        out += ' ';
+        out += arg;
+    }
+    return out;
+}
+
+std::string Protocol::serialize_invalidation(const std::string& key) {
+    return ">2\r\n$10\r\ninvalidate\r\n*1\r\n$" + std::to_string(key.size()) + "\r\n" + key + "\r\n";
+}
+
+bool Protocol::is_write_command(CommandType cmd) {
+    switch (cmd) {
+        case CommandType::SET:
+        case CommandType::DEL:
+        case CommandType::EXPIRE:
+        case CommandType::LPUSH:
+        case CommandType::RPUSH:
+        case CommandType::LPOP:
+        case CommandType::RPOP:
+        case CommandType::SADD:
+        case CommandType::SREM:
+            return true;
+        default:
+            return false;
+    }
+}
+
+bool Protocol::is_read_command(CommandType cmd) {
+    switch (cmd) {
+        case CommandType::GET:
+        case CommandType::EXISTS:
+        case CommandType::TTL:
+        case CommandType::KEYS:
+        case CommandType::DBSIZE:
+        case CommandType::LRANGE:
+        case CommandType::LLEN:
+        case CommandType::SISMEMBER:
+        case CommandType::SMEMBERS:
+        case CommandType::SCARD:
+            return true;
+        default:
+            return false;
+    }
+}
+
+bool Protocol::has_key(CommandType cmd) {
+    if (cmd == CommandType::KEYS || cmd == CommandType::DBSIZE) {
+        return false;
+    }
+    return is_write_command(cmd) || is_read_command(cmd);
+}
+
 } // namespace distkv
@@ -0,0 +1,784 @@
+#include "proxy.h"
+#include "net_util.h"
+#include <iostream>
+#include <sstream>
+#include <deque>
+#include <thread>
+#include <chrono>
+#include <cstring>
+#include <cstdlib>
+
+// Platform-specific includes
+#ifdef _WIN32
+    #include <winsock2.h>
+    #include <ws2tcpip.h>
+    #pragma comment(lib, "ws2_32.lib")
+    typedef int socklen_t;
+    #define CLOSE_SOCKET closesocket
+#else
+    #include <sys/socket.h>
+    #include <netinet/in.h>
+    #include <arpa/inet.h>
+    #include <unistd.h>
+    #define CLOSE_SOCKET close
+    #define INVALID_SOCKET -1
+    #define SOCKET_ERROR -1
+#endif
+
+namespace distkv {
+
+namespace {
+
+// Redirect rounds for one client read before giving up
+constexpr int MAX_REDIRECTS = 5;
+constexpr int TRYAGAIN_DELAY_MS = 5;
+
+bool starts_with(const std::string& s, const char* prefix) {
+    return s.rfind(prefix, 0) == 0;
+}
+
+std::string error_reply(const std::string& message) {
+    return Protocol::serialize_response(Response(StatusCode::ERROR, message));
+}
+
+// Read one complete RESP reply, keeping its wire form
+bool read_raw_reply(net::SocketReader& reader, std::string& out) {
+    std::string line;
+    if (!reader.read_line(line) || line.empty()) {
+        return false;
+    }
+    out += line;
+    out += "\r\n";
+
+    if (line[0] == '$') {
+        long len = std::atol(line.c_str() + 1);
+        if (len >= 0) {
+            std::string body;
+            if (!reader.read_exact(static_cast<size_t>(len) + 2, body)) {
+                return false;
+            }
+            out += body;
+        }
+    } else if (line[0] == '*') {
+        long count = std::atol(line.c_str() + 1);
+        for (long i = 0; i < count; ++i) {
+            if (!read_raw_reply(reader, out)) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+// Bulk strings of a reply: +OK has none, a bulk string one, an array its
+// elements (the shapes KEYS replies with)
+std::vector<std::string> reply_elements(const std::string& raw) {
+    std::vector<std::string> elements;
+    size_t pos = 0;
+    size_t count = 1;
+    if (starts_with(raw, "*")) {
+        count = std::strtoul(raw.c_str() + 1, nullptr, 10);
+        pos = raw.find("\r\n") + 2;
+    }
+    for (size_t i = 0; i < count && pos < raw.size() && raw[pos] == '$'; ++i) {
+        size_t header_end = raw.find("\r\n", pos);
+        long len = std::atol(raw.c_str() + pos + 1);
+        if (header_end == std::string::npos || len < 0) {
+            break;
+        }
+        elements.push_back(raw.substr(header_end + 2, static_cast<size_t>(len)));
+        pos = header_end + 2 + static_cast<size_t>(len) + 2;
+    }
+    return elements;
+}
+
+// Number carried in a bulk reply ("$1\r\n3\r\n", as DEL and DBSIZE reply)
+long long reply_number(const std::string& raw) {
+    auto elements = reply_elements(raw);
+    return elements.empty() ? 0 : std::atoll(elements[0].c_str());
+}
+
+// "MOVED 3999 127.0.0.1:6381" -> slot, address
+bool parse_redirect(const std::string& raw, int& slot, std::string& address) {
+    std::istringstream iss(raw.substr(1));
+    std::string kind;
+    return (iss >> kind >> slot >> address) && slot >= 0 && slot < CLUSTER_SLOTS &&
+           address.rfind(':') != std::string::npos;
+}
+
+} // namespace
+
+// Replies to a group of backend commands, filled in by the backend readers
+struct Proxy::Batch {
+    std::mutex mutex;
+    std::condition_variable cv;
+    size_t pending = 0;
+    std::vector<std::string> replies;  // wire form
+
+    void complete(size_t index, std::string reply) {
+        std::lock_guard<std::mutex> lock(mutex);
+        replies[index] = std::move(reply);
+        if (--pending == 0) {
+            cv.notify_all();
+        }
+    }
+
+    void wait() {
+        std::unique_lock<std::mutex> lock(mutex);
+        cv.wait(lock, [this]() { return pending == 0; });
+    }
+};
+
+// One backend command of a client command
+struct Proxy::SubCommand {
+    std::string line;
+    std::string address;   // node it goes to, "" = slot not served
+    bool asking = false;   // follow an ASK redirect: send ASKING first
+};
+
+// How to build a client reply from its backend commands
+struct Proxy::Plan {
+    enum class Merge { LOCAL, RAW, MGET, MSET, DEL, KEYS, DBSIZE };
+    Merge merge = Merge::LOCAL;
+    size_t first = 0;      // first SubCommand
+    size_t count = 0;
+    std::string local;     // reply for LOCAL
+};
+
+// A pipelined connection to a node. Commands from any thread are queued;
+// the writer sends the whole queue at once and the reader matches replies
+// to commands in order. The connection is (re)opened by the writer when
+// there is work, and commands fail fast while the node is unreachable.
+class Proxy::Backend {
+public:
+    struct Item {
+        std::string line;
+        Batch* batch;      // nullptr: discard the reply (ASKING)
+        size_t index;
+    };
+
+    Backend(const std::string& host, int port)
+        : host_(host), port_(port), fd_(INVALID_SOCKET), broken_(false), running_(true) {
+        writer_ = std::thread([this]() { write_loop(); });
+    }
+
+    ~Backend() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            running_ = false;
+            net::shutdown_socket(fd_);
+        }
+        cv_.notify_all();
+        writer_.join();
+        if (reader_.joinable()) {
+            reader_.join();
+        }
+        net::close_socket(fd_);
+
+        std::lock_guard<std::mutex> lock(mutex_);
+        fail_locked(outgoing_);
+        fail_locked(inflight_);
+    }
+
+    // Queue commands; they are sent back to back, in this order
+    void submit(std::vector<Item>& items) {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            for (auto& item : items) {
+                outgoing_.push_back(std::move(item));
+            }
+            if (!running_) {
+                fail_locked(outgoing_);
+                return;
+            }
+        }
+        cv_.notify_one();
+    }
+
+private:
+    std::string host_;
+    int port_;
+    int fd_;
+    bool broken_;          // the reader saw the connection fail
+    bool running_;
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    std::deque<Item> outgoing_;   // queued, not sent yet
+    std::deque<Item> inflight_;   // sent, waiting for replies
+    std::thread writer_;
+    std::thread reader_;
+
+    void fail_locked(std::deque<Item>& items) {
+        std::string error = error_reply("backend " + host_ + ":" + std::to_string(port_) +
+                                        " unavailable");
+        for (auto& item : items) {
+            if (item.batch) {
+                item.batch->complete(item.index, error);
+            }
+        }
+        items.clear();
+    }
+
+    void write_loop() {
+        std::unique_lock<std::mutex> lock(mutex_);
+        while (true) {
+            cv_.wait(lock, [this]() { return !running_ || !outgoing_.empty(); });
+            if (!running_) {
+                return;
+            }
+
+            if (fd_ == INVALID_SOCKET || broken_) {
+                // Only this thread closes the socket, after its reader is gone
+                int old_fd = fd_;
+                lock.unlock();
+                net::shutdown_socket(old_fd);
+                if (reader_.joinable()) {
+                    reader_.join();
+                }
+                net::close_socket(old_fd);
+                int fd = net::connect_tcp(host_, port_);
+                lock.lock();
+
+                fd_ = fd;
+                broken_ = false;
+                if (fd_ == INVALID_SOCKET) {
+                    fail_locked(outgoing_);
+                    continue;
+                }
+                reader_ = std::thread([this, fd]() { read_loop(fd); });
+            }
+
+            std::string data;
+            for (auto& item : outgoing_) {
+                data += item.line;
+                data += '\n';
+                inflight_.push_back(std::move(item));
+            }
+            outgoing_.clear();
+            int fd = fd_;
+
+            lock.unlock();
+            bool sent = net::send_all(fd, data);
+            lock.lock();
+            if (!sent) {
+                // The reader fails whatever is in flight
+                net::shutdown_socket(fd);
+            }
+        }
+    }
+
+    void read_loop(int fd) {
+        net::SocketReader reader(fd);
+        while (true) {
+            std::string reply;
+            if (!read_raw_reply(reader, reply)) {
+                break;
+            }
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (inflight_.empty()) {
+                break;  // reply nobody asked for
+            }
+            Item item = std::move(inflight_.front());
+            inflight_.pop_front();
+            if (item.batch) {
+                item.batch->complete(item.index, std::move(reply));
+            }
+        }
+
+        std::lock_guard<std::mutex> lock(mutex_);
+        broken_ = true;
+        fail_locked(inflight_);
+    }
+};
+
+Proxy::Proxy(const ProxyConfig& config)
+    : config_(config),
+      running_(false),
+      listen_fd_(INVALID_SOCKET),
+      slot_owner_(CLUSTER_SLOTS),
+      map_stale_(false),
+      next_client_(0),
+      redirects_(0) {
+    if (config_.pool_size == 0) {
+        config_.pool_size = 1;
+    }
+
+#ifdef _WIN32
+    WSADATA wsaData;
+    if (WSAStartup(MAKEWORD(2, 2), &wsaData) != 0) {
+        std::cerr << "WSAStartup failed\n";
+    }
+#endif
+}
+
+Proxy::~Proxy() {
+    stop();
+
+#ifdef _WIN32
+    WSACleanup();
+#endif
+}
+
+bool Proxy::refresh_slots() {
+    std::vector<std::string> candidates;
+    for (const auto& seed : config_.seeds) {
+        candidates.push_back(seed.first + ":" + std::to_string(seed.second));
+    }
+    {
+        std::lock_guard<std::mutex> lock(nodes_mutex_);
+        for (const auto& entry : nodes_) {
+            candidates.push_back(entry.first);
+        }
+    }
+
+    for (const auto& address : candidates) {
+        size_t colon = address.rfind(':');
+        int fd = net::connect_tcp(address.substr(0, colon), std::atoi(address.c_str() + colon + 1));
+        if (fd < 0) {
+            continue;
+        }
+
+        std::string reply;
+        net::SocketReader reader(fd);
+        bool ok = net::send_all(fd, "CLUSTER NODES\n") && read_raw_reply(reader, reply);
+        net::close_socket(fd);
+
+        auto text = reply_elements(reply);
+        std::vector<std::string> owners;
+        if (!ok || !starts_with(reply, "$") || text.empty() || !parse_slot_owners(text[0], owners)) {
+            continue;
+        }
+
+        std::unique_lock<std::shared_mutex> lock(slots_mutex_);
+        slot_owner_ = std::move(owners);
+        map_stale_ = false;
+        return true;
+    }
+    return false;
+}
+
+std::string Proxy::owner_of(int slot) {
+    std::shared_lock<std::shared_mutex> lock(slots_mutex_);
+    return slot_owner_[slot];
+}
+
+std::vector<std::string> Proxy::all_owners() {
+    std::set<std::string> owners;
+    std::shared_lock<std::shared_mutex> lock(slots_mutex_);
+    for (const auto& owner : slot_owner_) {
+        if (!owner.empty()) {
+            owners.insert(owner);
+        }
+    }
+    return std::vector<std::string>(owners.begin(), owners.end());
+}
+
+Proxy::Node& Proxy::node_for(const std::string& address) {
+    std::lock_guard<std::mutex> lock(nodes_mutex_);
+    auto& node = nodes_[address];
+    if (!node) {
+        size_t colon = address.rfind(':');
+        std::string host = address.substr(0, colon);
+        int port = std::atoi(address.c_str() + colon + 1);
+
+        node = std::make_unique<Node>();
+        for (size_t i = 0; i < config_.pool_size; ++i) {
+            node->pool.push_back(std::make_unique<Backend>(host, port));
+        }
+    }
+    return *node;
+}
+
+bool Proxy::init_socket() {
+    listen_fd_ = socket(AF_INET, SOCK_STREAM, 0);
+    if (listen_fd_ == INVALID_SOCKET) {
+        std::cerr << "Failed to create socket\n";
+        return false;
+    }
+
+    int opt = 1;
+#ifdef _WIN32
+    setsockopt(listen_fd_, SOL_SOCKET, SO_REUSEADDR, (const char*)&opt, sizeof(opt));
+#else
+    setsockopt(listen_fd_, SOL_SOCKET, SO_REUSEADDR, &opt, sizeof(opt));
+#endif
+
+    struct sockaddr_in addr;
+    std::memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = INADDR_ANY;
+    addr.sin_port = htons(config_.port);
+
+    if (bind(listen_fd_, (struct sockaddr*)&addr, sizeof(addr)) == SOCKET_ERROR) {
+        std::cerr << "Failed to bind socket to port " << config_.port << "\n";
+        CLOSE_SOCKET(listen_fd_);
+        listen_fd_ = INVALID_SOCKET;
+        return false;
+    }
+
+    if (listen(listen_fd_, 128) == SOCKET_ERROR) {
+        std::cerr << "Failed to listen on socket\n";
+        CLOSE_SOCKET(listen_fd_);
+        listen_fd_ = INVALID_SOCKET;
+        return false;
+    }
+
+    return true;
+}
+
+void Proxy::start() {
+    if (running_) {
+        std::cerr << "Proxy already running\n";
+        return;
+    }
+
+    if (!refresh_slots()) {
+        std::cerr << "No cluster node reachable to load the slot map from\n";
+        return;
+    }
+    if (!init_socket()) {
+        return;
+    }
+
+    running_ = true;
+    std::cout << "DistKV proxy listening on port " << config_.port << "\n";
+
+    while (running_) {
+        struct sockaddr_in client_addr;
+        socklen_t client_len = sizeof(client_addr);
+        int client_fd = accept(listen_fd_, (struct sockaddr*)&client_addr, &client_len);
+
+        if (client_fd == INVALID_SOCKET) {
+            if (running_) {
+                std::cerr << "Failed to accept connection\n";
+            }
+            continue;
+        }
+
+        net::set_nodelay(client_fd);
+
+        // Clients share backend connections round-robin; one client always
+        // uses the same ones, so its commands to a node stay in order
+        size_t pool_index;
+        {
+            std::lock_guard<std::mutex> lock(clients_mutex_);
+            client_fds_.insert(client_fd);
+            pool_index = next_client_++ % config_.pool_size;
+        }
+        std::thread([this, client_fd, pool_index]() {
+            handle_client(client_fd, pool_index);
+        }).detach();
+    }
+}
+
+void Proxy::stop() {
+    if (!running_.exchange(false)) {
+        return;
+    }
+
+    // Wake accept() and every client thread, then wait for the clients
+    net::shutdown_socket(listen_fd_);
+    net::close_socket(listen_fd_);
+    listen_fd_ = INVALID_SOCKET;
+    {
+        std::unique_lock<std::mutex> lock(clients_mutex_);
+        for (int fd : client_fds_) {
+            net::shutdown_socket(fd);
+        }
+        clients_cv_.wait(lock, [this]() { return client_fds_.empty(); });
+    }
+
+    std::lock_guard<std::mutex> lock(nodes_mutex_);
+    nodes_.clear();
+    std::cout << "Proxy stopped.\n";
+}
+
+void Proxy::handle_client(int client_fd, size_t pool_index) {
+    char buffer[16384];
+    std::string accumulated;
+    bool quit = false;
+
+    while (running_ && !quit) {
+#ifdef _WIN32
+        int bytes_read = recv(client_fd, buffer, sizeof(buffer), 0);
+#else
+        ssize_t bytes_read = recv(client_fd, buffer, sizeof(buffer), 0);
+#endif
+        if (bytes_read <= 0) {
+            break;
+        }
+        accumulated.append(buffer, bytes_read);
+
+        // Everything that arrived together is forwarded together
+        std::vector<std::string> lines;
+        size_t start = 0;
+        size_t pos;
+        while ((pos = accumulated.find('\n', start)) != std::string::npos) {
+            size_t end = pos;
+            if (end > start && accumulated[end - 1] == '\r') {
+                --end;
+            }
+            if (end > start) {
+                lines.push_back(accumulated.substr(start, end - start));
+            }
+            start = pos + 1;
+        }
+        accumulated.erase(0, start);
+
+        if (!lines.empty() && !net::send_all(client_fd, execute(lines, pool_index, quit))) {
+            break;
+        }
+    }
+
+    CLOSE_SOCKET(client_fd);
+    std::lock_guard<std::mutex> lock(clients_mutex_);
+    client_fds_.erase(client_fd);
+    clients_cv_.notify_all();
+}
+
+Proxy::Plan Proxy::plan(const std::string& line, std::vector<SubCommand>& subs, bool& quit) {
+    Request req = Protocol::parse_request(line);
+    Plan plan;
+    plan.first = subs.size();
+
+    auto add = [&](const std::string& command, const std::string& key) {
+        SubCommand sub;
+        sub.line = command;
+        sub.address = owner_of(key_hash_slot(key));
+        subs.push_back(std::move(sub));
+    };
+    auto add_everywhere = [&](const std::string& command) {
+        for (const auto& owner : all_owners()) {
+            SubCommand sub;
+            sub.line = command;
+            sub.address = owner;
+            subs.push_back(std::move(sub));
+        }
+    };
+    auto wrong_args = [&]() {
+        plan.local = Protocol::serialize_response(Response(StatusCode::INVALID_ARGS));
+        return plan;
+    };
+
+    switch (req.command) {
+        case CommandType::PING:
+            plan.local = Protocol::serialize_response(Response(StatusCode::OK, "PONG"));
+            return plan;
+
+        case CommandType::QUIT:
+            quit = true;
+            plan.local = Protocol::serialize_response(Response(StatusCode::OK, "Goodbye"));
+            return plan;
+
+        case CommandType::MGET:
+            if (req.args.empty()) {
+                return wrong_args();
+            }
+            plan.merge = Plan::Merge::MGET;
+            for (const auto& key : req.args) {
+                add("GET " + key, key);
+            }
+            break;
+
+        case CommandType::MSET:
+            if (req.args.empty() || req.args.size() % 2 != 0) {
+                return wrong_args();
+            }
+            plan.merge = Plan::Merge::MSET;
+            for (size_t i = 0; i < req.args.size(); i += 2) {
+                add("SET " + req.args[i] + " " + req.args[i + 1], req.args[i]);
+            }
+            break;
+
+        case CommandType::DEL:
+            if (req.args.empty()) {
+                return wrong_args();
+            }
+            plan.merge = req.args.size() == 1 ? Plan::Merge::RAW : Plan::Merge::DEL;
+            for (const auto& key : req.args) {
+                add("DEL " + key, key);
+            }
+            break;
+
+        case CommandType::KEYS:
+            plan.merge = Plan::Merge::KEYS;
+            add_everywhere(line);
+            break;
+
+        case CommandType::DBSIZE:
+            plan.merge = Plan::Merge::DBSIZE;
+            add_everywhere(line);
+            break;
+
+        case CommandType::UNKNOWN:
+            plan.local = error_reply("unknown command");
+            return plan;
+
+        default:
+            if (!Protocol::has_key(req.command)) {
+                plan.local = error_reply(Protocol::command_to_string(req.command) +
+                                         " is not supported by the proxy");
+                return plan;
+            }
+            if (req.args.empty()) {
+                return wrong_args();
+            }
+            plan.merge = Plan::Merge::RAW;
+            add(line, req.args[0]);
+            break;
+    }
+
+    plan.count = subs.size() - plan.first;
+    return plan;
+}
+
+void Proxy::dispatch(std::vector<SubCommand>& subs, const std::vector<size_t>& indices,
+                     Batch& batch, size_t pool_index) {
+    // Group by node so each node gets its share in one submit
+    std::map<std::string, std::vector<Backend::Item>> groups;
+    std::vector<size_t> unserved;
+    for (size_t index : indices) {
+        SubCommand& sub = subs[index];
+        if (sub.address.empty()) {
+            unserved.push_back(index);
+            continue;
+        }
+        auto& items = groups[sub.address];
+        if (sub.asking) {
+            items.push_back(Backend::Item{"ASKING", nullptr, 0});
+        }
+        items.push_back(Backend::Item{sub.line, &batch, index});
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(batch.mutex);
+        batch.pending = indices.size();
+    }
+    for (size_t index : unserved) {
+        batch.complete(index, error_reply("CLUSTERDOWN Hash slot not served"));
+    }
+    for (auto& group : groups) {
+        node_for(group.first).pool[pool_index]->submit(group.second);
+    }
+    batch.wait();
+}
+
+std::string Proxy::execute(const std::vector<std::string>& lines, size_t pool_index, bool& quit) {
+    if (map_stale_ && refresh_mutex_.try_lock()) {
+        refresh_slots();
+        refresh_mutex_.unlock();
+    }
+
+    std::vector<SubCommand> subs;
+    std::vector<Plan> plans;
+    for (const auto& line : lines) {
+        plans.push_back(plan(line, subs, quit));
+        if (quit) {
+            break;
+        }
+    }
+
+    Batch batch;
+    batch.replies.resize(subs.size());
+    std::vector<size_t> indices(subs.size());
+    for (size_t i = 0; i < subs.size(); ++i) {
+        indices[i] = i;
+    }
+
+    // Send everything, then resend whatever was redirected (all of it in
+    // one go again) until the replies are final
+    for (int round = 0; round <= MAX_REDIRECTS && !indices.empty(); ++round) {
+        dispatch(subs, indices, batch, pool_index);
+
+        indices.clear();
+        bool busy = false;
+        for (size_t i = 0; i < subs.size(); ++i) {
+            const std::string& reply = batch.replies[i];
+            if (reply.empty() || reply[0] != '-') {
+                continue;
+            }
+            int slot;
+            std::string address;
+            if (starts_with(reply, "-MOVED ") && parse_redirect(reply, slot, address)) {
+                {
+                    std::unique_lock<std::shared_mutex> lock(slots_mutex_);
+                    slot_owner_[slot] = address;
+                }
+                map_stale_ = true;
+                subs[i].address = address;
+                subs[i].asking = false;
+            } else if (starts_with(reply, "-ASK ") && parse_redirect(reply, slot, address)) {
+                subs[i].address = address;
+                subs[i].asking = true;
+            } else if (starts_with(reply, "-ERR TRYAGAIN")) {
+                busy = true;
+            } else {
+                if (starts_with(reply, "-ERR backend ")) {
+                    map_stale_ = true;
+                }
+                continue;
+            }
+            if (round < MAX_REDIRECTS) {
+                indices.push_back(i);
+                ++redirects_;
+            }
+        }
+        if (busy && !indices.empty()) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(TRYAGAIN_DELAY_MS));
+        }
+    }
+
+    std::string out;
+    for (const auto& plan : plans) {
+        out += merge(plan, batch.replies);
+    }
+    return out;
+}
+
+std::string Proxy::merge(const Plan& plan, const std::vector<std::string>& replies) const {
+    if (plan.merge == Plan::Merge::LOCAL) {
+        return plan.local;
+    }
+    if (plan.merge == Plan::Merge::RAW) {
+        return replies[plan.first];
+    }
+
+    // Any failed part fails the whole command
+    for (size_t i = plan.first; i < plan.first + plan.count; ++i) {
+        if (starts_with(replies[i], "-")) {
+            return replies[i];
+        }
+    }
+
+    switch (plan.merge) {
+        case Plan::Merge::MGET: {
+            std::string out = "*" + std::to_string(plan.count) + "\r\n";
+            for (size_t i = plan.first; i < plan.first + plan.count; ++i) {
+                out += replies[i];
+            }
+            return out;
+        }
+        case Plan::Merge::MSET:
+            return Protocol::serialize_response(Response(StatusCode::OK));
+        case Plan::Merge::DEL:
+        case Plan::Merge::DBSIZE: {
+            long long total = 0;
+            for (size_t i = plan.first; i < plan.first + plan.count; ++i) {
+                total += reply_number(replies[i]);
+            }
+            return Protocol::serialize_response(Response(StatusCode::OK, std::to_string(total)));
+        }
+        case Plan::Merge::KEYS: {
+            std::vector<std::string> keys;
+            for (size_t i = plan.first; i < plan.first + plan.count; ++i) {
+                auto elements = reply_elements(replies[i]);
+                keys.insert(keys.end(), elements.begin(), elements.end());
+            }
+            return Protocol::serialize_response(Response(StatusCode::OK, keys));
+        }
+        default:
+            return plan.local;
+    }
+}
+
+} // namespace distkv
@@ -0,0 +1,80 @@
+#include "proxy.h"
+#include <iostream>
+#include <csignal>
+#include <cstring>
+#include <cstdlib>
+
+using namespace distkv;
+
+// Global proxy instance for signal handling
+Proxy* g_proxy = nullptr;
+
+void signal_handler(int signal) {
+    if (signal == SIGINT || signal == SIGTERM) {
+        std::cout << "\nShutting down proxy...\n";
+        if (g_proxy) {
+            g_proxy->stop();
+        }
+    }
+}
+
+// Parse "host:port"
+bool parse_address(const std::string& spec, std::pair<std::string, int>& address) {
+    size_t colon = spec.rfind(':');
+    if (colon == std::string::npos || colon == 0) {
+        return false;
+    }
+    address.first = spec.substr(0, colon);
+    address.second = std::atoi(spec.c_str() + colon + 1);
+    return address.second > 0;
+}
+
+int main(int argc, char* argv[]) {
+    ProxyConfig config;
+
+    // Parse command line arguments
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--port") == 0 && i + 1 < argc) {
+            config.port = std::atoi(argv[i + 1]);
+            ++i;
+        } else if (std::strcmp(argv[i], "--seed") == 0 && i + 1 < argc) {
+            std::pair<std::string, int> seed;
+            if (!parse_address(argv[i + 1], seed)) {
+                std::cerr << "Invalid --seed, expected host:port\n";
+                return 1;
+            }
+            config.seeds.push_back(seed);
+            ++i;
+        } else if (std::strcmp(argv[i], "--pool-size") == 0 && i + 1 < argc) {
+            config.pool_size = static_cast<size_t>(std::atoi(argv[i + 1]));
+            ++i;
+        } else if (std::strcmp(argv[i], "--help") == 0) {
+            std::cout << "DistKV Proxy - cluster access for clients without cluster support\n\n";
+            std::cout << "Usage: " << argv[0] << " --seed <host:port> [options]\n\n";
+            std::cout << "Options:\n";
+            std::cout << "  --port <port>         Port to listen on (default: 7000)\n";
+            std::cout << "  --seed <host:port>    Cluster node to load the slot map from\n";
+            std::cout << "                        (repeat for more seeds)\n";
+            std::cout << "  --pool-size <n>       Connections per cluster node (default: 4)\n";
+            std::cout << "  --help                Show this help message\n";
+            return 0;
+        }
+    }
+
+    if (config.seeds.empty()) {
+        std::cerr << "At least one --seed is required\n";
+        return 1;
+    }
+
+    Proxy proxy(config);
+    g_proxy = &proxy;
+
+    // Register signal handlers
+    std::signal(SIGINT, signal_handler);
+    std::signal(SIGTERM, signal_handler);
+
+    // Start proxy (blocking)
+    proxy.start();
+
+    return 0;
+}
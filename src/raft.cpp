@@ -0,0 +1,1311 @@
+#include "raft.h"
+#include "persistence.h"
+#include "net_util.h"
+#include <iostream>
+#include <sstream>
+#include <fstream>
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <system_error>
+
+// Platform-specific includes
+#ifdef _WIN32
+    #include <winsock2.h>
+    #include <ws2tcpip.h>
+    #include <io.h>
+    #pragma comment(lib, "ws2_32.lib")
+    typedef int socklen_t;
+    #define CLOSE_SOCKET closesocket
+    #define fsync _commit
+    #define fileno _fileno
+    #define dup _dup
+    #define close_fd _close
+#else
+    #include <sys/socket.h>
+    #include <netinet/in.h>
+    #include <arpa/inet.h>
+    #include <unistd.h>
+    #define CLOSE_SOCKET close
+    #define INVALID_SOCKET -1
+    #define close_fd close
+#endif
+
+namespace distkv {
+
+namespace {
+
+// Wire format: [u32 length][u8 type][payload], integers little-endian
+enum MessageType : uint8_t {
+    MSG_REQUEST_VOTE = 1,
+    MSG_VOTE_REPLY = 2,
+    MSG_APPEND_ENTRIES = 3,
+    MSG_APPEND_REPLY = 4,
+    MSG_INSTALL_SNAPSHOT = 5,
+    MSG_SNAPSHOT_REPLY = 6
+};
+
+constexpr uint32_t MAX_FRAME_SIZE = 1u << 30;
+
+class Encoder {
+public:
+    void put_u8(uint8_t v) { buf_.push_back(static_cast<char>(v)); }
+
+    void put_u32(uint32_t v) {
+        for (int i = 0; i < 4; ++i) {
+            buf_.push_back(static_cast<char>((v >> (8 * i)) & 0xFF));
+        }
+    }
+
+    void put_u64(uint64_t v) {
+        for (int i = 0; i < 8; ++i) {
+            buf_.push_back(static_cast<char>((v >> (8 * i)) & 0xFF));
+        }
+    }
+
+    void put_bytes(const std::string& s) {
+        put_u32(static_cast<uint32_t>(s.size()));
+        buf_ += s;
+    }
+
+    const std::string& data() const { return buf_; }
+
+    // Wrap the payload into a frame
+    std::string frame(uint8_t type) const {
+        Encoder out;
+        out.put_u32(static_cast<uint32_t>(buf_.size() + 1));
+        out.put_u8(type);
+        out.buf_ += buf_;
+        return out.buf_;
+    }
+
+private:
+    std::string buf_;
+};
+
+class Decoder {
+public:
+    explicit Decoder(const std::string& s) : s_(s), pos_(0), ok_(true) {}
+
+    uint8_t get_u8() {
+        if (!need(1)) return 0;
+        return static_cast<uint8_t>(s_[pos_++]);
+    }
+
+    uint32_t get_u32() {
+        if (!need(4)) return 0;
+        uint32_t v = 0;
+        for (int i = 0; i < 4; ++i) {
+            v |= static_cast<uint32_t>(static_cast<uint8_t>(s_[pos_++])) << (8 * i);
+        }
+        return v;
+    }
+
+    uint64_t get_u64() {
+        if (!need(8)) return 0;
+        uint64_t v = 0;
+        for (int i = 0; i < 8; ++i) {
+            v |= static_cast<uint64_t>(static_cast<uint8_t>(s_[pos_++])) << (8 * i);
+        }
+        return v;
+    }
+
+    std::string get_bytes() {
+        uint32_t len = get_u32();
+        if (!need(len)) return "";
+        std::string out = s_.substr(pos_, len);
+        pos_ += len;
+        return out;
+    }
+
+    bool ok() const { return ok_; }
+
+private:
+    const std::string& s_;
+    size_t pos_;
+    bool ok_;
+
+    bool need(size_t n) {
+        if (!ok_ || s_.size() - pos_ < n) {
+            ok_ = false;
+            return false;
+        }
+        return true;
+    }
+};
+
+bool read_frame(net::SocketReader& reader, uint8_t& type, std::string& payload) {
+    std::string header;
+    if (!reader.read_exact(5, header)) {
+        return false;
+    }
+    Decoder dec(header);
+    uint32_t len = dec.get_u32();
+    type = dec.get_u8();
+    if (len == 0 || len > MAX_FRAME_SIZE) {
+        return false;
+    }
+    return reader.read_exact(len - 1, payload);
+}
+
+// Whole-file replace: write to a temp file, fsync, rename over
+bool write_file_atomic(const std::string& path, const std::string& data) {
+    std::string tmp = path + ".tmp";
+    std::FILE* f = std::fopen(tmp.c_str(), "wb");
+    if (!f) {
+        return false;
+    }
+    bool ok = std::fwrite(data.data(), 1, data.size(), f) == data.size();
+    ok = ok && std::fflush(f) == 0 && fsync(fileno(f)) == 0;
+    std::fclose(f);
+    if (!ok) {
+        return false;
+    }
+#ifdef _WIN32
+    std::remove(path.c_str());
+#endif
+    return std::rename(tmp.c_str(), path.c_str()) == 0;
+}
+
+bool read_file(const std::string& path, std::string& out) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file) {
+        return false;
+    }
+    std::ostringstream ss;
+    ss << file.rdbuf();
+    out = ss.str();
+    return true;
+}
+
+std::string encode_record(uint64_t index, uint64_t term, const std::string& command) {
+    Encoder enc;
+    enc.put_u64(index);
+    enc.put_u64(term);
+    enc.put_bytes(command);
+    return enc.data();
+}
+
+} // namespace
+
+RaftNode::RaftNode(const RaftConfig& config, Storage& storage, ApplyFn apply)
+    : config_(config),
+      storage_(storage),
+      apply_(std::move(apply)),
+      running_(false),
+      current_term_(0),
+      voted_for_(-1),
+      snapshot_index_(0),
+      snapshot_term_(0),
+      role_(Role::FOLLOWER),
+      leader_id_(-1),
+      commit_index_(0),
+      last_applied_(0),
+      durable_index_(0),
+      disk_failed_(false),
+      votes_(0),
+      rng_(std::random_device{}() ^ static_cast<unsigned>(config.node_id)),
+      listen_fd_(INVALID_SOCKET),
+      log_file_(nullptr) {}
+
+RaftNode::~RaftNode() {
+    stop();
+}
+
+bool RaftNode::start() {
+    if (running_) {
+        return true;
+    }
+
+    if (!load_state()) {
+        return false;
+    }
+
+    listen_fd_ = socket(AF_INET, SOCK_STREAM, 0);
+    if (listen_fd_ == INVALID_SOCKET) {
+        std::cerr << "Raft: failed to create socket\n";
+        return false;
+    }
+
+    int opt = 1;
+#ifdef _WIN32
+    setsockopt(listen_fd_, SOL_SOCKET, SO_REUSEADDR, (const char*)&opt, sizeof(opt));
+#else
+    setsockopt(listen_fd_, SOL_SOCKET, SO_REUSEADDR, &opt, sizeof(opt));
+#endif
+
+    struct sockaddr_in addr;
+    std::memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = INADDR_ANY;
+    addr.sin_port = htons(config_.port);
+
+    if (bind(listen_fd_, (struct sockaddr*)&addr, sizeof(addr)) < 0 ||
+        listen(listen_fd_, 16) < 0) {
+        std::cerr << "Raft: failed to listen on port " << config_.port << "\n";
+        CLOSE_SOCKET(listen_fd_);
+        listen_fd_ = INVALID_SOCKET;
+        return false;
+    }
+
+    uint64_t term;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        running_ = true;
+        term = current_term_;
+        reset_election_deadline();
+        for (const auto& info : config_.peers) {
+            auto peer = std::make_unique<PeerState>();
+            peer->info = info;
+            peers_.push_back(std::move(peer));
+        }
+    }
+
+    accept_thread_ = std::thread([this]() { accept_loop(); });
+    ticker_thread_ = std::thread([this]() { ticker_loop(); });
+    applier_thread_ = std::thread([this]() { applier_loop(); });
+    for (auto& peer : peers_) {
+        PeerState* p = peer.get();
+        p->sender = std::thread([this, p]() { sender_loop(p); });
+    }
+
+    std::cout << "Raft: node " << config_.node_id << " listening on port " << config_.port
+              << " (" << peers_.size() + 1 << " members, term " << term << ")\n";
+    return true;
+}
+
+void RaftNode::stop() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!running_) {
+            return;
+        }
+        running_ = false;
+        fail_proposals();
+        for (auto& peer : peers_) {
+            net::shutdown_socket(peer->fd);
+        }
+    }
+    cv_.notify_all();
+    applied_cv_.notify_all();
+
+    net::shutdown_socket(listen_fd_);
+    if (accept_thread_.joinable()) {
+        accept_thread_.join();
+    }
+    net::close_socket(listen_fd_);
+    listen_fd_ = INVALID_SOCKET;
+
+    {
+        std::lock_guard<std::mutex> lock(conn_mutex_);
+        for (int fd : conn_fds_) {
+            net::shutdown_socket(fd);
+        }
+    }
+    for (auto& t : conn_threads_) {
+        if (t.joinable()) {
+            t.join();
+        }
+    }
+    conn_threads_.clear();
+
+    for (auto& peer : peers_) {
+        if (peer->sender.joinable()) {
+            peer->sender.join();
+        }
+        if (peer->reader.joinable()) {
+            peer->reader.join();
+        }
+    }
+    peers_.clear();
+
+    if (ticker_thread_.joinable()) {
+        ticker_thread_.join();
+    }
+    if (applier_thread_.joinable()) {
+        applier_thread_.join();
+    }
+
+    if (log_file_) {
+        std::fclose(log_file_);
+        log_file_ = nullptr;
+    }
+}
+
+// ============= Client API =============
+
+bool RaftNode::propose(const std::string& command, Response& result, int timeout_ms) {
+    Proposal proposal;
+    uint64_t index;
+
+    std::unique_lock<std::mutex> lock(mutex_);
+    if (!running_ || role_ != Role::LEADER) {
+        return false;
+    }
+
+    proposal.term = current_term_;
+    log_.push_back(Entry{current_term_, command});
+    index = last_log_index();
+    append_log_records(index);
+    proposals_[index] = &proposal;
+    advance_commit();
+    cv_.notify_all();  // senders pick the entry up with whatever else is queued
+
+    // Make the entry durable locally while followers receive it
+    lock.unlock();
+    sync_log();
+    lock.lock();
+
+    bool finished = applied_cv_.wait_for(lock, std::chrono::milliseconds(timeout_ms),
+                                         [&proposal]() { return proposal.done; });
+    if (!finished) {
+        proposals_.erase(index);
+        return false;
+    }
+
+    if (proposal.ok) {
+        result = proposal.result;
+    }
+    return proposal.ok;
+}
+
+bool RaftNode::is_leader() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return role_ == Role::LEADER;
+}
+
+int RaftNode::leader_id() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return leader_id_;
+}
+
+RaftNode::Role RaftNode::role() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return role_;
+}
+
+uint64_t RaftNode::current_term() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return current_term_;
+}
+
+int RaftNode::voted_for() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return voted_for_;
+}
+
+uint64_t RaftNode::last_index() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return last_log_index();
+}
+
+uint64_t RaftNode::commit_index() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return commit_index_;
+}
+
+uint64_t RaftNode::last_applied() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return last_applied_;
+}
+
+uint64_t RaftNode::snapshot_index() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return snapshot_index_;
+}
+
+// ============= Log Helpers =============
+
+uint64_t RaftNode::last_log_term() const {
+    return log_.empty() ? snapshot_term_ : log_.back().term;
+}
+
+uint64_t RaftNode::term_at(uint64_t index) const {
+    if (index == snapshot_index_) {
+        return snapshot_term_;
+    }
+    if (index < snapshot_index_ || index > last_log_index()) {
+        return 0;
+    }
+    return entry_at(index).term;
+}
+
+// ============= Role Transitions =============
+
+void RaftNode::become_follower(uint64_t term) {
+    if (term > current_term_) {
+        current_term_ = term;
+        voted_for_ = -1;
+        if (!persist_meta()) {
+            fail_disk();
+        }
+    }
+    if (role_ == Role::LEADER) {
+        std::cout << "Raft: node " << config_.node_id << " stepping down in term "
+                  << current_term_ << "\n";
+        fail_proposals();
+    }
+    role_ = Role::FOLLOWER;
+    cv_.notify_all();
+}
+
+void RaftNode::become_candidate() {
+    ++current_term_;
+    role_ = Role::CANDIDATE;
+    voted_for_ = config_.node_id;
+    leader_id_ = -1;
+    votes_ = 1;
+    reset_election_deadline();
+    if (!persist_meta()) {
+        fail_disk();  // never campaign on a vote that is not on disk
+        return;
+    }
+
+    if (static_cast<size_t>(votes_) >= majority()) {
+        become_leader();
+        return;
+    }
+    cv_.notify_all();
+}
+
+void RaftNode::become_leader() {
+    role_ = Role::LEADER;
+    leader_id_ = config_.node_id;
+    for (auto& peer : peers_) {
+        peer->next_index = last_log_index() + 1;
+        peer->match_index = 0;
+        ++peer->epoch;
+        peer->last_send = std::chrono::steady_clock::time_point();
+    }
+
+    // A no-op in the new term lets entries from earlier terms commit
+    log_.push_back(Entry{current_term_, ""});
+    append_log_records(last_log_index());
+    advance_commit();
+
+    std::cout << "Raft: node " << config_.node_id << " became leader for term "
+              << current_term_ << "\n";
+    cv_.notify_all();
+}
+
+void RaftNode::reset_election_deadline() {
+    std::uniform_int_distribution<int> dist(config_.election_timeout_min_ms,
+                                            config_.election_timeout_max_ms);
+    election_deadline_ = std::chrono::steady_clock::now() + std::chrono::milliseconds(dist(rng_));
+}
+
+void RaftNode::advance_commit() {
+    if (role_ != Role::LEADER || disk_failed_) {
+        return;
+    }
+
+    // Only entries from the current term are committed by counting replicas
+    for (uint64_t n = last_log_index(); n > commit_index_ && n > snapshot_index_; --n) {
+        if (term_at(n) != current_term_) {
+            break;
+        }
+        size_t count = durable_index_ >= n ? 1 : 0;
+        for (const auto& peer : peers_) {
+            if (peer->match_index >= n) {
+                ++count;
+            }
+        }
+        if (count >= majority()) {
+            commit_index_ = n;
+            cv_.notify_all();
+            break;
+        }
+    }
+}
+
+void RaftNode::fail_proposals() {
+    for (auto& [index, proposal] : proposals_) {
+        proposal->done = true;
+        proposal->ok = false;
+    }
+    proposals_.clear();
+    applied_cv_.notify_all();
+}
+
+void RaftNode::fail_disk() {
+    if (!disk_failed_) {
+        std::cerr << "Raft: node " << config_.node_id << " cannot write to "
+                  << config_.data_dir << "; no longer voting or accepting entries\n";
+    }
+    disk_failed_ = true;
+    if (role_ == Role::LEADER) {
+        fail_proposals();
+    }
+    role_ = Role::FOLLOWER;
+    leader_id_ = -1;
+    cv_.notify_all();
+}
+
+// ============= Threads =============
+
+void RaftNode::accept_loop() {
+    while (running_) {
+        struct sockaddr_in client_addr;
+        socklen_t client_len = sizeof(client_addr);
+        int fd = accept(listen_fd_, (struct sockaddr*)&client_addr, &client_len);
+        if (fd == INVALID_SOCKET) {
+            if (!running_) {
+                break;
+            }
+            continue;
+        }
+
+        std::lock_guard<std::mutex> lock(conn_mutex_);
+        if (!running_) {
+            CLOSE_SOCKET(fd);
+            break;
+        }
+        conn_fds_.push_back(fd);
+        conn_threads_.emplace_back([this, fd]() { serve_connection(fd); });
+    }
+}
+
+void RaftNode::serve_connection(int fd) {
+    net::SocketReader reader(fd);
+    uint8_t type;
+    std::string payload;
+
+    while (running_ && read_frame(reader, type, payload)) {
+        std::string reply;
+        switch (type) {
+            case MSG_REQUEST_VOTE:
+                reply = handle_request_vote(payload);
+                break;
+            case MSG_APPEND_ENTRIES:
+                reply = handle_append_entries(payload);
+                break;
+            case MSG_INSTALL_SNAPSHOT:
+                reply = handle_install_snapshot(payload);
+                break;
+            default:
+                break;
+        }
+        if (reply.empty() || !net::send_all(fd, reply)) {
+            break;
+        }
+    }
+
+    std::lock_guard<std::mutex> lock(conn_mutex_);
+    conn_fds_.erase(std::remove(conn_fds_.begin(), conn_fds_.end(), fd), conn_fds_.end());
+    CLOSE_SOCKET(fd);
+}
+
+void RaftNode::sender_loop(PeerState* peer) {
+    const auto heartbeat = std::chrono::milliseconds(config_.heartbeat_interval_ms);
+    std::unique_lock<std::mutex> lock(mutex_);
+
+    while (running_) {
+        if (peer->fd < 0) {
+            lock.unlock();
+            if (peer->reader.joinable()) {
+                peer->reader.join();
+            }
+            int fd = net::connect_tcp(peer->info.host, peer->info.port);
+            lock.lock();
+
+            if (fd < 0) {
+                cv_.wait_for(lock, std::chrono::milliseconds(100), [this]() { return !running_; });
+                continue;
+            }
+            if (!running_) {
+                net::close_socket(fd);
+                break;
+            }
+
+            // Fresh connection: anything in flight on the old one is lost
+            peer->fd = fd;
+            peer->inflight.clear();
+            peer->snapshot_inflight = false;
+            peer->vote_requested_term = 0;
+            ++peer->epoch;
+            if (role_ == Role::LEADER) {
+                peer->next_index = std::max<uint64_t>(peer->match_index + 1, 1);
+            }
+            peer->reader = std::thread([this, peer, fd]() { reader_loop(peer, fd); });
+        }
+
+        std::string frame;
+        auto now = std::chrono::steady_clock::now();
+
+        if (role_ == Role::CANDIDATE && peer->vote_requested_term != current_term_) {
+            Encoder enc;
+            enc.put_u64(current_term_);
+            enc.put_u32(static_cast<uint32_t>(config_.node_id));
+            enc.put_u64(last_log_index());
+            enc.put_u64(last_log_term());
+            frame = enc.frame(MSG_REQUEST_VOTE);
+            peer->vote_requested_term = current_term_;
+        } else if (role_ == Role::LEADER) {
+            if (peer->next_index <= snapshot_index_) {
+                if (!peer->snapshot_inflight) {
+                    Encoder enc;
+                    enc.put_u64(current_term_);
+                    enc.put_u32(static_cast<uint32_t>(config_.node_id));
+                    enc.put_u64(snapshot_index_);
+                    enc.put_u64(snapshot_term_);
+                    enc.put_bytes(snapshot_data_);
+                    frame = enc.frame(MSG_INSTALL_SNAPSHOT);
+                    peer->snapshot_inflight = true;
+                    peer->last_send = now;
+                }
+            } else if (!peer->snapshot_inflight && peer->inflight.size() < config_.max_inflight) {
+                bool has_new = peer->next_index <= last_log_index();
+                if (has_new || now - peer->last_send >= heartbeat) {
+                    uint64_t prev = peer->next_index - 1;
+                    uint64_t last = std::min<uint64_t>(
+                        last_log_index(), peer->next_index + config_.max_batch_entries - 1);
+
+                    Encoder enc;
+                    enc.put_u64(current_term_);
+                    enc.put_u32(static_cast<uint32_t>(config_.node_id));
+                    enc.put_u64(prev);
+                    enc.put_u64(term_at(prev));
+                    enc.put_u64(commit_index_);
+                    enc.put_u32(static_cast<uint32_t>(has_new ? last - prev : 0));
+                    if (has_new) {
+                        for (uint64_t i = prev + 1; i <= last; ++i) {
+                            const Entry& e = entry_at(i);
+                            enc.put_u64(e.term);
+                            enc.put_bytes(e.command);
+                        }
+                        peer->next_index = last + 1;  // optimistic: pipeline the next batch
+                    }
+                    frame = enc.frame(MSG_APPEND_ENTRIES);
+                    peer->inflight.push_back(peer->epoch);
+                    peer->last_send = now;
+                }
+            }
+        }
+
+        if (frame.empty()) {
+            cv_.wait_for(lock, heartbeat);
+            continue;
+        }
+
+        int fd = peer->fd;
+        lock.unlock();
+        bool ok = net::send_all(fd, frame);
+        lock.lock();
+
+        if (!ok) {
+            // The reader notices and resets the connection
+            net::shutdown_socket(fd);
+            cv_.wait_for(lock, std::chrono::milliseconds(10));
+        }
+    }
+}
+
+void RaftNode::reader_loop(PeerState* peer, int fd) {
+    net::SocketReader reader(fd);
+    uint8_t type;
+    std::string payload;
+
+    while (read_frame(reader, type, payload)) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        handle_reply(peer, type, payload);
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (peer->fd == fd) {
+            peer->fd = -1;
+        }
+        peer->inflight.clear();
+        peer->snapshot_inflight = false;
+    }
+    net::close_socket(fd);
+    cv_.notify_all();
+}
+
+void RaftNode::ticker_loop() {
+    std::unique_lock<std::mutex> lock(mutex_);
+
+    while (running_) {
+        cv_.wait_for(lock, std::chrono::milliseconds(10));
+        if (!running_) {
+            break;
+        }
+
+        if (role_ != Role::LEADER && !disk_failed_ &&
+            std::chrono::steady_clock::now() >= election_deadline_) {
+            become_candidate();
+        }
+
+        // Entries appended outside propose() (the leader's no-op)
+        if (durable_index_ < last_log_index() && role_ == Role::LEADER) {
+            lock.unlock();
+            sync_log();
+            lock.lock();
+        }
+    }
+}
+
+void RaftNode::applier_loop() {
+    while (running_) {
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            cv_.wait_for(lock, std::chrono::milliseconds(100), [this]() {
+                return !running_ || commit_index_ > last_applied_;
+            });
+            if (!running_) {
+                break;
+            }
+        }
+
+        std::lock_guard<std::mutex> apply_lock(apply_mutex_);
+
+        uint64_t from;
+        std::vector<Entry> batch;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (commit_index_ <= last_applied_) {
+                continue;
+            }
+            from = last_applied_ + 1;
+            uint64_t to = std::min<uint64_t>(commit_index_, from + 1023);
+            for (uint64_t i = from; i <= to; ++i) {
+                batch.push_back(entry_at(i));
+            }
+        }
+
+        std::vector<Response> results;
+        results.reserve(batch.size());
+        for (const auto& entry : batch) {
+            results.push_back(entry.command.empty() ? Response(StatusCode::OK)
+                                                    : apply_(entry.command));
+        }
+
+        bool compact = false;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            for (size_t i = 0; i < batch.size(); ++i) {
+                uint64_t index = from + i;
+                auto it = proposals_.find(index);
+                if (it != proposals_.end()) {
+                    it->second->ok = it->second->term == batch[i].term;
+                    it->second->result = results[i];
+                    it->second->done = true;
+                    proposals_.erase(it);
+                }
+            }
+            last_applied_ = std::max(last_applied_, from + batch.size() - 1);
+            compact = config_.snapshot_threshold > 0 &&
+                      last_applied_ - snapshot_index_ >= config_.snapshot_threshold;
+        }
+        applied_cv_.notify_all();
+
+        if (compact) {
+            take_snapshot();
+        }
+    }
+}
+
+// ============= RPC Handlers =============
+
+std::string RaftNode::handle_request_vote(const std::string& payload) {
+    Decoder dec(payload);
+    uint64_t term = dec.get_u64();
+    int candidate = static_cast<int>(dec.get_u32());
+    uint64_t last_index = dec.get_u64();
+    uint64_t last_term = dec.get_u64();
+    if (!dec.ok()) {
+        return "";
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (disk_failed_) {
+        return "";
+    }
+    if (term > current_term_) {
+        become_follower(term);
+    }
+
+    bool up_to_date = last_term > last_log_term() ||
+                      (last_term == last_log_term() && last_index >= last_log_index());
+    bool granted = term == current_term_ && up_to_date &&
+                   (voted_for_ == -1 || voted_for_ == candidate);
+    if (granted) {
+        voted_for_ = candidate;
+        if (!persist_meta()) {
+            fail_disk();
+            return "";
+        }
+        reset_election_deadline();
+    }
+
+    Encoder enc;
+    enc.put_u64(current_term_);
+    enc.put_u8(granted ? 1 : 0);
+    return enc.frame(MSG_VOTE_REPLY);
+}
+
+std::string RaftNode::handle_append_entries(const std::string& payload) {
+    Decoder dec(payload);
+    uint64_t term = dec.get_u64();
+    int leader = static_cast<int>(dec.get_u32());
+    uint64_t prev_index = dec.get_u64();
+    uint64_t prev_term = dec.get_u64();
+    uint64_t leader_commit = dec.get_u64();
+    uint32_t count = dec.get_u32();
+    std::vector<Entry> entries;
+    for (uint32_t i = 0; i < count && dec.ok(); ++i) {
+        uint64_t entry_term = dec.get_u64();
+        entries.push_back(Entry{entry_term, dec.get_bytes()});
+    }
+    if (!dec.ok()) {
+        return "";
+    }
+
+    auto reply = [](uint64_t t, bool success, uint64_t index) {
+        Encoder enc;
+        enc.put_u64(t);
+        enc.put_u8(success ? 1 : 0);
+        enc.put_u64(index);
+        return enc.frame(MSG_APPEND_REPLY);
+    };
+
+    std::unique_lock<std::mutex> lock(mutex_);
+    if (disk_failed_) {
+        return "";
+    }
+    if (term < current_term_) {
+        return reply(current_term_, false, last_log_index() + 1);
+    }
+    if (term > current_term_ || role_ != Role::FOLLOWER) {
+        become_follower(term);
+    }
+    leader_id_ = leader;
+    reset_election_deadline();
+
+    if (prev_index > last_log_index()) {
+        return reply(current_term_, false, last_log_index() + 1);
+    }
+    if (prev_index > snapshot_index_ && term_at(prev_index) != prev_term) {
+        // Skip back over the whole conflicting term in one round trip
+        uint64_t conflict_term = term_at(prev_index);
+        uint64_t hint = prev_index;
+        while (hint > snapshot_index_ + 1 && term_at(hint - 1) == conflict_term) {
+            --hint;
+        }
+        return reply(current_term_, false, std::max(hint, commit_index_ + 1));
+    }
+
+    uint64_t index = prev_index;
+    uint64_t first_new = 0;
+    bool truncated = false;
+    for (auto& entry : entries) {
+        ++index;
+        if (index <= snapshot_index_) {
+            continue;  // already compacted, hence committed and identical
+        }
+        if (index <= last_log_index()) {
+            if (term_at(index) == entry.term) {
+                continue;
+            }
+            // Conflict: drop this entry and everything after it
+            log_.erase(log_.begin() + static_cast<long>(index - snapshot_index_ - 1), log_.end());
+            durable_index_ = std::min(durable_index_, index - 1);
+            truncated = true;
+        }
+        log_.push_back(std::move(entry));
+        if (first_new == 0) {
+            first_new = index;
+        }
+    }
+
+    if (truncated) {
+        if (!rewrite_log_file()) {
+            fail_disk();
+        }
+    } else if (first_new != 0) {
+        append_log_records(first_new);
+    }
+    if (disk_failed_) {
+        return "";
+    }
+
+    if (leader_commit > commit_index_) {
+        commit_index_ = std::max(commit_index_, std::min(leader_commit, index));
+        cv_.notify_all();
+    }
+
+    uint64_t reply_term = current_term_;
+    lock.unlock();
+
+    // Acknowledge only what is on disk
+    if (first_new != 0 && !sync_log()) {
+        return "";
+    }
+    return reply(reply_term, true, index);
+}
+
+std::string RaftNode::handle_install_snapshot(const std::string& payload) {
+    Decoder dec(payload);
+    uint64_t term = dec.get_u64();
+    int leader = static_cast<int>(dec.get_u32());
+    uint64_t last_index = dec.get_u64();
+    uint64_t last_term = dec.get_u64();
+    std::string data = dec.get_bytes();
+    if (!dec.ok()) {
+        return "";
+    }
+
+    auto reply = [](uint64_t t, uint64_t index) {
+        Encoder enc;
+        enc.put_u64(t);
+        enc.put_u64(index);
+        return enc.frame(MSG_SNAPSHOT_REPLY);
+    };
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (disk_failed_) {
+            return "";
+        }
+        if (term < current_term_) {
+            return reply(current_term_, 0);
+        }
+        if (term > current_term_ || role_ != Role::FOLLOWER) {
+            become_follower(term);
+        }
+        leader_id_ = leader;
+        reset_election_deadline();
+    }
+
+    // Lock order: apply_mutex_ before mutex_
+    std::lock_guard<std::mutex> apply_lock(apply_mutex_);
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    if (last_index <= snapshot_index_ || last_index <= last_applied_) {
+        return reply(current_term_, last_index);
+    }
+
+    std::istringstream is(data);
+    if (Persistence::read_snapshot(storage_, is) < 0) {
+        std::cerr << "Raft: received corrupt snapshot\n";
+        return reply(current_term_, 0);
+    }
+
+    // Keep our log suffix if it continues the snapshot
+    if (last_index <= last_log_index() && term_at(last_index) == last_term) {
+        log_.erase(log_.begin(), log_.begin() + static_cast<long>(last_index - snapshot_index_));
+    } else {
+        log_.clear();
+    }
+
+    snapshot_index_ = last_index;
+    snapshot_term_ = last_term;
+    snapshot_data_ = std::move(data);
+    commit_index_ = std::max(commit_index_, last_index);
+    last_applied_ = last_index;
+    // The old log stays on disk unless the snapshot covering it landed
+    if (!persist_snapshot() || !rewrite_log_file()) {
+        fail_disk();
+        return "";
+    }
+
+    std::cout << "Raft: node " << config_.node_id << " installed snapshot at index "
+              << last_index << "\n";
+    return reply(current_term_, last_index);
+}
+
+void RaftNode::handle_reply(PeerState* peer, uint8_t type, const std::string& payload) {
+    Decoder dec(payload);
+
+    switch (type) {
+        case MSG_VOTE_REPLY: {
+            uint64_t term = dec.get_u64();
+            bool granted = dec.get_u8() != 0;
+            if (!dec.ok()) return;
+
+            if (term > current_term_) {
+                become_follower(term);
+                reset_election_deadline();
+                return;
+            }
+            if (role_ == Role::CANDIDATE && term == current_term_ && granted &&
+                peer->vote_granted_term != current_term_) {
+                peer->vote_granted_term = current_term_;
+                if (static_cast<size_t>(++votes_) >= majority()) {
+                    become_leader();
+                }
+            }
+            break;
+        }
+
+        case MSG_APPEND_REPLY: {
+            uint64_t term = dec.get_u64();
+            bool success = dec.get_u8() != 0;
+            uint64_t index = dec.get_u64();
+            if (!dec.ok() || peer->inflight.empty()) return;
+
+            uint64_t epoch = peer->inflight.front();
+            peer->inflight.pop_front();
+
+            if (term > current_term_) {
+                become_follower(term);
+                reset_election_deadline();
+                return;
+            }
+            if (role_ != Role::LEADER || term != current_term_) {
+                return;
+            }
+
+            if (success) {
+                if (index > peer->match_index) {
+                    peer->match_index = index;
+                    advance_commit();
+                }
+            } else if (epoch == peer->epoch) {
+                // Rejected: drop the rest of the pipeline and resend from the hint
+                ++peer->epoch;
+                peer->next_index = std::max<uint64_t>(
+                    std::min(index, last_log_index() + 1), peer->match_index + 1);
+            }
+            cv_.notify_all();
+            break;
+        }
+
+        case MSG_SNAPSHOT_REPLY: {
+            uint64_t term = dec.get_u64();
+            uint64_t index = dec.get_u64();
+            if (!dec.ok()) return;
+
+            peer->snapshot_inflight = false;
+            if (term > current_term_) {
+                become_follower(term);
+                reset_election_deadline();
+                return;
+            }
+            if (role_ == Role::LEADER && term == current_term_ && index > 0) {
+                peer->match_index = std::max(peer->match_index, index);
+                peer->next_index = peer->match_index + 1;
+                ++peer->epoch;
+                advance_commit();
+            }
+            cv_.notify_all();
+            break;
+        }
+
+        default:
+            break;
+    }
+}
+
+// ============= Durability =============
+//
+// <data_dir>/raft-meta      "term voted_for"
+// <data_dir>/raft-log       records: [u64 index][u64 term][u32 len][command]
+// <data_dir>/raft-snapshot  [u64 index][u64 term] + Persistence snapshot
+
+std::string RaftNode::path(const std::string& name) const {
+    return config_.data_dir + "/" + name;
+}
+
+bool RaftNode::prepare_data_dir(const std::string& dir) {
+    std::error_code ec;
+    std::filesystem::create_directories(dir, ec);
+    return std::filesystem::is_directory(dir, ec);
+}
+
+bool RaftNode::load_state() {
+    if (config_.data_dir.empty()) {
+        return true;
+    }
+    if (!prepare_data_dir(config_.data_dir)) {
+        std::cerr << "Raft: cannot create data directory " << config_.data_dir << "\n";
+        return false;
+    }
+
+    std::string data;
+    if (read_file(path("raft-meta"), data)) {
+        std::istringstream is(data);
+        is >> current_term_ >> voted_for_;
+    }
+
+    if (read_file(path("raft-snapshot"), data) && data.size() >= 16) {
+        Decoder dec(data);
+        snapshot_index_ = dec.get_u64();
+        snapshot_term_ = dec.get_u64();
+        snapshot_data_ = data.substr(16);
+
+        std::istringstream is(snapshot_data_);
+        if (Persistence::read_snapshot(storage_, is) < 0) {
+            std::cerr << "Raft: corrupt snapshot in " << config_.data_dir << "\n";
+            snapshot_index_ = snapshot_term_ = 0;
+            snapshot_data_.clear();
+        }
+        commit_index_ = last_applied_ = snapshot_index_;
+    }
+
+    bool clean = true;
+    if (read_file(path("raft-log"), data)) {
+        Decoder dec(data);
+        while (true) {
+            uint64_t index = dec.get_u64();
+            uint64_t term = dec.get_u64();
+            std::string command = dec.get_bytes();
+            if (!dec.ok()) {
+                break;  // torn tail write
+            }
+            if (index <= snapshot_index_) {
+                continue;
+            }
+            if (index != last_log_index() + 1) {
+                clean = false;
+                break;
+            }
+            log_.push_back(Entry{term, std::move(command)});
+        }
+        clean = clean && dec.ok();
+    }
+
+    // Rewrite whenever the file holds anything we did not keep. Both files
+    // must be writable before this node may vote or accept entries.
+    if (!persist_meta() || !rewrite_log_file()) {
+        std::cerr << "Raft: cannot write state to " << config_.data_dir << "\n";
+        return false;
+    }
+
+    std::cout << "Raft: restored term " << current_term_ << ", snapshot index "
+              << snapshot_index_ << ", log up to " << last_log_index()
+              << (clean ? "" : " (truncated damaged tail)") << "\n";
+    return true;
+}
+
+bool RaftNode::persist_meta() {
+    if (config_.data_dir.empty()) {
+        return true;
+    }
+    return write_file_atomic(path("raft-meta"),
+                             std::to_string(current_term_) + " " + std::to_string(voted_for_) + "\n");
+}
+
+void RaftNode::append_log_records(uint64_t from_index) {
+    if (config_.data_dir.empty()) {
+        durable_index_ = last_log_index();
+        return;
+    }
+    for (uint64_t i = from_index; i <= last_log_index(); ++i) {
+        const Entry& e = entry_at(i);
+        std::string record = encode_record(i, e.term, e.command);
+        if (!log_file_ ||
+            std::fwrite(record.data(), 1, record.size(), log_file_) != record.size()) {
+            fail_disk();
+            return;
+        }
+    }
+}
+
+bool RaftNode::rewrite_log_file() {
+    if (config_.data_dir.empty()) {
+        durable_index_ = last_log_index();
+        return true;
+    }
+
+    std::string data;
+    for (uint64_t i = snapshot_index_ + 1; i <= last_log_index(); ++i) {
+        data += encode_record(i, entry_at(i).term, entry_at(i).command);
+    }
+
+    if (log_file_) {
+        std::fclose(log_file_);
+        log_file_ = nullptr;
+    }
+    if (!write_file_atomic(path("raft-log"), data)) {
+        std::cerr << "Raft: failed to rewrite log in " << config_.data_dir << "\n";
+        return false;
+    }
+    log_file_ = std::fopen(path("raft-log").c_str(), "ab");
+    if (!log_file_) {
+        std::cerr << "Raft: failed to open log in " << config_.data_dir << "\n";
+        return false;
+    }
+    durable_index_ = last_log_index();
+    return true;
+}
+
+bool RaftNode::persist_snapshot() {
+    if (config_.data_dir.empty()) {
+        return true;
+    }
+    Encoder header;
+    header.put_u64(snapshot_index_);
+    header.put_u64(snapshot_term_);
+    std::string data = header.data() + snapshot_data_;
+    if (!write_file_atomic(path("raft-snapshot"), data)) {
+        std::cerr << "Raft: failed to write snapshot in " << config_.data_dir << "\n";
+        return false;
+    }
+    return true;
+}
+
+bool RaftNode::sync_log() {
+    // Concurrent callers queue here; the first fsync usually covers the
+    // entries of everyone waiting behind it (group commit)
+    std::lock_guard<std::mutex> sync_lock(sync_mutex_);
+
+    uint64_t target;
+    int fd = -1;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        target = last_log_index();
+        if (durable_index_ >= target) {
+            return true;
+        }
+        if (config_.data_dir.empty()) {
+            durable_index_ = target;
+            advance_commit();
+            return true;
+        }
+        if (disk_failed_ || !log_file_) {
+            fail_disk();
+            return false;
+        }
+        if (std::fflush(log_file_) == 0) {
+            fd = dup(fileno(log_file_));  // survives a concurrent log rewrite
+        }
+    }
+
+    bool ok = fd >= 0 && fsync(fd) == 0;
+    if (fd >= 0) {
+        close_fd(fd);
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!ok) {
+        fail_disk();
+        return false;
+    }
+    durable_index_ = std::max(durable_index_, std::min(target, last_log_index()));
+    advance_commit();
+    return true;
+}
+
+void RaftNode::take_snapshot() {
+    // Called from the applier with apply_mutex_ held, so storage reflects
+    // exactly last_applied_
+    std::ostringstream os;
+    Persistence::write_snapshot(storage_, os);
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    uint64_t index = last_applied_;
+    if (index <= snapshot_index_) {
+        return;
+    }
+
+    snapshot_term_ = term_at(index);
+    log_.erase(log_.begin(), log_.begin() + static_cast<long>(index - snapshot_index_));
+    snapshot_index_ = index;
+    snapshot_data_ = os.str();
+    if (!persist_snapshot() || !rewrite_log_file()) {
+        fail_disk();
+    }
+}
+
+} // namespace distkv
@@ -1,27 +1,544 @@
 #include "replication.h"
+#include "persistence.h"
+#include "net_util.h"
+#include "compression.h"
+#include <iostream>
+#include <sstream>
+#include <chrono>
+#include <algorithm>
+#include <stdexcept>
 
 namespace distkv {
 
-// Placeholder implementations
-// Will be fully implemented in future phases
+namespace {
 
-void ReplicationMaster::register_slave(int fd) {
-    slave_fds_.push_back(fd);
+// Stream framing used when compression is negotiated
+constexpr uint8_t FRAME_STORED = 0;
+constexpr uint8_t FRAME_COMPRESSED = 1;
+constexpr size_t FRAME_HEADER_BYTES = 9;
+constexpr size_t FRAME_MAX_BYTES = 1 << 20;      // raw bytes per frame
+constexpr size_t MIN_COMPRESS_BYTES = 64;        // smaller frames are stored
+
+int64_t steady_now_ms() {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void put_u32(std::string& out, uint32_t v) {
+    for (int i = 0; i < 4; ++i) {
+        out += static_cast<char>((v >> (8 * i)) & 0xFF);
+    }
+}
+
+uint32_t get_u32(const char* p) {
+    uint32_t v = 0;
+    for (int i = 3; i >= 0; --i) {
+        v = (v << 8) | static_cast<unsigned char>(p[i]);
+    }
+    return v;
+}
+
+// Append data to out as a series of frames
+void encode_frames(const std::string& data, std::string& out) {
+    for (size_t pos = 0; pos < data.size(); pos += FRAME_MAX_BYTES) {
+        size_t len = std::min(FRAME_MAX_BYTES, data.size() - pos);
+        std::string block;
+        if (len >= MIN_COMPRESS_BYTES) {
+            block = Compression::compress(data.data() + pos, len);
+        }
+
+        bool stored = block.empty() || block.size() >= len;
+        out += static_cast<char>(stored ? FRAME_STORED : FRAME_COMPRESSED);
+        put_u32(out, static_cast<uint32_t>(len));
+        if (stored) {
+            put_u32(out, static_cast<uint32_t>(len));
+            out.append(data, pos, len);
+        } else {
+            put_u32(out, static_cast<uint32_t>(block.size()));
+            out += block;
+        }
+    }
+}
+
+// Reads the replication stream, expanding frames once compression is on
+class StreamReader {
+public:
+    explicit StreamReader(net::SocketReader& socket) : socket_(socket), framed_(false), pos_(0) {}
+
+    void set_framed(bool framed) { framed_ = framed; }
+
+    bool read_line(std::string& line) {
+        if (!framed_) {
+            return socket_.read_line(line);
+        }
+        while (true) {
+            size_t nl = buffer_.find('\n', pos_);
+            if (nl != std::string::npos) {
+                size_t end = nl;
+                if (end > pos_ && buffer_[end - 1] == '\r') {
+                    --end;
+                }
+                line.assign(buffer_, pos_, end - pos_);
+                pos_ = nl + 1;
+                return true;
+            }
+            if (!fill()) {
+                return false;
+            }
+        }
+    }
+
+    bool read_exact(size_t n, std::string& out) {
+        if (!framed_) {
+            return socket_.read_exact(n, out);
+        }
+        while (buffer_.size() - pos_ < n) {
+            if (!fill()) {
+                return false;
+            }
+        }
+        out.assign(buffer_, pos_, n);
+        pos_ += n;
+        return true;
+    }
+
+private:
+    net::SocketReader& socket_;
+    bool framed_;
+    std::string buffer_;
+    size_t pos_;
+
+    // Decode the next frame into buffer_
+    bool fill() {
+        if (pos_ > 0) {
+            buffer_.erase(0, pos_);
+            pos_ = 0;
+        }
+
+        std::string header;
+        if (!socket_.read_exact(FRAME_HEADER_BYTES, header)) {
+            return false;
+        }
+        uint8_t codec = static_cast<uint8_t>(header[0]);
+        uint32_t raw_len = get_u32(header.data() + 1);
+        uint32_t data_len = get_u32(header.data() + 5);
+        if (raw_len > FRAME_MAX_BYTES || data_len > FRAME_MAX_BYTES ||
+            (codec == FRAME_STORED && data_len != raw_len)) {
+            throw std::runtime_error("invalid replication frame");
+        }
+
+        std::string data;
+        if (!socket_.read_exact(data_len, data)) {
+            return false;
+        }
+        if (codec == FRAME_STORED) {
+            buffer_ += data;
+        } else if (codec != FRAME_COMPRESSED ||
+                   !Compression::decompress(data.data(), data.size(), raw_len, buffer_)) {
+            throw std::runtime_error("corrupt replication frame");
+        }
+        return true;
+    }
+};
+
+} // namespace
+
+// ============= ReplicationMaster =============
+
+ReplicationMaster::ReplicationMaster()
+    : slave_count_(0),
+      master_offset_(0) {}
+
+ReplicationMaster::~ReplicationMaster() {
+    shutdown();
+}
+
+void ReplicationMaster::register_slave(int fd, const Storage& storage, bool compress) {
+    // Encode the snapshot up front; the sender thread ships it so a slow
+    // replica never blocks the caller
+    std::ostringstream snapshot;
+    Persistence::write_snapshot(storage, snapshot);
+    std::string payload = snapshot.str();
+
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    auto link = std::make_unique<SlaveLink>();
+    link->fd = fd;
+    link->compress = compress;
+    link->ack_offset = master_offset_;
+    link->handshake = "+FULLRESYNC " + std::to_string(master_offset_) +
+                      (compress ? " COMPRESS" : "") + "\r\n";
+    link->pending = "$" + std::to_string(payload.size()) + "\r\n";
+    link->pending += payload;
+
+    SlaveLink* raw = link.get();
+    slaves_.push_back(std::move(link));
+    slave_count_ = slaves_.size();
+    raw->sender = std::thread([this, raw]() { sender_loop(raw); });
+
+    std::cout << "Replica attached (fd " << fd << ", offset " << master_offset_
+              << ", snapshot " << payload.size() << " bytes"
+              << (compress ? ", compressed" : "") << ")\n";
+}
+
+void ReplicationMaster::unregister_slave(int fd) {
+    std::unique_ptr<SlaveLink> link;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = std::find_if(slaves_.begin(), slaves_.end(),
+                               [fd](const auto& l) { return l->fd == fd; });
+        if (it == slaves_.end()) {
+            return;
+        }
+        link = std::move(*it);
+        slaves_.erase(it);
+        slave_count_ = slaves_.size();
+        link->closed = true;
+    }
+
+    send_cv_.notify_all();
+    ack_cv_.notify_all();
+    if (link->sender.joinable()) {
+        link->sender.join();
+    }
+
+    std::cout << "Replica detached (fd " << fd << ", " << link->wire_bytes << " bytes sent for "
+              << link->raw_bytes << " bytes of stream)\n";
+}
+
+uint64_t ReplicationMaster::replicate_command(const std::string& cmd) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    master_offset_ += cmd.size() + 1;
+    queue_to_all(cmd + "\n");
+    return master_offset_;
+}
+
+void ReplicationMaster::acknowledge(int fd, uint64_t offset) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (auto& link : slaves_) {
+        if (link->fd == fd) {
+            link->ack_offset = std::max(link->ack_offset, offset);
+            break;
+        }
+    }
+    ack_cv_.notify_all();
+}
+
+int ReplicationMaster::wait_for_replicas(uint64_t offset, int num_replicas, int timeout_ms) {
+    std::unique_lock<std::mutex> lock(mutex_);
+
+    if (count_acked(offset) >= num_replicas) {
+        return count_acked(offset);
+    }
+
+    // Ask replicas to report right away instead of waiting for their
+    // periodic ACK. Control lines are not counted in the offset.
+    queue_to_all("REPLCONF GETACK\n");
+
+    auto ready = [this, offset, num_replicas]() {
+        return count_acked(offset) >= num_replicas;
+    };
+
+    if (timeout_ms > 0) {
+        ack_cv_.wait_for(lock, std::chrono::milliseconds(timeout_ms), ready);
+    } else {
+        ack_cv_.wait(lock, ready);
+    }
+
+    return count_acked(offset);
+}
+
+uint64_t ReplicationMaster::offset() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return master_offset_;
+}
+
+size_t ReplicationMaster::slave_count() const {
+    return slave_count_.load();
+}
+
+void ReplicationMaster::shutdown() {
+    std::vector<std::unique_ptr<SlaveLink>> links;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (auto& link : slaves_) {
+            link->closed = true;
+            net::shutdown_socket(link->fd);
+        }
+        links.swap(slaves_);
+        slave_count_ = 0;
+    }
+
+    send_cv_.notify_all();
+    ack_cv_.notify_all();
+    for (auto& link : links) {
+        if (link->sender.joinable()) {
+            link->sender.join();
+        }
+    }
+}
+
+void ReplicationMaster::sender_loop(SlaveLink* link) {
+    std::unique_lock<std::mutex> lock(mutex_);
+
+    while (true) {
+        send_cv_.wait_for(lock, std::chrono::milliseconds(HEARTBEAT_INTERVAL_MS),
+                          [link]() { return link->closed || !link->pending.empty(); });
+        if (link->closed) {
+            break;
+        }
+
+        // Ship everything queued so far in one write, followed by the offset
+        // it brings the replica to (a bare heartbeat when nothing is queued)
+        std::string batch;
+        batch.swap(link->pending);
+        batch += "REPLCONF OFFSET " + std::to_string(master_offset_) + "\n";
+        std::string wire;
+        wire.swap(link->handshake);
+
+        lock.unlock();
+        if (link->compress) {
+            encode_frames(batch, wire);
+        } else {
+            wire += batch;
+        }
+        bool ok = net::send_all(link->fd, wire);
+        lock.lock();
+
+        link->raw_bytes += batch.size();
+        link->wire_bytes += wire.size();
+
+        if (!ok) {
+            // The connection handler sees EOF and unregisters the link
+            link->closed = true;
+            net::shutdown_socket(link->fd);
+            ack_cv_.notify_all();
+            break;
+        }
+    }
+}
+
+void ReplicationMaster::queue_to_all(const std::string& data) {
+    for (auto& link : slaves_) {
+        if (link->closed) {
+            continue;
+        }
+        link->pending += data;
+        if (link->pending.size() > MAX_PENDING_BYTES) {
+            std::cerr << "Replica (fd " << link->fd << ") fell too far behind, disconnecting\n";
+            link->closed = true;
+            net::shutdown_socket(link->fd);
+        }
+    }
+    send_cv_.notify_all();
+}
+
+int ReplicationMaster::count_acked(uint64_t offset) const {
+    int count = 0;
+    for (const auto& link : slaves_) {
+        if (!link->closed && link->ack_offset >= offset) {
+            ++count;
+        }
+    }
+    return count;
+}
+
+// ============= ReplicationSlave =============
+
+ReplicationSlave::ReplicationSlave(Storage& storage, ApplyFn apply)
+    : storage_(storage),
+      apply_(std::move(apply)),
+      master_port_(0),
+      compress_(false),
+      running_(false),
+      linked_(false),
+      offset_(0),
+      master_offset_(0),
+      caught_up_ms_(-1),
+      heartbeat_ms_(-1),
+      master_fd_(-1) {}
+
+ReplicationSlave::~ReplicationSlave() {
+    stop();
+}
+
+void ReplicationSlave::connect_to_master(const std::string& host, int port, bool compress) {
+    if (running_) {
+        return;
+    }
+
+    master_host_ = host;
+    master_port_ = port;
+    compress_ = compress;
+    running_ = true;
+
+    sync_thread_ = std::thread([this]() { run(); });
+    ack_thread_ = std::thread([this]() { ack_loop(); });
 }
 
-void ReplicationMaster::replicate_command(const std::string& cmd) {
-    // TODO: Send command to all slaves
-    (void)cmd;  // Suppress unused warning
+void ReplicationSlave::stop() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!running_) {
+            return;
+        }
+        running_ = false;
+        net::shutdown_socket(master_fd_);
+    }
+
+    stop_cv_.notify_all();
+    if (sync_thread_.joinable()) {
+        sync_thread_.join();
+    }
+    if (ack_thread_.joinable()) {
+        ack_thread_.join();
+    }
 }
 
-void ReplicationSlave::connect_to_master(const std::string& host, int port) {
-    // TODO: Connect to master
-    (void)host;
-    (void)port;
+void ReplicationSlave::run() {
+    while (running_) {
+        sync_from_master();
+
+        // Back off before reconnecting
+        std::unique_lock<std::mutex> lock(mutex_);
+        stop_cv_.wait_for(lock, std::chrono::seconds(1), [this]() { return !running_; });
+    }
 }
 
 void ReplicationSlave::sync_from_master() {
-    // TODO: Sync data from master
+    int fd = net::connect_tcp(master_host_, master_port_);
+    if (fd < 0) {
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!running_) {
+            net::close_socket(fd);
+            return;
+        }
+        master_fd_ = fd;
+    }
+
+    net::SocketReader socket_reader(fd);
+    StreamReader reader(socket_reader);
+    std::string line;
+
+    try {
+        if (!net::send_all(fd, compress_ ? "SYNC COMPRESS\n" : "SYNC\n") ||
+            !reader.read_line(line) || line.rfind("+FULLRESYNC ", 0) != 0) {
+            throw std::runtime_error("handshake failed: " + line);
+        }
+        uint64_t start_offset = std::stoull(line.substr(12));
+
+        // A primary without compression support answers a plain FULLRESYNC
+        const std::string compressed_tag = " COMPRESS";
+        reader.set_framed(line.size() > compressed_tag.size() &&
+                          line.compare(line.size() - compressed_tag.size(),
+                                       compressed_tag.size(), compressed_tag) == 0);
+
+        if (!reader.read_line(line) || line.empty() || line[0] != '$') {
+            throw std::runtime_error("missing snapshot payload");
+        }
+        std::string payload;
+        if (!reader.read_exact(std::stoull(line.substr(1)), payload)) {
+            throw std::runtime_error("truncated snapshot payload");
+        }
+
+        std::istringstream snapshot(payload);
+        if (Persistence::read_snapshot(storage_, snapshot) < 0) {
+            throw std::runtime_error("corrupt snapshot payload");
+        }
+
+        offset_ = start_offset;
+        master_offset_ = start_offset;
+        mark_caught_up();
+        heartbeat_ms_ = steady_now_ms();
+        linked_ = true;
+        std::cout << "Replication: full sync from " << master_host_ << ":" << master_port_
+                  << " complete (" << payload.size() << " bytes, offset " << start_offset << ")\n";
+        send_ack();
+
+        // Command stream
+        while (running_ && reader.read_line(line)) {
+            Request req = Protocol::parse_request(line);
+            if (req.command == CommandType::REPLCONF) {
+                if (!req.args.empty() && req.args[0] == "GETACK") {
+                    send_ack();
+                } else if (req.args.size() == 2 && req.args[0] == "OFFSET") {
+                    master_offset_ = std::stoull(req.args[1]);
+                    heartbeat_ms_ = steady_now_ms();
+                    if (offset_ >= master_offset_) {
+                        mark_caught_up();
+                    }
+                }
+                continue;
+            }
+
+            apply_(req);
+            offset_ += line.size() + 1;
+            if (offset_ > master_offset_) {
+                master_offset_ = offset_.load();
+            }
+        }
+    } catch (const std::exception& e) {
+        std::cerr << "Replication: " << e.what() << "\n";
+    }
+
+    linked_ = false;
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    net::close_socket(master_fd_);
+    master_fd_ = -1;
+}
+
+void ReplicationSlave::ack_loop() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (running_) {
+        stop_cv_.wait_for(lock, std::chrono::seconds(1), [this]() { return !running_; });
+        if (!running_) {
+            break;
+        }
+
+        lock.unlock();
+        if (linked_) {
+            send_ack();
+        }
+        lock.lock();
+    }
+}
+
+uint64_t ReplicationSlave::lag_offset() const {
+    uint64_t applied = offset_.load();
+    uint64_t announced = master_offset_.load();
+    return announced > applied ? announced - applied : 0;
+}
+
+int64_t ReplicationSlave::lag_ms() const {
+    int64_t caught_up = caught_up_ms_.load();
+    if (caught_up < 0) {
+        return -1;
+    }
+    return std::max<int64_t>(0, steady_now_ms() - caught_up);
+}
+
+int64_t ReplicationSlave::heartbeat_age_ms() const {
+    int64_t heartbeat = heartbeat_ms_.load();
+    if (heartbeat < 0) {
+        return -1;
+    }
+    return std::max<int64_t>(0, steady_now_ms() - heartbeat);
+}
+
+void ReplicationSlave::mark_caught_up() {
+    caught_up_ms_ = steady_now_ms();
+}
+
+void ReplicationSlave::send_ack() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (master_fd_ >= 0) {
+        net::send_all(master_fd_, "REPLCONF ACK " + std::to_string(offset_.load()) + "\n");
+    }
 }
 
 } // namespace distkv
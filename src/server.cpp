@@ -1,6 +1,15 @@
 #include "server.h"
+#include "persistence.h"
+#include "net_util.h"
+#include "shm_channel.h"
+#include "binary_protocol.h"
 #include <iostream>
+#include <sstream>
+#include <deque>
 #include <cstring>
+#include <stdexcept>
+#include <algorithm>
+#include <cctype>
 
 // Platform-specific includes
 #ifdef _WIN32
@@ -13,6 +22,8 @@
     #include <sys/socket.h>
     #include <netinet/in.h>
     #include <arpa/inet.h>
+    #include <sys/un.h>
+    #include <sys/stat.h>
     #include <unistd.h>
     #define CLOSE_SOCKET close
     #define INVALID_SOCKET -1
@@ -21,12 +32,57 @@
 
 namespace distkv {
 
+// Keys remembered for tracking clients; past this, the oldest-hashed
+// entries are dropped and their readers told to forget them
+constexpr size_t TRACKING_MAX_KEYS = 1000000;
+
+// Queue an invalidation of key in the session's protocol (push_mutex held)
+static void append_invalidation(ClientSession& session, const std::string& key) {
+    if (session.binary) {
+        BinaryProtocol::append_invalidation(session.pushes, key);
+    } else {
+        session.pushes += Protocol::serialize_invalidation(key);
+    }
+}
+
+// Parse "MS <n>" or "OFFSET <n>" into the matching staleness bound
+static bool parse_staleness_bound(std::string unit, const std::string& value,
+                                  int64_t& max_lag_ms, int64_t& max_lag_offset) {
+    std::transform(unit.begin(), unit.end(), unit.begin(),
+                   [](unsigned char c) { return std::toupper(c); });
+    int64_t limit;
+    try {
+        limit = std::stoll(value);
+    } catch (...) {
+        return false;
+    }
+    if (limit < 0) {
+        return false;
+    }
+
+    if (unit == "MS") {
+        max_lag_ms = limit;
+    } else if (unit == "OFFSET") {
+        max_lag_offset = limit;
+    } else {
+        return false;
+    }
+    return true;
+}
+
 Server::Server(int port, int num_threads)
     : port_(port),
       num_threads_(num_threads),
       running_(false),
       storage_(std::make_unique<Storage>()),
-      listen_fd_(INVALID_SOCKET) {
+      repl_master_(std::make_unique<ReplicationMaster>()),
+      master_port_(0),
+      repl_compress_(false),
+      raft_enabled_(false),
+      next_tracking_id_(0),
+      tracking_count_(0),
+      listen_fd_(INVALID_SOCKET),
+      unix_fd_(INVALID_SOCKET) {
 
 #ifdef _WIN32
     // Initialize Winsock
@@ -45,6 +101,44 @@ Server::~Server() {
 #endif
 }
 
+void Server::set_replica_of(const std::string& host, int port, bool compress) {
+    master_host_ = host;
+    master_port_ = port;
+    repl_compress_ = compress;
+}
+
+bool Server::enable_raft(const RaftConfig& config) {
+    // A node that cannot persist its term, vote and log must not join
+    if (!config.data_dir.empty() && !RaftNode::prepare_data_dir(config.data_dir)) {
+        std::cerr << "Raft: cannot create data directory " << config.data_dir << "\n";
+        return false;
+    }
+    raft_config_ = config;
+    raft_enabled_ = true;
+    return true;
+}
+
+bool Server::enable_cluster(const std::string& config_path, const std::string& host,
+                            const GossipConfig& gossip) {
+    auto cluster = std::make_unique<ClusterState>(config_path);
+    if (!cluster->init(host, port_)) {
+        return false;
+    }
+    cluster_ = std::move(cluster);
+    gossip_config_ = gossip;
+    return true;
+}
+
+bool Server::set_unix_socket(const std::string& path) {
+#ifdef _WIN32
+    (void)path;
+    return false;
+#else
+    unix_path_ = path;
+    return true;
+#endif
+}
+
 bool Server::init_socket() {
     // Create socket
     listen_fd_ = socket(AF_INET, SOCK_STREAM, 0);
@@ -84,6 +178,56 @@ bool Server::init_socket() {
     return true;
 }
 
+bool Server::init_unix_socket() {
+#ifdef _WIN32
+    return false;
+#else
+    struct sockaddr_un addr;
+    std::memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    if (unix_path_.size() >= sizeof(addr.sun_path)) {
+        std::cerr << "Unix socket path too long: " << unix_path_ << "\n";
+        return false;
+    }
+    std::memcpy(addr.sun_path, unix_path_.c_str(), unix_path_.size());
+
+    // A socket file outlives a crashed server; anything else at the path
+    // is left alone and makes bind fail
+    struct stat st;
+    if (lstat(unix_path_.c_str(), &st) == 0 && S_ISSOCK(st.st_mode)) {
+        unlink(unix_path_.c_str());
+    }
+
+    unix_fd_ = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (unix_fd_ == INVALID_SOCKET) {
+        std::cerr << "Failed to create unix socket\n";
+        return false;
+    }
+    if (bind(unix_fd_, (struct sockaddr*)&addr, sizeof(addr)) == SOCKET_ERROR ||
+        listen(unix_fd_, 10) == SOCKET_ERROR) {
+        std::cerr << "Failed to listen on unix socket " << unix_path_ << "\n";
+        CLOSE_SOCKET(unix_fd_);
+        unix_fd_ = INVALID_SOCKET;
+        return false;
+    }
+    return true;
+#endif
+}
+
+void Server::close_listeners() {
+    if (listen_fd_ != INVALID_SOCKET) {
+        CLOSE_SOCKET(listen_fd_);
+        listen_fd_ = INVALID_SOCKET;
+    }
+    if (unix_fd_ != INVALID_SOCKET) {
+        CLOSE_SOCKET(unix_fd_);
+        unix_fd_ = INVALID_SOCKET;
+#ifndef _WIN32
+        unlink(unix_path_.c_str());
+#endif
+    }
+}
+
 void Server::start() {
     if (running_) {
         std::cerr << "Server already running\n";
@@ -93,17 +237,66 @@ void Server::start() {
     if (!init_socket()) {
         return;
     }
+    if (!unix_path_.empty() && !init_unix_socket()) {
+        close_listeners();
+        return;
+    }
 
     running_ = true;
     std::cout << "DistKV server starting on port " << port_ << "...\n";
+    if (unix_fd_ != INVALID_SOCKET) {
+        std::cout << "Listening on unix socket " << unix_path_ << "\n";
+    }
+
+    if (!master_host_.empty()) {
+        repl_slave_ = std::make_unique<ReplicationSlave>(*storage_, [this](const Request& req) {
+            std::lock_guard<std::mutex> lock(write_mutex_);
+            if (apply_command(req).status == StatusCode::OK && Protocol::has_key(req.command)) {
+                invalidate(req.args[0]);
+            }
+        });
+        repl_slave_->connect_to_master(master_host_, master_port_, repl_compress_);
+        std::cout << "Replicating from " << master_host_ << ":" << master_port_ << "\n";
+    }
+
+    if (raft_enabled_) {
+        raft_ = std::make_unique<RaftNode>(raft_config_, *storage_, [this](const std::string& cmd) {
+            std::lock_guard<std::mutex> lock(write_mutex_);
+            return apply_and_replicate(Protocol::parse_request(cmd), nullptr);
+        });
+        if (!raft_->start()) {
+            running_ = false;
+            close_listeners();
+            return;
+        }
+    }
+
+    if (cluster_) {
+        cluster_bus_ = std::make_unique<ClusterBus>(*cluster_, gossip_config_);
+        if (!cluster_bus_->start()) {
+            running_ = false;
+            close_listeners();
+            return;
+        }
+    }
     std::cout << "Ready to accept connections.\n";
 
-    // Accept connections in main thread (simple approach for now)
-    while (running_) {
-        struct sockaddr_in client_addr;
-        socklen_t client_len = sizeof(client_addr);
+    // TCP connections are accepted in this thread, Unix socket ones in
+    // another; both end when stop() shuts the listeners down
+    std::thread unix_acceptor;
+    if (unix_fd_ != INVALID_SOCKET) {
+        unix_acceptor = std::thread([this]() { accept_loop(unix_fd_, false); });
+    }
+    accept_loop(listen_fd_, true);
+    if (unix_acceptor.joinable()) {
+        unix_acceptor.join();
+    }
+    close_listeners();
+}
 
-        int client_fd = accept(listen_fd_, (struct sockaddr*)&client_addr, &client_len);
+void Server::accept_loop(int listen_fd, bool tcp) {
+    while (running_) {
+        int client_fd = accept(listen_fd, nullptr, nullptr);
 
         if (client_fd == INVALID_SOCKET) {
             if (running_) {
@@ -112,9 +305,29 @@ void Server::start() {
             continue;
         }
 
+        if (tcp) {
+            net::set_nodelay(client_fd);
+        }
+
+        // stop() waits for every registered connection; one accepted
+        // while stopping is dropped right away
+        {
+            std::lock_guard<std::mutex> lock(clients_mutex_);
+            if (!running_) {
+                CLOSE_SOCKET(client_fd);
+                break;
+            }
+            client_fds_.insert(client_fd);
+        }
+
         // Handle client in separate thread
         std::thread([this, client_fd]() {
             handle_client(client_fd);
+
+            std::lock_guard<std::mutex> lock(clients_mutex_);
+            client_fds_.erase(client_fd);
+            CLOSE_SOCKET(client_fd);
+            clients_cv_.notify_all();
         }).detach();
     }
 }
@@ -126,9 +339,34 @@ void Server::stop() {
 
     running_ = false;
 
+    if (repl_slave_) {
+        repl_slave_->stop();
+    }
+    if (raft_) {
+        raft_->stop();
+    }
+    if (cluster_bus_) {
+        cluster_bus_->stop();
+    }
+    repl_master_->shutdown();
+
+    // Wake accept(); start() closes the listeners once its accept loops
+    // are done with them
     if (listen_fd_ != INVALID_SOCKET) {
-        CLOSE_SOCKET(listen_fd_);
-        listen_fd_ = INVALID_SOCKET;
+        net::shutdown_socket(listen_fd_);
+    }
+    if (unix_fd_ != INVALID_SOCKET) {
+        net::shutdown_socket(unix_fd_);
+    }
+
+    // Disconnect all clients and wait until their threads are done with
+    // this server
+    {
+        std::unique_lock<std::mutex> lock(clients_mutex_);
+        for (int fd : client_fds_) {
+            net::shutdown_socket(fd);
+        }
+        clients_cv_.wait(lock, [this]() { return client_fds_.empty(); });
     }
 
     std::cout << "Server stopped.\n";
@@ -137,56 +375,1040 @@ void Server::stop() {
 void Server::handle_client(int client_fd) {
     char buffer[4096];
     std::string accumulated;
+    std::string replies;
+    ClientSession session(client_fd);
+
+    // Requests arrive on the socket, or in the request ring once the
+    // client moved to shared memory
+    std::unique_ptr<ShmChannel> shm;
+    auto read_some = [&]() -> long {
+        if (shm) {
+            long n;
+            while ((n = shm->read(buffer, sizeof(buffer) - 1)) == 0) {
+            }
+            return n;
+        }
+        return static_cast<long>(recv(client_fd, buffer, sizeof(buffer) - 1, 0));
+    };
+
+    // However the session ends, nobody may reach it (or its segment)
+    // afterwards
+    struct Cleanup {
+        Server& server;
+        ClientSession& session;
+        ~Cleanup() {
+            if (session.is_replica) {
+                server.repl_master_->unregister_slave(session.fd);
+            }
+            server.stop_tracking(session);
+            std::lock_guard<std::mutex> lock(session.send_mutex);
+            session.shm = nullptr;
+        }
+    } cleanup{*this, session};
+
+    // Replies to the commands of one read go out in one send, together
+    // with invalidations queued for this client (and any queued while
+    // sending right after)
+    auto flush = [&]() {
+        bool sent = true;
+        {
+            std::lock_guard<std::mutex> lock(session.send_mutex);
+            if (session.tracking_id != 0) {
+                std::lock_guard<std::mutex> push_lock(session.push_mutex);
+                replies += session.pushes;
+                session.pushes.clear();
+            }
+            if (!replies.empty()) {
+                sent = session.shm ? session.shm->write(replies.data(), replies.size())
+                                   : net::send_all(client_fd, replies);
+            }
+        }
+        replies.clear();
+        return sent && (session.tracking_id == 0 || send_pushes(session, true));
+    };
+
+    // Binary requests are decoded in place; parsed counts the bytes of
+    // accumulated already consumed that way
+    BinaryProtocol::Frame frame;
+    size_t parsed = 0;
+    uint16_t request_id = 0;
+    auto respond = [&](const Response& resp) {
+        if (session.binary) {
+            BinaryProtocol::append_response(replies, request_id, resp);
+        } else {
+            replies += Protocol::serialize_response(resp);
+        }
+    };
 
     while (running_) {
-#ifdef _WIN32
-        int bytes_read = recv(client_fd, buffer, sizeof(buffer) - 1, 0);
-#else
-        ssize_t bytes_read = recv(client_fd, buffer, sizeof(buffer) - 1, 0);
-#endif
+        long bytes_read = read_some();
 
         if (bytes_read <= 0) {
             break;  // Connection closed or error
         }
 
-        buffer[bytes_read] = '\0';
-        accumulated += buffer;
+        accumulated.append(buffer, bytes_read);
 
-        // Process complete commands (ending with \n)
-        size_t pos;
-        while ((pos = accumulated.find('\n')) != std::string::npos) {
-            std::string line = accumulated.substr(0, pos);
-            accumulated = accumulated.substr(pos + 1);
+        // Process complete commands (frames, or lines ending with \n)
+        while (true) {
+            Request req;
+            if (session.binary) {
+                size_t needed;
+                auto status = BinaryProtocol::parse(accumulated.data(), accumulated.size(), parsed,
+                                                    frame, needed);
+                if (status == BinaryProtocol::Status::NEED_MORE) {
+                    break;
+                }
+                if (status == BinaryProtocol::Status::ERROR) {
+                    // Frame boundaries are lost with it
+                    request_id = 0;
+                    respond(Response(StatusCode::ERROR, "protocol error"));
+                    flush();
+                    return;
+                }
+                request_id = frame.id;
+                req = BinaryProtocol::to_request(frame);
+            } else {
+                size_t pos = accumulated.find('\n');
+                if (pos == std::string::npos) {
+                    break;
+                }
+                std::string line = accumulated.substr(0, pos);
+                accumulated = accumulated.substr(pos + 1);
+
+                // Remove carriage return if present
+                if (!line.empty() && line.back() == '\r') {
+                    line.pop_back();
+                }
+
+                if (line.empty()) {
+                    continue;
+                }
+
+                // Parse and execute command
+                req = Protocol::parse_request(line);
+            }
+
+            // A replica link only carries offset acknowledgements back
+            if (session.is_replica) {
+                if (req.command == CommandType::REPLCONF && req.args.size() == 2 &&
+                    req.args[0] == "ACK") {
+                    try {
+                        repl_master_->acknowledge(client_fd, std::stoull(req.args[1]));
+                    } catch (...) {
+                    }
+                }
+                continue;
+            }
 
-            // Remove carriage return if present
-            if (!line.empty() && line.back() == '\r') {
-                line.pop_back();
+            if (req.command == CommandType::PROTOCOL) {
+                if (switch_protocol(req, session, request_id, replies) && !session.binary) {
+                    // Text parsing starts where the frames ended
+                    accumulated.erase(0, parsed);
+                    parsed = 0;
+                }
+                continue;
             }
 
-            if (line.empty()) {
+            // These hand the connection's raw stream over, which only
+            // the text protocol leaves alone
+            if (session.binary && (req.command == CommandType::SHM ||
+                                   req.command == CommandType::SYNC ||
+                                   req.command == CommandType::IMPORTBATCH)) {
+                respond(Response(StatusCode::ERROR, Protocol::command_to_string(req.command) +
+                                                        " is not supported over the binary protocol"));
                 continue;
             }
 
-            // Parse and execute command
-            Request req = Protocol::parse_request(line);
-            Response resp = execute_command(req);
+            // The segment travels with the reply, so that goes out on its own
+            if (req.command == CommandType::SHM) {
+                flush();
+                Response error;
+                if (attach_shm(req, session, shm, error)) {
+                    accumulated.clear();  // nothing may follow SHM before its reply
+                } else {
+                    respond(error);
+                }
+                continue;
+            }
 
-            // Send response
-            std::string response_str = Protocol::serialize_response(resp);
-            send(client_fd, response_str.c_str(), response_str.length(), 0);
+            if (req.command == CommandType::SYNC) {
+                if (shm) {
+                    respond(Response(StatusCode::ERROR, "SYNC is not supported over shared memory"));
+                    continue;
+                }
+                if (repl_slave_) {
+                    respond(Response(StatusCode::ERROR, "replica chaining is not supported"));
+                    continue;
+                }
+                // "SYNC COMPRESS" asks for a compressed stream
+                bool compress = !req.args.empty() && (req.args[0] == "COMPRESS" ||
+                                                      req.args[0] == "compress");
+                flush();
+                std::lock_guard<std::mutex> lock(write_mutex_);
+                repl_master_->register_slave(client_fd, *storage_, compress);
+                session.is_replica = true;
+                continue;
+            }
+
+            // IMPORTBATCH <n> is followed by n bytes of encoded entries
+            if (req.command == CommandType::IMPORTBATCH) {
+                // Capped like any other bulk length; past a bad length the
+                // rest of the stream cannot be framed, so drop the client
+                const std::string count = req.args.size() == 1 ? req.args[0] : "";
+                bool valid = !count.empty() && count.size() <= 19 &&
+                             count.find_first_not_of("0123456789") == std::string::npos;
+                uint64_t len = valid ? std::strtoull(count.c_str(), nullptr, 10) : 0;
+                if (!valid || len > BinaryProtocol::MAX_ELEMENT_BYTES) {
+                    respond(Response(StatusCode::ERROR, "invalid IMPORTBATCH length"));
+                    flush();
+                    return;
+                }
+                if (accumulated.size() < len) {
+                    // The sender may wait for earlier acks before sending more
+                    flush();
+                }
+                while (accumulated.size() < len) {
+                    bytes_read = read_some();
+                    if (bytes_read <= 0) {
+                        return;
+                    }
+                    accumulated.append(buffer, bytes_read);
+                }
+                std::string payload = accumulated.substr(0, len);
+                accumulated.erase(0, len);
+
+                respond(import_batch(payload));
+                continue;
+            }
+
+            Response resp = execute_command(req, session);
+
+            respond(resp);
 
             // Check for QUIT command
             if (req.command == CommandType::QUIT) {
-                CLOSE_SOCKET(client_fd);
+                flush();
                 return;
             }
         }
+
+        if (parsed > 0) {
+            accumulated.erase(0, parsed);
+            parsed = 0;
+        }
+
+        if (!flush()) {
+            break;
+        }
+    }
+}
+
+bool Server::switch_protocol(const Request& req, ClientSession& session, uint16_t id,
+                             std::string& replies) {
+    std::string mode = req.args.size() == 1 ? req.args[0] : "";
+    std::transform(mode.begin(), mode.end(), mode.begin(), [](unsigned char c) { return std::toupper(c); });
+    Response resp(StatusCode::OK);
+    if (mode != "TEXT" && mode != "BINARY") {
+        resp = Response(StatusCode::ERROR, "expected PROTOCOL TEXT|BINARY");
+    }
+
+    std::lock_guard<std::mutex> lock(session.push_mutex);
+    replies += session.pushes;
+    session.pushes.clear();
+    if (session.binary) {
+        BinaryProtocol::append_response(replies, id, resp);
+    } else {
+        replies += Protocol::serialize_response(resp);
+    }
+    if (resp.status != StatusCode::OK) {
+        return false;
+    }
+    session.binary = mode == "BINARY";
+    return true;
+}
+
+bool Server::attach_shm(const Request& req, ClientSession& session,
+                        std::unique_ptr<ShmChannel>& shm, Response& error) {
+    if (shm || session.is_replica) {
+        error = Response(StatusCode::ERROR, "connection cannot switch to shared memory");
+        return false;
+    }
+    if (!net::is_unix_socket(session.fd)) {
+        error = Response(StatusCode::ERROR, "SHM is only available over the Unix socket");
+        return false;
+    }
+
+    size_t ring_bytes = 1024 * 1024;
+    int spin_us = 50;
+    if (req.args.size() > 2) {
+        error = Response(StatusCode::INVALID_ARGS);
+        return false;
+    }
+    try {
+        if (!req.args.empty()) {
+            ring_bytes = std::stoull(req.args[0]);
+        }
+        if (req.args.size() == 2) {
+            spin_us = std::stoi(req.args[1]);
+        }
+    } catch (...) {
+        error = Response(StatusCode::INVALID_ARGS);
+        return false;
+    }
+    spin_us = std::max(std::min(spin_us, 1000000), -1);
+
+    auto channel = ShmChannel::create(ring_bytes);
+    if (!channel) {
+        error = Response(StatusCode::ERROR, "shared memory is not available");
+        return false;
+    }
+    channel->set_spin_us(spin_us);
+    channel->set_alive_check([this, &session]() { return running_ && net::peer_open(session.fd); });
+
+    std::lock_guard<std::mutex> lock(session.send_mutex);
+    if (!net::send_with_fd(session.fd, Protocol::serialize_response(Response(StatusCode::OK)),
+                           channel->fd())) {
+        error = Response(StatusCode::ERROR, "failed to pass the segment");
+        return false;
+    }
+    session.shm = channel.get();
+    shm = std::move(channel);
+    return true;
+}
+
+Response Server::execute_command(const Request& req, ClientSession& session) {
+    // Keyed commands run under the shared migration lock, so a slot
+    // migration only copies or drops keys between commands
+    std::shared_lock<std::shared_mutex> migration_lock(migration_mutex_, std::defer_lock);
+    if (cluster_) {
+        if (Protocol::has_key(req.command) || req.command == CommandType::BOUNDED) {
+            migration_lock.lock();
+        }
+        // BOUNDED is routed by the read it wraps, ASKING included (below)
+        Response redirect;
+        if (req.command != CommandType::BOUNDED && !cluster_route(req, session, redirect)) {
+            return redirect;
+        }
+    }
+
+    if (Protocol::is_write_command(req.command)) {
+        if (repl_slave_) {
+            return Response(StatusCode::ERROR, "READONLY You can't write against a read only replica");
+        }
+
+        if (raft_) {
+            // Committed through the Raft log; the leader applies it
+            Response resp;
+            if (!raft_->propose(Protocol::serialize_request(req), resp)) {
+                return raft_redirect();
+            }
+            return resp;
+        }
+
+        std::lock_guard<std::mutex> lock(write_mutex_);
+        return apply_and_replicate(req, &session);
+    }
+
+    if (Protocol::is_read_command(req.command)) {
+        Response error;
+        if (!within_staleness(session.max_lag_ms, session.max_lag_offset, error)) {
+            return error;
+        }
+        track_read(req, session);
+        return apply_command(req);
+    }
+
+    switch (req.command) {
+        case CommandType::WAIT: {
+            if (req.args.size() != 2) {
+                return Response(StatusCode::INVALID_ARGS);
+            }
+            try {
+                int num_replicas = std::stoi(req.args[0]);
+                int timeout_ms = std::stoi(req.args[1]);
+                if (num_replicas < 0 || timeout_ms < 0) {
+                    throw std::invalid_argument("negative");
+                }
+                int acked = repl_master_->wait_for_replicas(
+                    session.last_write_offset, num_replicas, timeout_ms);
+                return Response(StatusCode::OK, std::to_string(acked));
+            } catch (...) {
+                return Response(StatusCode::ERROR, "invalid WAIT arguments");
+            }
+        }
+
+        case CommandType::REPLCONF:
+            return Response(StatusCode::OK);
+
+        case CommandType::STALENESS: {
+            // STALENESS -> current lag; STALENESS MS|OFFSET <n> | OFF -> bound reads
+            if (req.args.empty()) {
+                int64_t lag_ms = repl_slave_ ? repl_slave_->lag_ms() : 0;
+                uint64_t lag_offset = repl_slave_ ? repl_slave_->lag_offset() : 0;
+                return Response(StatusCode::OK, std::vector<std::string>{
+                    std::to_string(lag_ms), std::to_string(lag_offset)});
+            }
+            if (req.args.size() == 1 && (req.args[0] == "OFF" || req.args[0] == "off")) {
+                session.max_lag_ms = -1;
+                session.max_lag_offset = -1;
+                return Response(StatusCode::OK);
+            }
+            if (req.args.size() != 2) {
+                return Response(StatusCode::INVALID_ARGS);
+            }
+            if (!parse_staleness_bound(req.args[0], req.args[1],
+                                       session.max_lag_ms, session.max_lag_offset)) {
+                return Response(StatusCode::ERROR, "invalid staleness bound");
+            }
+            return Response(StatusCode::OK);
+        }
+
+        case CommandType::BOUNDED: {
+            // BOUNDED MS|OFFSET <n> <read command...>: one-off bound for a read
+            // ASKING is spent on this command even if the read never gets
+            // as far as routing
+            bool asking = session.asking;
+            session.asking = false;
+            if (req.args.size() < 3) {
+                return Response(StatusCode::INVALID_ARGS);
+            }
+            int64_t max_lag_ms = session.max_lag_ms;
+            int64_t max_lag_offset = session.max_lag_offset;
+            if (!parse_staleness_bound(req.args[0], req.args[1], max_lag_ms, max_lag_offset)) {
+                return Response(StatusCode::ERROR, "invalid staleness bound");
+            }
+
+            std::string line = req.args[2];
+            for (size_t i = 3; i < req.args.size(); ++i) {
+                line += " " + req.args[i];
+            }
+            Request inner = Protocol::parse_request(line);
+            if (!Protocol::is_read_command(inner.command)) {
+                return Response(StatusCode::ERROR, "BOUNDED only applies to read commands");
+            }
+
+            Response error;
+            if (!within_staleness(max_lag_ms, max_lag_offset, error)) {
+                return error;
+            }
+            if (cluster_) {
+                session.asking = asking;
+                if (!cluster_route(inner, session, error)) {
+                    return error;
+                }
+            }
+            track_read(inner, session);
+            return apply_command(inner);
+        }
+
+        case CommandType::CLUSTER:
+            return cluster_command(req);
+
+        case CommandType::CLIENT:
+            return client_command(req, session);
+
+        case CommandType::ASKING:
+            if (!cluster_) {
+                return Response(StatusCode::ERROR, "This instance has cluster support disabled");
+            }
+            session.asking = true;
+            return Response(StatusCode::OK);
+
+        default:
+            return apply_command(req);
+    }
+}
+
+Response Server::apply_and_replicate(const Request& req, ClientSession* session) {
+    Response resp = apply_command(req);
+    if (resp.status == StatusCode::OK && repl_master_->has_slaves()) {
+        uint64_t offset = repl_master_->replicate_command(Protocol::serialize_request(req));
+        if (session) {
+            session->last_write_offset = offset;
+        }
+    }
+    if (resp.status == StatusCode::OK && Protocol::has_key(req.command)) {
+        invalidate(req.args[0]);
+    }
+    return resp;
+}
+
+Response Server::raft_redirect() const {
+    if (raft_->is_leader()) {
+        return Response(StatusCode::ERROR, "TRYAGAIN write was not committed in time");
+    }
+
+    int leader = raft_->leader_id();
+    for (const auto& peer : raft_config_.peers) {
+        if (peer.id == leader) {
+            return Response(StatusCode::ERROR, "NOTLEADER " + peer.host + ":" +
+                            std::to_string(peer.port - RAFT_PORT_OFFSET));
+        }
+    }
+    return Response(StatusCode::ERROR, "NOTLEADER no leader elected");
+}
+
+bool Server::cluster_route(const Request& req, ClientSession& session, Response& redirect) {
+    // ASKING only applies to the command right after it
+    bool asking = session.asking;
+    session.asking = false;
+
+    if (!Protocol::has_key(req.command) || req.args.empty()) {
+        return true;
+    }
+
+    int slot = key_hash_slot(req.args[0]);
+    SlotState state = cluster_->slot_state(slot);
+
+    if (state.mine) {
+        if (!state.migrating_to) {
+            return true;
+        }
+        // Keys in flight to the target can be read but not changed
+        if (migrating_keys_.count(req.args[0])) {
+            if (Protocol::is_write_command(req.command)) {
+                redirect = Response(StatusCode::ERROR, "TRYAGAIN key is being migrated");
+                return false;
+            }
+            return true;
+        }
+        // Keys already moved to the migration target are served there
+        if (!storage_->exists(req.args[0])) {
+            redirect = Response(StatusCode::ASK, std::to_string(slot) + " " +
+                                state.migrating_to->address());
+            return false;
+        }
+        return true;
     }
 
-    CLOSE_SOCKET(client_fd);
+    if (state.importing && asking) {
+        return true;
+    }
+    if (!state.assigned) {
+        redirect = Response(StatusCode::ERROR, "CLUSTERDOWN Hash slot not served");
+        return false;
+    }
+    redirect = Response(StatusCode::MOVED, std::to_string(slot) + " " + state.owner.address());
+    return false;
+}
+
+Response Server::cluster_command(const Request& req) {
+    if (!cluster_) {
+        return Response(StatusCode::ERROR, "This instance has cluster support disabled");
+    }
+    if (req.args.empty()) {
+        return Response(StatusCode::INVALID_ARGS);
+    }
+
+    std::string sub = req.args[0];
+    std::transform(sub.begin(), sub.end(), sub.begin(),
+                   [](unsigned char c) { return std::toupper(c); });
+    const size_t argc = req.args.size();
+
+    // Parse req.args[from..] as slot numbers
+    auto parse_slots = [&req](size_t from, std::vector<int>& slots) {
+        for (size_t i = from; i < req.args.size(); ++i) {
+            int slot = ClusterState::parse_slot(req.args[i]);
+            if (slot < 0) {
+                return false;
+            }
+            slots.push_back(slot);
+        }
+        return !slots.empty();
+    };
+
+    if (sub == "MYID" && argc == 1) {
+        return Response(StatusCode::OK, cluster_->myself_id());
+    }
+    if (sub == "NODES" && argc == 1) {
+        return Response(StatusCode::OK, cluster_->describe_nodes());
+    }
+    if (sub == "INFO" && argc == 1) {
+        return Response(StatusCode::OK, cluster_->info());
+    }
+    if (sub == "KEYSLOT" && argc == 2) {
+        return Response(StatusCode::OK, std::to_string(key_hash_slot(req.args[1])));
+    }
+
+    if (sub == "MEET" && argc == 3) {
+        int port = std::atoi(req.args[2].c_str());
+        if (!cluster_bus_ || !cluster_bus_->meet(req.args[1], port)) {
+            return Response(StatusCode::ERROR, "Invalid node address specified: " +
+                            req.args[1] + ":" + req.args[2]);
+        }
+        return Response(StatusCode::OK);
+    }
+    if (sub == "ADDNODE" && argc == 4) {
+        int port = std::atoi(req.args[3].c_str());
+        if (!cluster_->add_node(req.args[1], req.args[2], port)) {
+            return Response(StatusCode::ERROR, "invalid node address");
+        }
+        return Response(StatusCode::OK);
+    }
+    if (sub == "FORGET" && argc == 2) {
+        if (!cluster_->forget_node(req.args[1])) {
+            return Response(StatusCode::ERROR, "Unknown node " + req.args[1]);
+        }
+        return Response(StatusCode::OK);
+    }
+
+    if (sub == "ADDSLOTS" || sub == "DELSLOTS") {
+        std::vector<int> slots;
+        if (!parse_slots(1, slots)) {
+            return Response(StatusCode::ERROR, "Invalid or out of range slot");
+        }
+        bool ok = sub == "ADDSLOTS" ? cluster_->add_slots(slots) : cluster_->del_slots(slots);
+        if (!ok) {
+            return Response(StatusCode::ERROR, "Slot is already busy");
+        }
+        return Response(StatusCode::OK);
+    }
+    if (sub == "ADDSLOTSRANGE" && argc >= 3 && argc % 2 == 1) {
+        std::vector<int> bounds;
+        if (!parse_slots(1, bounds)) {
+            return Response(StatusCode::ERROR, "Invalid or out of range slot");
+        }
+        std::vector<int> slots;
+        for (size_t i = 0; i < bounds.size(); i += 2) {
+            for (int slot = bounds[i]; slot <= bounds[i + 1]; ++slot) {
+                slots.push_back(slot);
+            }
+        }
+        if (slots.empty() || !cluster_->add_slots(slots)) {
+            return Response(StatusCode::ERROR, "Slot is already busy");
+        }
+        return Response(StatusCode::OK);
+    }
+
+    if (sub == "SETSLOT" && argc >= 3) {
+        std::string action = req.args[2];
+        std::transform(action.begin(), action.end(), action.begin(),
+                       [](unsigned char c) { return std::toupper(c); });
+
+        // SETSLOT <start>-<end> NODE|MIGRATING|IMPORTING <id> marks a whole
+        // range at once
+        size_t dash = req.args[1].find('-');
+        if (dash != std::string::npos && argc == 4) {
+            int start = ClusterState::parse_slot(req.args[1].substr(0, dash));
+            int stop = ClusterState::parse_slot(req.args[1].substr(dash + 1));
+            if (start < 0 || stop < start) {
+                return Response(StatusCode::ERROR, "Invalid or out of range slot");
+            }
+            std::vector<int> slots;
+            for (int slot = start; slot <= stop; ++slot) {
+                slots.push_back(slot);
+            }
+            bool ok = false;
+            if (action == "NODE") {
+                ok = cluster_->assign_slots(slots, req.args[3]);
+            } else if (action == "MIGRATING") {
+                ok = cluster_->set_migrating(slots, req.args[3]);
+            } else if (action == "IMPORTING") {
+                ok = cluster_->set_importing(slots, req.args[3]);
+            } else {
+                return Response(StatusCode::INVALID_ARGS);
+            }
+            if (!ok) {
+                return Response(StatusCode::ERROR, "SETSLOT " + action + " rejected for slots " +
+                                req.args[1]);
+            }
+            return Response(StatusCode::OK);
+        }
+
+        int slot = ClusterState::parse_slot(req.args[1]);
+        if (slot < 0) {
+            return Response(StatusCode::ERROR, "Invalid or out of range slot");
+        }
+
+        bool ok = false;
+        if (action == "STABLE" && argc == 3) {
+            cluster_->set_stable(slot);
+            ok = true;
+        } else if (action == "NODE" && argc == 4) {
+            ok = cluster_->assign_slots({slot}, req.args[3]);
+        } else if (action == "MIGRATING" && argc == 4) {
+            ok = cluster_->set_migrating(slot, req.args[3]);
+        } else if (action == "IMPORTING" && argc == 4) {
+            ok = cluster_->set_importing(slot, req.args[3]);
+        } else {
+            return Response(StatusCode::INVALID_ARGS);
+        }
+        if (!ok) {
+            return Response(StatusCode::ERROR, "SETSLOT " + action + " rejected for slot " +
+                            std::to_string(slot));
+        }
+        return Response(StatusCode::OK);
+    }
+
+    // MIGRATESLOT <slot>|<start>-<end> <target-id> [keys-per-batch]
+    if (sub == "MIGRATESLOT" && (argc == 3 || argc == 4)) {
+        size_t dash = req.args[1].find('-');
+        int start = ClusterState::parse_slot(req.args[1].substr(0, dash));
+        int stop = dash == std::string::npos ? start
+                                             : ClusterState::parse_slot(req.args[1].substr(dash + 1));
+        if (start < 0 || stop < start) {
+            return Response(StatusCode::ERROR, "Invalid or out of range slot");
+        }
+        long batch_keys = argc == 4 ? std::atol(req.args[3].c_str())
+                                    : static_cast<long>(MIGRATION_BATCH_KEYS);
+        if (batch_keys <= 0) {
+            return Response(StatusCode::INVALID_ARGS);
+        }
+        std::vector<int> slots;
+        for (int slot = start; slot <= stop; ++slot) {
+            slots.push_back(slot);
+        }
+        return migrate_slots(slots, req.args[2], static_cast<size_t>(batch_keys));
+    }
+
+    if ((sub == "COUNTKEYSINSLOT" && argc == 2) || (sub == "GETKEYSINSLOT" && argc == 3)) {
+        int slot = ClusterState::parse_slot(req.args[1]);
+        if (slot < 0) {
+            return Response(StatusCode::ERROR, "Invalid or out of range slot");
+        }
+        long limit = sub == "GETKEYSINSLOT" ? std::atol(req.args[2].c_str()) : -1;
+
+        std::vector<std::string> found;
+        size_t count = 0;
+        for (const auto& key : storage_->keys()) {
+            if (key_hash_slot(key) != slot) {
+                continue;
+            }
+            ++count;
+            if (limit >= 0 && found.size() < static_cast<size_t>(limit)) {
+                found.push_back(key);
+            }
+        }
+        if (sub == "COUNTKEYSINSLOT") {
+            return Response(StatusCode::OK, std::to_string(count));
+        }
+        return Response(StatusCode::OK, found);
+    }
+
+    return Response(StatusCode::ERROR, "unknown CLUSTER subcommand or wrong number of arguments");
+}
+
+Response Server::migrate_slots(const std::vector<int>& slots, const std::string& target_id,
+                               size_t batch_keys) {
+    const std::string myself = cluster_->myself_id();
+    auto target = cluster_->node(target_id);
+    if (!target || target_id == myself) {
+        return Response(StatusCode::ERROR, "Unknown node " + target_id);
+    }
+    for (int slot : slots) {
+        if (!cluster_->slot_state(slot).mine) {
+            return Response(StatusCode::ERROR, "slot " + std::to_string(slot) +
+                            " is not served by this node");
+        }
+    }
+
+    int fd = net::connect_tcp(target->host, target->port);
+    if (fd < 0) {
+        return Response(StatusCode::ERROR, "cannot connect to " + target->address());
+    }
+    // A hung target must not leave migrating_keys_ refusing writes forever:
+    // a missed acknowledgement aborts the migration like a dropped link
+    net::set_recv_timeout(fd, migration_timeout_ms_);
+    net::SocketReader reader(fd);
+    std::string reply;
+    auto acknowledged = [&]() { return reader.read_line(reply) && reply == "+OK"; };
+    auto fail = [&](const std::string& message) {
+        net::close_socket(fd);
+        return Response(StatusCode::ERROR, message + (reply.empty() ? "" : " (" + reply + ")"));
+    };
+
+    // The target must accept ASKed commands before we start redirecting
+    std::string range = std::to_string(slots.front()) + "-" + std::to_string(slots.back());
+    if (!net::send_all(fd, "CLUSTER SETSLOT " + range + " IMPORTING " + myself + "\n") ||
+        !acknowledged()) {
+        return fail("target refused to import slots " + range);
+    }
+
+    // From here on, new keys of these slots are created on the target
+    std::vector<std::string> keys;
+    {
+        std::unique_lock<std::shared_mutex> lock(migration_mutex_);
+        cluster_->set_migrating(slots, target_id);
+        std::vector<bool> moving(CLUSTER_SLOTS, false);
+        for (int slot : slots) {
+            moving[slot] = true;
+        }
+        for (const auto& key : storage_->keys()) {
+            if (moving[key_hash_slot(key)]) {
+                keys.push_back(key);
+            }
+        }
+    }
+
+    // Stream batches, keeping up to MIGRATION_PIPELINE unacknowledged
+    std::deque<std::vector<std::string>> in_flight;
+    size_t next = 0;
+    size_t moved = 0;
+    bool ok = true;
+    while (ok && (next < keys.size() || !in_flight.empty())) {
+        while (next < keys.size() && in_flight.size() < MIGRATION_PIPELINE) {
+            size_t count = std::min(batch_keys, keys.size() - next);
+            std::vector<std::string> batch(keys.begin() + next, keys.begin() + next + count);
+            next += count;
+
+            std::ostringstream payload;
+            {
+                std::unique_lock<std::shared_mutex> lock(migration_mutex_);
+                auto entries = storage_->get_entries(batch);
+                Persistence::write_entries(entries, payload);
+                batch.clear();
+                for (const auto& entry : entries) {
+                    migrating_keys_.insert(entry.first);
+                    batch.push_back(entry.first);
+                }
+            }
+            in_flight.push_back(std::move(batch));
+
+            std::string data = payload.str();
+            if (!net::send_all(fd, "IMPORTBATCH " + std::to_string(data.size()) + "\n" + data)) {
+                ok = false;
+                break;
+            }
+        }
+
+        if (!ok || !acknowledged()) {
+            ok = false;
+            break;
+        }
+
+        // The target stored the oldest batch, drop it here
+        {
+            std::unique_lock<std::shared_mutex> lock(migration_mutex_);
+            std::lock_guard<std::mutex> write_lock(write_mutex_);
+            for (const auto& key : in_flight.front()) {
+                apply_and_replicate(Request(CommandType::DEL, {key}), nullptr);
+                migrating_keys_.erase(key);
+            }
+        }
+        moved += in_flight.front().size();
+        in_flight.pop_front();
+    }
+
+    if (!ok) {
+        // Unacknowledged keys stay here; the slots stay MIGRATING, so running
+        // the command again resumes with the keys that are left
+        std::unique_lock<std::shared_mutex> lock(migration_mutex_);
+        for (const auto& batch : in_flight) {
+            for (const auto& key : batch) {
+                migrating_keys_.erase(key);
+            }
+        }
+        return fail("migration interrupted after " + std::to_string(moved) + " keys");
+    }
+
+    // Hand the slots over: first on the target, then here
+    if (!net::send_all(fd, "CLUSTER SETSLOT " + range + " NODE " + target_id + "\n") ||
+        !acknowledged()) {
+        return fail("target did not take over slots " + range);
+    }
+    {
+        std::unique_lock<std::shared_mutex> lock(migration_mutex_);
+        cluster_->assign_slots(slots, target_id);
+    }
+    net::close_socket(fd);
+
+    std::cout << "Migrated slots " << range << " (" << moved << " keys) to "
+              << target->address() << std::endl;
+    return Response(StatusCode::OK, std::to_string(moved));
+}
+
+Response Server::import_batch(const std::string& payload) {
+    if (!cluster_) {
+        return Response(StatusCode::ERROR, "This instance has cluster support disabled");
+    }
+
+    std::unordered_map<std::string, std::shared_ptr<Value>> entries;
+    std::istringstream is(payload);
+    if (Persistence::read_entries(is, entries) < 0) {
+        return Response(StatusCode::ERROR, "corrupt IMPORTBATCH payload");
+    }
+    for (const auto& entry : entries) {
+        SlotState state = cluster_->slot_state(key_hash_slot(entry.first));
+        if (!state.importing && !state.mine) {
+            return Response(StatusCode::ERROR, "slot " + std::to_string(key_hash_slot(entry.first)) +
+                            " is not being imported");
+        }
+    }
+
+    storage_->merge_entries(entries);
+    for (const auto& entry : entries) {
+        invalidate(entry.first);
+    }
+    return Response(StatusCode::OK);
+}
+
+Response Server::client_command(const Request& req, ClientSession& session) {
+    // CLIENT TRACKING ON|OFF
+    if (req.args.size() != 2) {
+        return Response(StatusCode::INVALID_ARGS);
+    }
+    std::string sub = req.args[0];
+    std::string mode = req.args[1];
+    std::transform(sub.begin(), sub.end(), sub.begin(), [](unsigned char c) { return std::toupper(c); });
+    std::transform(mode.begin(), mode.end(), mode.begin(), [](unsigned char c) { return std::toupper(c); });
+    if (sub != "TRACKING" || (mode != "ON" && mode != "OFF")) {
+        return Response(StatusCode::ERROR, "unknown CLIENT subcommand");
+    }
+
+    if (mode == "OFF") {
+        stop_tracking(session);
+    } else if (session.tracking_id == 0) {
+        std::lock_guard<std::mutex> lock(tracking_mutex_);
+        session.tracking_id = ++next_tracking_id_;
+        tracking_sessions_[session.tracking_id] = &session;
+        ++tracking_count_;
+    }
+    return Response(StatusCode::OK);
+}
+
+void Server::stop_tracking(ClientSession& session) {
+    if (session.tracking_id == 0) {
+        return;
+    }
+    // Once erased no writer can reach the session any more
+    std::lock_guard<std::mutex> lock(tracking_mutex_);
+    tracking_sessions_.erase(session.tracking_id);
+    session.tracking_id = 0;
+    --tracking_count_;
+}
+
+void Server::track_read(const Request& req, ClientSession& session) {
+    if (session.tracking_id == 0 || !Protocol::has_key(req.command) || req.args.empty()) {
+        return;
+    }
+    const std::string& key = req.args[0];
+    {
+        std::lock_guard<std::mutex> lock(tracking_mutex_);
+        auto it = tracked_keys_.find(key);
+        if (it == tracked_keys_.end()) {
+            if (tracked_keys_.size() >= TRACKING_MAX_KEYS) {
+                auto victim = tracked_keys_.begin();
+                for (uint64_t id : victim->second) {
+                    auto reader = tracking_sessions_.find(id);
+                    if (reader != tracking_sessions_.end()) {
+                        queue_push(*reader->second, victim->first);
+                    }
+                }
+                tracked_keys_.erase(victim);
+            }
+            it = tracked_keys_.emplace(key, std::unordered_set<uint64_t>()).first;
+        }
+        it->second.insert(session.tracking_id);
+    }
+
+    // Expiry is lazy and never reported, so a key with a TTL is not
+    // cacheable: the client is told to drop it right after the reply.
+    // Checked after registering, so an EXPIRE racing with it is reported.
+    if (storage_->ttl(key) >= 0) {
+        std::lock_guard<std::mutex> lock(session.push_mutex);
+        append_invalidation(session, key);
+    }
+}
+
+void Server::invalidate(const std::string& key) {
+    if (tracking_count_ == 0) {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(tracking_mutex_);
+    auto it = tracked_keys_.find(key);
+    if (it == tracked_keys_.end()) {
+        return;
+    }
+    for (uint64_t id : it->second) {
+        auto reader = tracking_sessions_.find(id);
+        if (reader != tracking_sessions_.end()) {
+            queue_push(*reader->second, key);
+        }
+    }
+    tracked_keys_.erase(it);
+}
+
+void Server::queue_push(ClientSession& session, const std::string& key) {
+    {
+        std::lock_guard<std::mutex> lock(session.push_mutex);
+        append_invalidation(session, key);
+    }
+    if (!send_pushes(session, false)) {
+        // The client is not reading; rather than block writers or let its
+        // cache go stale, drop the connection (and with it the cache)
+        net::shutdown_socket(session.fd);
+    }
+}
+
+bool Server::send_pushes(ClientSession& session, bool may_block) {
+    while (true) {
+        std::unique_lock<std::mutex> send_lock(session.send_mutex, std::try_to_lock);
+        if (!send_lock.owns_lock()) {
+            // The holder sends them once it is done
+            return true;
+        }
+        std::string out;
+        {
+            std::lock_guard<std::mutex> lock(session.push_mutex);
+            out.swap(session.pushes);
+        }
+        if (out.empty()) {
+            return true;
+        }
+        bool sent;
+        if (session.shm) {
+            sent = may_block ? session.shm->write(out.data(), out.size())
+                             : session.shm->try_write(out.data(), out.size());
+        } else {
+            sent = may_block ? net::send_all(session.fd, out) : net::try_send_all(session.fd, out);
+        }
+        if (!sent) {
+            return false;
+        }
+    }
+}
+
+bool Server::within_staleness(int64_t max_lag_ms, int64_t max_lag_offset, Response& error) const {
+    // Only a replica can be behind; the primary always serves current data
+    if (!repl_slave_ || (max_lag_ms < 0 && max_lag_offset < 0)) {
+        return true;
+    }
+
+    int64_t lag_ms = repl_slave_->lag_ms();
+    if (lag_ms < 0) {
+        error = Response(StatusCode::ERROR, "STALE replica has not synced with its primary");
+        return false;
+    }
+
+    // Cut off from the primary, the lag figures stop growing; whatever the
+    // bound, the replica can't vouch for its data
+    if (!repl_slave_->is_linked()) {
+        error = Response(StatusCode::ERROR, "STALE replica is not linked to its primary");
+        return false;
+    }
+    int64_t heartbeat_age = repl_slave_->heartbeat_age_ms();
+    if (heartbeat_age > ReplicationSlave::HEARTBEAT_TIMEOUT_MS) {
+        error = Response(StatusCode::ERROR, "STALE replica has not heard from its primary for " +
+                         std::to_string(heartbeat_age) + "ms");
+        return false;
+    }
+    if (max_lag_ms >= 0 && lag_ms > max_lag_ms) {
+        error = Response(StatusCode::ERROR, "STALE replica is " + std::to_string(lag_ms) +
+                         "ms behind (bound " + std::to_string(max_lag_ms) + "ms)");
+        return false;
+    }
+
+    uint64_t lag_offset = repl_slave_->lag_offset();
+    if (max_lag_offset >= 0 && lag_offset > static_cast<uint64_t>(max_lag_offset)) {
+        error = Response(StatusCode::ERROR, "STALE replica is " + std::to_string(lag_offset) +
+                         " bytes behind (bound " + std::to_string(max_lag_offset) + ")");
+        return false;
+    }
+    return true;
 }
 
-Response Server::execute_command(const Request& req) {
+Response Server::apply_command(const Request& req) {
     switch (req.command) {
         case CommandType::PING:
             return Response(StatusCode::OK, "PONG");
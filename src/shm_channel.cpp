@@ -0,0 +1,378 @@
+#include "shm_channel.h"
+#include <atomic>
+#include <chrono>
+#include <algorithm>
+#include <cstring>
+#include <new>
+#include <thread>
+
+#ifdef __linux__
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #include <sys/syscall.h>
+    #include <linux/futex.h>
+    #include <unistd.h>
+    #include <ctime>
+#endif
+
+namespace distkv {
+
+// Control block of one ring. head and tail count bytes ever written and
+// read, so head - tail is the fill level; each sits on its own cache line
+// so producer and consumer do not contend. The *_seq words are futexes
+// bumped to wake a sleeper, which first raises its *_sleeping flag.
+struct ShmRing {
+    alignas(64) std::atomic<uint64_t> head;
+    alignas(64) std::atomic<uint64_t> tail;
+    alignas(64) std::atomic<uint32_t> data_seq;
+    std::atomic<uint32_t> reader_sleeping;
+    alignas(64) std::atomic<uint32_t> space_seq;
+    std::atomic<uint32_t> writer_sleeping;
+};
+
+#ifdef __linux__
+
+namespace {
+
+constexpr uint64_t SEGMENT_MAGIC = 0x6873766b74736964ULL;  // "distkvsh"
+constexpr uint32_t SEGMENT_VERSION = 1;
+
+struct SegmentHeader {
+    uint64_t magic;
+    uint32_t version;
+    uint32_t reserved;
+    uint64_t ring_bytes;
+};
+
+// Segment layout: header, request ring, reply ring, request data, reply data
+constexpr size_t RINGS_OFFSET = 64;
+
+size_t data_offset() {
+    size_t end = RINGS_OFFSET + 2 * sizeof(ShmRing);
+    return (end + 4095) & ~size_t(4095);
+}
+
+size_t segment_bytes(size_t ring_bytes) {
+    return data_offset() + 2 * ring_bytes;
+}
+
+static_assert(std::atomic<uint32_t>::is_always_lock_free, "futex words must be plain integers");
+static_assert(std::atomic<uint64_t>::is_always_lock_free, "ring counters must be lock-free");
+static_assert(sizeof(SegmentHeader) <= RINGS_OFFSET, "header overlaps the rings");
+
+inline void cpu_relax() {
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_ia32_pause();
+#elif defined(__aarch64__)
+    asm volatile("yield");
+#endif
+}
+
+uint32_t* futex_word(std::atomic<uint32_t>& word) {
+    return reinterpret_cast<uint32_t*>(&word);
+}
+
+// Shared (not FUTEX_PRIVATE) operations: the word is mapped by two processes
+void futex_wait(std::atomic<uint32_t>& word, uint32_t expected, int timeout_ms) {
+    struct timespec timeout;
+    timeout.tv_sec = timeout_ms / 1000;
+    timeout.tv_nsec = static_cast<long>(timeout_ms % 1000) * 1000000L;
+    syscall(SYS_futex, futex_word(word), FUTEX_WAIT, expected, &timeout, nullptr, 0);
+}
+
+void futex_wake(std::atomic<uint32_t>& word) {
+    syscall(SYS_futex, futex_word(word), FUTEX_WAKE, 1, nullptr, nullptr, 0);
+}
+
+// Wake a side sleeping (or about to sleep) on seq. The waker's own store
+// and this load are seq_cst, as are the sleeper's flag store and its
+// re-check, so either the sleeper sees the store or the waker sees the flag.
+void notify(std::atomic<uint32_t>& seq, std::atomic<uint32_t>& sleeping) {
+    if (sleeping.load(std::memory_order_seq_cst)) {
+        seq.fetch_add(1, std::memory_order_seq_cst);
+        futex_wake(seq);
+    }
+}
+
+// Spinning only pays off when the other side runs at the same time; on
+// one CPU it would just hold off the side being waited for
+bool single_cpu() {
+    static const bool single = std::thread::hardware_concurrency() == 1;
+    return single;
+}
+
+// Wait until ready(): spin for spin_us, then sleep on seq for one slice.
+// False if a slice passed without ready().
+template <typename Ready>
+bool wait_for(Ready ready, std::atomic<uint32_t>& seq, std::atomic<uint32_t>& sleeping, int spin_us) {
+    using Clock = std::chrono::steady_clock;
+    if (single_cpu() && spin_us > 0) {
+        spin_us = 0;
+    }
+    auto start = Clock::now();
+    auto spin_until = start + std::chrono::microseconds(std::max(spin_us, 0));
+    auto slice_end = start + std::chrono::milliseconds(ShmChannel::WAIT_SLICE_MS);
+    for (unsigned i = 0; spin_us != 0; ++i) {
+        if (ready()) {
+            return true;
+        }
+        if (single_cpu()) {
+            std::this_thread::yield();
+        } else {
+            cpu_relax();
+        }
+        if ((i & 63) == 63) {
+            auto now = Clock::now();
+            if (spin_us < 0 ? now >= slice_end : now >= spin_until) {
+                break;
+            }
+        }
+    }
+    if (spin_us < 0) {
+        return false;
+    }
+
+    uint32_t expected = seq.load(std::memory_order_seq_cst);
+    sleeping.store(1, std::memory_order_seq_cst);
+    if (!ready()) {
+        futex_wait(seq, expected, ShmChannel::WAIT_SLICE_MS);
+    }
+    sleeping.store(0, std::memory_order_relaxed);
+    return ready();
+}
+
+size_t round_ring_bytes(size_t ring_bytes) {
+    size_t bytes = ShmChannel::MIN_RING_BYTES;
+    while (bytes < ring_bytes && bytes < ShmChannel::MAX_RING_BYTES) {
+        bytes <<= 1;
+    }
+    return bytes;
+}
+
+} // namespace
+
+ShmChannel::ShmChannel(int fd, void* base, size_t mapped_bytes, size_t capacity, bool server)
+    : fd_(fd),
+      base_(base),
+      mapped_bytes_(mapped_bytes),
+      capacity_(capacity),
+      spin_us_(50),
+      corrupt_(false) {
+    char* bytes = static_cast<char*>(base);
+    ShmRing* requests = reinterpret_cast<ShmRing*>(bytes + RINGS_OFFSET);
+    ShmRing* replies = requests + 1;
+    char* request_data = bytes + data_offset();
+    char* reply_data = request_data + capacity;
+    rx_ = server ? requests : replies;
+    tx_ = server ? replies : requests;
+    rx_data_ = server ? request_data : reply_data;
+    tx_data_ = server ? reply_data : request_data;
+}
+
+std::unique_ptr<ShmChannel> ShmChannel::create(size_t ring_bytes) {
+    size_t capacity = round_ring_bytes(ring_bytes);
+    size_t total = segment_bytes(capacity);
+
+    int fd = memfd_create("distkv-shm", MFD_CLOEXEC);
+    if (fd < 0) {
+        return nullptr;
+    }
+    if (ftruncate(fd, static_cast<off_t>(total)) != 0) {
+        close(fd);
+        return nullptr;
+    }
+    void* base = mmap(nullptr, total, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (base == MAP_FAILED) {
+        close(fd);
+        return nullptr;
+    }
+
+    // A new memfd is zero-filled: both rings start empty
+    char* bytes = static_cast<char*>(base);
+    SegmentHeader* header = new (bytes) SegmentHeader();
+    header->magic = SEGMENT_MAGIC;
+    header->version = SEGMENT_VERSION;
+    header->ring_bytes = capacity;
+    ShmRing* rings = reinterpret_cast<ShmRing*>(bytes + RINGS_OFFSET);
+    new (&rings[0]) ShmRing();
+    new (&rings[1]) ShmRing();
+
+    return std::unique_ptr<ShmChannel>(new ShmChannel(fd, base, total, capacity, true));
+}
+
+std::unique_ptr<ShmChannel> ShmChannel::attach(int fd) {
+    struct stat st;
+    if (fstat(fd, &st) != 0 || static_cast<size_t>(st.st_size) < data_offset()) {
+        close(fd);
+        return nullptr;
+    }
+    size_t total = static_cast<size_t>(st.st_size);
+    void* base = mmap(nullptr, total, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (base == MAP_FAILED) {
+        close(fd);
+        return nullptr;
+    }
+
+    const SegmentHeader* header = static_cast<const SegmentHeader*>(base);
+    size_t capacity = static_cast<size_t>(header->ring_bytes);
+    if (header->magic != SEGMENT_MAGIC || header->version != SEGMENT_VERSION ||
+        capacity != round_ring_bytes(capacity) || segment_bytes(capacity) != total) {
+        munmap(base, total);
+        close(fd);
+        return nullptr;
+    }
+    return std::unique_ptr<ShmChannel>(new ShmChannel(fd, base, total, capacity, false));
+}
+
+ShmChannel::~ShmChannel() {
+    munmap(base_, mapped_bytes_);
+    close(fd_);
+}
+
+long ShmChannel::read(char* buffer, size_t len) {
+    size_t n = read_available(buffer, len);
+    if (n > 0) {
+        return static_cast<long>(n);
+    }
+    if (corrupt_) {
+        return -1;
+    }
+    auto has_data = [this]() {
+        return rx_->head.load(std::memory_order_seq_cst) != rx_->tail.load(std::memory_order_relaxed);
+    };
+    if (!wait_for(has_data, rx_->data_seq, rx_->reader_sleeping, spin_us_)) {
+        return alive_ && !alive_() ? -1 : 0;
+    }
+    n = read_available(buffer, len);
+    return corrupt_ ? -1 : static_cast<long>(n);
+}
+
+bool ShmChannel::check_fill(uint64_t used) {
+    if (used > capacity_) {
+        corrupt_ = true;
+    }
+    return !corrupt_;
+}
+
+size_t ShmChannel::read_available(char* buffer, size_t len) {
+    uint64_t tail = rx_->tail.load(std::memory_order_relaxed);
+    uint64_t head = rx_->head.load(std::memory_order_acquire);
+    if (!check_fill(head - tail)) {
+        return 0;
+    }
+    size_t n = static_cast<size_t>(std::min<uint64_t>(head - tail, len));
+    if (n == 0) {
+        return 0;
+    }
+    size_t offset = static_cast<size_t>(tail & (capacity_ - 1));
+    size_t first = std::min(n, capacity_ - offset);
+    std::memcpy(buffer, rx_data_ + offset, first);
+    std::memcpy(buffer + first, rx_data_, n - first);
+
+    rx_->tail.store(tail + n, std::memory_order_seq_cst);
+    notify(rx_->space_seq, rx_->writer_sleeping);
+    return n;
+}
+
+void ShmChannel::publish(const char* data, size_t len) {
+    uint64_t head = tx_->head.load(std::memory_order_relaxed);
+    size_t offset = static_cast<size_t>(head & (capacity_ - 1));
+    size_t first = std::min(len, capacity_ - offset);
+    std::memcpy(tx_data_ + offset, data, first);
+    std::memcpy(tx_data_, data + first, len - first);
+
+    tx_->head.store(head + len, std::memory_order_seq_cst);
+    notify(tx_->data_seq, tx_->reader_sleeping);
+}
+
+bool ShmChannel::wait_for_room() {
+    // A fill level other than full is room, or corruption for write() to see
+    auto has_room = [this]() {
+        return tx_->head.load(std::memory_order_relaxed) - tx_->tail.load(std::memory_order_seq_cst) !=
+               capacity_;
+    };
+    while (!wait_for(has_room, tx_->space_seq, tx_->writer_sleeping, spin_us_)) {
+        if (alive_ && !alive_()) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool ShmChannel::write(const char* data, size_t len) {
+    while (len > 0) {
+        uint64_t used = tx_->head.load(std::memory_order_relaxed) - tx_->tail.load(std::memory_order_acquire);
+        if (!check_fill(used)) {
+            return false;
+        }
+        size_t room = capacity_ - static_cast<size_t>(used);
+        if (room == 0) {
+            if (!wait_for_room()) {
+                return false;
+            }
+            continue;
+        }
+        size_t n = std::min(room, len);
+        publish(data, n);
+        data += n;
+        len -= n;
+    }
+    return true;
+}
+
+bool ShmChannel::try_write(const char* data, size_t len) {
+    uint64_t used = tx_->head.load(std::memory_order_relaxed) - tx_->tail.load(std::memory_order_acquire);
+    if (!check_fill(used) || capacity_ - static_cast<size_t>(used) < len) {
+        return false;
+    }
+    if (len > 0) {
+        publish(data, len);
+    }
+    return true;
+}
+
+#else // !__linux__
+
+ShmChannel::ShmChannel(int fd, void* base, size_t mapped_bytes, size_t capacity, bool)
+    : fd_(fd), base_(base), mapped_bytes_(mapped_bytes), capacity_(capacity),
+      rx_(nullptr), tx_(nullptr), rx_data_(nullptr), tx_data_(nullptr), spin_us_(0), corrupt_(false) {}
+
+std::unique_ptr<ShmChannel> ShmChannel::create(size_t) {
+    return nullptr;
+}
+
+std::unique_ptr<ShmChannel> ShmChannel::attach(int) {
+    return nullptr;
+}
+
+ShmChannel::~ShmChannel() {}
+
+long ShmChannel::read(char*, size_t) {
+    return -1;
+}
+
+size_t ShmChannel::read_available(char*, size_t) {
+    return 0;
+}
+
+bool ShmChannel::check_fill(uint64_t) {
+    return false;
+}
+
+void ShmChannel::publish(const char*, size_t) {}
+
+bool ShmChannel::wait_for_room() {
+    return false;
+}
+
+bool ShmChannel::write(const char*, size_t) {
+    return false;
+}
+
+bool ShmChannel::try_write(const char*, size_t) {
+    return false;
+}
+
+#endif
+
+} // namespace distkv
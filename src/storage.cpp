@@ -312,6 +312,26 @@ void Storage::restore_snapshot(const std::unordered_map<std::string, std::shared
     data_ = data;
 }
 
+std::unordered_map<std::string, std::shared_ptr<Value>> Storage::get_entries(
+    const std::vector<std::string>& keys) const {
+    std::shared_lock<std::shared_mutex> lock(mutex_);
+    std::unordered_map<std::string, std::shared_ptr<Value>> result;
+    for (const auto& key : keys) {
+        auto it = data_.find(key);
+        if (it != data_.end() && !it->second->is_expired()) {
+            result[key] = it->second;
+        }
+    }
+    return result;
+}
+
+void Storage::merge_entries(const std::unordered_map<std::string, std::shared_ptr<Value>>& data) {
+    std::unique_lock<std::shared_mutex> lock(mutex_);
+    for (const auto& [key, value] : data) {
+        data_[key] = value;
+    }
+}
+
 // ============= Private Helpers =============
 
 void Storage::cleanup_expired(const std::string& key) {
@@ -0,0 +1,172 @@
+#include "../client/async_client.h"
+#include "test_util.h"
+#include <iostream>
+#include <cassert>
+#include <chrono>
+#include <condition_variable>
+#include <future>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace distkv;
+using namespace distkv::test;
+
+class TestRunner {
+public:
+    void run_all() {
+        test_futures();
+        test_many_in_flight();
+        test_callbacks();
+        test_connection_loss();
+
+        std::cout << "\n✓ All tests passed!\n";
+    }
+
+private:
+    void test_futures() {
+        std::cout << "Testing future completion... ";
+
+        TestServer server(27500);
+        AsyncClient client(2);
+        assert(client.connect("127.0.0.1", 27500));
+        assert(client.is_connected());
+
+        auto set = client.set("a", "1");
+        auto get = client.get("a");
+        auto missing = client.get("missing");
+        auto bad = client.command({"NOSUCHCOMMAND"});
+        assert(set.get().ok());
+        assert(get.get().value() == "1");
+        assert(missing.get().is_nil());
+        assert(!bad.get().ok());
+
+        client.disconnect();
+        assert(!client.is_connected());
+        assert(!client.get("a").get().ok());
+        std::cout << "✓\n";
+    }
+
+    void test_many_in_flight() {
+        std::cout << "Testing many in-flight requests over few connections... ";
+
+        TestServer server(27501);
+        AsyncClient client(2);
+        assert(client.connect("127.0.0.1", 27501));
+
+        // Four submitting threads, each with thousands of outstanding futures
+        std::vector<std::thread> threads;
+        for (int t = 0; t < 4; ++t) {
+            threads.emplace_back([&client, t]() {
+                std::vector<std::future<AsyncClient::Reply>> sets;
+                for (int i = 0; i < 5000; ++i) {
+                    sets.push_back(client.set("k:" + std::to_string(t) + ":" + std::to_string(i), std::to_string(i)));
+                }
+                for (auto& f : sets) {
+                    assert(f.get().ok());
+                }
+                std::vector<std::future<AsyncClient::Reply>> gets;
+                for (int i = 0; i < 5000; ++i) {
+                    gets.push_back(client.get("k:" + std::to_string(t) + ":" + std::to_string(i)));
+                }
+                for (int i = 0; i < 5000; ++i) {
+                    assert(gets[i].get().value() == std::to_string(i));
+                }
+            });
+        }
+        for (auto& thread : threads) {
+            thread.join();
+        }
+        assert(client.in_flight() == 0);
+        assert(client.command({"DBSIZE"}).get().integer() == 20000);
+
+        std::cout << "✓\n";
+    }
+
+    void test_callbacks() {
+        std::cout << "Testing callback completion and chaining... ";
+
+        TestServer server(27502);
+        AsyncClient client(1);
+        assert(client.connect("127.0.0.1", 27502));
+
+        std::mutex mutex;
+        std::condition_variable cv;
+        std::vector<int> order;
+        std::string chained;
+
+        // Replies on one connection complete in submission order
+        for (int i = 0; i < 100; ++i) {
+            client.command({"SET", "c" + std::to_string(i), "v"}, [&, i](AsyncClient::Reply reply) {
+                assert(reply.ok());
+                std::lock_guard<std::mutex> lock(mutex);
+                order.push_back(i);
+                cv.notify_all();
+            });
+        }
+
+        // A callback may issue the next command
+        client.command({"SET", "chain", "done"}, [&](AsyncClient::Reply) {
+            client.command({"GET", "chain"}, [&](AsyncClient::Reply reply) {
+                std::lock_guard<std::mutex> lock(mutex);
+                chained = reply.value().value_or("");
+                cv.notify_all();
+            });
+        });
+
+        std::unique_lock<std::mutex> lock(mutex);
+        assert(cv.wait_for(lock, std::chrono::seconds(5), [&]() { return order.size() == 100 && !chained.empty(); }));
+        for (int i = 0; i < 100; ++i) {
+            assert(order[i] == i);
+        }
+        assert(chained == "done");
+
+        std::cout << "✓\n";
+    }
+
+    void test_connection_loss() {
+        std::cout << "Testing connection loss and reconnect... ";
+
+        AsyncClient client(2);
+        {
+            TestServer server(27503);
+            assert(client.connect("127.0.0.1", 27503));
+            assert(client.set("x", "1").get().ok());
+        }
+
+        // The server is gone: requests fail instead of hanging
+        AsyncClient::Reply reply = client.get("x").get();
+        assert(!reply.ok());
+        assert(wait_until([&]() { return !client.is_connected(); }));
+
+        // Connections are reopened in the background once it is back
+        TestServer server(27503);
+        assert(wait_until([&]() { return client.set("y", "2").get().ok(); }));
+        assert(client.get("y").get().value() == "2");
+
+        std::cout << "✓\n";
+    }
+
+    template <typename Pred>
+    static bool wait_until(Pred pred) {
+        for (int attempt = 0; attempt < 500; ++attempt) {
+            if (pred()) {
+                return true;
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
+        return false;
+    }
+};
+
+int main() {
+    std::cout << "\n=================================\n";
+    std::cout << "Running DistKV Async Client Tests\n";
+    std::cout << "=================================\n\n";
+
+    TestRunner runner;
+    runner.run_all();
+
+    return 0;
+}
@@ -0,0 +1,352 @@
+#include "../client/client.h"
+#include "../include/binary_protocol.h"
+#include "test_util.h"
+#include <iostream>
+#include <cassert>
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+
+#ifdef _WIN32
+    #include <winsock2.h>
+#else
+    #include <sys/socket.h>
+#endif
+
+using namespace distkv;
+using namespace distkv::test;
+
+namespace {
+
+// Read from fd until one whole frame is buffered, then decode it from
+// copy, where its views stay valid until the next call
+bool read_frame(int fd, std::string& buffer, BinaryProtocol::Frame& frame, std::string& copy) {
+    while (true) {
+        size_t pos = 0;
+        size_t needed;
+        auto status = BinaryProtocol::parse(buffer.data(), buffer.size(), pos, frame, needed);
+        if (status == BinaryProtocol::Status::ERROR) {
+            return false;
+        }
+        if (status == BinaryProtocol::Status::DONE) {
+            copy = buffer.substr(0, pos);
+            buffer.erase(0, pos);
+            pos = 0;
+            return BinaryProtocol::parse(copy.data(), copy.size(), pos, frame, needed) ==
+                   BinaryProtocol::Status::DONE;
+        }
+        char chunk[4096];
+        long n = static_cast<long>(recv(fd, chunk, sizeof(chunk), 0));
+        if (n <= 0) {
+            return false;
+        }
+        buffer.append(chunk, static_cast<size_t>(n));
+    }
+}
+
+} // namespace
+
+class TestRunner {
+public:
+    void run_all() {
+        test_frames();
+        test_partial_and_malformed();
+        test_frame_sizes();
+        test_client_commands();
+        test_raw_connection();
+        test_invalidations();
+
+        std::cout << "\n✓ All tests passed!\n";
+    }
+
+private:
+    void test_frames() {
+        std::cout << "Testing frame encoding and decoding... ";
+
+        // Varints take 7 bits per byte
+        std::string varint;
+        BinaryProtocol::append_varint(varint, 127);
+        assert(varint.size() == 1);
+        varint.clear();
+        BinaryProtocol::append_varint(varint, 128);
+        assert(varint == std::string("\x80\x01", 2));
+
+        // Arguments keep any bytes, the empty string included
+        std::string value("a b\r\nc\0d", 8);
+        std::string out;
+        BinaryProtocol::append_request(out, 0xBEEF, CommandType::SET, {"key", value, ""});
+        assert(out.substr(0, 3) == "\x01\xEF\xBE");
+
+        BinaryProtocol::Frame frame;
+        size_t pos = 0;
+        size_t needed;
+        assert(BinaryProtocol::parse(out.data(), out.size(), pos, frame, needed) ==
+               BinaryProtocol::Status::DONE);
+        assert(pos == out.size());
+        Request req = BinaryProtocol::to_request(frame);
+        assert(frame.id == 0xBEEF);
+        assert(req.command == CommandType::SET);
+        assert(req.args == std::vector<std::string>({"key", value, ""}));
+
+        // A text command line encodes as its words
+        out.clear();
+        BinaryProtocol::append_request(out, 1, "  lrange  list 0   -1 ");
+        pos = 0;
+        assert(BinaryProtocol::parse(out.data(), out.size(), pos, frame, needed) ==
+               BinaryProtocol::Status::DONE);
+        req = BinaryProtocol::to_request(frame);
+        assert(req.command == CommandType::LRANGE);
+        assert(req.args == std::vector<std::string>({"list", "0", "-1"}));
+
+        // Opcodes outside CommandType decode as UNKNOWN
+        out.clear();
+        BinaryProtocol::append_request(out, 2, static_cast<CommandType>(0x77), {});
+        pos = 0;
+        assert(BinaryProtocol::parse(out.data(), out.size(), pos, frame, needed) ==
+               BinaryProtocol::Status::DONE);
+        assert(BinaryProtocol::to_request(frame).command == CommandType::UNKNOWN);
+
+        // Replies carry the status and the data; frames sit back to back
+        out.clear();
+        BinaryProtocol::append_response(out, 5, Response(StatusCode::OK, std::vector<std::string>{"x", "yz"}));
+        BinaryProtocol::append_response(out, 6, Response(StatusCode::NOT_FOUND));
+        BinaryProtocol::append_invalidation(out, "k");
+        pos = 0;
+        assert(BinaryProtocol::parse(out.data(), out.size(), pos, frame, needed) ==
+               BinaryProtocol::Status::DONE);
+        assert(frame.code == 0 && frame.id == 5 && frame.elements.size() == 2 && frame.elements[1] == "yz");
+        assert(BinaryProtocol::parse(out.data(), out.size(), pos, frame, needed) ==
+               BinaryProtocol::Status::DONE);
+        assert(frame.code == static_cast<uint8_t>(StatusCode::NOT_FOUND) && frame.elements.empty());
+        assert(BinaryProtocol::parse(out.data(), out.size(), pos, frame, needed) ==
+               BinaryProtocol::Status::DONE);
+        assert(frame.code == BinaryProtocol::PUSH && frame.id == 0 && frame.elements[0] == "k");
+        assert(pos == out.size());
+
+        std::cout << "✓\n";
+    }
+
+    void test_partial_and_malformed() {
+        std::cout << "Testing partial and malformed frames... ";
+
+        std::string out;
+        BinaryProtocol::append_request(out, 9, CommandType::SET, {"key", std::string(300, 'v')});
+
+        // Every prefix wants more, and never more than the whole frame
+        BinaryProtocol::Frame frame;
+        for (size_t len = 0; len < out.size(); ++len) {
+            size_t pos = 0;
+            size_t needed = 0;
+            assert(BinaryProtocol::parse(out.data(), len, pos, frame, needed) ==
+                   BinaryProtocol::Status::NEED_MORE);
+            assert(pos == 0);
+            assert(needed > 0 && needed <= out.size());
+        }
+
+        // A varint running past 10 bytes, or absurd counts and lengths
+        std::string bad("\x01\x00\x00", 3);
+        bad += std::string(11, '\xFF');
+        size_t pos = 0;
+        size_t needed;
+        assert(BinaryProtocol::parse(bad.data(), bad.size(), pos, frame, needed) ==
+               BinaryProtocol::Status::ERROR);
+
+        bad = std::string("\x01\x00\x00", 3);
+        BinaryProtocol::append_varint(bad, BinaryProtocol::MAX_ELEMENTS + 1);
+        pos = 0;
+        assert(BinaryProtocol::parse(bad.data(), bad.size(), pos, frame, needed) ==
+               BinaryProtocol::Status::ERROR);
+
+        bad = std::string("\x01\x00\x00\x01", 4);
+        BinaryProtocol::append_varint(bad, BinaryProtocol::MAX_ELEMENT_BYTES + 1);
+        pos = 0;
+        assert(BinaryProtocol::parse(bad.data(), bad.size(), pos, frame, needed) ==
+               BinaryProtocol::Status::ERROR);
+
+        std::cout << "✓\n";
+    }
+
+    void test_frame_sizes() {
+        std::cout << "Testing frames against the text protocol's bytes... ";
+
+        std::string value(100, 'v');
+        std::string binary;
+        BinaryProtocol::append_request(binary, 1, CommandType::SET, {"user:12345678", value});
+        assert(binary.size() <= ("SET user:12345678 " + value + "\n").size());
+
+        // Replies save the delimiters and the decimal lengths
+        std::vector<Response> responses = {
+            Response(StatusCode::OK),
+            Response(StatusCode::NOT_FOUND),
+            Response(StatusCode::OK, value),
+            Response(StatusCode::OK, "1"),
+            Response(StatusCode::OK, std::vector<std::string>(50, "member")),
+        };
+        for (const auto& resp : responses) {
+            binary.clear();
+            BinaryProtocol::append_response(binary, 1, resp);
+            assert(binary.size() < Protocol::serialize_response(resp).size());
+        }
+
+        std::cout << "✓\n";
+    }
+
+    void test_client_commands() {
+        std::cout << "Testing a client on the binary protocol... ";
+
+        TestServer server(27560);
+        Client client;
+        assert(client.connect("127.0.0.1", 27560));
+        assert(!client.is_binary());
+        assert(client.enable_binary());
+        assert(client.is_binary());
+
+        assert(client.ping());
+        assert(client.set("a", "1"));
+        assert(client.get("a") == "1");
+        assert(!client.get("missing"));
+        assert(client.exists("a"));
+        assert(client.ttl("a") == -1);
+        assert(client.rpush("list", "x") == 1);
+        assert(client.rpush("list", "y") == 2);
+        assert(client.lrange("list", 0, -1) == std::vector<std::string>({"x", "y"}));
+        assert(client.sadd("set", "m"));
+        assert(client.smembers("set") == std::vector<std::string>({"m"}));
+        assert(client.dbsize() == 3);
+
+        // Errors read the same as over text
+        Client text;
+        assert(text.connect("127.0.0.1", 27560));
+        auto binary_errors = client.pipeline().command({"FROB"}).command({"GET"}).execute();
+        auto text_errors = text.pipeline().command({"FROB"}).command({"GET"}).execute();
+        for (size_t i = 0; i < 2; ++i) {
+            assert(!binary_errors[i].ok());
+            assert(binary_errors[i].str == text_errors[i].str);
+        }
+
+        // Large values, in place or copied, and pipelines of many windows
+        std::string value(300000, 'z');
+        assert(client.set("big", value));
+        assert(client.get_view("big") == std::string_view(value));
+        assert(text.get("big") == value);
+        auto pipeline = client.pipeline();
+        for (int i = 0; i < 20000; ++i) {
+            pipeline.set("p" + std::to_string(i), std::to_string(i));
+        }
+        pipeline.get("p19999");
+        auto replies = pipeline.execute();
+        assert(replies.size() == 20001 && replies.back().value() == "19999");
+        assert(client.get_error().empty());
+
+        // Back to text and over again, and kept across reconnects
+        client.disable_binary();
+        assert(!client.is_binary());
+        assert(client.get("p7") == "7");
+        assert(client.enable_binary());
+        client.disconnect();
+        assert(client.connect("127.0.0.1", 27560));
+        assert(client.is_binary());
+        assert(client.get("p8") == "8");
+
+        std::cout << "✓\n";
+    }
+
+    void test_raw_connection() {
+        std::cout << "Testing frames on a raw connection... ";
+
+        TestServer server(27561);
+        int fd = net::connect_tcp("127.0.0.1", 27561);
+        assert(fd >= 0);
+        std::string buffer;
+        BinaryProtocol::Frame frame;
+        std::string copy;
+
+        // Switched mid-batch: the rest of the send is already binary
+        std::string batch = "PROTOCOL BINARY\n";
+        std::string value("two words\nand a\0byte", 20);
+        BinaryProtocol::append_request(batch, 7, CommandType::SET, {"k", value});
+        assert(net::send_all(fd, batch));
+        char ok[5];
+        assert(recv(fd, ok, sizeof(ok), MSG_WAITALL) == 5 && std::string(ok, 5) == "+OK\r\n");
+        assert(read_frame(fd, buffer, frame, copy));
+        assert(frame.id == 7 && frame.code == 0 && frame.elements.empty());
+
+        // Ids are echoed whatever they are, frames split anywhere
+        std::string requests;
+        BinaryProtocol::append_request(requests, 300, CommandType::GET, {"k"});
+        BinaryProtocol::append_request(requests, 2, CommandType::SYNC, {});
+        BinaryProtocol::append_request(requests, 65535, CommandType::DBSIZE, {});
+        for (char c : requests) {
+            assert(net::send_all(fd, std::string(1, c)));
+        }
+        assert(read_frame(fd, buffer, frame, copy));
+        assert(frame.id == 300 && frame.elements.size() == 1 && frame.elements[0] == value);
+        assert(read_frame(fd, buffer, frame, copy));
+        assert(frame.id == 2 && frame.code == static_cast<uint8_t>(StatusCode::ERROR));
+        assert(read_frame(fd, buffer, frame, copy));
+        assert(frame.id == 65535 && frame.elements[0] == "1");
+
+        // A frame that cannot be valid ends the connection
+        assert(net::send_all(fd, std::string("\x02\x00\x00\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF", 14)));
+        assert(read_frame(fd, buffer, frame, copy));
+        assert(frame.code == static_cast<uint8_t>(StatusCode::ERROR));
+        char c;
+        assert(recv(fd, &c, 1, 0) == 0);
+        net::close_socket(fd);
+
+        std::cout << "✓\n";
+    }
+
+    void test_invalidations() {
+        std::cout << "Testing cache invalidations on the binary protocol... ";
+
+        TestServer server(27562);
+        Client reader;
+        Client writer;
+        assert(reader.connect("127.0.0.1", 27562));
+        assert(reader.enable_cache());
+        assert(reader.enable_binary());
+        assert(writer.connect("127.0.0.1", 27562));
+        assert(writer.enable_binary());
+
+        assert(writer.set("k", "1"));
+        assert(reader.get("k") == "1");
+        assert(reader.get("k") == "1");
+        assert(reader.cache_hits() == 1);
+
+        for (int i = 2; i < 20; ++i) {
+            assert(writer.set("k", std::to_string(i)));
+            bool updated = false;
+            for (int attempt = 0; attempt < 500 && !updated; ++attempt) {
+                updated = reader.get("k") == std::to_string(i);
+                if (!updated) {
+                    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+                }
+            }
+            assert(updated);
+        }
+
+        // Keys with a TTL are dropped right after the reply, in a push
+        // frame behind it
+        assert(writer.set("t", "v"));
+        assert(writer.expire("t", 100));
+        size_t hits = reader.cache_hits();
+        assert(reader.get("t") == "v");
+        assert(reader.get("t") == "v");
+        assert(reader.cache_hits() == hits);
+
+        std::cout << "✓\n";
+    }
+};
+
+int main() {
+    std::cout << "\n====================================\n";
+    std::cout << "Running DistKV Binary Protocol Tests\n";
+    std::cout << "====================================\n\n";
+
+    TestRunner runner;
+    runner.run_all();
+
+    return 0;
+}
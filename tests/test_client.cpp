@@ -0,0 +1,239 @@
+#include "../client/client.h"
+#include "test_util.h"
+#include <iostream>
+#include <cassert>
+#include <chrono>
+#include <cstring>
+#include <cstdio>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#ifndef _WIN32
+    #include <sys/socket.h>
+    #include <sys/stat.h>
+    #include <sys/un.h>
+    #include <unistd.h>
+#endif
+
+using namespace distkv;
+using namespace distkv::test;
+
+class TestRunner {
+public:
+    void run_all() {
+        test_views();
+        test_large_values();
+        test_get_into();
+        test_views_with_cache();
+#ifndef _WIN32
+        test_unix_socket();
+#endif
+
+        std::cout << "\n✓ All tests passed!\n";
+    }
+
+private:
+    void test_views() {
+        std::cout << "Testing reply views into the receive buffer... ";
+
+        TestServer server(27530);
+        Client client;
+        assert(client.connect("127.0.0.1", 27530));
+
+        assert(client.set("a", "alpha"));
+        assert(client.set("empty-ish", "-"));
+        auto view = client.get_view("a");
+        assert(view && *view == "alpha");
+        assert(client.get_view("empty-ish") == std::string_view("-"));
+        assert(!client.get_view("missing"));
+        assert(client.get_error().empty());
+
+        // Non-bulk replies still decode
+        assert(client.lpush("list", "x") == 1);
+        assert(client.exists("a"));
+        assert(client.get("a") == "alpha");
+
+        // A view stays usable until the next call
+        auto first = client.get_view("a");
+        std::string copy(*first);
+        assert(client.set("a", "beta"));
+        assert(client.get_view("a") == std::string_view("beta"));
+        assert(copy == "alpha");
+
+        std::cout << "✓\n";
+    }
+
+    void test_large_values() {
+        std::cout << "Testing large values across many reads... ";
+
+        TestServer server(27531);
+        Client client;
+        assert(client.connect("127.0.0.1", 27531));
+
+        std::vector<size_t> sizes = {1, 16383, 16384, 16385, 100000, 2 * 1024 * 1024};
+        for (size_t size : sizes) {
+            std::string value = make_value(size);
+            assert(client.set("big" + std::to_string(size), value));
+        }
+        for (size_t size : sizes) {
+            std::string value = make_value(size);
+            auto view = client.get_view("big" + std::to_string(size));
+            assert(view && view->size() == size && *view == value);
+            assert(client.get("big" + std::to_string(size)) == value);
+        }
+
+        // Pipelined replies behind a large one are intact
+        auto pipeline = client.pipeline();
+        pipeline.get("big100000").get("big1").get("missing").ping();
+        auto replies = pipeline.execute();
+        assert(replies[0].str == make_value(100000));
+        assert(replies[1].str == "a");
+        assert(replies[2].is_nil());
+        assert(replies[3].str == "PONG");
+        assert(client.get_view("big16385")->size() == 16385);
+
+        std::cout << "✓\n";
+    }
+
+    void test_get_into() {
+        std::cout << "Testing reads into caller buffers... ";
+
+        TestServer server(27532);
+        Client client;
+        assert(client.connect("127.0.0.1", 27532));
+        std::string value = make_value(50000);
+        assert(client.set("v", value));
+
+        // The destination's storage is reused
+        std::string out;
+        out.reserve(64 * 1024);
+        const char* storage = out.data();
+        assert(client.get_into("v", out));
+        assert(out == value && out.data() == storage);
+        assert(!client.get_into("missing", out));
+
+        char small[10];
+        auto len = client.get_into("v", small, sizeof(small));
+        assert(len && *len == value.size());
+        assert(std::memcmp(small, value.data(), sizeof(small)) == 0);
+        assert(!client.get_into("missing", small, sizeof(small)));
+
+        client.disconnect();
+        assert(!client.get_into("v", out));
+        assert(!client.get_view("v"));
+
+        std::cout << "✓\n";
+    }
+
+    void test_views_with_cache() {
+        std::cout << "Testing views of cached values... ";
+
+        TestServer server(27533);
+        Client client;
+        Client writer;
+        assert(client.connect("127.0.0.1", 27533));
+        assert(writer.connect("127.0.0.1", 27533));
+        assert(client.enable_cache());
+
+        assert(writer.set("k", "one"));
+        assert(client.get_view("k") == std::string_view("one"));
+        assert(client.get_view("k") == std::string_view("one"));
+        assert(client.cache_hits() == 1);
+        assert(!client.get_view("nothing"));
+        assert(!client.get_view("nothing"));
+        assert(client.cache_hits() == 2);
+
+        assert(writer.set("k", "two"));
+        bool updated = false;
+        for (int attempt = 0; attempt < 500 && !updated; ++attempt) {
+            updated = client.get_view("k") == std::string_view("two");
+            if (!updated) {
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            }
+        }
+        assert(updated);
+
+        std::cout << "✓\n";
+    }
+
+#ifndef _WIN32
+    void test_unix_socket() {
+        std::cout << "Testing connections over a Unix domain socket... ";
+
+        std::string path = "/tmp/distkv-test-client.sock";
+
+        // A socket file left by a crashed server does not block startup
+        {
+            int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+            struct sockaddr_un addr;
+            std::memset(&addr, 0, sizeof(addr));
+            addr.sun_family = AF_UNIX;
+            std::strcpy(addr.sun_path, path.c_str());
+            std::remove(path.c_str());
+            assert(bind(fd, (struct sockaddr*)&addr, sizeof(addr)) == 0);
+            close(fd);
+        }
+
+        {
+            TestServer server(27534, path);
+            Client local;
+            Client remote;
+            assert(local.connect_unix(path));
+            assert(remote.connect("127.0.0.1", 27534));
+
+            // Both listeners serve the same data
+            assert(local.set("a", "1"));
+            assert(remote.get("a") == "1");
+            assert(remote.set("b", "2"));
+            assert(local.get("b") == "2");
+
+            std::string value = make_value(300000);
+            assert(local.set("big", value));
+            assert(local.get_view("big") == std::string_view(value));
+            auto pipeline = local.pipeline();
+            for (int i = 0; i < 1000; ++i) {
+                pipeline.rpush("list", std::to_string(i));
+            }
+            auto replies = pipeline.execute();
+            assert(replies.back().integer() == 1000);
+            assert(remote.llen("list") == 1000);
+
+            // Caching works over either transport
+            assert(local.enable_cache());
+            assert(local.get("a") == "1");
+            assert(remote.set("a", "3"));
+            bool updated = false;
+            for (int attempt = 0; attempt < 500 && !updated; ++attempt) {
+                updated = local.get("a") == "3";
+                if (!updated) {
+                    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+                }
+            }
+            assert(updated);
+        }
+
+        // The socket file goes away with the server
+        struct stat st;
+        assert(stat(path.c_str(), &st) != 0);
+        Client client;
+        assert(!client.connect_unix(path));
+        assert(!client.get_error().empty());
+        assert(!client.connect_unix(std::string(200, 'x')));
+
+        std::cout << "✓\n";
+    }
+#endif
+};
+
+int main() {
+    std::cout << "\n===========================\n";
+    std::cout << "Running DistKV Client Tests\n";
+    std::cout << "===========================\n\n";
+
+    TestRunner runner;
+    runner.run_all();
+
+    return 0;
+}
@@ -0,0 +1,215 @@
+#include "../client/client.h"
+#include "test_util.h"
+#include <iostream>
+#include <cassert>
+#include <chrono>
+#include <memory>
+#include <string>
+#include <thread>
+
+using namespace distkv;
+using namespace distkv::test;
+
+class TestRunner {
+public:
+    void run_all() {
+        test_cached_reads();
+        test_invalidation();
+        test_expiring_keys();
+        test_eviction();
+        test_reconnect();
+
+        std::cout << "\n✓ All tests passed!\n";
+    }
+
+private:
+    void test_cached_reads() {
+        std::cout << "Testing repeated reads served from the cache... ";
+
+        TestServer server(27520);
+        Client client;
+        assert(client.connect("127.0.0.1", 27520));
+        assert(client.enable_cache());
+        assert(client.set("hot", "v1"));
+
+        assert(client.get("hot") == "v1");
+        for (int i = 0; i < 100; ++i) {
+            assert(client.get("hot") == "v1");
+        }
+        assert(client.cache_misses() == 1);
+        assert(client.cache_hits() == 100);
+
+        // Missing keys are cached too
+        assert(!client.get("cold"));
+        assert(!client.get("cold"));
+        assert(client.cache_hits() == 101);
+
+        // Own writes are visible at once
+        assert(client.set("hot", "v2"));
+        assert(client.get("hot") == "v2");
+        assert(client.del("hot"));
+        assert(!client.get("hot"));
+
+        assert(client.cache_size() == 2);
+
+        client.disable_cache();
+        assert(client.cache_size() == 0);
+        assert(client.get("cold") == std::nullopt);
+        assert(client.cache_hits() == 101);
+
+        std::cout << "✓\n";
+    }
+
+    void test_invalidation() {
+        std::cout << "Testing invalidation on writes by other clients... ";
+
+        TestServer server(27521);
+        Client reader;
+        Client writer;
+        assert(reader.connect("127.0.0.1", 27521));
+        assert(writer.connect("127.0.0.1", 27521));
+        assert(reader.enable_cache());
+
+        assert(writer.set("k", "1"));
+        assert(reader.get("k") == "1");
+        assert(reader.get("k") == "1");
+
+        // Invalidations are pushed as writes are applied and picked up by
+        // the next read; writes to other keys leave the entry alone
+        assert(writer.set("k", "2"));
+        assert(wait_until([&]() { return reader.get("k") == "2"; }));
+        size_t misses = reader.cache_misses();
+        assert(writer.rpush("k2", "a") == 1);
+        assert(reader.get("k") == "2");
+        assert(reader.cache_misses() == misses);
+
+        // A cached miss is dropped once the key is created
+        assert(!reader.get("later"));
+        assert(writer.set("later", "now"));
+        assert(wait_until([&]() { return reader.get("later") == "now"; }));
+
+        // And a cached value once the key is deleted
+        assert(writer.del("k"));
+        assert(wait_until([&]() { return !reader.get("k"); }));
+
+        // Tracking is one-shot per read: every new value is seen
+        for (int i = 0; i < 50; ++i) {
+            assert(writer.set("counter", std::to_string(i)));
+            assert(wait_until([&]() { return reader.get("counter") == std::to_string(i); }));
+        }
+
+        std::cout << "✓\n";
+    }
+
+    void test_expiring_keys() {
+        std::cout << "Testing keys with a TTL are not cached... ";
+
+        TestServer server(27522);
+        Client client;
+        assert(client.connect("127.0.0.1", 27522));
+        assert(client.enable_cache());
+
+        assert(client.set("session", "abc"));
+        assert(client.expire("session", 100));
+        assert(client.get("session") == "abc");
+        assert(client.get("session") == "abc");
+        assert(client.cache_hits() == 0);
+        assert(client.cache_size() == 0);
+
+        // EXPIRE on a cached key invalidates it
+        Client other;
+        assert(other.connect("127.0.0.1", 27522));
+        assert(client.set("plain", "x"));
+        assert(client.get("plain") == "x");
+        assert(client.get("plain") == "x");
+        assert(client.cache_hits() == 1);
+        assert(other.expire("plain", 100));
+        size_t misses = client.cache_misses();
+        assert(wait_until([&]() { return client.get("plain") == "x" && client.cache_misses() > misses; }));
+        assert(client.cache_size() == 0);
+
+        std::cout << "✓\n";
+    }
+
+    void test_eviction() {
+        std::cout << "Testing LRU eviction at capacity... ";
+
+        TestServer server(27523);
+        Client client;
+        assert(client.connect("127.0.0.1", 27523));
+        assert(client.enable_cache(3));
+
+        for (const char* key : {"a", "b", "c"}) {
+            assert(client.set(key, key));
+            assert(client.get(key) == std::string(key));
+        }
+        assert(client.get("a") == "a");        // a is now most recent
+        assert(client.set("d", "d"));
+        assert(client.get("d") == "d");        // evicts b
+        assert(client.cache_size() == 3);
+
+        size_t misses = client.cache_misses();
+        assert(client.get("a") == "a");
+        assert(client.get("c") == "c");
+        assert(client.cache_misses() == misses);
+        assert(client.get("b") == "b");
+        assert(client.cache_misses() == misses + 1);
+
+        std::cout << "✓\n";
+    }
+
+    void test_reconnect() {
+        std::cout << "Testing cache reset across reconnects... ";
+
+        Client client;
+        {
+            TestServer server(27524);
+            assert(client.connect("127.0.0.1", 27524));
+            assert(client.enable_cache());
+            assert(client.set("k", "old"));
+            assert(client.get("k") == "old");
+            assert(client.cache_size() == 1);
+        }
+
+        // The server went away: the closed connection is noticed before
+        // a cached value would be served
+        TestServer server(27524);
+        assert(!client.get("k"));
+        assert(!client.is_connected());
+        assert(client.cache_size() == 0);
+
+        // Tracking is turned on again for the new connection
+        Client writer;
+        assert(writer.connect("127.0.0.1", 27524));
+        assert(client.connect("127.0.0.1", 27524));
+        assert(writer.set("k", "new"));
+        assert(client.get("k") == "new");
+        assert(client.get("k") == "new");
+        assert(writer.set("k", "newer"));
+        assert(wait_until([&]() { return client.get("k") == "newer"; }));
+
+        std::cout << "✓\n";
+    }
+
+    template <typename Pred>
+    static bool wait_until(Pred pred) {
+        for (int attempt = 0; attempt < 500; ++attempt) {
+            if (pred()) {
+                return true;
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        return false;
+    }
+};
+
+int main() {
+    std::cout << "\n=================================\n";
+    std::cout << "Running DistKV Client Cache Tests\n";
+    std::cout << "=================================\n\n";
+
+    TestRunner runner;
+    runner.run_all();
+
+    return 0;
+}
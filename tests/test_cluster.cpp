@@ -0,0 +1,382 @@
+#include "../include/cluster.h"
+#include "../include/persistence.h"
+#include "../include/storage.h"
+#include "test_util.h"
+#include <iostream>
+#include <sstream>
+#include <fstream>
+#include <cassert>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <thread>
+
+#ifndef _WIN32
+    #include <sys/socket.h>
+    #include <netinet/in.h>
+    #include <arpa/inet.h>
+    #include <unistd.h>
+#endif
+
+using namespace distkv;
+using namespace distkv::test;
+
+// Test fixture
+class TestRunner {
+public:
+    void run_all() {
+        test_key_hash_slot();
+        test_slot_ownership();
+        test_config_round_trip();
+        test_range_markers();
+        test_migration_batch();
+        test_hostile_import();
+        test_bounded_asking();
+#ifndef _WIN32
+        test_migration_timeout();
+#endif
+
+        std::cout << "\n=================================\n";
+        std::cout << "All tests passed! ✓\n";
+        std::cout << "=================================\n";
+    }
+
+private:
+    void test_key_hash_slot() {
+        std::cout << "Testing key hash slots... ";
+
+        // CRC16/XMODEM check value
+        assert(crc16("123456789", 9) == 0x31C3);
+
+        // Same slots as other Redis Cluster implementations
+        assert(key_hash_slot("foo") == 12182);
+        assert(key_hash_slot("") == 0);
+
+        // Only a non-empty {hashtag} is hashed
+        assert(key_hash_slot("{user1000}.following") == key_hash_slot("user1000"));
+        assert(key_hash_slot("{user1000}.followers") == key_hash_slot("user1000"));
+        assert(key_hash_slot("foo{}{bar}") == crc16("foo{}{bar}", 10) % CLUSTER_SLOTS);
+        assert(key_hash_slot("foo{{bar}}zap") == key_hash_slot("{bar"));
+        assert(key_hash_slot("foo{bar}{zap}") == key_hash_slot("bar"));
+
+        std::cout << "✓\n";
+    }
+
+    void test_slot_ownership() {
+        std::cout << "Testing slot ownership and migration markers... ";
+        ClusterState cluster("");
+        assert(cluster.init("127.0.0.1", 7000));
+        std::string me = cluster.myself_id();
+        assert(me.size() == 40);
+
+        std::string other(40, 'b');
+        assert(cluster.add_node(other, "127.0.0.1", 7001));
+
+        assert(cluster.add_slots({0, 1, 2}));
+        assert(!cluster.add_slots({2, 3}));          // 2 is taken
+        assert(cluster.assign_slots({100, 101}, other));
+        assert(!cluster.assign_slots({5}, std::string(40, 'c')));
+
+        SlotState mine = cluster.slot_state(1);
+        assert(mine.assigned && mine.mine);
+        SlotState theirs = cluster.slot_state(100);
+        assert(theirs.assigned && !theirs.mine && theirs.owner.address() == "127.0.0.1:7001");
+        assert(!cluster.slot_state(50).assigned);
+
+        // Only the owner can migrate a slot, only a non-owner can import it
+        assert(cluster.set_migrating(1, other));
+        assert(!cluster.set_migrating(100, other));
+        assert(cluster.set_importing(100, other));
+        assert(cluster.slot_state(1).migrating_to->id == other);
+        assert(cluster.slot_state(100).importing);
+
+        cluster.set_stable(1);
+        assert(!cluster.slot_state(1).migrating_to);
+
+        // Forgetting a node releases its slots
+        assert(cluster.forget_node(other));
+        assert(!cluster.slot_state(100).assigned);
+        assert(!cluster.slot_state(100).importing);
+        assert(!cluster.forget_node(me));
+
+        std::cout << "✓\n";
+    }
+
+    void test_config_round_trip() {
+        std::cout << "Testing cluster config persistence... ";
+        const std::string path = "test_cluster_nodes.conf";
+        std::remove(path.c_str());
+
+        std::string me;
+        std::string other(40, 'e');
+        {
+            ClusterState cluster(path);
+            assert(cluster.init("127.0.0.1", 7000));
+            me = cluster.myself_id();
+            assert(cluster.add_node(other, "10.0.0.2", 7001));
+            std::vector<int> low;
+            for (int slot = 0; slot < 8192; ++slot) low.push_back(slot);
+            assert(cluster.add_slots(low));
+            std::vector<int> high;
+            for (int slot = 8192; slot < CLUSTER_SLOTS; ++slot) high.push_back(slot);
+            assert(cluster.assign_slots(high, other));
+            assert(cluster.set_migrating(42, other));
+        }
+
+        ClusterState reloaded(path);
+        assert(reloaded.init("127.0.0.1", 7000));
+        assert(reloaded.myself_id() == me);
+        assert(reloaded.slot_state(0).mine);
+        assert(reloaded.slot_state(8191).mine);
+        assert(reloaded.slot_state(16383).owner.host == "10.0.0.2");
+        assert(reloaded.slot_state(42).migrating_to->id == other);
+        assert(reloaded.info().find("cluster_state:ok") != std::string::npos);
+
+        // A hand-edited config epoch is refused, not thrown out of init()
+        for (const char* epoch : {"x", "-1", "99999999999999999999999"}) {
+            {
+                std::ofstream file(path, std::ios::trunc);
+                file << me << " 127.0.0.1:7000 myself,master - 0 0 " << epoch << " connected 0-16383\n";
+            }
+            ClusterState corrupt(path);
+            assert(!corrupt.init("127.0.0.1", 7000));
+        }
+
+        std::remove(path.c_str());
+        std::cout << "✓\n";
+    }
+
+    void test_range_markers() {
+        std::cout << "Testing slot range migration markers... ";
+        ClusterState cluster("");
+        assert(cluster.init("127.0.0.1", 7000));
+        std::string other(40, 'f');
+        assert(cluster.add_node(other, "127.0.0.1", 7001));
+        assert(cluster.add_slots({10, 11, 12}));
+
+        // All or nothing: slot 13 is not ours
+        assert(!cluster.set_migrating(std::vector<int>{11, 12, 13}, other));
+        assert(!cluster.slot_state(11).migrating_to);
+        assert(cluster.set_migrating(std::vector<int>{10, 11, 12}, other));
+        assert(cluster.slot_state(12).migrating_to->id == other);
+
+        assert(!cluster.set_importing(std::vector<int>{12, 13}, other));
+        assert(cluster.set_importing(std::vector<int>{13, 14}, other));
+        assert(cluster.slot_state(14).importing);
+
+        // Handing a slot over clears its markers
+        assert(cluster.assign_slots({10, 13}, other));
+        assert(!cluster.slot_state(10).migrating_to);
+        assert(!cluster.slot_state(13).importing);
+
+        std::cout << "✓\n";
+    }
+
+    void test_migration_batch() {
+        std::cout << "Testing migration batch encoding... ";
+        Storage source;
+        source.set("{user1}.name", "alice");
+        source.lpush("{user1}.queue", "job1");
+        source.lpush("{user1}.queue", "job2");
+        source.sadd("{user1}.tags", "admin");
+
+        // Only existing entries are copied
+        auto entries = source.get_entries({"{user1}.name", "{user1}.queue", "{user1}.tags",
+                                           "{user1}.missing"});
+        assert(entries.size() == 3);
+
+        std::ostringstream os;
+        assert(Persistence::write_entries(entries, os) == 3);
+
+        std::unordered_map<std::string, std::shared_ptr<Value>> decoded;
+        std::istringstream is(os.str());
+        assert(Persistence::read_entries(is, decoded) == 3);
+
+        // Importing merges into whatever the target already has
+        Storage target;
+        target.set("{user1}.name", "stale");
+        target.set("other", "kept");
+        target.merge_entries(decoded);
+        assert(target.dbsize() == 4);
+        assert(*target.get("{user1}.name") == "alice");
+        assert(*target.get("other") == "kept");
+        auto queue = target.lrange("{user1}.queue", 0, -1);
+        assert(queue && queue->size() == 2 && (*queue)[0] == "job2");
+        assert(target.sismember("{user1}.tags", "admin"));
+
+        // Truncated payloads are rejected
+        std::string truncated = os.str().substr(0, os.str().size() - 3);
+        std::istringstream bad(truncated);
+        decoded.clear();
+        assert(Persistence::read_entries(bad, decoded) < 0);
+
+        std::cout << "✓\n";
+    }
+
+    void test_hostile_import() {
+        std::cout << "Testing oversized and corrupt IMPORTBATCH... ";
+        TestServer server(27610, [](Server& s) { assert(s.enable_cluster("", "127.0.0.1")); });
+
+        auto reply_to = [](const std::string& data, std::string& reply) {
+            int fd = net::connect_tcp("127.0.0.1", 27610);
+            assert(fd >= 0);
+            net::SocketReader reader(fd);
+            bool answered = net::send_all(fd, data) && reader.read_line(reply);
+            // A bad length leaves the stream unframed, so the server hangs up
+            std::string rest;
+            bool open = reader.read_line(rest);
+            net::close_socket(fd);
+            return answered && !open;
+        };
+        auto pong = [](int fd, net::SocketReader& reader) {
+            std::string header;
+            std::string body;
+            return net::send_all(fd, "PING\n") && reader.read_line(header) && reader.read_line(body) &&
+                   body == "PONG";
+        };
+        std::string reply;
+        assert(reply_to("IMPORTBATCH 99999999999\n", reply));
+        assert(reply.find("invalid IMPORTBATCH length") != std::string::npos);
+        assert(reply_to("IMPORTBATCH 123456789012345678901234\n", reply));
+        assert(reply_to("IMPORTBATCH -5\n", reply));
+
+        // Lengths inside the payload far beyond its size: a key, then a value
+        auto field = [](uint64_t n) { return std::string(reinterpret_cast<const char*>(&n), sizeof(n)); };
+        std::string huge_key = field(1) + field(1ULL << 60) + "abc";
+        std::string huge_value = field(1) + field(3) + "key" + std::string(1, '\0') + field(0) +
+                                 field(~0ULL) + "abc";
+        for (const std::string& payload : {huge_key, huge_value, field(5)}) {
+            int fd = net::connect_tcp("127.0.0.1", 27610);
+            assert(fd >= 0);
+            net::SocketReader reader(fd);
+            assert(net::send_all(fd, "IMPORTBATCH " + std::to_string(payload.size()) + "\n" + payload));
+            assert(reader.read_line(reply) && reply.find("corrupt IMPORTBATCH payload") != std::string::npos);
+            // The connection stays usable after a well-framed bad batch
+            assert(pong(fd, reader));
+            net::close_socket(fd);
+        }
+
+        // The server survived all of it
+        int fd = net::connect_tcp("127.0.0.1", 27610);
+        assert(fd >= 0);
+        net::SocketReader reader(fd);
+        assert(pong(fd, reader));
+        net::close_socket(fd);
+        assert(server.server().get_storage()->dbsize() == 0);
+
+        std::cout << "✓\n";
+    }
+
+    void test_bounded_asking() {
+        std::cout << "Testing ASKING before a bounded read of an importing slot... ";
+        const std::string source_id(40, 's');
+        const std::string key = "{importing}name";
+        const int slot = key_hash_slot(key);
+
+        TestServer server(27613, [&](Server& s) {
+            assert(s.enable_cluster("", "127.0.0.1"));
+            assert(s.get_cluster()->add_node(source_id, "127.0.0.1", 27614));
+            assert(s.get_cluster()->assign_slots({slot}, source_id));
+            assert(s.get_cluster()->set_importing(slot, source_id));
+        });
+        server.server().get_storage()->set(key, "alice");
+
+        int fd = net::connect_tcp("127.0.0.1", 27613);
+        assert(fd >= 0);
+        net::SocketReader reader(fd);
+        auto call = [&](const std::string& line) {
+            std::string reply;
+            assert(net::send_all(fd, line + "\n") && reader.read_line(reply));
+            if (reply[0] == '$' && reply != "$-1") {
+                assert(reader.read_line(reply));
+            }
+            return reply;
+        };
+        const std::string bounded = "BOUNDED MS 1000 GET " + key;
+
+        // Without ASKING the slot still belongs to the source
+        assert(call(bounded).find("MOVED") != std::string::npos);
+
+        // With it, the wrapped read is served here rather than sent back
+        assert(call("ASKING") == "+OK");
+        assert(call(bounded) == "alice");
+
+        // ASKING covers only the next command, even a rejected BOUNDED
+        assert(call("ASKING") == "+OK");
+        assert(call("BOUNDED MS 1000 SET " + key + " bob").find("only applies to read") != std::string::npos);
+        assert(call(bounded).find("MOVED") != std::string::npos);
+
+        net::close_socket(fd);
+        std::cout << "✓\n";
+    }
+
+#ifndef _WIN32
+    void test_migration_timeout() {
+        std::cout << "Testing migration to a target that stops answering... ";
+        const std::string target_id(40, 't');
+        const std::string key = "{migrating}name";
+        const int slot = key_hash_slot(key);
+
+        // A target that agrees to import, then never acknowledges a batch
+        int listener = socket(AF_INET, SOCK_STREAM, 0);
+        int opt = 1;
+        setsockopt(listener, SOL_SOCKET, SO_REUSEADDR, &opt, sizeof(opt));
+        sockaddr_in addr{};
+        addr.sin_family = AF_INET;
+        addr.sin_port = htons(27612);
+        inet_pton(AF_INET, "127.0.0.1", &addr.sin_addr);
+        assert(bind(listener, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) == 0);
+        assert(listen(listener, 1) == 0);
+        std::thread target([listener]() {
+            int fd = accept(listener, nullptr, nullptr);
+            net::SocketReader reader(fd);
+            std::string line;
+            if (reader.read_line(line)) {
+                net::send_all(fd, "+OK\r\n");
+            }
+            while (reader.read_line(line)) {
+            }
+            net::close_socket(fd);
+        });
+
+        TestServer server(27611, [&](Server& s) {
+            assert(s.enable_cluster("", "127.0.0.1"));
+            s.set_migration_timeout(300);
+            assert(s.get_cluster()->add_slots({slot}));
+            assert(s.get_cluster()->add_node(target_id, "127.0.0.1", 27612));
+        });
+        int fd = net::connect_tcp("127.0.0.1", 27611);
+        assert(fd >= 0);
+        net::SocketReader reader(fd);
+        std::string reply;
+        assert(net::send_all(fd, "SET " + key + " alice\n") && reader.read_line(reply) && reply == "+OK");
+
+        auto start = std::chrono::steady_clock::now();
+        assert(net::send_all(fd, "CLUSTER MIGRATESLOT " + std::to_string(slot) + " " + target_id + "\n"));
+        assert(reader.read_line(reply) && reply.find("migration interrupted") != std::string::npos);
+        assert(std::chrono::steady_clock::now() - start < std::chrono::seconds(5));
+
+        // The unacknowledged key is writable here again
+        assert(net::send_all(fd, "SET " + key + " bob\n") && reader.read_line(reply) && reply == "+OK");
+        assert(*server.server().get_storage()->get(key) == "bob");
+
+        net::close_socket(fd);
+        server.stop();
+        target.join();
+        net::close_socket(listener);
+
+        std::cout << "✓\n";
+    }
+#endif
+};
+
+int main() {
+    std::cout << "\n=================================\n";
+    std::cout << "Running DistKV Cluster Tests\n";
+    std::cout << "=================================\n\n";
+
+    TestRunner runner;
+    runner.run_all();
+
+    return 0;
+}
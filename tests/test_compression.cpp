@@ -0,0 +1,108 @@
+#include "../include/compression.h"
+#include <iostream>
+#include <cassert>
+#include <random>
+#include <string>
+
+using namespace distkv;
+
+// Test fixture
+class TestRunner {
+public:
+    void run_all() {
+        test_round_trip();
+        test_command_stream_ratio();
+        test_corrupt_input();
+
+        std::cout << "\n=================================\n";
+        std::cout << "All tests passed! ✓\n";
+        std::cout << "=================================\n";
+    }
+
+private:
+    static bool round_trips(const std::string& input) {
+        std::string block = Compression::compress(input);
+        std::string output = "prefix";
+        if (!Compression::decompress(block.data(), block.size(), input.size(), output)) {
+            return false;
+        }
+        return output == "prefix" + input;
+    }
+
+    void test_round_trip() {
+        std::cout << "Testing compress/decompress round trip... ";
+
+        assert(round_trips(""));
+        assert(round_trips("a"));
+        assert(round_trips("abcd"));
+        assert(round_trips(std::string(100000, 'x')));  // long overlapping match
+        assert(round_trips("abcabcabcabcabcabcabcabcabcabcabcabcabcabc"));
+
+        // Incompressible data must still round trip
+        std::mt19937 rng(42);
+        std::string noise;
+        for (int i = 0; i < 200000; ++i) {
+            noise += static_cast<char>(rng() & 0xFF);
+        }
+        assert(round_trips(noise));
+
+        // Literal and match lengths across the 15/255 extension boundaries
+        for (size_t len : {14, 15, 16, 269, 270, 271, 600}) {
+            std::string mixed = noise.substr(0, len) + std::string(len, 'z') + noise.substr(len, len);
+            assert(round_trips(mixed));
+        }
+
+        std::cout << "✓\n";
+    }
+
+    void test_command_stream_ratio() {
+        std::cout << "Testing compression of a command stream... ";
+
+        std::string stream;
+        for (int i = 0; i < 5000; ++i) {
+            stream += "SET user:" + std::to_string(i) + " session-" + std::to_string(i % 97) + "\n";
+        }
+        std::string block = Compression::compress(stream);
+        assert(block.size() * 3 < stream.size());
+        assert(round_trips(stream));
+
+        std::cout << "✓\n";
+    }
+
+    void test_corrupt_input() {
+        std::cout << "Testing corrupt input is rejected... ";
+
+        std::string input;
+        for (int i = 0; i < 1000; ++i) {
+            input += "LPUSH queue item" + std::to_string(i % 10) + "\n";
+        }
+        std::string block = Compression::compress(input);
+        std::string out;
+
+        // Wrong expected size, truncated block, trailing garbage
+        assert(!Compression::decompress(block.data(), block.size(), input.size() + 1, out));
+        out.clear();
+        assert(!Compression::decompress(block.data(), block.size() / 2, input.size(), out));
+        out.clear();
+        std::string padded = block + "junk";
+        assert(!Compression::decompress(padded.data(), padded.size(), input.size(), out));
+
+        // Match offset pointing before the start of the output
+        std::string bad = "\x40" "abcd" "\xFF\xFF";
+        out.clear();
+        assert(!Compression::decompress(bad.data(), bad.size(), 8, out));
+
+        std::cout << "✓\n";
+    }
+};
+
+int main() {
+    std::cout << "\n=================================\n";
+    std::cout << "Running DistKV Compression Tests\n";
+    std::cout << "=================================\n\n";
+
+    TestRunner runner;
+    runner.run_all();
+
+    return 0;
+}
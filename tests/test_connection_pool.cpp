@@ -0,0 +1,215 @@
+#include "../client/connection_pool.h"
+#include "test_util.h"
+#include <iostream>
+#include <cassert>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace distkv;
+using namespace distkv::test;
+
+namespace {
+
+PoolConfig make_config(size_t max_connections, int acquire_timeout_ms = 1000, int health_check_idle_ms = 5000) {
+    PoolConfig config;
+    config.max_connections = max_connections;
+    config.acquire_timeout_ms = acquire_timeout_ms;
+    config.health_check_idle_ms = health_check_idle_ms;
+    return config;
+}
+
+} // namespace
+
+class TestRunner {
+public:
+    void run_all() {
+        test_lazy_connect();
+        test_bounded_size();
+        test_thread_affinity();
+        test_health_check();
+        test_concurrent_use();
+
+        std::cout << "\n✓ All tests passed!\n";
+    }
+
+private:
+    void test_lazy_connect() {
+        std::cout << "Testing lazy connect and reuse... ";
+
+        // Nothing listening: acquire fails and leaves no connection behind
+        {
+            ConnectionPool pool("127.0.0.1", 27519, make_config(2));
+            assert(!pool.acquire());
+            assert(!pool.get_error().empty());
+            assert(pool.size() == 0);
+        }
+
+        TestServer server(27510);
+        ConnectionPool pool("127.0.0.1", 27510, make_config(4));
+        assert(pool.size() == 0);
+
+        Client* first = nullptr;
+        {
+            auto conn = pool.acquire();
+            assert(conn);
+            assert(conn->set("a", "1"));
+            first = &*conn;
+            assert(pool.size() == 1 && pool.idle() == 0);
+        }
+        assert(pool.idle() == 1);
+
+        // Released connections are reused instead of opening more
+        for (int i = 0; i < 10; ++i) {
+            auto conn = pool.acquire();
+            assert(&*conn == first);
+            assert(conn->get("a") == "1");
+        }
+        assert(pool.size() == 1);
+
+        pool.close_idle();
+        assert(pool.size() == 0);
+
+        std::cout << "✓\n";
+    }
+
+    void test_bounded_size() {
+        std::cout << "Testing size bound and acquire timeout... ";
+
+        TestServer server(27511);
+        ConnectionPool pool("127.0.0.1", 27511, make_config(2, 100));
+
+        auto a = pool.acquire();
+        auto b = pool.acquire();
+        assert(a && b && &*a != &*b);
+
+        auto start = std::chrono::steady_clock::now();
+        assert(!pool.acquire());
+        auto waited = std::chrono::steady_clock::now() - start;
+        assert(waited >= std::chrono::milliseconds(90));
+        assert(pool.size() == 2);
+
+        // A waiter gets the next connection released
+        std::atomic<bool> got(false);
+        std::thread waiter([&]() {
+            auto conn = pool.acquire();
+            got = conn && conn->ping();
+        });
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        a.release();
+        waiter.join();
+        assert(got);
+        assert(pool.size() == 2);
+
+        std::cout << "✓\n";
+    }
+
+    void test_thread_affinity() {
+        std::cout << "Testing per-thread connection affinity... ";
+
+        TestServer server(27512);
+        ConnectionPool pool("127.0.0.1", 27512, make_config(4));
+
+        // Each thread keeps getting the connection it used last
+        std::atomic<bool> stable(true);
+        std::vector<std::thread> threads;
+        for (int t = 0; t < 3; ++t) {
+            threads.emplace_back([&pool, &stable, t]() {
+                Client* mine = nullptr;
+                for (int i = 0; i < 200; ++i) {
+                    auto conn = pool.acquire();
+                    assert(conn);
+                    if (!mine) {
+                        mine = &*conn;
+                    } else if (&*conn != mine) {
+                        stable = false;
+                    }
+                    conn->set("t" + std::to_string(t), std::to_string(i));
+                }
+            });
+        }
+        for (auto& thread : threads) {
+            thread.join();
+        }
+        assert(stable);
+        assert(pool.size() <= 3);
+
+        std::cout << "✓\n";
+    }
+
+    void test_health_check() {
+        std::cout << "Testing health checks across a server restart... ";
+
+        // Idle connections pinged on every acquire
+        ConnectionPool checked("127.0.0.1", 27513, make_config(2, 1000, 0));
+        // Never pinged: a dead connection is only noticed when used
+        ConnectionPool unchecked("127.0.0.1", 27513, make_config(2, 1000, -1));
+        {
+            TestServer server(27513);
+            assert(checked.acquire()->set("k", "1"));
+            assert(unchecked.acquire()->set("k", "1"));
+        }
+        TestServer server(27513);
+
+        {
+            auto conn = checked.acquire();
+            assert(conn);
+            assert(conn->set("k", "2"));
+        }
+        assert(checked.size() == 1);
+
+        {
+            auto conn = unchecked.acquire();
+            assert(conn);
+            assert(!conn->set("k", "3"));
+        }
+        // The failed connection was dropped and is replaced on demand
+        assert(unchecked.size() == 0);
+        assert(unchecked.acquire()->get("k") == "2");
+
+        std::cout << "✓\n";
+    }
+
+    void test_concurrent_use() {
+        std::cout << "Testing many threads sharing few connections... ";
+
+        TestServer server(27514);
+        ConnectionPool pool("127.0.0.1", 27514, make_config(3));
+
+        std::atomic<int> failures(0);
+        std::vector<std::thread> threads;
+        for (int t = 0; t < 8; ++t) {
+            threads.emplace_back([&pool, &failures, t]() {
+                for (int i = 0; i < 500; ++i) {
+                    auto conn = pool.acquire();
+                    if (!conn || !conn->set("c:" + std::to_string(t) + ":" + std::to_string(i), "v")) {
+                        ++failures;
+                    }
+                }
+            });
+        }
+        for (auto& thread : threads) {
+            thread.join();
+        }
+        assert(failures == 0);
+        assert(pool.size() <= 3);
+        assert(pool.idle() == pool.size());
+        assert(pool.acquire()->dbsize() == 4000);
+
+        std::cout << "✓\n";
+    }
+};
+
+int main() {
+    std::cout << "\n=====================================\n";
+    std::cout << "Running DistKV Connection Pool Tests\n";
+    std::cout << "=====================================\n\n";
+
+    TestRunner runner;
+    runner.run_all();
+
+    return 0;
+}
@@ -0,0 +1,267 @@
+#include "../include/gossip.h"
+#include <iostream>
+#include <cassert>
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <thread>
+#include <vector>
+
+using namespace distkv;
+
+// In-process cluster of gossiping nodes over loopback (UDP ports are the
+// client ports plus CLUSTER_BUS_PORT_OFFSET; nothing listens on the client
+// ports themselves)
+class GossipCluster {
+public:
+    GossipCluster(int size, int base_port) : size_(size) {
+        config_.tick_ms = 20;
+        config_.fanout = 2;
+        config_.gossip_entries = 2;
+        config_.node_timeout_ms = 400;
+
+        for (int i = 0; i < size; ++i) {
+            states_.push_back(std::make_unique<ClusterState>(""));
+            assert(states_[i]->init("127.0.0.1", base_port + i));
+            buses_.emplace_back();
+        }
+
+        // Each node serves an equal share of the slots
+        int per_node = CLUSTER_SLOTS / size;
+        for (int i = 0; i < size; ++i) {
+            std::vector<int> slots;
+            int end = (i == size - 1) ? CLUSTER_SLOTS : (i + 1) * per_node;
+            for (int slot = i * per_node; slot < end; ++slot) slots.push_back(slot);
+            assert(states_[i]->add_slots(slots));
+        }
+    }
+
+    ~GossipCluster() {
+        for (auto& bus : buses_) {
+            if (bus) bus->stop();
+        }
+    }
+
+    void start(int i) {
+        buses_[i] = std::make_unique<ClusterBus>(*states_[i], config_);
+        assert(buses_[i]->start());
+    }
+
+    void stop(int i) {
+        buses_[i]->stop();
+        buses_[i].reset();
+    }
+
+    int size() const { return size_; }
+    ClusterState& state(int i) { return *states_[i]; }
+    ClusterBus& bus(int i) { return *buses_[i]; }
+    int node_timeout_ms() const { return config_.node_timeout_ms; }
+    int tick_ms() const { return config_.tick_ms; }
+
+    static bool wait_until(const std::function<bool()>& pred, int timeout_ms = 5000) {
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeout_ms);
+        while (std::chrono::steady_clock::now() < deadline) {
+            if (pred()) return true;
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
+        return pred();
+    }
+
+private:
+    int size_;
+    GossipConfig config_;
+    std::vector<std::unique_ptr<ClusterState>> states_;
+    std::vector<std::unique_ptr<ClusterBus>> buses_;
+};
+
+class TestRunner {
+public:
+    void run_all() {
+        test_message_encoding();
+        test_membership_convergence();
+        test_epoch_propagation();
+        test_failure_detection();
+
+        std::cout << "\n=================================\n";
+        std::cout << "All tests passed! ✓\n";
+        std::cout << "=================================\n";
+    }
+
+private:
+    // Every node knows all others and agrees on every slot's owner
+    static bool converged(GossipCluster& cluster) {
+        for (int i = 0; i < cluster.size(); ++i) {
+            if (cluster.state(i).nodes().size() != static_cast<size_t>(cluster.size())) {
+                return false;
+            }
+        }
+        for (int slot = 0; slot < CLUSTER_SLOTS; slot += 97) {
+            SlotState expected = cluster.state(0).slot_state(slot);
+            for (int i = 1; i < cluster.size(); ++i) {
+                SlotState state = cluster.state(i).slot_state(slot);
+                if (!state.assigned || state.owner.id != expected.owner.id) {
+                    return false;
+                }
+            }
+        }
+        return true;
+    }
+
+    void test_message_encoding() {
+        std::cout << "Testing bus message encoding... ";
+
+        GossipMessage msg;
+        msg.type = GossipMessage::PING;
+        msg.sender_id = std::string(40, 'a');
+        msg.sender_host = "10.0.0.1";
+        msg.sender_port = 7001;
+        msg.current_epoch = 12;
+        msg.config_epoch = 7;
+        msg.slots.assign(CLUSTER_SLOTS / 8, '\0');
+        for (int slot = 100; slot <= 5000; ++slot) {
+            msg.slots[slot / 8] |= static_cast<char>(1 << (slot % 8));
+        }
+        GossipMessage::Entry entry;
+        entry.id = std::string(40, 'b');
+        entry.host = "10.0.0.2";
+        entry.port = 7002;
+        entry.pfail = true;
+        msg.gossip.push_back(entry);
+
+        // Contiguous slots are sent as ranges, not as the 2KB bitmap
+        std::string wire = msg.encode();
+        assert(wire.size() < 200);
+
+        GossipMessage decoded;
+        assert(GossipMessage::decode(wire, decoded));
+        assert(decoded.type == GossipMessage::PING);
+        assert(decoded.sender_id == msg.sender_id && decoded.sender_port == 7001);
+        assert(decoded.current_epoch == 12 && decoded.config_epoch == 7);
+        assert(decoded.slots == msg.slots);
+        assert(decoded.gossip.size() == 1 && decoded.gossip[0].pfail && !decoded.gossip[0].fail);
+
+        // Scattered slots fall back to the bitmap
+        msg.slots.assign(CLUSTER_SLOTS / 8, '\0');
+        for (int slot = 0; slot < CLUSTER_SLOTS; slot += 2) {
+            msg.slots[slot / 8] |= static_cast<char>(1 << (slot % 8));
+        }
+        wire = msg.encode();
+        assert(wire.size() < CLUSTER_SLOTS / 8 + 200);
+        assert(GossipMessage::decode(wire, decoded) && decoded.slots == msg.slots);
+
+        // Truncated or foreign datagrams are rejected
+        assert(!GossipMessage::decode(wire.substr(0, wire.size() - 1), decoded));
+        assert(!GossipMessage::decode("PING", decoded));
+
+        std::cout << "✓\n";
+    }
+
+    void test_membership_convergence() {
+        std::cout << "Testing membership and slot map convergence... ";
+        GossipCluster cluster(6, 27200);
+        for (int i = 0; i < cluster.size(); ++i) cluster.start(i);
+
+        // A chain of MEETs is enough, gossip spreads the rest
+        for (int i = 1; i < cluster.size(); ++i) {
+            assert(cluster.bus(i).meet("127.0.0.1", 27200 + i - 1));
+        }
+        assert(GossipCluster::wait_until([&]() { return converged(cluster); }));
+        assert(cluster.state(5).slot_state(0).owner.port == 27200);
+        assert(cluster.state(0).info().find("cluster_state:ok") != std::string::npos);
+
+        // Traffic per node is bounded by the fanout, not the cluster size:
+        // about fanout pings and their pongs per tick
+        uint64_t before = cluster.bus(0).messages_sent();
+        std::this_thread::sleep_for(std::chrono::milliseconds(1000));
+        uint64_t sent = cluster.bus(0).messages_sent() - before;
+        uint64_t ticks = 1000 / cluster.tick_ms();
+        assert(sent > 0 && sent <= ticks * 2 * 3);
+
+        std::cout << "✓\n";
+    }
+
+    void test_epoch_propagation() {
+        std::cout << "Testing config epoch propagation... ";
+        GossipCluster cluster(4, 27210);
+        for (int i = 0; i < cluster.size(); ++i) cluster.start(i);
+        for (int i = 1; i < cluster.size(); ++i) {
+            assert(cluster.bus(i).meet("127.0.0.1", 27210));
+        }
+        assert(GossipCluster::wait_until([&]() { return converged(cluster); }));
+
+        // Equal config epochs are resolved, so every node ends up unique
+        assert(GossipCluster::wait_until([&]() {
+            std::vector<uint64_t> epochs;
+            for (const auto& node : cluster.state(0).nodes()) {
+                for (uint64_t e : epochs) {
+                    if (e == node.config_epoch) return false;
+                }
+                epochs.push_back(node.config_epoch);
+            }
+            return true;
+        }));
+
+        // Node 3 takes slot 0 over from node 0 (end of a migration); its new
+        // epoch wins everywhere, including on the old owner
+        std::string taker = cluster.state(3).myself_id();
+        assert(cluster.state(3).assign_slots({0}, taker));
+        assert(cluster.state(3).myself().config_epoch == cluster.state(3).current_epoch());
+        assert(GossipCluster::wait_until([&]() {
+            for (int i = 0; i < cluster.size(); ++i) {
+                if (cluster.state(i).slot_state(0).owner.id != taker) return false;
+            }
+            return true;
+        }));
+        assert(!cluster.state(0).slot_state(0).mine);
+        assert(cluster.state(0).slot_state(1).mine);
+
+        std::cout << "✓\n";
+    }
+
+    void test_failure_detection() {
+        std::cout << "Testing failure detection... ";
+        GossipCluster cluster(5, 27220);
+        for (int i = 0; i < cluster.size(); ++i) cluster.start(i);
+        for (int i = 1; i < cluster.size(); ++i) {
+            assert(cluster.bus(i).meet("127.0.0.1", 27220));
+        }
+        assert(GossipCluster::wait_until([&]() { return converged(cluster); }));
+
+        std::string victim = cluster.state(4).myself_id();
+        cluster.stop(4);
+
+        // Every survivor agrees on FAIL, and the cluster is down while the
+        // failed node still owns slots
+        assert(GossipCluster::wait_until([&]() {
+            for (int i = 0; i < 4; ++i) {
+                if (!cluster.state(i).node(victim)->fail) return false;
+            }
+            return true;
+        }, cluster.node_timeout_ms() * 10));
+        assert(cluster.state(0).info().find("cluster_state:fail") != std::string::npos);
+        assert(cluster.state(1).describe_nodes().find("master,fail") != std::string::npos);
+
+        // It is back once it talks to the others again
+        cluster.start(4);
+        assert(GossipCluster::wait_until([&]() {
+            for (int i = 0; i < 4; ++i) {
+                auto node = cluster.state(i).node(victim);
+                if (node->fail || node->pfail) return false;
+            }
+            return true;
+        }));
+
+        std::cout << "✓\n";
+    }
+};
+
+int main() {
+    std::cout << "\n=================================\n";
+    std::cout << "Running DistKV Gossip Tests\n";
+    std::cout << "=================================\n\n";
+
+    TestRunner runner;
+    runner.run_all();
+
+    return 0;
+}
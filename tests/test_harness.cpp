@@ -0,0 +1,256 @@
+#include "../harness/harness.h"
+#include "../include/net_util.h"
+#include "../client/client.h"
+#include <iostream>
+#include <cassert>
+#include <chrono>
+#include <string>
+#include <thread>
+
+using namespace distkv;
+
+namespace {
+
+// Send one command over an open connection and return the first reply line
+std::string call(int fd, net::SocketReader& reader, const std::string& line) {
+    std::string reply;
+    if (!net::send_all(fd, line + "\n") || !reader.read_line(reply)) {
+        return "";
+    }
+    if (!reply.empty() && reply[0] == '$' && reply != "$-1") {
+        std::string body;
+        reader.read_line(body);
+        return body;
+    }
+    return reply;
+}
+
+std::optional<std::string> get(int port, const std::string& key) {
+    Client client;
+    if (!client.connect("127.0.0.1", port)) {
+        return std::nullopt;
+    }
+    return client.get(key);
+}
+
+} // namespace
+
+class TestRunner {
+public:
+    void run_all() {
+        test_fault_link();
+        test_replication_partition();
+        test_wait_acks();
+        test_raft_failover();
+        test_workload();
+
+        std::cout << "\n✓ All harness tests passed!\n";
+    }
+
+private:
+    void test_fault_link() {
+        std::cout << "Testing fault link latency and partitions... ";
+
+        Server server(27400, 2);
+        std::thread server_thread([&server]() { server.start(); });
+        FaultLink link(27401, "127.0.0.1", 27400);
+        assert(link.start());
+        assert(LocalCluster::wait_for([]() {
+            int fd = net::connect_tcp("127.0.0.1", 27400);
+            net::close_socket(fd);
+            return fd >= 0;
+        }, 2000));
+
+        int fd = net::connect_tcp("127.0.0.1", 27401);
+        assert(fd >= 0);
+        net::SocketReader reader(fd);
+        assert(call(fd, reader, "PING") == "PONG");
+
+        // Each direction is delayed, so a round trip takes twice the latency
+        link.set_latency_ms(50);
+        auto start = std::chrono::steady_clock::now();
+        assert(call(fd, reader, "SET link 1") == "+OK");
+        auto elapsed = std::chrono::steady_clock::now() - start;
+        assert(elapsed >= std::chrono::milliseconds(100));
+        link.set_latency_ms(0);
+
+        // A partition drops the open connection and refuses new ones
+        link.set_partitioned(true);
+        assert(call(fd, reader, "PING").empty());
+        net::close_socket(fd);
+        fd = net::connect_tcp("127.0.0.1", 27401);
+        net::SocketReader refused(fd);
+        assert(call(fd, refused, "PING").empty());
+        net::close_socket(fd);
+
+        link.set_partitioned(false);
+        fd = net::connect_tcp("127.0.0.1", 27401);
+        net::SocketReader healed(fd);
+        assert(call(fd, healed, "GET link") == "1");
+        net::close_socket(fd);
+        assert(link.bytes_forwarded() > 0);
+
+        link.stop();
+        server.stop();
+        server_thread.join();
+        std::cout << "✓\n";
+    }
+
+    void test_replication_partition() {
+        std::cout << "Testing replication across a partition... ";
+
+        HarnessConfig config;
+        config.base_port = 27410;
+        config.topology = Topology::REPLICATION;
+        LocalCluster cluster(config);
+        assert(cluster.start());
+
+        Client primary;
+        assert(primary.connect("127.0.0.1", cluster.port(0)));
+        assert(primary.set("before", "1"));
+        for (size_t i = 1; i < cluster.size(); ++i) {
+            assert(LocalCluster::wait_for([&]() { return get(cluster.port(i), "before") == "1"; }, 3000));
+        }
+
+        // Node 2 is cut off from the primary, node 1 still follows it
+        cluster.partition({0}, {2});
+        assert(primary.set("during", "2"));
+        assert(LocalCluster::wait_for([&]() { return get(cluster.port(1), "during") == "2"; }, 3000));
+        std::this_thread::sleep_for(std::chrono::milliseconds(300));
+        assert(!get(cluster.port(2), "during"));
+
+        // After healing, node 2 reconnects and catches up
+        cluster.heal();
+        assert(LocalCluster::wait_for([&]() { return get(cluster.port(2), "during") == "2"; }, 5000));
+
+        cluster.stop();
+        std::cout << "✓\n";
+    }
+
+    void test_wait_acks() {
+        std::cout << "Testing WAIT with acknowledging and partitioned replicas... ";
+
+        HarnessConfig config;
+        config.nodes = 2;
+        config.base_port = 27470;
+        config.topology = Topology::REPLICATION;
+        LocalCluster cluster(config);
+        assert(cluster.start());
+
+        int fd = net::connect_tcp("127.0.0.1", cluster.port(0));
+        assert(fd >= 0);
+        net::SocketReader reader(fd);
+        assert(call(fd, reader, "SET before 1") == "+OK");
+        assert(LocalCluster::wait_for([&]() { return get(cluster.port(1), "before") == "1"; }, 3000));
+
+        // The replica acknowledges the write well within the timeout
+        assert(call(fd, reader, "SET acked 1") == "+OK");
+        auto start = std::chrono::steady_clock::now();
+        assert(call(fd, reader, "WAIT 1 5000") == "1");
+        assert(std::chrono::steady_clock::now() - start < std::chrono::seconds(2));
+
+        // Cut off, it can't: WAIT gives up after the timeout with none
+        cluster.partition({0}, {1});
+        assert(call(fd, reader, "SET unacked 1") == "+OK");
+        start = std::chrono::steady_clock::now();
+        assert(call(fd, reader, "WAIT 1 300") == "0");
+        assert(std::chrono::steady_clock::now() - start >= std::chrono::milliseconds(300));
+
+        // Back on the link, the resynced replica covers the earlier write
+        cluster.heal();
+        assert(LocalCluster::wait_for([&]() { return get(cluster.port(1), "unacked") == "1"; }, 5000));
+        assert(call(fd, reader, "WAIT 1 5000") == "1");
+
+        net::close_socket(fd);
+        cluster.stop();
+        std::cout << "✓\n";
+    }
+
+    void test_raft_failover() {
+        std::cout << "Testing Raft failover after isolating the leader... ";
+
+        HarnessConfig config;
+        config.base_port = 27430;
+        config.topology = Topology::RAFT;
+        LocalCluster cluster(config);
+        assert(cluster.start());
+
+        std::optional<size_t> old_leader = cluster.leader();
+        assert(old_leader);
+
+        // The majority side elects a new leader and keeps taking writes
+        cluster.isolate(*old_leader);
+        size_t new_leader = cluster.size();
+        assert(LocalCluster::wait_for([&]() {
+            for (size_t i = 0; i < cluster.size(); ++i) {
+                Client client;
+                if (i != *old_leader && client.connect("127.0.0.1", cluster.port(i)) &&
+                    client.set("failover", "ok")) {
+                    new_leader = i;
+                    return true;
+                }
+            }
+            return false;
+        }, 10000));
+        assert(new_leader != *old_leader);
+
+        // Once healed, the old leader learns the new entries
+        cluster.heal();
+        assert(LocalCluster::wait_for([&]() { return get(cluster.port(*old_leader), "failover") == "ok"; },
+                                      10000));
+
+        // A crashed follower rejoins from its persisted log
+        size_t follower = (new_leader + 1) % cluster.size();
+        assert(cluster.crash(follower));
+        assert(!cluster.is_up(follower));
+        assert(cluster.restart(follower));
+        assert(LocalCluster::wait_for([&]() { return get(cluster.port(follower), "failover") == "ok"; },
+                                      10000));
+
+        cluster.stop();
+        std::cout << "✓\n";
+    }
+
+    void test_workload() {
+        std::cout << "Testing built-in workload... ";
+
+        HarnessConfig config;
+        config.base_port = 27450;
+        config.topology = Topology::STANDALONE;
+        LocalCluster cluster(config);
+        assert(cluster.start());
+
+        WorkloadConfig workload;
+        workload.clients = 3;
+        workload.duration_ms = 500;
+        workload.interval_ms = 100;
+        workload.key_space = 100;
+        workload.read_ratio = 0.0;
+        WorkloadResult result = cluster.run_workload(workload);
+
+        assert(result.ops > 0);
+        assert(result.errors == 0);
+        assert(result.timeline.size() == 5);
+        assert(result.p50_us <= result.p99_us && result.p99_us <= result.max_us);
+
+        // Each client wrote to its own node
+        for (size_t i = 0; i < cluster.size(); ++i) {
+            assert(cluster.dbsize(i) > 0);
+        }
+
+        cluster.stop();
+        assert(!cluster.is_up(0));
+        std::cout << "✓\n";
+    }
+};
+
+int main() {
+    std::cout << "\n=================================\n";
+    std::cout << "Running DistKV Harness Tests\n";
+    std::cout << "=================================\n\n";
+
+    TestRunner runner;
+    runner.run_all();
+
+    return 0;
+}
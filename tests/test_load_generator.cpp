@@ -0,0 +1,458 @@
+#include "../benchmarks/load_generator.h"
+#include "../client/client.h"
+#include "test_util.h"
+#include <iostream>
+#include <cassert>
+#include <cmath>
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace distkv;
+using namespace distkv::test;
+
+namespace {
+
+LoadConfig small_config(int port) {
+    LoadConfig config;
+    config.port = port;
+    config.threads = 2;
+    config.clients = 2;
+    config.pipeline = 4;
+    config.requests = 200;
+    config.key_space = 100;
+    config.seed = 42;
+    return config;
+}
+
+uint64_t sum_ops(const LoadResult& result) {
+    uint64_t ops = 0;
+    for (const auto& command : result.commands) {
+        ops += command.ops;
+    }
+    return ops;
+}
+
+} // namespace
+
+class TestRunner {
+public:
+    void run_all() {
+        test_specs();
+        test_histogram();
+        test_key_distributions();
+        test_result_files();
+        test_counted_run();
+        test_preloaded_reads();
+        test_skewed_runs();
+        test_command_mix();
+        test_timed_run();
+        test_open_loop();
+        test_unix_socket();
+        test_no_server();
+
+        std::cout << "\n✓ All tests passed!\n";
+    }
+
+private:
+    void test_specs() {
+        std::cout << "Testing value size and mix specs... ";
+
+        SizeSpec size;
+        assert(size.parse("100") && size.min == 100 && size.max == 100 && size.weighted.empty());
+        assert(size.parse("32-1024") && size.min == 32 && size.max == 1024);
+        assert(size.parse("32:60,1024:30,65536:10"));
+        assert(size.weighted.size() == 3 && size.min == 32 && size.largest() == 65536);
+        assert(size.describe() == "32:60,1024:30,65536:10 bytes");
+        assert(!size.parse("") && !size.parse("0") && !size.parse("100-10") && !size.parse("32:") &&
+               !size.parse("abc"));
+
+        std::vector<MixEntry> mix;
+        assert(parse_mix("get:10,SET:1,lpush", mix));
+        assert(mix.size() == 3 && mix[0].command == CommandType::GET && mix[0].weight == 10);
+        assert(mix[1].command == CommandType::SET && mix[2].weight == 1);
+        assert(parse_mix("get:1,get:2,set:0", mix) && mix.size() == 1 && mix[0].weight == 3);
+        assert(size.parse("zipf:10-100") && size.zipfian && size.min == 10 && size.max == 100);
+        assert(size.describe() == "10-100 bytes, zipfian");
+        assert(!size.parse("zipf:100") && size.parse("100") && !size.zipfian);
+
+        KeyDistribution keys;
+        assert(keys.parse("zipfian") && keys.kind == KeyDistribution::Kind::ZIPFIAN && keys.theta == 0.99);
+        assert(keys.parse("zipfian:0.5") && keys.theta == 0.5);
+        assert(keys.parse("hotspot:0.01:0.9") && keys.kind == KeyDistribution::Kind::HOTSPOT);
+        assert(keys.hot_keys == 0.01 && keys.hot_ops == 0.9);
+        assert(keys.parse("latest") && keys.kind == KeyDistribution::Kind::LATEST);
+        assert(keys.parse("uniform") && keys.kind == KeyDistribution::Kind::UNIFORM);
+        assert(!keys.parse("zipfian:1") && !keys.parse("zipfian:x") && !keys.parse("hotspot:0.1") &&
+               !keys.parse("hotspot:0:0.5") && !keys.parse("gaussian") && !keys.parse(""));
+
+        assert(!parse_mix("flushdb:1", mix) && !parse_mix("get:x", mix) && !parse_mix("set:0", mix));
+        assert(mix.size() == 1);
+
+        std::cout << "✓\n";
+    }
+
+    void test_histogram() {
+        std::cout << "Testing latency histograms... ";
+
+        LatencyHistogram histogram;
+        assert(histogram.count() == 0 && histogram.value_at(0.99) == 0 && histogram.min() == 0);
+
+        // Small values are exact; large ones within 1 / SUB_BUCKETS
+        for (uint64_t v = 1; v <= 1000; ++v) {
+            histogram.record(v);
+        }
+        assert(histogram.count() == 1000 && histogram.min() == 1 && histogram.max() == 1000);
+        assert(histogram.value_at(0.5) == 500 && histogram.value_at(0.99) == 990);
+        assert(histogram.value_at(0) == 1 && histogram.value_at(1) == 1000);
+        assert(histogram.mean() == 500.5);
+
+        LatencyHistogram wide;
+        for (uint64_t v : {5000ULL, 123456789ULL, 3600000000000ULL}) {
+            LatencyHistogram one;
+            one.record(v);
+            uint64_t reported = one.value_at(0.5);
+            assert(reported >= v && reported - v <= v / LatencyHistogram::SUB_BUCKETS);
+            wide.merge(one);
+        }
+
+        // A tail of 1 in 10000 shows up at p99.99 and nowhere below
+        LatencyHistogram tail;
+        tail.record(100000, 9999);
+        tail.record(50000000);
+        assert(tail.value_at(0.999) < 101000 && tail.value_at(0.9999) < 101000);
+        tail.record(50000000);
+        assert(tail.value_at(0.9999) >= 50000000 && tail.max() == 50000000);
+
+        // Merging adds counts and keeps extremes
+        wide.merge(histogram);
+        assert(wide.count() == 1003 && wide.min() == 1 && wide.max() == 3600000000000ULL);
+
+        std::string text = histogram.percentile_distribution();
+        assert(text.find("Percentile") != std::string::npos);
+        assert(text.find("1.000000000000") != std::string::npos);
+        assert(text.find("Total count    =         1000") != std::string::npos);
+        assert(histogram.to_json().find("\"count\":1000,") == 1);
+
+        std::cout << "✓\n";
+    }
+
+    void test_result_files() {
+        std::cout << "Testing result files and comparisons... ";
+
+        ResultDocument doc("microbench");
+        doc.set_label("v1 \"rc\"");
+        doc.set_config("min_time", 0.2);
+        doc.add_benchmark("storage/get", {{"ns_per_op", 100}, {"ops_per_sec", 1e7}, {"allocs_per_op", 0}});
+        doc.add_benchmark("storage/set", {{"ns_per_op", 250.5}, {"errors", 0}});
+        doc.set_resource("peak_rss_bytes", 1 << 20);
+
+        ResultSet baseline;
+        std::string error;
+        assert(baseline.load(doc.to_json(), error));
+        assert(baseline.suite == "microbench" && baseline.label == "v1 \"rc\"");
+        assert(baseline.benchmarks.size() == 3 && baseline.benchmarks[2].first == "resources");
+        assert(baseline.benchmarks[1].second[0].second == 250.5);
+        assert(!baseline.environment.empty() && baseline.environment[0].first == "hostname");
+
+        JsonValue value;
+        assert(JsonValue::parse(" [1, -2.5e3, \"a\\u00e9\\n\", true, null, {}] ", value, error));
+        assert(value.items().size() == 6 && value.items()[1].number() == -2500);
+        assert(value.items()[2].string() == "a\xc3\xa9\n" && value.items()[3].boolean());
+        assert(!JsonValue::parse("{\"a\":1,}", value, error) && !error.empty());
+        assert(!JsonValue::parse("[1] 2", value, error));
+        assert(!JsonValue::parse(std::string(100, '['), value, error));
+        assert(!baseline.load("[]", error));
+
+        // Within noise, faster, slower, a new error, dropped and new metrics
+        ResultSet current = baseline;
+        current.benchmarks[0].second = {{"ns_per_op", 104}, {"ops_per_sec", 1.2e7}, {"allocs_per_op", 1}};
+        current.benchmarks[1].second = {{"ns_per_op", 150}, {"errors", 3}, {"mb_per_sec", 10}};
+        current.benchmarks.pop_back();
+        std::vector<MetricChange> changes = compare_results(baseline, current, CompareOptions());
+        assert(changes.size() == 7);
+        assert(changes[0].verdict == Verdict::UNCHANGED && std::fabs(changes[0].change - 0.04) < 1e-9);
+        assert(changes[1].verdict == Verdict::IMPROVED);
+        assert(changes[2].verdict == Verdict::REGRESSED && std::isinf(changes[2].change));
+        assert(changes[3].verdict == Verdict::IMPROVED);
+        assert(changes[4].verdict == Verdict::REGRESSED && changes[4].threshold == 0);
+        assert(changes[5].verdict == Verdict::REMOVED && changes[5].benchmark == "resources");
+        assert(changes[6].verdict == Verdict::ADDED && changes[6].metric == "mb_per_sec");
+
+        CompareOptions strict;
+        strict.threshold = 0.01;
+        assert(compare_results(baseline, current, strict)[0].verdict == Verdict::REGRESSED);
+        strict.metric_thresholds.emplace_back("ns_per_op", 0.5);
+        assert(compare_results(baseline, current, strict)[0].verdict == Verdict::UNCHANGED);
+        assert(strict.threshold_for("p99_9_us") > strict.threshold_for("p50_us"));
+        assert(higher_is_better("ops_per_sec") && !higher_is_better("p99_us"));
+
+        std::cout << "✓\n";
+    }
+
+    void test_key_distributions() {
+        std::cout << "Testing key distributions... ";
+
+        const int draws = 200000;
+        std::mt19937_64 rng(7);
+        auto histogram = [&](KeyChooser chooser, uint64_t keys) {
+            std::vector<int> counts(keys);
+            for (int i = 0; i < draws; ++i) {
+                uint64_t key = chooser.next(rng, false);
+                assert(key < keys);
+                ++counts[key];
+            }
+            return counts;
+        };
+
+        // Uniform: no key far above its 1 in 1000 share
+        KeyDistribution distribution;
+        auto uniform = histogram(KeyChooser(distribution, 1000, nullptr), 1000);
+        for (int count : uniform) {
+            assert(count > 100 && count < 320);
+        }
+
+        // Zipfian: key k drawn in proportion to 1 / (k + 1)^theta
+        distribution.parse("zipfian:0.99");
+        auto zipfian = histogram(KeyChooser(distribution, 1000, nullptr), 1000);
+        double zeta = ZipfianGenerator::zeta(1000, 0.99);
+        for (int k : {0, 1, 9}) {
+            double expected = draws / std::pow(k + 1.0, 0.99) / zeta;
+            assert(std::abs(zipfian[k] - expected) < expected * 0.1);
+        }
+        assert(zipfian[0] > zipfian[1] && zipfian[1] > zipfian[10] && zipfian[10] > zipfian[500]);
+
+        // Past a million terms the zeta sum is an integral, still close
+        double exact = 0;
+        for (uint64_t k = 1; k <= 3000000; ++k) {
+            exact += 1.0 / std::pow(static_cast<double>(k), 0.8);
+        }
+        assert(std::abs(ZipfianGenerator::zeta(3000000, 0.8) - exact) < exact * 1e-6);
+        ZipfianGenerator huge(1000000000ULL, 0.99);
+        for (int i = 0; i < 1000; ++i) {
+            assert(huge.next(rng) < 1000000000ULL);
+        }
+
+        // Hotspot: 90% of draws to the first 1% of keys
+        distribution.parse("hotspot:0.01:0.9");
+        auto hotspot = histogram(KeyChooser(distribution, 1000, nullptr), 1000);
+        int hot = 0;
+        for (int k = 0; k < 10; ++k) {
+            hot += hotspot[k];
+        }
+        assert(hot > draws * 0.88 && hot < draws * 0.92);
+
+        // Latest: writes count up from the key space, reads favor the newest
+        distribution.parse("latest");
+        std::atomic<uint64_t> newest(1000);
+        KeyChooser latest(distribution, 1000, &newest);
+        assert(latest.next(rng, true) == 1000 && latest.next(rng, true) == 1001 && newest == 1002);
+        int recent = 0;
+        for (int i = 0; i < draws; ++i) {
+            uint64_t key = latest.next(rng, false);
+            assert(key < 1002 && key >= 2);
+            recent += key >= 992;
+        }
+        assert(recent > draws / 3);
+
+        std::cout << "✓\n";
+    }
+
+    void test_counted_run() {
+        std::cout << "Testing a run of counted requests... ";
+
+        TestServer server(27570);
+        LoadGenerator generator(small_config(27570));
+        LoadResult result = generator.run();
+        assert(result.ok);
+        assert(result.totals.ops == 2 * 2 * 200);
+        assert(result.totals.errors == 0);
+        assert(sum_ops(result) == result.totals.ops);
+        assert(result.totals.latency.count() == result.totals.ops);
+        assert(result.commands.size() == 2 && result.commands[0].name == "SET" && result.commands[1].name == "GET");
+        assert(result.commands[1].hits + result.commands[1].misses == result.commands[1].ops);
+        assert(result.bytes_sent > 0 && result.bytes_received > 0 && result.seconds > 0);
+
+        const LatencyHistogram& latency = result.totals.latency;
+        assert(latency.min() > 0 && latency.value_at(0.5) <= latency.value_at(0.9999));
+        assert(latency.value_at(0.9999) <= latency.max() && latency.mean() <= latency.max());
+
+        ResultSet results;
+        std::string error;
+        assert(results.load(result.document(generator.config()).to_json(), error));
+        assert(results.suite == "bench" && results.benchmarks.size() == 5);
+        assert(results.benchmarks[1].first == "GET" && results.benchmarks[2].first == "Totals");
+        assert(results.benchmarks[2].second[0].first == "ops_per_sec");
+        assert(std::fabs(results.benchmarks[2].second[0].second - result.ops_per_sec()) < 0.01);
+        assert(results.benchmarks.back().first == "resources");
+
+        std::string report = result.report();
+        assert(report.find("SET ") != std::string::npos && report.find("GET ") != std::string::npos);
+        assert(report.find("Totals") != std::string::npos);
+
+        std::cout << "✓\n";
+    }
+
+    void test_preloaded_reads() {
+        std::cout << "Testing reads of a preloaded key space... ";
+
+        TestServer server(27571);
+        LoadConfig config = small_config(27571);
+        config.key_prefix = "bench:";
+        config.preload = true;
+        config.value_size.parse("16:1,200:1");
+        parse_mix("get", config.mix);
+        LoadGenerator generator(config);
+        LoadResult result = generator.run();
+        assert(result.ok && result.totals.ops == 800);
+        assert(result.commands[0].hits == 800 && result.commands[0].misses == 0);
+
+        Client client;
+        assert(client.connect("127.0.0.1", 27571));
+        assert(client.dbsize() == 100);
+        auto value = client.get("bench:key:99");
+        assert(value && (value->size() == 16 || value->size() == 200));
+
+        std::cout << "✓\n";
+    }
+
+    void test_skewed_runs() {
+        std::cout << "Testing skewed key and value distributions... ";
+
+        TestServer server(27578);
+        LoadConfig config = small_config(27578);
+        config.preload = true;
+        config.key_distribution.parse("zipfian");
+        config.value_size.parse("zipf:1-5000");
+        parse_mix("set:1,get:1,lpush:1,lrange:1", config.mix);
+        LoadGenerator zipfian(config);
+        LoadResult result = zipfian.run();
+        assert(result.ok && result.totals.ops == 800 && result.totals.errors == 0);
+        assert(result.commands[1].misses == 0);
+
+        // Writes under latest create keys past the preloaded key space
+        config.key_distribution.parse("latest");
+        parse_mix("set:1,get:1", config.mix);
+        LoadGenerator latest(config);
+        result = latest.run();
+        assert(result.ok && result.totals.errors == 0);
+        assert(result.commands[1].hits > result.commands[1].misses);
+
+        Client client;
+        assert(client.connect("127.0.0.1", 27578));
+        uint64_t sets = result.commands[0].ops;
+        assert(client.exists("key:" + std::to_string(100 + sets - 1)));
+        assert(!client.exists("key:" + std::to_string(100 + sets)));
+
+        std::cout << "✓\n";
+    }
+
+    void test_command_mix() {
+        std::cout << "Testing every command over both protocols... ";
+
+        TestServer server(27572);
+        for (bool binary : {false, true}) {
+            LoadConfig config = small_config(27572);
+            config.binary = binary;
+            config.value_size.parse("8-64");
+            assert(parse_mix("set,get,del,exists,expire,ttl,lpush,rpush,lpop,rpop,lrange,llen,"
+                             "sadd,srem,sismember,smembers,scard",
+                             config.mix));
+            LoadGenerator generator(config);
+            LoadResult result = generator.run();
+            assert(result.ok && result.totals.ops == 800);
+            assert(result.totals.errors == 0);
+            assert(result.commands.size() == 17 && sum_ops(result) == 800);
+        }
+
+        std::cout << "✓\n";
+    }
+
+    void test_timed_run() {
+        std::cout << "Testing a timed run with progress... ";
+
+        TestServer server(27573);
+        LoadConfig config = small_config(27573);
+        config.duration_s = 1.3;
+        int reports = 0;
+        auto start = std::chrono::steady_clock::now();
+        LoadGenerator generator(config);
+        LoadResult result = generator.run([&](double seconds, uint64_t answered) {
+            assert(seconds >= 1 && answered > 0);
+            ++reports;
+        });
+        assert(std::chrono::steady_clock::now() - start >= std::chrono::milliseconds(1300));
+        assert(result.ok && result.totals.errors == 0);
+        assert(result.totals.ops > 0 && reports >= 1);
+
+        std::cout << "✓\n";
+    }
+
+    void test_open_loop() {
+        std::cout << "Testing an open-loop run at a fixed rate... ";
+
+        TestServer server(27575);
+        LoadConfig config = small_config(27575);
+        config.requests = 100;
+        config.rate = 2000;
+        auto start = std::chrono::steady_clock::now();
+        LoadGenerator generator(config);
+        LoadResult result = generator.run();
+        auto elapsed = std::chrono::steady_clock::now() - start;
+
+        // 400 requests at 2000/s take 200ms, however fast the server is
+        assert(result.ok && result.totals.ops == 400 && result.totals.errors == 0);
+        assert(elapsed >= std::chrono::milliseconds(190) && elapsed < std::chrono::seconds(3));
+        assert(result.target_rate == 2000);
+        assert(result.report().find("Open loop at 2000") != std::string::npos);
+
+        // A rate far above what the server sustains queues requests behind
+        // each other, and the wait counts as latency
+        config.requests = 500;
+        config.pipeline = 1;
+        config.rate = 1e9;
+        LoadGenerator flood(config);
+        LoadResult flooded = flood.run();
+        assert(flooded.ok && flooded.totals.ops == 2000);
+        assert(flooded.totals.latency.value_at(0.99) > flooded.totals.latency.value_at(0.01) * 10);
+
+        std::cout << "✓\n";
+    }
+
+    void test_unix_socket() {
+        std::cout << "Testing a run over a Unix domain socket... ";
+
+        std::string path = "/tmp/distkv-test-load-1.sock";
+        TestServer server(27576, path);
+        LoadConfig config = small_config(0);
+        config.unix_socket = path;
+        LoadGenerator generator(config);
+        LoadResult result = generator.run();
+        assert(result.ok && result.totals.ops == 800 && result.totals.errors == 0);
+
+        std::cout << "✓\n";
+    }
+
+    void test_no_server() {
+        std::cout << "Testing a run without a server... ";
+
+        LoadGenerator generator(small_config(27577));
+        LoadResult result = generator.run();
+        assert(!result.ok && !result.error.empty());
+        assert(result.totals.ops == 0);
+
+        std::cout << "✓\n";
+    }
+};
+
+int main() {
+    std::cout << "\n===================================\n";
+    std::cout << "Running DistKV Load Generator Tests\n";
+    std::cout << "===================================\n\n";
+
+    TestRunner runner;
+    runner.run_all();
+
+    return 0;
+}
@@ -0,0 +1,276 @@
+#include "../include/proxy.h"
+#include "test_util.h"
+#include <iostream>
+#include <cassert>
+#include <chrono>
+#include <cstdlib>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace distkv;
+using namespace distkv::test;
+
+// Three cluster nodes with a third of the slots each, served in-process.
+// The servers keep running until the process exits.
+class TestCluster {
+public:
+    explicit TestCluster(int base_port) {
+        for (int i = 0; i < 3; ++i) {
+            servers_.push_back(new Server(base_port + i, 2));
+            assert(servers_[i]->enable_cluster("", "127.0.0.1"));
+        }
+        for (int i = 0; i < 3; ++i) {
+            std::vector<int> slots;
+            for (int slot = i * CLUSTER_SLOTS / 3; slot < (i + 1) * CLUSTER_SLOTS / 3; ++slot) {
+                slots.push_back(slot);
+            }
+            for (int j = 0; j < 3; ++j) {
+                ClusterState* state = servers_[j]->get_cluster();
+                if (i == j) {
+                    assert(state->add_slots(slots));
+                } else {
+                    assert(state->add_node(cluster(i).myself_id(), "127.0.0.1", base_port + i));
+                    assert(state->assign_slots(slots, cluster(i).myself_id()));
+                }
+            }
+        }
+        for (Server* server : servers_) {
+            std::thread([server]() { server->start(); }).detach();
+        }
+        for (int i = 0; i < 3; ++i) {
+            assert(wait_for_port(base_port + i));
+        }
+    }
+
+    ClusterState& cluster(int i) { return *servers_[i]->get_cluster(); }
+    Storage& storage(int i) { return *servers_[i]->get_storage(); }
+
+private:
+    std::vector<Server*> servers_;
+};
+
+// Plain (not cluster-aware) client reading raw RESP replies
+class RawClient {
+public:
+    explicit RawClient(int port) : fd_(net::connect_tcp("127.0.0.1", port)), reader_(fd_) {
+        assert(fd_ >= 0);
+    }
+    ~RawClient() { net::close_socket(fd_); }
+
+    void send(const std::string& data) { assert(net::send_all(fd_, data)); }
+
+    std::string read() {
+        std::string out;
+        assert(read_into(out));
+        return out;
+    }
+
+    std::string call(const std::string& line) {
+        send(line + "\n");
+        return read();
+    }
+
+private:
+    int fd_;
+    net::SocketReader reader_;
+
+    bool read_into(std::string& out) {
+        std::string line;
+        if (!reader_.read_line(line) || line.empty()) {
+            return false;
+        }
+        out += line + "\r\n";
+        if (line[0] == '$' && std::atol(line.c_str() + 1) >= 0) {
+            std::string body;
+            if (!reader_.read_exact(std::atol(line.c_str() + 1) + 2, body)) {
+                return false;
+            }
+            out += body;
+        } else if (line[0] == '*') {
+            for (long i = std::atol(line.c_str() + 1); i > 0; --i) {
+                if (!read_into(out)) {
+                    return false;
+                }
+            }
+        }
+        return true;
+    }
+};
+
+class TestRunner {
+public:
+    TestRunner() : cluster_(27300) {
+        ProxyConfig config;
+        config.port = 27310;
+        config.seeds = {{"127.0.0.1", 27300}};
+        config.pool_size = 2;
+        proxy_ = std::make_unique<Proxy>(config);
+        proxy_thread_ = std::thread([this]() { proxy_->start(); });
+        assert(wait_for_port(27310));
+    }
+
+    ~TestRunner() {
+        proxy_->stop();
+        proxy_thread_.join();
+    }
+
+    void run_all() {
+        test_routing();
+        test_multi_key();
+        test_redirects();
+        test_pipelining();
+
+        std::cout << "\n=================================\n";
+        std::cout << "All tests passed! ✓\n";
+        std::cout << "=================================\n";
+    }
+
+private:
+    TestCluster cluster_;
+    std::unique_ptr<Proxy> proxy_;
+    std::thread proxy_thread_;
+
+    static std::string bulk(const std::string& value) {
+        return "$" + std::to_string(value.size()) + "\r\n" + value + "\r\n";
+    }
+
+    static int node_of(const std::string& key) {
+        return key_hash_slot(key) * 3 / CLUSTER_SLOTS;
+    }
+
+    void test_routing() {
+        std::cout << "Testing single-key routing... ";
+        RawClient client(27310);
+
+        assert(client.call("PING") == bulk("PONG"));
+        for (int i = 0; i < 30; ++i) {
+            std::string key = "route:" + std::to_string(i);
+            assert(client.call("SET " + key + " v" + std::to_string(i)) == "+OK\r\n");
+            assert(client.call("GET " + key) == bulk("v" + std::to_string(i)));
+
+            // Stored on the node owning the slot, nowhere else
+            for (int node = 0; node < 3; ++node) {
+                assert(cluster_.storage(node).exists(key) == (node == node_of(key)));
+            }
+        }
+        assert(client.call("RPUSH route:list a") == bulk("1"));
+        assert(client.call("LLEN route:list") == bulk("1"));
+        assert(client.call("GET") == "-ERR wrong number of arguments\r\n");
+        assert(client.call("CLUSTER NODES").rfind("-ERR", 0) == 0);
+
+        std::cout << "✓\n";
+    }
+
+    void test_multi_key() {
+        std::cout << "Testing scatter-gather MGET/MSET/DEL... ";
+        RawClient client(27310);
+
+        std::string mset = "MSET";
+        std::string mget = "MGET";
+        std::string expected = "*101\r\n";
+        for (int i = 0; i < 100; ++i) {
+            mset += " multi:" + std::to_string(i) + " " + std::to_string(i);
+            mget += " multi:" + std::to_string(i);
+            expected += bulk(std::to_string(i));
+        }
+        mget += " multi:missing";
+        expected += "$-1\r\n";
+
+        assert(client.call(mset) == "+OK\r\n");
+        assert(client.call(mget) == expected);
+        assert(client.call("MSET a") == "-ERR wrong number of arguments\r\n");
+
+        // The keys really are spread over all nodes
+        for (int node = 0; node < 3; ++node) {
+            assert(cluster_.storage(node).dbsize() > 0);
+        }
+        size_t total = 0;
+        for (int node = 0; node < 3; ++node) {
+            total += cluster_.storage(node).dbsize();
+        }
+        assert(client.call("DBSIZE") == bulk(std::to_string(total)));
+
+        assert(client.call("DEL multi:0 multi:1 multi:2 multi:missing") == bulk("3"));
+        assert(client.call("DEL multi:3") == bulk("1"));
+        assert(client.call("MGET multi:0") == "*1\r\n$-1\r\n");
+
+        std::string keys = client.call("KEYS");
+        assert(keys.rfind("*" + std::to_string(total - 4) + "\r\n", 0) == 0);
+
+        std::cout << "✓\n";
+    }
+
+    void test_redirects() {
+        std::cout << "Testing MOVED handling inside the proxy... ";
+        RawClient client(27310);
+
+        // Move a key's slot to another node behind the proxy's back
+        std::string key = "moving";
+        int from = node_of(key);
+        int to = (from + 1) % 3;
+        std::string to_id = cluster_.cluster(to).myself_id();
+        for (int node = 0; node < 3; ++node) {
+            assert(cluster_.cluster(node).assign_slots({key_hash_slot(key)}, to_id));
+        }
+        cluster_.storage(to).set(key, "moved");
+
+        uint64_t before = proxy_->redirects();
+        assert(client.call("GET " + key) == bulk("moved"));
+        assert(proxy_->redirects() == before + 1);
+
+        // The slot map was updated, so the next one goes straight there
+        assert(client.call("GET " + key) == bulk("moved"));
+        assert(proxy_->redirects() == before + 1);
+
+        std::cout << "✓\n";
+    }
+
+    void test_pipelining() {
+        std::cout << "Testing pipelined and concurrent clients... ";
+
+        // Replies come back in order for a large pipeline
+        RawClient client(27310);
+        std::string batch;
+        for (int i = 0; i < 2000; ++i) {
+            batch += "SET pipe:" + std::to_string(i) + " " + std::to_string(i) + "\n";
+            batch += "GET pipe:" + std::to_string(i) + "\n";
+        }
+        client.send(batch);
+        for (int i = 0; i < 2000; ++i) {
+            assert(client.read() == "+OK\r\n");
+            assert(client.read() == bulk(std::to_string(i)));
+        }
+
+        // Clients share the backend connections without mixing up replies
+        std::vector<std::thread> threads;
+        for (int t = 0; t < 8; ++t) {
+            threads.emplace_back([t]() {
+                RawClient own(27310);
+                for (int i = 0; i < 200; ++i) {
+                    std::string key = "conc:" + std::to_string(t) + ":" + std::to_string(i);
+                    assert(own.call("SET " + key + " " + key) == "+OK\r\n");
+                    assert(own.call("MGET " + key + " pipe:" + std::to_string(i)) ==
+                           "*2\r\n" + bulk(key) + bulk(std::to_string(i)));
+                }
+            });
+        }
+        for (auto& thread : threads) {
+            thread.join();
+        }
+
+        std::cout << "✓\n";
+    }
+};
+
+int main() {
+    std::cout << "\n=================================\n";
+    std::cout << "Running DistKV Proxy Tests\n";
+    std::cout << "=================================\n\n";
+
+    TestRunner runner;
+    runner.run_all();
+
+    return 0;
+}
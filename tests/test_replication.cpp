@@ -0,0 +1,353 @@
+#include "../client/client.h"
+#include "../client/replicated_client.h"
+#include "../include/persistence.h"
+#include "../include/replication.h"
+#include "../include/storage.h"
+#include "test_util.h"
+#include <iostream>
+#include <sstream>
+#include <cassert>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+
+#ifndef _WIN32
+    #include <sys/socket.h>
+    #include <netinet/in.h>
+    #include <arpa/inet.h>
+    #include <unistd.h>
+#endif
+
+using namespace distkv;
+using namespace distkv::test;
+
+#ifndef _WIN32
+// A primary that completes a full sync with an empty snapshot and then
+// sends only what the test asks for: offset heartbeats announcing
+// announced_, until paused or closed
+class FakePrimary {
+public:
+    explicit FakePrimary(int port) : announced_(0), heartbeats_(true), closed_(false), fd_(-1) {
+        listener_ = socket(AF_INET, SOCK_STREAM, 0);
+        int opt = 1;
+        setsockopt(listener_, SOL_SOCKET, SO_REUSEADDR, &opt, sizeof(opt));
+        sockaddr_in addr{};
+        addr.sin_family = AF_INET;
+        addr.sin_port = htons(static_cast<uint16_t>(port));
+        inet_pton(AF_INET, "127.0.0.1", &addr.sin_addr);
+        assert(bind(listener_, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) == 0);
+        assert(listen(listener_, 1) == 0);
+        thread_ = std::thread([this]() { serve(); });
+    }
+
+    ~FakePrimary() {
+        close_link();
+        thread_.join();
+    }
+
+    void announce(uint64_t offset) { announced_ = offset; }
+    void pause_heartbeats() { heartbeats_ = false; }
+    void close_link() { closed_ = true; }
+
+private:
+    int listener_;
+    std::atomic<uint64_t> announced_;
+    std::atomic<bool> heartbeats_;
+    std::atomic<bool> closed_;
+    int fd_;
+    std::thread thread_;
+
+    void serve() {
+        fd_ = accept(listener_, nullptr, nullptr);
+        close(listener_);
+        char c;
+        while (recv(fd_, &c, 1, 0) == 1 && c != '\n') {
+        }
+
+        Storage empty;
+        std::ostringstream snapshot;
+        Persistence::write_snapshot(empty, snapshot);
+        std::string payload = snapshot.str();
+        net::send_all(fd_, "+FULLRESYNC 0\r\n$" + std::to_string(payload.size()) + "\r\n" + payload);
+
+        while (!closed_) {
+            if (heartbeats_) {
+                net::send_all(fd_, "REPLCONF OFFSET " + std::to_string(announced_.load()) + "\n");
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        }
+        close(fd_);
+    }
+};
+#endif
+
+class TestRunner {
+public:
+    void run_all() {
+        test_bounded_reads();
+#ifndef _WIN32
+        test_lagging_replica();
+        test_replicated_client_fallback();
+#endif
+        test_disconnected_replica();
+        test_compressed_stream();
+
+        std::cout << "\n✓ All tests passed!\n";
+    }
+
+private:
+    // The first reply of a one-command pipeline
+    static Client::Reply run(Client& client, const std::vector<std::string>& args) {
+        auto replies = client.pipeline().command(args).execute();
+        assert(replies.size() == 1);
+        return replies[0];
+    }
+
+    static bool is_stale(const Client::Reply& reply) {
+        return !reply.ok() && reply.str.find("STALE") != std::string::npos;
+    }
+
+    // Every key with its contents, by the type its prefix names: s: strings,
+    // l: lists, t: sets
+    static std::vector<std::string> dump(Client& client) {
+        std::vector<std::string> keys = client.keys();
+        std::sort(keys.begin(), keys.end());
+        std::vector<std::string> out;
+        for (const auto& key : keys) {
+            out.push_back(key);
+            if (key.compare(0, 2, "l:") == 0) {
+                for (const auto& item : client.lrange(key, 0, -1)) {
+                    out.push_back(item);
+                }
+            } else if (key.compare(0, 2, "t:") == 0) {
+                std::vector<std::string> members = client.smembers(key);
+                std::sort(members.begin(), members.end());
+                out.insert(out.end(), members.begin(), members.end());
+            } else {
+                out.push_back(client.get(key).value_or("<missing>"));
+            }
+        }
+        return out;
+    }
+
+    // size letters that no compressor can shrink
+    static std::string random_value(size_t size, uint32_t seed) {
+        std::string value(size, 'a');
+        for (size_t i = 0; i < size; ++i) {
+            seed = seed * 1103515245u + 12345u;
+            value[i] = static_cast<char>('A' + (seed >> 16) % 58);
+        }
+        return value;
+    }
+
+    // Poll until key reads as value on client, for up to three seconds
+    static bool wait_for_value(Client& client, const std::string& key, const std::string& value) {
+        for (int attempt = 0; attempt < 300; ++attempt) {
+            auto current = client.get(key);
+            if (current && *current == value) {
+                return true;
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
+        return false;
+    }
+
+    void test_bounded_reads() {
+        std::cout << "Testing reads within the staleness bound... ";
+
+        TestServer primary(27620);
+        TestServer replica(27621, [](Server& server) { server.set_replica_of("127.0.0.1", 27620); });
+        Client writer;
+        Client reader;
+        assert(writer.connect("127.0.0.1", 27620));
+        assert(reader.connect("127.0.0.1", 27621));
+
+        assert(writer.set("k", "v1"));
+        assert(wait_for_value(reader, "k", "v1"));
+
+        // A linked replica with heartbeats arriving is within generous bounds
+        assert(reader.set_max_staleness_ms(5000));
+        assert(reader.get("k") == std::optional<std::string>("v1"));
+        auto bounded = run(reader, {"BOUNDED", "OFFSET", "1000000", "GET", "k"});
+        assert(bounded.ok() && bounded.str == "v1");
+
+        // The primary ignores bounds
+        assert(writer.set_max_staleness_ms(0));
+        assert(writer.get("k") == std::optional<std::string>("v1"));
+
+        std::cout << "✓\n";
+    }
+
+#ifndef _WIN32
+    void test_lagging_replica() {
+        std::cout << "Testing reads beyond the staleness bound... ";
+
+        FakePrimary primary(27622);
+        primary.announce(1000);
+        TestServer replica(27623, [](Server& server) { server.set_replica_of("127.0.0.1", 27622); });
+        Client reader;
+        assert(reader.connect("127.0.0.1", 27623));
+
+        // The replica hears of offset 1000 but never gets the bytes
+        bool behind = false;
+        for (int attempt = 0; attempt < 300 && !behind; ++attempt) {
+            auto lag = run(reader, {"STALENESS"}).list();
+            behind = lag.size() == 2 && lag[1] == "1000";
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
+        assert(behind);
+
+        assert(is_stale(run(reader, {"BOUNDED", "OFFSET", "100", "GET", "k"})));
+        auto within = run(reader, {"BOUNDED", "OFFSET", "5000", "GET", "k"});
+        assert(within.ok() && within.is_nil());
+
+        // Without heartbeats the replica can't tell it is still current,
+        // whatever the bound
+        primary.pause_heartbeats();
+        std::this_thread::sleep_for(
+            std::chrono::milliseconds(ReplicationSlave::HEARTBEAT_TIMEOUT_MS + 200));
+        assert(is_stale(run(reader, {"BOUNDED", "OFFSET", "5000", "GET", "k"})));
+        assert(is_stale(run(reader, {"BOUNDED", "MS", "60000", "GET", "k"})));
+
+        // Unbounded reads are still served
+        auto unbounded = run(reader, {"GET", "k"});
+        assert(unbounded.ok() && unbounded.is_nil());
+
+        std::cout << "✓\n";
+    }
+
+    void test_replicated_client_fallback() {
+        std::cout << "Testing ReplicatedClient falling back to the primary... ";
+
+        TestServer primary(27624);
+        FakePrimary lagging_source(27625);
+        lagging_source.announce(1000);
+        TestServer replica(27626, [](Server& server) { server.set_replica_of("127.0.0.1", 27625); });
+
+        ReplicatedClient client;
+        assert(client.connect("127.0.0.1", 27624));
+        client.add_replica("127.0.0.1", 27626);
+        client.set_max_staleness_offset(100);
+        assert(client.set("k", "primary"));
+
+        // Wait until the replica knows it is behind, then every read has
+        // to come from the primary
+        Client probe;
+        assert(probe.connect("127.0.0.1", 27626));
+        bool behind = false;
+        for (int attempt = 0; attempt < 300 && !behind; ++attempt) {
+            behind = is_stale(run(probe, {"BOUNDED", "OFFSET", "100", "GET", "k"}));
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
+        assert(behind);
+
+        assert(client.get("k") == std::optional<std::string>("primary"));
+        assert(client.exists("k"));
+        assert(client.replica_reads() == 0);
+        assert(client.primary_reads() == 2);
+
+        // A bound the replica meets sends reads back to it
+        ReplicatedClient relaxed;
+        assert(relaxed.connect("127.0.0.1", 27624));
+        relaxed.add_replica("127.0.0.1", 27626);
+        relaxed.set_max_staleness_offset(5000);
+        assert(!relaxed.get("k"));
+        assert(relaxed.replica_reads() == 1);
+
+        std::cout << "✓\n";
+    }
+#endif
+
+    void test_disconnected_replica() {
+        std::cout << "Testing reads on a replica cut off from its primary... ";
+
+        Client reader;
+        TestServer replica(27628, [](Server& server) { server.set_replica_of("127.0.0.1", 27627); });
+        {
+            TestServer primary(27627);
+            Client writer;
+            assert(writer.connect("127.0.0.1", 27627));
+            assert(reader.connect("127.0.0.1", 27628));
+            assert(writer.set("k", "v1"));
+            assert(wait_for_value(reader, "k", "v1"));
+            assert(reader.set_max_staleness_offset(1000000));
+            assert(reader.get("k") == std::optional<std::string>("v1"));
+        }
+
+        // No lag figure grows once the link is gone, yet even the loosest
+        // bound is refused
+        bool stale = false;
+        for (int attempt = 0; attempt < 300 && !stale; ++attempt) {
+            stale = is_stale(run(reader, {"GET", "k"}));
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
+        assert(stale);
+        assert(is_stale(run(reader, {"BOUNDED", "MS", "60000", "GET", "k"})));
+
+        std::cout << "✓\n";
+    }
+    void test_compressed_stream() {
+        std::cout << "Testing a compressed replication stream... ";
+
+        TestServer primary(27629);
+        TestServer replica(27630, [](Server& server) { server.set_replica_of("127.0.0.1", 27629, true); });
+        Client writer;
+        Client reader;
+        assert(writer.connect("127.0.0.1", 27629));
+        assert(reader.connect("127.0.0.1", 27630));
+        assert(writer.set("s:first", "1"));
+        assert(wait_for_value(reader, "s:first", "1"));
+
+        // Single writes, each its own small batch and frame
+        for (int i = 0; i < 20; ++i) {
+            assert(writer.set("s:single" + std::to_string(i), make_value(100 + i)));
+        }
+
+        // Bursts well past the 1 MiB a frame holds, so command lines
+        // straddle frames: compressible values, then values the stream has
+        // to store as they are
+        auto burst = writer.pipeline();
+        for (int i = 0; i < 300; ++i) {
+            burst.set("s:packed" + std::to_string(i), std::to_string(i) + make_value(8000));
+        }
+        for (int i = 0; i < 40; ++i) {
+            burst.set("s:random" + std::to_string(i), random_value(30000, i));
+        }
+        for (const auto& reply : burst.execute()) {
+            assert(reply.ok());
+        }
+
+        // One stored frame is far larger than a socket read, so it arrives
+        // split across many reads
+        assert(writer.set("s:huge", random_value(1500000, 99)));
+
+        // Other data types and overwrites interleaved with the rest
+        for (int i = 0; i < 50; ++i) {
+            assert(writer.rpush("l:list", make_value(50 + i)) == i + 1);
+            assert(writer.sadd("t:set", "member" + std::to_string(i % 30)) == (i < 30));
+        }
+        assert(writer.del("s:packed7"));
+        assert(writer.set("s:packed8", "overwritten"));
+        assert(writer.set("s:last", "1"));
+
+        assert(wait_for_value(reader, "s:last", "1"));
+        assert(reader.dbsize() == writer.dbsize());
+        assert(dump(reader) == dump(writer));
+
+        std::cout << "✓\n";
+    }
+};
+
+int main() {
+    std::cout << "\n==================================\n";
+    std::cout << "Running DistKV Replication Tests\n";
+    std::cout << "==================================\n\n";
+
+    TestRunner runner;
+    runner.run_all();
+
+    return 0;
+}
@@ -0,0 +1,191 @@
+#include "../client/resp_parser.h"
+#include <iostream>
+#include <cassert>
+#include <string>
+#include <vector>
+
+using namespace distkv;
+
+namespace {
+
+// Parse a whole buffer that must hold exactly the given number of replies
+std::vector<RespReply> parse_all(const std::string& data, size_t expected) {
+    RespParser parser;
+    std::vector<RespReply> replies;
+    size_t pos = 0;
+    while (replies.size() < expected) {
+        RespReply reply;
+        assert(parser.parse(data.data(), data.size(), pos, reply) == RespParser::Status::DONE);
+        replies.push_back(std::move(reply));
+    }
+    assert(pos == data.size());
+    return replies;
+}
+
+} // namespace
+
+class TestRunner {
+public:
+    void run_all() {
+        test_simple_types();
+        test_bulk_with_crlf();
+        test_arrays();
+        test_split_input();
+        test_protocol_errors();
+        test_conversions();
+        test_push_messages();
+
+        std::cout << "\n✓ All tests passed!\n";
+    }
+
+private:
+    void test_simple_types() {
+        std::cout << "Testing status, error, integer, bulk and nil replies... ";
+
+        auto replies = parse_all("+OK\r\n-ERR no such key\r\n:-42\r\n$5\r\nhello\r\n$0\r\n\r\n$-1\r\n", 6);
+        assert(replies[0].type == RespReply::Type::STATUS && replies[0].str == "OK");
+        assert(replies[1].type == RespReply::Type::ERROR && replies[1].str == "ERR no such key");
+        assert(!replies[1].ok());
+        assert(replies[2].type == RespReply::Type::INTEGER && replies[2].number == -42);
+        assert(replies[3].type == RespReply::Type::BULK && replies[3].str == "hello");
+        assert(replies[4].type == RespReply::Type::BULK && replies[4].str.empty());
+        assert(replies[5].is_nil() && !replies[5].value());
+
+        std::cout << "✓\n";
+    }
+
+    void test_bulk_with_crlf() {
+        std::cout << "Testing bulk strings containing CRLF... ";
+
+        std::string value = "line1\r\nline2\r\n";
+        auto replies = parse_all("$" + std::to_string(value.size()) + "\r\n" + value + "\r\n+OK\r\n", 2);
+        assert(replies[0].str == value);
+        assert(replies[1].str == "OK");
+
+        std::cout << "✓\n";
+    }
+
+    void test_arrays() {
+        std::cout << "Testing flat, empty and nested arrays... ";
+
+        auto replies = parse_all("*3\r\n$1\r\na\r\n$-1\r\n:7\r\n*0\r\n*2\r\n*2\r\n+x\r\n$1\r\ny\r\n*1\r\n$1\r\nz\r\n*-1\r\n", 4);
+        assert(replies[0].type == RespReply::Type::ARRAY && replies[0].elements.size() == 3);
+        assert(replies[0].elements[0].str == "a");
+        assert(replies[0].elements[1].is_nil());
+        assert(replies[0].elements[2].number == 7);
+
+        assert(replies[1].type == RespReply::Type::ARRAY && replies[1].elements.empty());
+
+        const RespReply& nested = replies[2];
+        assert(nested.elements.size() == 2);
+        assert(nested.elements[0].elements.size() == 2);
+        assert(nested.elements[0].elements[0].str == "x");
+        assert(nested.elements[0].elements[1].str == "y");
+        assert(nested.elements[1].elements[0].str == "z");
+
+        assert(replies[3].is_nil());
+
+        std::cout << "✓\n";
+    }
+
+    void test_split_input() {
+        std::cout << "Testing replies split across reads... ";
+
+        std::string big(100000, 'v');
+        std::string data = "*3\r\n$" + std::to_string(big.size()) + "\r\n" + big + "\r\n+OK\r\n*1\r\n:12345\r\n";
+
+        // Bytes arrive in small pieces; consumed bytes are dropped like a
+        // client compacting its read buffer
+        for (size_t step : {1, 7, 4096}) {
+            RespParser parser;
+            std::string buffer;
+            size_t pos = 0;
+            RespReply reply;
+            RespParser::Status status = RespParser::Status::NEED_MORE;
+            for (size_t offset = 0; offset < data.size(); offset += step) {
+                assert(status == RespParser::Status::NEED_MORE);
+                buffer.erase(0, pos);
+                pos = 0;
+                buffer.append(data, offset, step);
+                status = parser.parse(buffer.data(), buffer.size(), pos, reply);
+            }
+            assert(status == RespParser::Status::DONE);
+            assert(pos == buffer.size());
+            assert(reply.elements.size() == 3);
+            assert(reply.elements[0].str == big);
+            assert(reply.elements[1].str == "OK");
+            assert(reply.elements[2].elements[0].number == 12345);
+        }
+
+        std::cout << "✓\n";
+    }
+
+    void test_protocol_errors() {
+        std::cout << "Testing malformed input... ";
+
+        for (const std::string& bad : {std::string("?what\r\n"), std::string("$abc\r\n"),
+                                       std::string(":12x\r\n"), std::string("\r\n"),
+                                       std::string("*1x\r\n")}) {
+            RespParser parser;
+            RespReply reply;
+            size_t pos = 0;
+            assert(parser.parse(bad.data(), bad.size(), pos, reply) == RespParser::Status::ERROR);
+        }
+
+        // After reset() a parser starts over at a reply boundary
+        RespParser parser;
+        RespReply reply;
+        std::string partial = "*2\r\n$3\r\nab";
+        size_t pos = 0;
+        assert(parser.parse(partial.data(), partial.size(), pos, reply) == RespParser::Status::NEED_MORE);
+        parser.reset();
+        std::string fresh = "+PONG\r\n";
+        pos = 0;
+        assert(parser.parse(fresh.data(), fresh.size(), pos, reply) == RespParser::Status::DONE);
+        assert(reply.str == "PONG");
+
+        std::cout << "✓\n";
+    }
+
+    void test_conversions() {
+        std::cout << "Testing reply conversions... ";
+
+        auto replies = parse_all("$1\r\n1\r\n$1\r\n0\r\n:3\r\n$2\r\n-2\r\n+OK\r\n*2\r\n$1\r\na\r\n:5\r\n$1\r\nb\r\n", 7);
+        assert(replies[0].boolean() && !replies[1].boolean());
+        assert(replies[2].integer() == 3 && replies[2].boolean());
+        assert(replies[3].integer() == -2);
+        assert(replies[4].integer(-1) == -1);
+
+        // KEYS/LRANGE/SMEMBERS: no elements is +OK, one is a bulk string
+        assert(replies[4].list().empty());
+        assert((replies[5].list() == std::vector<std::string>{"a", "5"}));
+        assert((replies[6].list() == std::vector<std::string>{"b"}));
+
+        std::cout << "✓\n";
+    }
+
+    void test_push_messages() {
+        std::cout << "Testing push messages between replies... ";
+
+        auto replies = parse_all("$1\r\nv\r\n>2\r\n$10\r\ninvalidate\r\n*2\r\n$1\r\na\r\n$1\r\nb\r\n+OK\r\n", 3);
+        assert(replies[0].str == "v");
+        assert(replies[1].type == RespReply::Type::PUSH);
+        assert(replies[1].elements.size() == 2);
+        assert(replies[1].elements[0].str == "invalidate");
+        assert((replies[1].elements[1].list() == std::vector<std::string>{"a", "b"}));
+        assert(replies[2].str == "OK");
+
+        std::cout << "✓\n";
+    }
+};
+
+int main() {
+    std::cout << "\n=================================\n";
+    std::cout << "Running DistKV RESP Parser Tests\n";
+    std::cout << "=================================\n\n";
+
+    TestRunner runner;
+    runner.run_all();
+
+    return 0;
+}
@@ -0,0 +1,249 @@
+#include "../client/sharded_client.h"
+#include "test_util.h"
+#include <iostream>
+#include <cassert>
+#include <chrono>
+#include <map>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace distkv;
+using namespace distkv::test;
+
+namespace {
+
+std::string address(int port) {
+    return "127.0.0.1:" + std::to_string(port);
+}
+
+} // namespace
+
+class TestRunner {
+public:
+    void run_all() {
+        test_distribution();
+        test_minimal_movement();
+        test_routing();
+        test_batches();
+        test_server_down();
+
+        std::cout << "\n✓ All tests passed!\n";
+    }
+
+private:
+    static constexpr int KEYS = 20000;
+
+    void test_distribution() {
+        std::cout << "Testing key distribution and weights... ";
+
+        // No connections are needed to place keys
+        ShardedClient client;
+        assert(client.server_for("k").empty());
+        assert(client.add_server("127.0.0.1", 27601));
+        assert(client.add_server("127.0.0.1", 27602));
+        assert(client.add_server("127.0.0.1", 27603, 2));
+        assert(!client.add_server("127.0.0.1", 27601));
+        assert(!client.add_server("127.0.0.1", 27604, 0));
+        assert(client.server_count() == 3);
+
+        std::map<std::string, int> counts;
+        for (int i = 0; i < KEYS; ++i) {
+            ++counts[client.server_for("key:" + std::to_string(i))];
+        }
+        assert(counts.size() == 3);
+        assert(counts[address(27601)] > KEYS * 0.20 && counts[address(27601)] < KEYS * 0.30);
+        assert(counts[address(27602)] > KEYS * 0.20 && counts[address(27602)] < KEYS * 0.30);
+        assert(counts[address(27603)] > KEYS * 0.42 && counts[address(27603)] < KEYS * 0.58);
+
+        // Placement depends only on the set of servers, not the order
+        // they were added in
+        ShardedClient other;
+        assert(other.add_server("127.0.0.1", 27603, 2));
+        assert(other.add_server("127.0.0.1", 27602));
+        assert(other.add_server("127.0.0.1", 27601));
+        for (int i = 0; i < 1000; ++i) {
+            std::string key = "key:" + std::to_string(i);
+            assert(client.server_for(key) == other.server_for(key));
+        }
+
+        std::cout << "✓\n";
+    }
+
+    void test_minimal_movement() {
+        std::cout << "Testing minimal key movement on membership changes... ";
+
+        ShardedClient client;
+        for (int port = 27601; port <= 27604; ++port) {
+            assert(client.add_server("127.0.0.1", port));
+        }
+        std::vector<std::string> before;
+        for (int i = 0; i < KEYS; ++i) {
+            before.push_back(client.server_for("key:" + std::to_string(i)));
+        }
+
+        // A fifth server takes about a fifth of the keys, all from others
+        assert(client.add_server("127.0.0.1", 27605));
+        int moved = 0;
+        for (int i = 0; i < KEYS; ++i) {
+            std::string now = client.server_for("key:" + std::to_string(i));
+            if (now != before[i]) {
+                assert(now == address(27605));
+                ++moved;
+            }
+        }
+        assert(moved > KEYS * 0.14 && moved < KEYS * 0.26);
+
+        // Removing it again restores the old placement exactly
+        assert(client.remove_server("127.0.0.1", 27605));
+        assert(!client.remove_server("127.0.0.1", 27605));
+        for (int i = 0; i < KEYS; ++i) {
+            assert(client.server_for("key:" + std::to_string(i)) == before[i]);
+        }
+
+        // Removing a server only moves that server's keys
+        assert(client.remove_server("127.0.0.1", 27602));
+        for (int i = 0; i < KEYS; ++i) {
+            if (before[i] != address(27602)) {
+                assert(client.server_for("key:" + std::to_string(i)) == before[i]);
+            }
+        }
+
+        std::cout << "✓\n";
+    }
+
+    void test_routing() {
+        std::cout << "Testing commands reach the owning server... ";
+
+        TestServer a(27540);
+        TestServer b(27541);
+        TestServer c(27542);
+        ShardedClient client;
+        std::map<std::string, std::unique_ptr<Client>> direct;
+        for (int port = 27540; port <= 27542; ++port) {
+            assert(client.add_server("127.0.0.1", port));
+            direct[address(port)] = std::make_unique<Client>();
+            assert(direct[address(port)]->connect("127.0.0.1", port));
+        }
+
+        for (int i = 0; i < 100; ++i) {
+            std::string key = "r" + std::to_string(i);
+            assert(client.set(key, "v" + std::to_string(i)));
+            assert(client.get(key) == "v" + std::to_string(i));
+            for (auto& entry : direct) {
+                assert(entry.second->exists(key) == (entry.first == client.server_for(key)));
+            }
+        }
+
+        assert(client.rpush("list", "x") == 1);
+        assert(client.rpush("list", "y") == 2);
+        assert(client.lrange("list", 0, -1) == std::vector<std::string>({"x", "y"}));
+        assert(client.lpop("list") == "x");
+        assert(client.sadd("set", "m"));
+        assert(client.sismember("set", "m"));
+        assert(client.scard("set") == 1);
+        assert(client.expire("r1", 100));
+        assert(client.ttl("r1") > 0);
+        assert(client.del("r1"));
+        assert(!client.get("r1"));
+        assert(client.get_error().empty());
+
+        std::cout << "✓\n";
+    }
+
+    void test_batches() {
+        std::cout << "Testing multi-key commands split per server... ";
+
+        TestServer a(27543);
+        TestServer b(27544);
+        ShardedClient client;
+        assert(client.add_server("127.0.0.1", 27543));
+        assert(client.add_server("127.0.0.1", 27544));
+
+        std::vector<std::pair<std::string, std::string>> pairs;
+        std::vector<std::string> keys;
+        for (int i = 0; i < 500; ++i) {
+            pairs.emplace_back("m" + std::to_string(i), "v" + std::to_string(i));
+            keys.push_back("m" + std::to_string(i));
+        }
+        assert(client.mset(pairs));
+        assert(client.dbsize() == 500);
+
+        // Replies come back in request order, whichever server answered
+        keys.push_back("missing");
+        auto values = client.mget(keys);
+        assert(values.size() == 501);
+        for (int i = 0; i < 500; ++i) {
+            assert(values[i] == "v" + std::to_string(i));
+        }
+        assert(!values[500]);
+
+        // Both servers got a share
+        Client direct;
+        assert(direct.connect("127.0.0.1", 27543));
+        size_t on_a = direct.dbsize();
+        assert(on_a > 150 && on_a < 350);
+
+        std::vector<std::vector<std::string>> commands = {
+            {"SET", "x", "1"}, {"GET", "x"}, {"GET", "m7"}, {"DEL", "x"}, {"EXISTS", "x"}};
+        auto replies = client.execute(commands);
+        assert(replies[0].ok());
+        assert(replies[1].value() == "1");
+        assert(replies[2].value() == "v7");
+        assert(replies[3].boolean());
+        assert(!replies[4].boolean());
+
+        assert(client.del(std::vector<std::string>(keys.begin(), keys.begin() + 100)) == 100);
+        assert(client.dbsize() == 400);
+
+        std::cout << "✓\n";
+    }
+
+    void test_server_down() {
+        std::cout << "Testing keys on an unreachable server... ";
+
+        TestServer up(27545);
+        ShardedClient client;
+        assert(client.add_server("127.0.0.1", 27545));
+        assert(client.add_server("127.0.0.1", 27546));
+
+        std::vector<std::string> keys;
+        for (int i = 0; i < 50; ++i) {
+            keys.push_back("d" + std::to_string(i));
+        }
+
+        // Keys of the down server fail instead of moving to the live one
+        std::vector<std::pair<std::string, std::string>> pairs;
+        for (const auto& key : keys) {
+            pairs.emplace_back(key, "v");
+        }
+        assert(!client.mset(pairs));
+        assert(client.get_error().find(address(27546)) != std::string::npos);
+        auto values = client.mget(keys);
+        for (size_t i = 0; i < keys.size(); ++i) {
+            assert(values[i].has_value() == (client.server_for(keys[i]) == address(27545)));
+        }
+
+        // Its connection is opened once it comes up
+        TestServer later(27546);
+        assert(client.mset(pairs));
+        for (const auto& value : client.mget(keys)) {
+            assert(value == "v");
+        }
+        assert(client.get_error().empty());
+
+        std::cout << "✓\n";
+    }
+};
+
+int main() {
+    std::cout << "\n===================================\n";
+    std::cout << "Running DistKV Sharded Client Tests\n";
+    std::cout << "===================================\n\n";
+
+    TestRunner runner;
+    runner.run_all();
+
+    return 0;
+}
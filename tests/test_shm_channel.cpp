@@ -0,0 +1,332 @@
+#include "../client/client.h"
+#include "../include/shm_channel.h"
+#include "test_util.h"
+#include <iostream>
+#include <cassert>
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#ifdef __linux__
+    #include <sys/mman.h>
+    #include <unistd.h>
+#endif
+
+using namespace distkv;
+using namespace distkv::test;
+
+#ifdef __linux__
+class TestRunner {
+public:
+    void run_all() {
+        test_ring_transfer();
+        test_ring_limits();
+        test_corrupt_counters();
+        test_client_commands();
+        test_busy_poll();
+        test_invalidations();
+        test_refused();
+        test_server_gone();
+
+        std::cout << "\n✓ All tests passed!\n";
+    }
+
+private:
+    void test_ring_transfer() {
+        std::cout << "Testing byte streams through the rings... ";
+
+        auto server = ShmChannel::create(5000);
+        assert(server && server->ring_bytes() == 8192);
+        auto client = ShmChannel::attach(dup(server->fd()));
+        assert(client && client->ring_bytes() == 8192);
+
+        // Small messages both ways
+        char buffer[64];
+        assert(client->write("PING\n", 5));
+        assert(server->read(buffer, sizeof(buffer)) == 5);
+        assert(std::memcmp(buffer, "PING\n", 5) == 0);
+        assert(server->write("+PONG\r\n", 7));
+        assert(client->read_available(buffer, sizeof(buffer)) == 7);
+        assert(client->read_available(buffer, sizeof(buffer)) == 0);
+
+        // Far more than the ring holds, wrapping many times, with the
+        // writer waiting for room and the reader for data
+        std::string sent = make_value(1000000);
+        std::thread writer([&]() { assert(client->write(sent.data(), sent.size())); });
+        std::string received;
+        std::vector<char> chunk(3000);
+        while (received.size() < sent.size()) {
+            long n = server->read(chunk.data(), chunk.size());
+            assert(n >= 0);
+            received.append(chunk.data(), static_cast<size_t>(n));
+        }
+        writer.join();
+        assert(received == sent);
+
+        std::cout << "✓\n";
+    }
+
+    void test_ring_limits() {
+        std::cout << "Testing full rings and dead peers... ";
+
+        auto server = ShmChannel::create(0);
+        assert(server && server->ring_bytes() == ShmChannel::MIN_RING_BYTES);
+        auto client = ShmChannel::attach(dup(server->fd()));
+        assert(client);
+
+        std::string block(ShmChannel::MIN_RING_BYTES - 10, 'b');
+        assert(client->try_write(block.data(), block.size()));
+        assert(!client->try_write("0123456789A", 11));
+        assert(client->try_write("0123456789", 10));
+
+        // A writer facing a full ring gives up when the alive check fails
+        std::atomic<bool> alive(true);
+        client->set_alive_check([&]() { return alive.load(); });
+        std::thread stopper([&]() {
+            std::this_thread::sleep_for(std::chrono::milliseconds(20));
+            alive = false;
+        });
+        assert(!client->write("x", 1));
+        stopper.join();
+
+        // So does a reader with nothing to read; a passing check makes it
+        // return 0 after a slice
+        server->set_spin_us(0);
+        std::vector<char> drain(ShmChannel::MIN_RING_BYTES);
+        assert(server->read(drain.data(), drain.size()) == static_cast<long>(drain.size()));
+        server->set_alive_check([]() { return true; });
+        assert(server->read(drain.data(), drain.size()) == 0);
+        server->set_alive_check([]() { return false; });
+        assert(server->read(drain.data(), drain.size()) == -1);
+
+        // Anything but a segment is refused
+        int fds[2];
+        assert(pipe(fds) == 0);
+        close(fds[1]);
+        assert(!ShmChannel::attach(fds[0]));
+
+        std::cout << "✓\n";
+    }
+
+    void test_corrupt_counters() {
+        std::cout << "Testing rings with corrupted counters... ";
+
+        // Scribble on the counters the way a hostile peer could: the rings
+        // start at byte 64 of the segment, four cache lines each, head
+        // first, then tail
+        auto counter = [](void* base, size_t ring, size_t which) {
+            char* bytes = static_cast<char*>(base) + 64 + ring * 256 + which * 64;
+            return reinterpret_cast<std::atomic<uint64_t>*>(bytes);
+        };
+        char buffer[64];
+
+        // A request head far past the tail fails the read, for good
+        {
+            auto server = ShmChannel::create(0);
+            auto client = ShmChannel::attach(dup(server->fd()));
+            assert(server && client);
+            void* base = mmap(nullptr, 4096, PROT_READ | PROT_WRITE, MAP_SHARED, server->fd(), 0);
+            assert(base != MAP_FAILED);
+
+            assert(client->write("PING\n", 5));
+            counter(base, 0, 0)->store(ShmChannel::MIN_RING_BYTES * 4);
+            assert(server->read(buffer, sizeof(buffer)) == -1);
+            assert(server->corrupt());
+            counter(base, 0, 0)->store(5);
+            assert(server->read(buffer, sizeof(buffer)) == -1);
+            munmap(base, 4096);
+        }
+
+        // A reply tail ahead of the head (a negative fill level) fails
+        // both kinds of write instead of overrunning the ring
+        {
+            auto server = ShmChannel::create(0);
+            auto client = ShmChannel::attach(dup(server->fd()));
+            assert(server && client);
+            void* base = mmap(nullptr, 4096, PROT_READ | PROT_WRITE, MAP_SHARED, server->fd(), 0);
+            assert(base != MAP_FAILED);
+
+            counter(base, 1, 1)->store(100);
+            assert(!server->try_write("+PONG\r\n", 7));
+            assert(!server->write("+PONG\r\n", 7));
+            assert(server->corrupt());
+            munmap(base, 4096);
+        }
+
+        // A writer waiting for room on a full ring gives up as soon as
+        // the tail jumps backwards, rather than waiting for the alive check
+        {
+            auto server = ShmChannel::create(0);
+            auto client = ShmChannel::attach(dup(server->fd()));
+            assert(server && client);
+            void* base = mmap(nullptr, 4096, PROT_READ | PROT_WRITE, MAP_SHARED, server->fd(), 0);
+            assert(base != MAP_FAILED);
+
+            std::string block(ShmChannel::MIN_RING_BYTES, 'b');
+            assert(client->try_write(block.data(), block.size()));
+            std::thread scribbler([&]() {
+                std::this_thread::sleep_for(std::chrono::milliseconds(20));
+                counter(base, 0, 1)->store(ShmChannel::MIN_RING_BYTES * 2);
+            });
+            assert(!client->write("x", 1));
+            scribbler.join();
+            assert(client->corrupt());
+            munmap(base, 4096);
+        }
+
+        std::cout << "✓\n";
+    }
+
+    void test_client_commands() {
+        std::cout << "Testing a client on shared memory... ";
+
+        std::string path = "/tmp/distkv-test-shm-1.sock";
+        TestServer server(27550, path);
+        Client client;
+        ShmConfig config;
+        config.ring_bytes = 16 * 1024;
+        assert(client.connect_shm(path, config));
+        assert(client.is_shm());
+
+        assert(client.ping());
+        assert(client.set("a", "1"));
+        assert(client.get("a") == "1");
+        assert(!client.get("missing"));
+        assert(client.rpush("list", "x") == 1);
+        assert(client.lrange("list", 0, -1) == std::vector<std::string>({"x"}));
+
+        // Values and batches larger than the rings stream through them
+        std::string value = make_value(200000);
+        assert(client.set("big", value));
+        assert(client.get_view("big") == std::string_view(value));
+        auto pipeline = client.pipeline();
+        for (int i = 0; i < 2000; ++i) {
+            pipeline.set("p" + std::to_string(i), std::to_string(i));
+        }
+        pipeline.get("p1999");
+        auto replies = pipeline.execute();
+        assert(replies.size() == 2001 && replies.back().value() == "1999");
+
+        // The same data as every other transport
+        Client tcp;
+        assert(tcp.connect("127.0.0.1", 27550));
+        assert(tcp.get("p7") == "7");
+        assert(client.dbsize() == tcp.dbsize());
+
+        client.disconnect();
+        assert(!client.is_shm() && !client.is_connected());
+        assert(client.connect_shm(path));
+        assert(client.get("a") == "1");
+
+        std::cout << "✓\n";
+    }
+
+    void test_busy_poll() {
+        std::cout << "Testing busy polling... ";
+
+        std::string path = "/tmp/distkv-test-shm-2.sock";
+        TestServer server(27551, path);
+        Client client;
+        ShmConfig config;
+        config.spin_us = -1;
+        assert(client.connect_shm(path, config));
+        for (int i = 0; i < 1000; ++i) {
+            assert(client.set("k", std::to_string(i)));
+            assert(client.get("k") == std::to_string(i));
+        }
+
+        std::cout << "✓\n";
+    }
+
+    void test_invalidations() {
+        std::cout << "Testing cache invalidations over shared memory... ";
+
+        std::string path = "/tmp/distkv-test-shm-3.sock";
+        TestServer server(27552, path);
+        Client reader;
+        Client writer;
+        assert(reader.connect_shm(path));
+        assert(reader.enable_cache());
+        assert(writer.connect("127.0.0.1", 27552));
+
+        assert(writer.set("k", "1"));
+        assert(reader.get("k") == "1");
+        assert(reader.get("k") == "1");
+        assert(reader.cache_hits() == 1);
+
+        // Pushed into the reply ring by the writer's connection
+        for (int i = 2; i < 20; ++i) {
+            assert(writer.set("k", std::to_string(i)));
+            bool updated = false;
+            for (int attempt = 0; attempt < 500 && !updated; ++attempt) {
+                updated = reader.get("k") == std::to_string(i);
+                if (!updated) {
+                    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+                }
+            }
+            assert(updated);
+        }
+
+        std::cout << "✓\n";
+    }
+
+    void test_refused() {
+        std::cout << "Testing SHM outside a Unix socket connection... ";
+
+        std::string path = "/tmp/distkv-test-shm-4.sock";
+        TestServer server(27553, path);
+        Client tcp;
+        assert(tcp.connect("127.0.0.1", 27553));
+        auto replies = tcp.pipeline().command({"SHM", "4096"}).ping().execute();
+        assert(!replies[0].ok());
+        assert(replies[1].str == "PONG");
+
+        Client client;
+        assert(!client.connect_shm("/tmp/distkv-test-shm-missing.sock"));
+        assert(!client.is_connected());
+
+        std::cout << "✓\n";
+    }
+
+    void test_server_gone() {
+        std::cout << "Testing a server stopping under a shared-memory client... ";
+
+        std::string path = "/tmp/distkv-test-shm-5.sock";
+        Client client;
+        {
+            TestServer server(27554, path);
+            assert(client.connect_shm(path));
+            assert(client.set("k", "v"));
+
+            // stop() waits for the session, which notices within a wait slice
+            auto start = std::chrono::steady_clock::now();
+            server.stop();
+            assert(std::chrono::steady_clock::now() - start < std::chrono::seconds(2));
+        }
+        assert(!client.get("k"));
+        assert(!client.is_connected());
+
+        std::cout << "✓\n";
+    }
+};
+
+#endif
+
+int main() {
+    std::cout << "\n==================================\n";
+    std::cout << "Running DistKV Shared Memory Tests\n";
+    std::cout << "==================================\n\n";
+
+#ifdef __linux__
+    TestRunner runner;
+    runner.run_all();
+#else
+    std::cout << "Shared memory transport is Linux only, skipped\n";
+#endif
+
+    return 0;
+}
@@ -0,0 +1,82 @@
+#ifndef DISTKV_TEST_UTIL_H
+#define DISTKV_TEST_UTIL_H
+
+// Fixtures shared by the test suites that run a server in-process
+
+#include "../include/server.h"
+#include "../include/net_util.h"
+#include <cassert>
+#include <chrono>
+#include <functional>
+#include <string>
+#include <thread>
+
+namespace distkv {
+namespace test {
+
+// Poll until something accepts connections on port, for up to two seconds
+inline bool wait_for_port(int port) {
+    for (int attempt = 0; attempt < 200; ++attempt) {
+        int fd = net::connect_tcp("127.0.0.1", port);
+        if (fd >= 0) {
+            net::close_socket(fd);
+            return true;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    return false;
+}
+
+// A server on its own thread, stopped and joined by stop() or on
+// destruction. configure runs on the server before it starts listening
+// (cluster mode, replica links); unix_path also opens a Unix domain
+// socket listener.
+class TestServer {
+public:
+    explicit TestServer(int port, const std::string& unix_path = "")
+        : TestServer(port, [unix_path](Server& server) {
+              if (!unix_path.empty()) {
+                  server.set_unix_socket(unix_path);
+              }
+          }) {}
+
+    TestServer(int port, const std::function<void(Server&)>& configure)
+        : server_(port, 2), thread_([this, configure]() {
+              if (configure) {
+                  configure(server_);
+              }
+              server_.start();
+          }) {
+        assert(wait_for_port(port));
+    }
+
+    ~TestServer() { stop(); }
+
+    void stop() {
+        if (thread_.joinable()) {
+            server_.stop();
+            thread_.join();
+        }
+    }
+
+    Server& server() { return server_; }
+
+private:
+    Server server_;
+    std::thread thread_;
+};
+
+// size bytes of one word (the line protocol splits on spaces), varied so
+// misplaced chunks show up
+inline std::string make_value(size_t size) {
+    std::string value(size, 'x');
+    for (size_t i = 0; i < size; i += 97) {
+        value[i] = static_cast<char>('a' + (i / 97) % 26);
+    }
+    return value;
+}
+
+} // namespace test
+} // namespace distkv
+
+#endif // DISTKV_TEST_UTIL_H